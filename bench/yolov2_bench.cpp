@@ -0,0 +1,616 @@
+/*
+ * YOLOv2 microbenchmark suite
+ *
+ * Times the hot host/HLS-model kernels over realistic YOLOv2 layer shapes and
+ * reports ns/element and GB/s. Results can be written to, and compared
+ * against, a JSON baseline so kernel changes can be checked for regressions:
+ *
+ *   ./yolov2_bench --baseline bench/baseline_fp32.json
+ *   ./yolov2_bench --write-baseline bench/baseline_fp32.json
+ */
+
+#include "yolov2_bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <core/yolo.h>
+#include "core_io.hpp"
+#include "core_compute.hpp"
+#include "yolo2_host_ops.hpp"
+
+namespace {
+
+struct BenchConfig {
+    std::string filter;
+    std::string baseline_path;
+    std::string write_baseline_path;
+    double min_time_ms = 200.0;
+    int min_iters = 5;
+    double tolerance_pct = 10.0;
+    bool fail_on_regression = false;
+    bool list_only = false;
+};
+
+struct BenchResult {
+    std::string name;
+    int iters = 0;
+    double ns_per_iter = 0.0;
+    double ns_per_elem = 0.0;
+    double gbps = 0.0;
+};
+
+BenchConfig g_cfg;
+std::vector<BenchResult> g_results;
+
+double now_ns()
+{
+    using clock = std::chrono::steady_clock;
+    return std::chrono::duration<double, std::nano>(clock::now().time_since_epoch()).count();
+}
+
+void print_usage(const char *prog)
+{
+    std::printf("Usage: %s [--filter <substr>] [--baseline <file.json>] [--write-baseline <file.json>]\n"
+                "          [--min-time-ms <ms>] [--min-iters <n>] [--tolerance <pct>] [--fail-on-regression] [--list]\n",
+                prog);
+}
+
+BenchConfig parse_args(int argc, char **argv)
+{
+    BenchConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--filter" && i + 1 < argc) {
+            cfg.filter = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            cfg.baseline_path = argv[++i];
+        } else if (arg == "--write-baseline" && i + 1 < argc) {
+            cfg.write_baseline_path = argv[++i];
+        } else if (arg == "--min-time-ms" && i + 1 < argc) {
+            cfg.min_time_ms = std::atof(argv[++i]);
+        } else if (arg == "--min-iters" && i + 1 < argc) {
+            cfg.min_iters = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            cfg.tolerance_pct = std::atof(argv[++i]);
+        } else if (arg == "--fail-on-regression") {
+            cfg.fail_on_regression = true;
+        } else if (arg == "--list") {
+            cfg.list_only = true;
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            print_usage(argv[0]);
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+    return cfg;
+}
+
+// Baseline format: one kernel per line so it stays diff-friendly and can be
+// parsed without a JSON dependency.
+//   "core.compute.conv3x3": {"ns_per_elem": 0.812, "gb_per_s": 3.21},
+std::map<std::string, BenchResult> read_baseline(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open baseline: " + path);
+
+    std::map<std::string, BenchResult> out;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t q0 = line.find('"');
+        if (q0 == std::string::npos) continue;
+        const size_t q1 = line.find('"', q0 + 1);
+        if (q1 == std::string::npos) continue;
+        const size_t ns_pos = line.find("\"ns_per_elem\"", q1);
+        const size_t gb_pos = line.find("\"gb_per_s\"", q1);
+        if (ns_pos == std::string::npos) continue;
+
+        BenchResult r;
+        r.name = line.substr(q0 + 1, q1 - q0 - 1);
+        r.ns_per_elem = std::strtod(line.c_str() + line.find(':', ns_pos) + 1, nullptr);
+        if (gb_pos != std::string::npos) {
+            r.gbps = std::strtod(line.c_str() + line.find(':', gb_pos) + 1, nullptr);
+        }
+        out[r.name] = r;
+    }
+    return out;
+}
+
+void write_baseline(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to write baseline: " + path);
+
+    out << "{\n";
+#ifdef INT16_MODE
+    out << "  \"precision\": \"int16\",\n";
+#else
+    out << "  \"precision\": \"fp32\",\n";
+#endif
+    out << "  \"kernels\": {\n";
+    for (size_t i = 0; i < g_results.size(); ++i) {
+        const BenchResult &r = g_results[i];
+        char buf[256];
+        std::snprintf(buf, sizeof(buf), "    \"%s\": {\"ns_per_elem\": %.6g, \"gb_per_s\": %.6g}%s\n",
+                      r.name.c_str(), r.ns_per_elem, r.gbps, (i + 1 < g_results.size()) ? "," : "");
+        out << buf;
+    }
+    out << "  }\n}\n";
+    std::printf("Baseline written to %s (%zu kernels)\n", path.c_str(), g_results.size());
+}
+
+// Returns the number of kernels that regressed beyond the tolerance.
+int compare_baseline(const std::map<std::string, BenchResult> &baseline)
+{
+    int regressions = 0;
+    std::printf("\n%-34s %14s %14s %9s\n", "kernel", "base ns/elem", "now ns/elem", "delta");
+    for (const BenchResult &r : g_results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second.ns_per_elem <= 0.0) {
+            std::printf("%-34s %14s %14.4f %9s\n", r.name.c_str(), "-", r.ns_per_elem, "new");
+            continue;
+        }
+        const double base = it->second.ns_per_elem;
+        const double delta_pct = (r.ns_per_elem - base) / base * 100.0;
+        const bool regressed = delta_pct > g_cfg.tolerance_pct;
+        if (regressed) regressions++;
+        std::printf("%-34s %14.4f %14.4f %+8.1f%%%s\n", r.name.c_str(), base, r.ns_per_elem, delta_pct,
+                    regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+std::mt19937 &rng()
+{
+    static std::mt19937 gen(0x5eed);
+    return gen;
+}
+
+template <typename T>
+void fill_random(T *data, size_t n, float lo, float hi)
+{
+    std::uniform_real_distribution<float> dist(lo, hi);
+    for (size_t i = 0; i < n; ++i) {
+        if (std::is_integral<T>::value) {
+            data[i] = static_cast<T>(std::lround(dist(rng()) * 256.0f)); // Q8 fixed point
+        } else {
+            data[i] = static_cast<T>(dist(rng()));
+        }
+    }
+}
+
+int align_256b(int w)
+{
+    int a = (w >> 3) << 3;
+    if (w & 0x7) a += 8;
+    return a;
+}
+
+// ---------------------------------------------------------------------------
+// HLS core kernels
+
+struct ComputeCtx {
+    IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width];
+    Acc_Dtype output_buffer[Tm][Tr][Tc];
+    IO_Dtype weight_buffer[Tm][Tn][K][K];
+    IO_Dtype beta_buffer[MAX_BETA_LENGTH];
+    int n_next[1];
+    int Ksize;
+    int Kstride;
+    int TR_MIN;
+    int TC_MIN;
+};
+
+void run_compute(void *p)
+{
+    ComputeCtx *ctx = static_cast<ComputeCtx *>(p);
+    // n_next=1 keeps the accumulate path (the steady state of every IFM loop).
+    compute(ctx->input_buffer, ctx->output_buffer, ctx->weight_buffer, ctx->beta_buffer, ctx->n_next,
+            ctx->Ksize, ctx->Kstride, 0, Tm, ctx->TR_MIN, ctx->TC_MIN, true, 0, 8, 8, 8, 8);
+}
+
+void bench_compute(const char *name, int Ksize)
+{
+    if (!yolo2_bench_enabled(name)) return;
+    auto ctx = std::make_unique<ComputeCtx>();
+    fill_random(&ctx->input_buffer[0][0][0], sizeof(ctx->input_buffer) / sizeof(IO_Dtype), -1.f, 1.f);
+    fill_random(&ctx->weight_buffer[0][0][0][0], sizeof(ctx->weight_buffer) / sizeof(IO_Dtype), -0.1f, 0.1f);
+    fill_random(ctx->beta_buffer, MAX_BETA_LENGTH, -0.5f, 0.5f);
+    std::memset(ctx->output_buffer, 0, sizeof(ctx->output_buffer));
+    ctx->n_next[0] = 1;
+    ctx->Ksize = Ksize;
+    ctx->Kstride = 1;
+    ctx->TR_MIN = Tr;
+    ctx->TC_MIN = Tc;
+    // Prime the bias cache (enable=false path).
+    compute(ctx->input_buffer, ctx->output_buffer, ctx->weight_buffer, ctx->beta_buffer, ctx->n_next,
+            Ksize, 1, 0, Tm, Tr, Tc, false, 0, 8, 8, 8, 8);
+
+    const size_t macs = static_cast<size_t>(Tm) * Tn * Ksize * Ksize * Tr * Tc;
+    const size_t bytes = (static_cast<size_t>(Tn) * (Tr + Ksize - 1) * (Tc + Ksize - 1) +
+                          static_cast<size_t>(Tm) * Tn * Ksize * Ksize +
+                          static_cast<size_t>(Tm) * Tr * Tc * 2) * sizeof(IO_Dtype);
+    yolo2_bench_run(name, nullptr, run_compute, ctx.get(), macs, bytes);
+}
+
+struct InputLoadCtx {
+    std::vector<IO_Dtype> ifm;
+    IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width];
+    int Input_w, Input_h, IW_align, TRow, TCol, Kstride, Padding, LayerType;
+};
+
+void run_input_load(void *p)
+{
+    InputLoadCtx *ctx = static_cast<InputLoadCtx *>(p);
+    // Second tile row/column so the padding branches are not the common case.
+    input_load(ctx->ifm.data(), ctx->input_buffer, Tr, Tc, 0, ctx->Kstride, ctx->Padding, ctx->TRow, ctx->TCol,
+               ctx->Input_w, ctx->IW_align, ctx->Input_h, Tn, ctx->Input_h * ctx->IW_align, ctx->LayerType);
+}
+
+void bench_input_load()
+{
+    const char *name = "core.input_load";
+    if (!yolo2_bench_enabled(name)) return;
+    // Layer 2 of YOLOv2: 208x208x32 input, 3x3/s1.
+    auto ctx = std::make_unique<InputLoadCtx>();
+    ctx->Input_w = 208;
+    ctx->Input_h = 208;
+    ctx->IW_align = align_256b(ctx->Input_w);
+    ctx->Kstride = 1;
+    ctx->Padding = 1;
+    ctx->LayerType = 0;
+    ctx->TRow = (Tr - 1) * ctx->Kstride + 3;
+    ctx->TCol = (Tc - 1) * ctx->Kstride + 3;
+    ctx->ifm.resize(static_cast<size_t>(32) * ctx->Input_h * ctx->IW_align + 512);
+    fill_random(ctx->ifm.data(), ctx->ifm.size(), -1.f, 1.f);
+
+    const size_t elems = static_cast<size_t>(Tn) * ctx->TRow * ctx->TCol;
+    yolo2_bench_run(name, nullptr, run_input_load, ctx.get(), elems, elems * sizeof(IO_Dtype) * 2);
+}
+
+struct WeightLoadCtx {
+    std::vector<IO_Dtype> weights;
+    IO_Dtype weight_buffer[Tm][Tn][K][K];
+    int bits;
+};
+
+void run_weight_load(void *p)
+{
+    WeightLoadCtx *ctx = static_cast<WeightLoadCtx *>(p);
+    // m=n=0 resets the internal stream offset every call.
+    weight_load_reorg(ctx->weights.data(), ctx->weight_buffer, true, 0, 0, 0, K * K, K, Tm, Tn, ctx->bits);
+}
+
+// bits=8 streams packed int8 weights (two per word); INT16 builds only.
+void bench_weight_load_reorg(const char *name, int bits)
+{
+    if (!yolo2_bench_enabled(name)) return;
+    auto ctx = std::make_unique<WeightLoadCtx>();
+    ctx->bits = bits;
+    ctx->weights.resize(static_cast<size_t>(Tm) * Tn * K * K + 16);
+    fill_random(ctx->weights.data(), ctx->weights.size(), -0.1f, 0.1f);
+
+    const size_t elems = static_cast<size_t>(Tm) * Tn * K * K;
+    yolo2_bench_run(name, nullptr, run_weight_load, ctx.get(), elems,
+                    (bits == 8 ? elems : elems * sizeof(IO_Dtype)) + elems * sizeof(IO_Dtype));
+}
+
+struct WriteBackCtx {
+    Acc_Dtype output_buffer[Tm][Tr][Tc];
+    uint16_t requant_mult[MAX_BETA_LENGTH];
+    uint8_t requant_shift[MAX_BETA_LENGTH];
+    std::vector<IO_Dtype> ofm;
+    int Output_w, Output_h, OW_align;
+};
+
+void run_write_back(void *p)
+{
+    WriteBackCtx *ctx = static_cast<WriteBackCtx *>(p);
+    write_back_output_reorg(ctx->output_buffer, ctx->ofm.data(), 0, 0, 0, ctx->OW_align, ctx->Output_h,
+                            Tm, Tr, Tc, ctx->Output_h * ctx->OW_align, true, 8,
+                            ctx->requant_mult, ctx->requant_shift, false, true);
+}
+
+void bench_write_back()
+{
+    const char *name = "core.write_back_output_reorg";
+    if (!yolo2_bench_enabled(name)) return;
+    // Layer 9 of YOLOv2: 26x26x256 leaky output.
+    auto ctx = std::make_unique<WriteBackCtx>();
+    ctx->Output_w = 26;
+    ctx->Output_h = 26;
+    ctx->OW_align = align_256b(ctx->Output_w);
+    ctx->ofm.resize(static_cast<size_t>(256) * ctx->Output_h * ctx->OW_align);
+    fill_random(&ctx->output_buffer[0][0][0], sizeof(ctx->output_buffer) / sizeof(Acc_Dtype), -1.f, 1.f);
+
+    const size_t elems = static_cast<size_t>(Tm) * Tr * Tc;
+    yolo2_bench_run(name, nullptr, run_write_back, ctx.get(), elems, elems * sizeof(IO_Dtype) * 2);
+}
+
+// ---------------------------------------------------------------------------
+// Host-side (CPU) kernels
+
+struct ReorgCtx {
+    std::vector<IO_Dtype> in;
+    std::vector<IO_Dtype> out;
+};
+
+void run_reorg(void *p)
+{
+    ReorgCtx *ctx = static_cast<ReorgCtx *>(p);
+    // Same call shape as the host model's reorg layer.
+    reorg_cpu(ctx->in.data(), 26, 32 * 13, 4, 2, ctx->out.data());
+}
+
+void bench_reorg()
+{
+    const char *name = "host.reorg_cpu";
+    if (!yolo2_bench_enabled(name)) return;
+    ReorgCtx ctx;
+    const size_t elems = static_cast<size_t>(26) * 32 * 13 * 4;
+    ctx.in.resize(elems);
+    ctx.out.resize(elems);
+    fill_random(ctx.in.data(), elems, -1.f, 1.f);
+    yolo2_bench_run(name, nullptr, run_reorg, &ctx, elems, elems * sizeof(IO_Dtype) * 2);
+}
+
+struct WeightReorgCtx {
+    std::vector<IO_Dtype> in;
+    std::vector<IO_Dtype> out;
+    int IFM, OFM, Ksize;
+};
+
+void run_weight_reorg(void *p)
+{
+    WeightReorgCtx *ctx = static_cast<WeightReorgCtx *>(p);
+    WeightReorg(ctx->in.data(), ctx->out.data(), ctx->IFM, ctx->OFM, ctx->Ksize);
+}
+
+void bench_weight_reorg()
+{
+    const char *name = "host.WeightReorg";
+    if (!yolo2_bench_enabled(name)) return;
+    // Layer 10 of YOLOv2: 256 -> 512, 3x3.
+    WeightReorgCtx ctx;
+    ctx.IFM = 256;
+    ctx.OFM = 512;
+    ctx.Ksize = 3;
+    const size_t elems = static_cast<size_t>(ctx.IFM) * ctx.OFM * ctx.Ksize * ctx.Ksize;
+    ctx.in.resize(elems);
+    ctx.out.resize(elems);
+    fill_random(ctx.in.data(), elems, -0.1f, 0.1f);
+    yolo2_bench_run(name, nullptr, run_weight_reorg, &ctx, elems, elems * sizeof(IO_Dtype) * 2);
+}
+
+struct ImageCtx {
+    image src;
+    int w, h;
+};
+
+void run_resize(void *p)
+{
+    ImageCtx *ctx = static_cast<ImageCtx *>(p);
+    image out = resize_image(ctx->src, ctx->w, ctx->h);
+    free_image(out);
+}
+
+void run_letterbox(void *p)
+{
+    ImageCtx *ctx = static_cast<ImageCtx *>(p);
+    image out = letterbox_image(ctx->src, ctx->w, ctx->h);
+    free_image(out);
+}
+
+void bench_images()
+{
+    const bool do_resize = yolo2_bench_enabled("host.resize_image");
+    const bool do_letterbox = yolo2_bench_enabled("host.letterbox_image");
+    if (!do_resize && !do_letterbox) return;
+
+    // dog.jpg sized input (768x576) to the 416x416 network input.
+    ImageCtx ctx;
+    ctx.src = make_image(768, 576, 3);
+    fill_random(ctx.src.data, static_cast<size_t>(768) * 576 * 3, 0.f, 1.f);
+    const size_t src_bytes = static_cast<size_t>(768) * 576 * 3 * sizeof(float);
+
+    if (do_resize) {
+        ctx.w = 416;
+        ctx.h = 312;
+        const size_t elems = static_cast<size_t>(ctx.w) * ctx.h * 3;
+        yolo2_bench_run("host.resize_image", nullptr, run_resize, &ctx, elems, src_bytes + elems * sizeof(float));
+    }
+    if (do_letterbox) {
+        ctx.w = 416;
+        ctx.h = 416;
+        const size_t elems = static_cast<size_t>(ctx.w) * ctx.h * 3;
+        yolo2_bench_run("host.letterbox_image", nullptr, run_letterbox, &ctx, elems, src_bytes + elems * sizeof(float));
+    }
+    free_image(ctx.src);
+}
+
+struct RegionCtx {
+    layer l;
+    std::vector<float> input;
+};
+
+void run_region(void *p)
+{
+    RegionCtx *ctx = static_cast<RegionCtx *>(p);
+    forward_region_layer(ctx->l, ctx->input.data());
+}
+
+struct NmsCtx {
+    std::vector<detection> dets;
+    std::vector<detection> dets_pristine;
+    std::vector<float> probs;
+    std::vector<float> probs_pristine;
+    int classes;
+};
+
+void restore_nms(void *p)
+{
+    NmsCtx *ctx = static_cast<NmsCtx *>(p);
+    ctx->dets = ctx->dets_pristine;
+    std::memcpy(ctx->probs.data(), ctx->probs_pristine.data(), ctx->probs.size() * sizeof(float));
+}
+
+void run_nms(void *p)
+{
+    NmsCtx *ctx = static_cast<NmsCtx *>(p);
+    do_nms_sort(ctx->dets.data(), static_cast<int>(ctx->dets.size()), ctx->classes, 0.45f);
+}
+
+void bench_region_and_nms()
+{
+    const int w = 13, h = 13, num = 5, classes = 80, coords = 4;
+
+    if (yolo2_bench_enabled("host.forward_region_layer")) {
+        RegionCtx ctx;
+        ctx.l = make_region_layer(1, w, h, num, classes, coords);
+        ctx.l.softmax = 1;
+        ctx.input.resize(ctx.l.outputs);
+        fill_random(ctx.input.data(), ctx.input.size(), -4.f, 4.f);
+        const size_t elems = static_cast<size_t>(ctx.l.outputs);
+        yolo2_bench_run("host.forward_region_layer", nullptr, run_region, &ctx, elems, elems * sizeof(float) * 2);
+        free_layer(ctx.l);
+    }
+
+    if (yolo2_bench_enabled("host.do_nms_sort")) {
+        NmsCtx ctx;
+        const int total = w * h * num;
+        ctx.classes = classes;
+        ctx.dets_pristine.resize(total);
+        ctx.dets.resize(total);
+        ctx.probs.resize(static_cast<size_t>(total) * classes);
+        ctx.probs_pristine.resize(ctx.probs.size());
+        std::uniform_real_distribution<float> u(0.f, 1.f);
+        for (int i = 0; i < total; ++i) {
+            detection &d = ctx.dets_pristine[i];
+            std::memset(&d, 0, sizeof(d));
+            d.bbox.x = 0.05f + 0.9f * u(rng());
+            d.bbox.y = 0.05f + 0.9f * u(rng());
+            d.bbox.w = 0.05f + 0.35f * u(rng());
+            d.bbox.h = 0.05f + 0.35f * u(rng());
+            d.objectness = u(rng());
+            d.classes = classes;
+            d.sort_class = -1;
+            d.prob = ctx.probs.data() + static_cast<size_t>(i) * classes;
+            for (int c = 0; c < classes; ++c) {
+                const float p = u(rng());
+                ctx.probs_pristine[static_cast<size_t>(i) * classes + c] = (p > 0.9f) ? p * d.objectness : 0.f;
+            }
+        }
+        yolo2_bench_run("host.do_nms_sort", restore_nms, run_nms, &ctx,
+                        static_cast<size_t>(total) * classes, 0);
+    }
+}
+
+} // namespace
+
+extern "C" int yolo2_bench_enabled(const char *name)
+{
+    if (g_cfg.list_only) {
+        std::printf("  %s\n", name);
+        return 0;
+    }
+    return g_cfg.filter.empty() || std::strstr(name, g_cfg.filter.c_str()) != nullptr;
+}
+
+extern "C" void yolo2_bench_run(const char *name, yolo2_bench_fn setup, yolo2_bench_fn fn, void *ctx,
+                                size_t elems, size_t bytes)
+{
+    // Warm-up: page in buffers and settle caches/branch predictors.
+    if (setup) setup(ctx);
+    fn(ctx);
+
+    std::vector<double> samples;
+    double total_ns = 0.0;
+    while (static_cast<int>(samples.size()) < g_cfg.min_iters || total_ns < g_cfg.min_time_ms * 1e6) {
+        if (setup) setup(ctx);
+        const double t0 = now_ns();
+        fn(ctx);
+        const double dt = now_ns() - t0;
+        samples.push_back(dt);
+        total_ns += dt;
+        if (samples.size() >= 1000000) break;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    BenchResult r;
+    r.name = name;
+    r.iters = static_cast<int>(samples.size());
+    r.ns_per_iter = samples[samples.size() / 2];
+    r.ns_per_elem = elems ? r.ns_per_iter / static_cast<double>(elems) : 0.0;
+    r.gbps = bytes ? static_cast<double>(bytes) / r.ns_per_iter : 0.0;
+    g_results.push_back(r);
+
+    if (bytes) {
+        std::printf("%-34s %9d %14.1f %12.4f %10.3f\n", r.name.c_str(), r.iters, r.ns_per_iter, r.ns_per_elem, r.gbps);
+    } else {
+        std::printf("%-34s %9d %14.1f %12.4f %10s\n", r.name.c_str(), r.iters, r.ns_per_iter, r.ns_per_elem, "-");
+    }
+    std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    try {
+        g_cfg = parse_args(argc, argv);
+
+        if (g_cfg.list_only) {
+            std::printf("Available benchmarks:\n");
+        } else {
+#ifdef INT16_MODE
+            std::printf("YOLOv2 microbenchmarks (int16, Tm=%d Tn=%d Tr=%d Tc=%d)\n", Tm, Tn, Tr, Tc);
+#else
+            std::printf("YOLOv2 microbenchmarks (fp32, Tm=%d Tn=%d Tr=%d Tc=%d)\n", Tm, Tn, Tr, Tc);
+#endif
+            std::printf("%-34s %9s %14s %12s %10s\n", "kernel", "iters", "ns/iter", "ns/elem", "GB/s");
+        }
+
+        bench_compute("core.compute.conv3x3", 3);
+        bench_compute("core.compute.conv1x1", 1);
+        bench_input_load();
+        bench_weight_load_reorg("core.weight_load_reorg", 16);
+#ifdef INT16_MODE
+        bench_weight_load_reorg("core.weight_load_reorg.w8", 8);
+#endif
+        bench_write_back();
+        bench_reorg();
+        bench_weight_reorg();
+        bench_images();
+        bench_region_and_nms();
+        yolo2_bench_linux_app();
+
+        if (g_cfg.list_only) return 0;
+
+        if (!g_cfg.write_baseline_path.empty()) {
+            write_baseline(g_cfg.write_baseline_path);
+        }
+        if (!g_cfg.baseline_path.empty()) {
+            const int regressions = compare_baseline(read_baseline(g_cfg.baseline_path));
+            if (regressions > 0) {
+                std::printf("%d kernel(s) slower than baseline by more than %.1f%%\n", regressions, g_cfg.tolerance_pct);
+                if (g_cfg.fail_on_regression) return 2;
+            }
+        }
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "Fatal error: %s\n", ex.what());
+        return 1;
+    }
+    return 0;
+}
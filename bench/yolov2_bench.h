@@ -0,0 +1,38 @@
+/*
+ * YOLOv2 microbenchmark harness (shared by the C++ host benches and the
+ * linux_app C benches).
+ */
+
+#ifndef YOLOV2_BENCH_H
+#define YOLOV2_BENCH_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*yolo2_bench_fn)(void *ctx);
+
+/**
+ * Time fn(ctx) repeatedly and record the median iteration.
+ *
+ * setup (optional) runs before every iteration outside the timed region,
+ * e.g. to restore inputs that the kernel mutates in place.
+ * elems/bytes are the work done by a single call and drive the ns/element
+ * and GB/s columns.
+ */
+void yolo2_bench_run(const char *name, yolo2_bench_fn setup, yolo2_bench_fn fn, void *ctx,
+                     size_t elems, size_t bytes);
+
+/** Returns non-zero when name passes the --filter given on the command line. */
+int yolo2_bench_enabled(const char *name);
+
+/** linux_app postprocess/draw benches (bench/yolov2_bench_linux_app.c). */
+void yolo2_bench_linux_app(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YOLOV2_BENCH_H */
@@ -0,0 +1,173 @@
+/*
+ * linux_app post-processing / drawing microbenchmarks.
+ *
+ * Compiled as C against linux_app/src so the numbers reflect the exact code
+ * that runs on the board (modulo the host CPU).
+ */
+
+#include "yolov2_bench.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "yolo2_network.h"
+#include "yolo2_postprocess.h"
+#include "yolo2_draw.h"
+
+#define BENCH_REGION_W       13
+#define BENCH_REGION_H       13
+#define BENCH_REGION_NUM     5
+#define BENCH_REGION_CLASSES 80
+#define BENCH_REGION_COORDS  4
+#define BENCH_MAX_DETS       (BENCH_REGION_W * BENCH_REGION_H * BENCH_REGION_NUM)
+#define BENCH_FRAME_W        640
+#define BENCH_FRAME_H        480
+
+static uint32_t bench_rng_state = 0x2545F491u;
+
+static float bench_randf(float lo, float hi)
+{
+    bench_rng_state ^= bench_rng_state << 13;
+    bench_rng_state ^= bench_rng_state >> 17;
+    bench_rng_state ^= bench_rng_state << 5;
+    return lo + (hi - lo) * ((float)(bench_rng_state & 0xFFFFFF) / (float)0x1000000);
+}
+
+typedef struct {
+    layer_t layer;
+    float *input;
+    float *output;
+    yolo2_detection_t *dets;
+    yolo2_detection_t *dets_pristine;
+    float *probs;
+    float *probs_pristine;
+    int num_dets;
+    uint8_t *rgb;
+} linux_app_bench_ctx_t;
+
+static void bench_region_forward(void *p)
+{
+    linux_app_bench_ctx_t *ctx = (linux_app_bench_ctx_t *)p;
+    yolo2_forward_region_layer(&ctx->layer, ctx->input, ctx->output);
+}
+
+static void bench_region_detections(void *p)
+{
+    linux_app_bench_ctx_t *ctx = (linux_app_bench_ctx_t *)p;
+    yolo2_detection_t dets[BENCH_MAX_DETS];
+    const int n = yolo2_get_region_detections(&ctx->layer, ctx->output, 768, 576, 416, 416,
+                                              0.005f, dets, BENCH_MAX_DETS);
+    yolo2_free_detections(dets, n);
+}
+
+static void bench_nms_restore(void *p)
+{
+    linux_app_bench_ctx_t *ctx = (linux_app_bench_ctx_t *)p;
+    memcpy(ctx->dets, ctx->dets_pristine, (size_t)ctx->num_dets * sizeof(yolo2_detection_t));
+    memcpy(ctx->probs, ctx->probs_pristine,
+           (size_t)ctx->num_dets * BENCH_REGION_CLASSES * sizeof(float));
+}
+
+static void bench_nms(void *p)
+{
+    linux_app_bench_ctx_t *ctx = (linux_app_bench_ctx_t *)p;
+    yolo2_do_nms_sort(ctx->dets, ctx->num_dets, BENCH_REGION_CLASSES, 0.45f);
+}
+
+static void bench_draw(void *p)
+{
+    linux_app_bench_ctx_t *ctx = (linux_app_bench_ctx_t *)p;
+    yolo2_draw_detections_rgb24(ctx->rgb, BENCH_FRAME_W, BENCH_FRAME_H, ctx->dets_pristine,
+                                ctx->num_dets, 0.24f, NULL, 0);
+}
+
+void yolo2_bench_linux_app(void)
+{
+    linux_app_bench_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+
+    layer_t *l = &ctx.layer;
+    l->type = LAYER_REGION;
+    l->w = BENCH_REGION_W;
+    l->h = BENCH_REGION_H;
+    l->num = BENCH_REGION_NUM;
+    l->classes = BENCH_REGION_CLASSES;
+    l->coords = BENCH_REGION_COORDS;
+    l->softmax = 1;
+    l->c = l->num * (l->classes + l->coords + 1);
+    l->out_w = l->w;
+    l->out_h = l->h;
+    l->out_c = l->c;
+    l->outputs = l->w * l->h * l->c;
+
+    const size_t outputs = (size_t)l->outputs;
+    ctx.input = (float *)malloc(outputs * sizeof(float));
+    ctx.output = (float *)malloc(outputs * sizeof(float));
+    ctx.dets = (yolo2_detection_t *)calloc(BENCH_MAX_DETS, sizeof(yolo2_detection_t));
+    ctx.dets_pristine = (yolo2_detection_t *)calloc(BENCH_MAX_DETS, sizeof(yolo2_detection_t));
+    ctx.probs = (float *)calloc((size_t)BENCH_MAX_DETS * BENCH_REGION_CLASSES, sizeof(float));
+    ctx.probs_pristine = (float *)calloc((size_t)BENCH_MAX_DETS * BENCH_REGION_CLASSES, sizeof(float));
+    ctx.rgb = (uint8_t *)calloc((size_t)BENCH_FRAME_W * BENCH_FRAME_H * 3, 1);
+    if (!ctx.input || !ctx.output || !ctx.dets || !ctx.dets_pristine ||
+        !ctx.probs || !ctx.probs_pristine || !ctx.rgb) {
+        fprintf(stderr, "ERROR: linux_app bench allocation failed\n");
+        goto cleanup;
+    }
+
+    for (size_t i = 0; i < outputs; ++i) {
+        ctx.input[i] = bench_randf(-4.0f, 4.0f);
+    }
+    yolo2_forward_region_layer(l, ctx.input, ctx.output);
+
+    // One candidate per anchor cell with sparse class scores, as seen after a low threshold.
+    ctx.num_dets = BENCH_MAX_DETS;
+    for (int i = 0; i < ctx.num_dets; ++i) {
+        yolo2_detection_t *d = &ctx.dets_pristine[i];
+        d->bbox.x = bench_randf(0.05f, 0.95f);
+        d->bbox.y = bench_randf(0.05f, 0.95f);
+        d->bbox.w = bench_randf(0.05f, 0.4f);
+        d->bbox.h = bench_randf(0.05f, 0.4f);
+        d->objectness = bench_randf(0.0f, 1.0f);
+        d->classes = BENCH_REGION_CLASSES;
+        d->sort_class = -1;
+        d->prob = ctx.probs + (size_t)i * BENCH_REGION_CLASSES;
+        float *prob = ctx.probs_pristine + (size_t)i * BENCH_REGION_CLASSES;
+        for (int c = 0; c < BENCH_REGION_CLASSES; ++c) {
+            const float p = bench_randf(0.0f, 1.0f);
+            prob[c] = (p > 0.9f) ? p * d->objectness : 0.0f;
+        }
+    }
+    bench_nms_restore(&ctx);
+
+    if (yolo2_bench_enabled("app.forward_region_layer")) {
+        yolo2_bench_run("app.forward_region_layer", NULL, bench_region_forward, &ctx,
+                        outputs, outputs * 2 * sizeof(float));
+    }
+    if (yolo2_bench_enabled("app.get_region_detections")) {
+        yolo2_bench_run("app.get_region_detections", NULL, bench_region_detections, &ctx,
+                        outputs, outputs * sizeof(float));
+    }
+    if (yolo2_bench_enabled("app.do_nms_sort")) {
+        yolo2_bench_run("app.do_nms_sort", bench_nms_restore, bench_nms, &ctx,
+                        (size_t)ctx.num_dets * BENCH_REGION_CLASSES, 0);
+    }
+    if (yolo2_bench_enabled("app.draw_detections_rgb24")) {
+        // Draw from the untouched scores (NMS above zeroes most of them).
+        for (int i = 0; i < ctx.num_dets; ++i) {
+            ctx.dets_pristine[i].prob = ctx.probs_pristine + (size_t)i * BENCH_REGION_CLASSES;
+        }
+        yolo2_bench_run("app.draw_detections_rgb24", NULL, bench_draw, &ctx,
+                        (size_t)BENCH_FRAME_W * BENCH_FRAME_H, 0);
+    }
+
+cleanup:
+    free(ctx.input);
+    free(ctx.output);
+    free(ctx.dets);
+    free(ctx.dets_pristine);
+    free(ctx.probs);
+    free(ctx.probs_pristine);
+    free(ctx.rgb);
+}
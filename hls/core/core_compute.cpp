@@ -1,5 +1,7 @@
 #include "core_compute.hpp"
 #include "core_io.hpp"
+#include "yolo2_act_layout.h"
+#include "yolo2_requant.h"
 
 #include <cstdint>
 #include <cmath>
@@ -16,14 +18,30 @@
 #pragma GCC diagnostic ignored "-Wunknown-pragmas"
 #endif
 
+YOLO2_NS_BEGIN
+
+#ifdef ACT_BLOCKED_LAYOUT
+// write_back_output_reorg writes blocks of Tn channels
+static_assert(Tn == YOLO2_ACT_BLOCK, "ACT_BLOCKED_LAYOUT blocks Tn channels; yolo2_act_layout.h assumes YOLO2_ACT_BLOCK");
+#endif
+
 #define MAX(x,y) ((x)>(y)?(x):(y))
 #define MIN(x,y) ((x)<(y)?(x):(y))
 
-void compute(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype output_buffer[Tm][Tr][Tc],
-             IO_Dtype weight_buffer[Tm][Tn][K][K], IO_Dtype beta_buffer[MAX_BETA_LENGTH], int n_next[1],
-             const int Ksize,const int Kstride,int m,
-             const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable,
-             int Qw, int Qa_in, int Qa_out, int Qb)
+// Max-pool start value (below any activation)
+#ifdef INT16_MODE
+#define POOL_PAD_VALUE static_cast<IO_Dtype>(-32768)
+#else
+#define POOL_PAD_VALUE static_cast<IO_Dtype>(-1024*1024)
+#endif
+
+// Any conv shape: one kernel tap per cycle, each tap read-modify-writes the
+// output tile.
+static void compute_generic(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype output_buffer[Tm][Tr][Tc],
+                            IO_Dtype weight_buffer[Tm][Tn][K][K], IO_Dtype beta_buffer[MAX_BETA_LENGTH], int n_next[1],
+                            const int Ksize,const int Kstride,int m,
+                            const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable, int first_n,
+                            int Qw, int Qa_in, int Qa_out, int Qb)
 {
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer complete dim=1)
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer complete dim=1)
@@ -45,10 +63,16 @@ HLS_PRAGMA(HLS ARRAY_PARTITION variable=local_beta_buffer complete dim=1)
     uint8_t i,j,tr,tc,tm,tn;
     const int n = n_next[0];
 
-    // Precompute shifts to align accumulator/bias into Qa_out domain.
-    const int shift_out = Qa_in + Qw - Qa_out;
-    const int shift_bias = Qb - Qa_out;
-    const bool first_input_tile = (n == 0);
+    // Each slice is shifted into the accumulator domain (Qa_out + ACC_GUARD_BITS);
+    // the guard bits keep its rounding well below one output LSB, and the
+    // rounding to Qa_out happens once, at write-back.
+    const int Qacc = Qa_out + ACC_GUARD_BITS;
+    const int shift_out = Qa_in + Qw - Qacc;
+    const int shift_bias = Qb - Qacc;
+    // The first slice of this accumulator starts from the bias (first_n == 0)
+    // or from zero (a split-K partial sum, see core_scheduler.cpp).
+    const bool first_input_tile = (n == first_n);
+    const bool add_bias = (first_n == 0);
 
     const bool bias_shift_right = (shift_bias > 0);
     const bool bias_shift_left = (shift_bias < 0);
@@ -74,7 +98,7 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
 HLS_PRAGMA(HLS PIPELINE II=1)
                     const int input_row = Kstride*tr + i;
                     const int input_col = Kstride*tc + j;
-                    const bool use_bias_init = (i == 0) && (j == 0) && first_input_tile;
+                    const bool use_init = (i == 0) && (j == 0) && first_input_tile;
                     int64_t base = 0;
                     int64_t partial_sum = 0;
                     int64_t scaled = 0;
@@ -82,8 +106,10 @@ HLS_PRAGMA(HLS PIPELINE II=1)
                     for(tm = 0;tm < Tm;tm++)
                     {
 HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
-                        // Start from bias (shifted to Qa_out) on the very first tile.
-                        if(use_bias_init) {
+                        // Start from the bias (shifted to Qacc) on the very first tile.
+                        if(use_init && !add_bias) {
+                            base = 0;
+                        } else if(use_init) {
                             int64_t b = static_cast<int64_t>(local_beta_buffer[tm]);
                             if (bias_shift_right) {
                                 base = (b + bias_round) >> bias_shift_mag;
@@ -113,9 +139,9 @@ HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
                         }
 
                         acc = base + scaled;
-                        if (acc > 32767) acc = 32767;
-                        if (acc < -32768) acc = -32768;
-                        output_buffer[tm][tr][tc] = static_cast<IO_Dtype>(acc);
+                        if (acc > INT32_MAX) acc = INT32_MAX;
+                        if (acc < INT32_MIN) acc = INT32_MIN;
+                        output_buffer[tm][tr][tc] = static_cast<Acc_Dtype>(acc);
                     }
                 }
 #else
@@ -128,8 +154,11 @@ HLS_PRAGMA(HLS ARRAY_PARTITION variable=local_beta_buffer complete dim=1)
         return;
     }
 
+    (void)Qw; (void)Qa_in; (void)Qa_out; (void)Qb;
     uint8_t i,j,tr,tc,tm,tn;
     int n = n_next[0];
+    const bool first_input_tile = (n == first_n);
+    const bool add_bias = (first_n == 0);
     IO_Dtype partial_mul[Tm][Tn];
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=partial_mul complete dim=1)
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=partial_mul complete dim=2)
@@ -150,8 +179,8 @@ HLS_PRAGMA(HLS PIPELINE II=1)
                     {
 HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
 
-                        if(i==0&&j==0&&n==0)
-                            partial_add[tm] = local_beta_buffer[tm];
+                        if(i==0&&j==0&&first_input_tile)
+                            partial_add[tm] = add_bias ? local_beta_buffer[tm] : (IO_Dtype)0;
                         else
                             partial_add[tm] = output_buffer[tm][tr][tc];
 
@@ -172,7 +201,202 @@ HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
 #endif
 }
 
-void nonlinear_leaky_row(IO_Dtype output_localbuf[Tc], IO_Dtype Input[Tm][Tr][Tc], uint8_t tm, uint8_t tr, uint8_t *tm_n, uint8_t *tr_n, uint8_t TC_MIN,const bool IsNL, bool enable)
+// KS x KS conv at stride KST: the taps of one output pixel are unrolled and
+// share the Tm x Tn MAC array over II = KS*KS cycles, so the same MAC rate as
+// compute_generic() with the partial sum held in a register: the output tile
+// is read and written once per pixel instead of once per tap. Each tap is
+// still rounded and saturated into the accumulator in (i, j) order, so the
+// result is bit-identical.
+template <int KS, int KST>
+static void compute_fixed(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype output_buffer[Tm][Tr][Tc],
+                          IO_Dtype weight_buffer[Tm][Tn][K][K], IO_Dtype beta_buffer[MAX_BETA_LENGTH], int n_next[1],
+                          int m, const int TM_MIN, const int TR_MIN, const int TC_MIN, bool enable, int first_n,
+                          int Qw, int Qa_in, int Qa_out, int Qb)
+{
+    static_assert(KS > 0 && KS <= K && KST > 0 && KST <= S, "kernel shape exceeds K/S");
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer complete dim=1)
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer complete dim=1)
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer complete dim=1)
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer complete dim=2)
+#ifdef INT16_MODE
+    static Acc_Dtype local_beta_buffer[Tm];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=local_beta_buffer complete dim=1)
+
+    if(!enable)
+    {
+        for (int tm = 0; tm < TM_MIN; ++tm) {
+            local_beta_buffer[tm] = static_cast<Acc_Dtype>(beta_buffer[m + tm]);
+        }
+        return;
+    }
+
+    const int n = n_next[0];
+    const int Qacc = Qa_out + ACC_GUARD_BITS;
+    const int shift_out = Qa_in + Qw - Qacc;
+    const int shift_bias = Qb - Qacc;
+    const bool first_input_tile = (n == first_n);
+    const bool add_bias = (first_n == 0);
+
+    const bool bias_shift_right = (shift_bias > 0);
+    const bool bias_shift_left = (shift_bias < 0);
+    const int bias_shift_abs = bias_shift_right ? shift_bias : (bias_shift_left ? -shift_bias : 0);
+    const int bias_shift_mag = (bias_shift_abs > 30) ? 30 : bias_shift_abs;
+    const int64_t bias_round = (bias_shift_right && bias_shift_mag > 0) ? (1LL << (bias_shift_mag - 1)) : 0;
+
+    const bool out_shift_right = (shift_out > 0);
+    const bool out_shift_left = (shift_out < 0);
+    const int out_shift_abs = out_shift_right ? shift_out : (out_shift_left ? -shift_out : 0);
+    const int out_shift_mag = (out_shift_abs > 30) ? 30 : out_shift_abs;
+    const int64_t out_round = (out_shift_right && out_shift_mag > 0) ? (1LL << (out_shift_mag - 1)) : 0;
+
+    for(int tr = 0;tr < TR_MIN;tr++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+        for(int tc = 0;tc < TC_MIN;tc++)
+        {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
+DO_PRAGMA(HLS PIPELINE II=KS*KS)
+            int64_t acc[Tm];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=acc complete dim=1)
+            for(int tm = 0;tm < Tm;tm++)
+            {
+HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
+                if(first_input_tile && !add_bias) {
+                    acc[tm] = 0;
+                } else if(first_input_tile) {
+                    const int64_t b = static_cast<int64_t>(local_beta_buffer[tm]);
+                    if (bias_shift_right) {
+                        acc[tm] = (b + bias_round) >> bias_shift_mag;
+                    } else if (bias_shift_left) {
+                        acc[tm] = b << bias_shift_mag;
+                    } else {
+                        acc[tm] = b;
+                    }
+                } else {
+                    acc[tm] = static_cast<int64_t>(output_buffer[tm][tr][tc]);
+                }
+            }
+
+            for(int i = 0;i < KS;i++)
+                for(int j = 0;j < KS;j++)
+                    for(int tm = 0;tm < Tm;tm++)
+                    {
+                        int64_t partial_sum = 0;
+                        for(int tn = 0;tn < Tn;tn++)
+                        {
+                            const int32_t weight_val = static_cast<int32_t>(weight_buffer[tm][tn][i][j]);
+                            const int32_t input_val = static_cast<int32_t>(input_buffer[tn][KST*tr + i][KST*tc + j]);
+                            partial_sum += static_cast<int64_t>(weight_val * input_val);
+                        }
+
+                        if (out_shift_right) {
+                            partial_sum = (partial_sum + out_round) >> out_shift_mag;
+                        } else if (out_shift_left) {
+                            partial_sum = partial_sum << out_shift_mag;
+                        }
+
+                        int64_t v = acc[tm] + partial_sum;
+                        if (v > INT32_MAX) v = INT32_MAX;
+                        if (v < INT32_MIN) v = INT32_MIN;
+                        acc[tm] = v;
+                    }
+
+            for(int tm = 0;tm < Tm;tm++)
+                output_buffer[tm][tr][tc] = static_cast<Acc_Dtype>(acc[tm]);
+        }
+#else
+    static IO_Dtype local_beta_buffer[Tm];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=local_beta_buffer complete dim=1)
+
+    if(!enable)
+    {
+        copy_local_beta(beta_buffer,local_beta_buffer,TM_MIN, m);
+        return;
+    }
+
+    (void)Qw; (void)Qa_in; (void)Qa_out; (void)Qb;
+    const int n = n_next[0];
+    const bool first_input_tile = (n == first_n);
+    const bool add_bias = (first_n == 0);
+
+    for(int tr = 0;tr < TR_MIN;tr++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+        for(int tc = 0;tc < TC_MIN;tc++)
+        {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
+DO_PRAGMA(HLS PIPELINE II=KS*KS)
+            IO_Dtype acc[Tm];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=acc complete dim=1)
+            for(int tm = 0;tm < Tm;tm++)
+            {
+HLS_PRAGMA(HLS DEPENDENCE variable=output_buffer inter false)
+                if(first_input_tile)
+                    acc[tm] = add_bias ? local_beta_buffer[tm] : (IO_Dtype)0;
+                else
+                    acc[tm] = output_buffer[tm][tr][tc];
+            }
+
+            for(int i = 0;i < KS;i++)
+                for(int j = 0;j < KS;j++)
+                    for(int tm = 0;tm < Tm;tm++)
+                    {
+                        IO_Dtype partial_sum = 0;
+                        for(int tn = 0;tn < Tn;tn++)
+                        {
+                            partial_sum += weight_buffer[tm][tn][i][j]*input_buffer[tn][KST*tr + i][KST*tc + j];
+                        }
+                        acc[tm] = acc[tm] + partial_sum;
+                    }
+
+            for(int tm = 0;tm < Tm;tm++)
+                output_buffer[tm][tr][tc] = acc[tm];
+        }
+#endif
+}
+
+void compute(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype output_buffer[Tm][Tr][Tc],
+             IO_Dtype weight_buffer[Tm][Tn][K][K], IO_Dtype beta_buffer[MAX_BETA_LENGTH], int n_next[1],
+             const int Ksize,const int Kstride,int m,
+             const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable, int first_n,
+             int Qw, int Qa_in, int Qa_out, int Qb)
+{
+    if(Ksize == 3 && Kstride == 1)
+        compute_fixed<3, 1>(input_buffer, output_buffer, weight_buffer, beta_buffer, n_next, m,
+                            TM_MIN, TR_MIN, TC_MIN, enable, first_n, Qw, Qa_in, Qa_out, Qb);
+    else if(Ksize == 1 && Kstride == 1)
+        compute_fixed<1, 1>(input_buffer, output_buffer, weight_buffer, beta_buffer, n_next, m,
+                            TM_MIN, TR_MIN, TC_MIN, enable, first_n, Qw, Qa_in, Qa_out, Qb);
+    else
+#if GENERIC_KERNELS
+        compute_generic(input_buffer, output_buffer, weight_buffer, beta_buffer, n_next, Ksize, Kstride, m,
+                        TM_MIN, TR_MIN, TC_MIN, enable, first_n, Qw, Qa_in, Qa_out, Qb);
+#else
+        assert(!"conv shape not built (GENERIC_KERNELS=0)");
+#endif
+}
+
+// Requantizes one accumulator to the output domain (INT16: multiply by the
+// channel's Mult, shift by OutShift + Shift with rounding, then saturate; see
+// yolo2_requant.h) and applies the leaky activation.
+static IO_Dtype output_value(Acc_Dtype acc, int OutShift, int Mult, int Shift, bool IsNL)
+{
+HLS_PRAGMA(HLS INLINE)
+#ifdef INT16_MODE
+    int64_t v = yolo2_requant(static_cast<int64_t>(acc), Mult, OutShift + Shift);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    int32_t tmp_i = static_cast<int32_t>(v);
+    if(IsNL && tmp_i < 0)
+        tmp_i = tmp_i / 10;
+    return static_cast<IO_Dtype>(tmp_i);
+#else
+    (void)OutShift; (void)Mult; (void)Shift;
+    if((acc < 0.0f)&&IsNL)
+        return acc*0.1f;
+    return acc;
+#endif
+}
+
+void nonlinear_leaky_row(IO_Dtype output_localbuf[Tc], Acc_Dtype Input[Tm][Tr][Tc], uint8_t tm, uint8_t tr, uint8_t *tm_n, uint8_t *tr_n, uint8_t TC_MIN,const bool IsNL, int OutShift, int Mult, int Shift, bool enable)
 {
 HLS_PRAGMA(HLS INLINE)
     if(!enable)
@@ -181,28 +405,11 @@ HLS_PRAGMA(HLS INLINE)
     uint8_t tc;
     assert((TC_MIN>0)&&(TC_MIN<=Tc));
 
-#ifndef INT16_MODE
-    IO_Dtype tmp_out;
-#endif
     for(tc = 0;tc < TC_MIN;tc++)
     {
 DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
 HLS_PRAGMA(HLS PIPELINE II=1)
-        IO_Dtype tmp = Input[tm][tr][tc];
-#ifdef INT16_MODE
-        int32_t tmp_i = static_cast<int32_t>(tmp);
-        if(IsNL && tmp_i < 0)
-            tmp_i = tmp_i / 10;
-        if (tmp_i > 32767) tmp_i = 32767;
-        if (tmp_i < -32768) tmp_i = -32768;
-        output_localbuf[tc] = static_cast<IO_Dtype>(tmp_i);
-#else
-        if((tmp < 0.0f)&&IsNL)
-            tmp_out = tmp*0.1f;
-        else
-            tmp_out = tmp;
-        output_localbuf[tc] = tmp_out;
-#endif
+        output_localbuf[tc] = output_value(Input[tm][tr][tc], OutShift, Mult, Shift, IsNL);
     }
 
     *tm_n = tm;
@@ -219,8 +426,9 @@ HLS_PRAGMA(HLS INLINE)
     memcpy((IO_Dtype *)(Output + ofm_offset), local_buf, TC_MIN*sizeof(IO_Dtype));
 }
 
-void write_back_output_reorg(IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Output,int r,int c,int m,uint16_t Output_w,uint16_t Output_h,
-                             uint8_t TM_MIN,uint8_t TR_MIN,uint8_t TC_MIN,const int OHxOW, bool IsNL, bool write_flag)
+void write_back_output_reorg(Acc_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Output,int r,int c,int m,uint16_t Output_w,uint16_t Output_h,
+                             uint8_t TM_MIN,uint8_t TR_MIN,uint8_t TC_MIN,const int OHxOW, bool IsNL, int OutShift,
+                             uint16_t requant_mult[MAX_BETA_LENGTH], uint8_t requant_shift[MAX_BETA_LENGTH], bool Requant, bool write_flag)
 {
     if(!write_flag || !Output)
         return;
@@ -229,6 +437,41 @@ void write_back_output_reorg(IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Outpu
     assert((TR_MIN >0)&&(TR_MIN <=Tr));
     assert((TC_MIN >0)&&(TC_MIN <=Tc));
 
+#ifdef ACT_BLOCKED_LAYOUT
+    // Channel-blocked layout: m is a multiple of Tn, so every Tn output
+    // channels form one block. Rows are written as one burst per block row,
+    // or as a single burst when the tile spans whole rows. Lanes past TM_MIN
+    // (last block of a layer) are written as zero padding.
+    (void)Output_h;
+    static IO_Dtype tile_buf[Tr*Tc*Tn];
+    for(int tb = 0; tb < TM_MIN; tb += Tn)
+    {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tm/Tn)
+        for(int tr = 0; tr < TR_MIN; tr++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+            for(int tc = 0; tc < TC_MIN; tc++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
+                for(int lane = 0; lane < Tn; lane++)
+                {
+HLS_PRAGMA(HLS PIPELINE II=1)
+                    const int tm = tb + lane;
+                    const bool lane_requant = Requant && (tm < TM_MIN);
+                    const int mult = lane_requant ? (int)requant_mult[m + tm] : 1;
+                    const int shift = lane_requant ? (int)requant_shift[m + tm] : 0;
+                    tile_buf[(tr*TC_MIN + tc)*Tn + lane] = (tm < TM_MIN) ? output_value(output_buffer[tm][tr][tc], OutShift, mult, shift, IsNL) : (IO_Dtype)0;
+                }
+
+        IO_Dtype *block = Output + (m + tb)*OHxOW;
+        if((c == 0)&&(TC_MIN == Output_w))
+            memcpy(block + r*Output_w*Tn, tile_buf, TR_MIN*TC_MIN*Tn*sizeof(IO_Dtype));
+        else
+            for(int tr = 0; tr < TR_MIN; tr++)
+            {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+                memcpy(block + ((r + tr)*Output_w + c)*Tn, tile_buf + tr*TC_MIN*Tn, TC_MIN*Tn*sizeof(IO_Dtype));
+            }
+    }
+#else
     const int offset = m*OHxOW + r*Output_w + c;
     static IO_Dtype local_buf0[Tc];
     static IO_Dtype local_buf1[Tc];
@@ -242,14 +485,17 @@ void write_back_output_reorg(IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Outpu
     for(t = 0;t < TM_MINxTR_MIN + 1;t++)
     {
 DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tm*Tr)
+        const bool row_requant = Requant && (tm < TM_MIN);
+        const int mult = row_requant ? (int)requant_mult[m + tm] : 1;
+        const int shift = row_requant ? (int)requant_shift[m + tm] : 0;
         if(pp)
         {
-            nonlinear_leaky_row( local_buf0, output_buffer, tm, tr, &tm_n0, &tr_n0, TC_MIN, IsNL, t!=TM_MINxTR_MIN);
+            nonlinear_leaky_row( local_buf0, output_buffer, tm, tr, &tm_n0, &tr_n0, TC_MIN, IsNL, OutShift, mult, shift, t!=TM_MINxTR_MIN);
             ofm_mmcpy_row( Output, local_buf1, offset, OHxOW, Output_w, TC_MIN, tm_n1, tr_n1, t!=0);
             pp = false;
         }else
         {
-            nonlinear_leaky_row( local_buf1, output_buffer, tm, tr, &tm_n1, &tr_n1, TC_MIN, IsNL, t!=TM_MINxTR_MIN);
+            nonlinear_leaky_row( local_buf1, output_buffer, tm, tr, &tm_n1, &tr_n1, TC_MIN, IsNL, OutShift, mult, shift, t!=TM_MINxTR_MIN);
             ofm_mmcpy_row( Output, local_buf0, offset, OHxOW, Output_w, TC_MIN, tm_n0, tr_n0, t!=0);
             pp = true;
         }
@@ -261,18 +507,43 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tm*Tr)
             tm++;
         }
     }
+#endif
 }
 
-void pool_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype Output[Tm][Tr][Tc],
-          const int Ksize,const int Kstride,
-          const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable)
+void add_partial_sums(Acc_Dtype output_buffer[Tm][Tr][Tc], Acc_Dtype partial[Tm][Tr][Tc], const int TR_MIN, const int TC_MIN)
 {
-    if(!enable)
-        return;
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer complete dim=1)
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=partial complete dim=1)
+    for(int tr = 0; tr < TR_MIN; tr++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+        for(int tc = 0; tc < TC_MIN; tc++)
+        {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
+HLS_PRAGMA(HLS PIPELINE II=1)
+            for(int tm = 0; tm < Tm; tm++)
+            {
+#ifdef INT16_MODE
+                int64_t acc = static_cast<int64_t>(output_buffer[tm][tr][tc]) + partial[tm][tr][tc];
+                if (acc > INT32_MAX) acc = INT32_MAX;
+                if (acc < INT32_MIN) acc = INT32_MIN;
+                output_buffer[tm][tr][tc] = static_cast<Acc_Dtype>(acc);
+#else
+                output_buffer[tm][tr][tc] += partial[tm][tr][tc];
+#endif
+            }
+        }
+}
 
+// Any pool shape: one tap per cycle.
+static void pool_generic(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
+                         const int Ksize,const int Kstride,
+                         const int TR_MIN,const int TC_MIN)
+{
     uint8_t i,j,tr,tc,of;
     IO_Dtype tmp[Tn];
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=tmp complete dim=1)
+    for(of = 0; of < Tn; of++)
+        tmp[of] = POOL_PAD_VALUE;
 
     for(tr = 0;tr < TR_MIN;tr++)
 DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
@@ -286,22 +557,67 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=K)
 HLS_PRAGMA(HLS PIPELINE II=1)
                     for( of = 0; of < Tn; of++)
                     {
-                        if(i==0&&j==0) {
-#ifdef INT16_MODE
-                            tmp[of] = static_cast<IO_Dtype>(-32768);
-#else
-                            tmp[of] = -1024*1024;
-#endif
-                        }
+                        if(i==0&&j==0)
+                            tmp[of] = POOL_PAD_VALUE;
 
                         if(Input[of][tr*Kstride+i][tc*Kstride+j] > tmp[of])
                             tmp[of] = Input[of][tr*Kstride+i][tc*Kstride+j];
 
-                        if(i==1&&j==1)
+                        if(i==Ksize-1&&j==Ksize-1)
                             Output[of][tr][tc] = tmp[of];
                     }
                 }
+}
 
+// KS x KS pool at stride KST: one kernel row per cycle. The KS taps of a row
+// are unrolled; at KS = 2 they are the two ports of the input buffer bank.
+template <int KS, int KST>
+static void pool_shape(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
+                       const int TR_MIN,const int TC_MIN)
+{
+    static_assert(KS > 0 && KS <= K && KST > 0 && KST <= S, "kernel shape exceeds K/S");
+    IO_Dtype tmp[Tn];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=tmp complete dim=1)
+
+    for(int tr = 0;tr < TR_MIN;tr++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tr)
+        for(int tc = 0;tc < TC_MIN;tc++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=Tc)
+            for(int i = 0;i < KS; i++)
+            {
+HLS_PRAGMA(HLS PIPELINE II=1)
+                for(int of = 0; of < Tn; of++)
+                {
+                    IO_Dtype v = (i == 0) ? POOL_PAD_VALUE : tmp[of];
+                    for(int j = 0;j < KS; j++)
+                    {
+                        const IO_Dtype x = Input[of][tr*KST+i][tc*KST+j];
+                        if(x > v)
+                            v = x;
+                    }
+                    tmp[of] = v;
+                    if(i == KS-1)
+                        Output[of][tr][tc] = v;
+                }
+            }
+}
+
+void pool_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
+          const int Ksize,const int Kstride,
+          const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable)
+{
+    (void)TM_MIN;
+    if(!enable)
+        return;
+
+    if(Ksize == 2 && Kstride == 2)
+        pool_shape<2, 2>(Input, Output, TR_MIN, TC_MIN);
+    else
+#if GENERIC_KERNELS
+        pool_generic(Input, Output, Ksize, Kstride, TR_MIN, TC_MIN);
+#else
+        assert(!"pool shape not built (GENERIC_KERNELS=0)");
+#endif
 }
 
 void zero_output(IO_Dtype output_buffer[Tm][Tr][Tc], int TM_MIN, int TR_MIN, int TC_MIN)
@@ -351,7 +667,7 @@ HLS_PRAGMA(HLS PIPELINE II=1)
             }
 }
 
-void reorg_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype Output[Tm][Tr][Tc],
+void reorg_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
           const int Ksize,const int Kstride,
           const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable)
 {
@@ -378,6 +694,8 @@ HLS_PRAGMA(HLS PIPELINE II=1)
             }
 }
 
+YOLO2_NS_END
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
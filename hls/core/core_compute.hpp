@@ -6,21 +6,44 @@
 #include "types.hpp"
 #include <models/yolov2/yolov2_acc_pragmas.h>
 
-void compute(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype output_buffer[Tm][Tr][Tc],
+// Kernel shapes: compute() and pool_yolo2() dispatch on (Ksize, Kstride) to
+// datapaths built for a fixed shape (conv 3x3/s1 and 1x1/s1, pool 2x2/s2,
+// the shapes of YOLOv2); reorg_yolo2() is always 2x2. Other shapes run a
+// generic datapath with runtime Ksize/Kstride. Every conv datapath has its
+// own Tm x Tn MAC array, so a bitstream for a fixed model can leave the
+// generic ones out with GENERIC_KERNELS=0 (other shapes then fail an assert).
+#ifndef GENERIC_KERNELS
+#define GENERIC_KERNELS 1
+#endif
+
+YOLO2_NS_BEGIN
+
+// output_buffer holds Acc_Dtype partial sums (int32 at Qa_out + ACC_GUARD_BITS
+// in INT16_MODE); write_back_output_reorg() requantizes them by OutShift, and
+// with Requant also by the per-channel multiplier and shift (yolo2_requant.h)
+// that beta_load() put next to the bias, indexed by m + tm.
+// first_n is the first input-channel slice accumulated into output_buffer:
+// 0 starts from the bias, anything else from zero (a split-K partial sum).
+void compute(IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype output_buffer[Tm][Tr][Tc],
              IO_Dtype weight_buffer[Tm][Tn][K][K], IO_Dtype beta_buffer[MAX_BETA_LENGTH], int n_next[1],
              const int Ksize, const int Kstride, int m,
-             const int TM_MIN, const int TR_MIN, const int TC_MIN, bool enable,
+             const int TM_MIN, const int TR_MIN, const int TC_MIN, bool enable, int first_n,
              int Qw, int Qa_in, int Qa_out, int Qb);
 
-void pool_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype Output[Tm][Tr][Tc],
+void add_partial_sums(Acc_Dtype output_buffer[Tm][Tr][Tc], Acc_Dtype partial[Tm][Tr][Tc], const int TR_MIN, const int TC_MIN);
+
+void pool_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
                 const int Ksize,const int Kstride,
                 const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable);
 
-void write_back_output_reorg(IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Output,int r,int c,int m,uint16_t Output_w,uint16_t Output_h,
-                             uint8_t TM_MIN,uint8_t TR_MIN,uint8_t TC_MIN,const int OHxOW, bool IsNL, bool write_flag);
+void write_back_output_reorg(Acc_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype *Output,int r,int c,int m,uint16_t Output_w,uint16_t Output_h,
+                             uint8_t TM_MIN,uint8_t TR_MIN,uint8_t TC_MIN,const int OHxOW, bool IsNL, int OutShift,
+                             uint16_t requant_mult[MAX_BETA_LENGTH], uint8_t requant_shift[MAX_BETA_LENGTH], bool Requant, bool write_flag);
 
-void nonlinear_leaky_row(IO_Dtype output_localbuf[Tc], IO_Dtype Input[Tm][Tr][Tc], uint8_t tm, uint8_t tr, uint8_t *tm_n, uint8_t *tr_n, uint8_t TC_MIN,const bool IsNL, bool enable);
+void nonlinear_leaky_row(IO_Dtype output_localbuf[Tc], Acc_Dtype Input[Tm][Tr][Tc], uint8_t tm, uint8_t tr, uint8_t *tm_n, uint8_t *tr_n, uint8_t TC_MIN,const bool IsNL, int OutShift, int Mult, int Shift, bool enable);
 void ofm_mmcpy_row(IO_Dtype *Output, IO_Dtype local_buf[Tc], int offset, int OHxOW, int Output_w, int TC_MIN, uint8_t tm, uint8_t tr,bool enable);
-void reorg_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype Output[Tm][Tr][Tc],
+void reorg_yolo2(IO_Dtype Input[Tn][OnChipIB_Height][OnChipIB_Width], Acc_Dtype Output[Tm][Tr][Tc],
                  const int Ksize,const int Kstride,
                  const int TM_MIN,const int TR_MIN,const int TC_MIN,bool enable);
+
+YOLO2_NS_END
@@ -1,4 +1,6 @@
 #include "core_io.hpp"
+#include "yolo2_act_layout.h"
+#include "yolo2_requant.h"
 
 #include <cassert>
 #include <algorithm>
@@ -16,6 +18,8 @@
 #pragma GCC diagnostic ignored "-Wunknown-pragmas"
 #endif
 
+YOLO2_NS_BEGIN
+
 void ifm_mmcpy_row(IO_Dtype *input, IO_Dtype local_buf[OnChipIB_Width/8+3][8], int CurrentOffset, int IHxIW, int IW_align_256b, int TCol,
                    uint8_t t1, uint8_t t2, uint8_t *t1_n, uint8_t *t2_n, uint8_t *bn_n, bool enable)
 {
@@ -79,6 +83,61 @@ HLS_PRAGMA(HLS PIPELINE II=1)
     }
 }
 
+#ifdef ACT_BLOCKED_LAYOUT
+static_assert(Tn == YOLO2_ACT_BLOCK, "ACT_BLOCKED_LAYOUT blocks Tn channels; yolo2_act_layout.h assumes YOLO2_ACT_BLOCK");
+
+// Channel-blocked layout (yolo2_act_layout.h): n is a multiple of Tn, so the
+// TN_MIN channels of a tile share one block. Each tile row is a single burst;
+// when the tile covers whole rows, the entire tile is a single burst.
+void input_load(IO_Dtype *input, IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], int r, int c, int n, int Kstride, int Padding, int TRow, int TCol, int Input_w, int IW_align_256b, int Input_h, int TN_MIN, int IHxIW, int LayerType)
+{
+    (void)IW_align_256b;
+    static IO_Dtype tile_buf[TRow_max*TCol_max*Tn];
+
+    const int Coffset = c*Kstride - Padding;
+    const int Roffset = r*Kstride - Padding;
+    const int x0 = MAX(Coffset, 0);
+    const int x1 = MIN(Coffset + TCol, Input_w);
+    const int y0 = MAX(Roffset, 0);
+    const int y1 = MIN(Roffset + TRow, Input_h);
+    const int pitch = (x1 - x0)*Tn;
+    IO_Dtype *block = input + n*IHxIW;
+
+    IO_Dtype pad_value = 0;
+    if(LayerType==1) {
+#ifdef INT16_MODE
+        pad_value = static_cast<IO_Dtype>(-32768);
+#else
+        pad_value = -1024*1024;
+#endif
+    }
+
+    if((x1 > x0)&&(y1 > y0))
+    {
+        if((x0 == 0)&&(x1 == Input_w))
+            memcpy(tile_buf, block + y0*Input_w*Tn, (y1 - y0)*pitch*sizeof(IO_Dtype));
+        else
+            for(int y = y0; y < y1; y++)
+            {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=TRow_max)
+                memcpy(tile_buf + (y - y0)*pitch, block + (y*Input_w + x0)*Tn, pitch*sizeof(IO_Dtype));
+            }
+    }
+
+    for(int t2 = 0; t2 < TRow; t2++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=TRow_max)
+        for(int t3 = 0; t3 < TCol; t3++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=TCol_max)
+            for(int t1 = 0; t1 < Tn; t1++)
+            {
+HLS_PRAGMA(HLS PIPELINE II=1)
+                const int y = Roffset + t2;
+                const int x = Coffset + t3;
+                const bool Enable = (t1 < TN_MIN)&&(y >= y0)&&(y < y1)&&(x >= x0)&&(x < x1);
+                input_buffer[t1][t2][t3] = Enable ? tile_buf[(y - y0)*pitch + (x - x0)*Tn + t1] : pad_value;
+            }
+}
+#else
 void input_load(IO_Dtype *input, IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], int r, int c, int n, int Kstride, int Padding, int TRow, int TCol, int Input_w, int IW_align_256b, int Input_h, int TN_MIN, int IHxIW, int LayerType)
 {
     uint8_t t1,t2;
@@ -136,8 +195,9 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=TRow_max)
         }
     }
 }
+#endif
 
-void weight_load_reorg(IO_Dtype *Weight, IO_Dtype weight_buffer[Tm][Tn][K][K], bool weight_load_enable, int m, int n, int IFM_numxKxK, int KxK, int Ksize, int TM_MIN, int TN_MIN)
+void weight_load_reorg(IO_Dtype *Weight, IO_Dtype weight_buffer[Tm][Tn][K][K], bool weight_load_enable, int m, int n, int IFM_numxKxK, int KxK, int Ksize, int TM_MIN, int TN_MIN, int WeightBits)
 {
     (void)IFM_numxKxK;
     uint8_t t1,t2,t3,t4;
@@ -156,6 +216,95 @@ void weight_load_reorg(IO_Dtype *Weight, IO_Dtype weight_buffer[Tm][Tn][K][K], b
 
     uint16_t mm_offset = TM_MIN*TN_MIN*KxK;
 
+#ifdef INT16_MODE
+    if(WeightBits == 4)
+    {
+        // W4 layers start with a 16-entry int16 codebook, followed by 4-bit
+        // indices packed four per 16-bit word (lowest nibble first). A 256-bit
+        // beat carries 32 indices, expanded through the codebook LUT. The
+        // codebook is read only where the weight stream restarts (m == 0,
+        // n == 0), not per Tm block; the next-layer prefetch in accel_layer
+        // relies on this to leave the next layer's codebook in place.
+        static IO_Dtype codebook[16];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=codebook complete dim=1)
+        if(m==0&&n==0)
+            memcpy(codebook, Weight, 16*sizeof(IO_Dtype));
+
+        uint32_t trans_offset_w4 = 16 + ((Woffset >> 5) << 3);
+        uint8_t begin_w4 = Woffset & 0x1F;
+        uint16_t TCol_w4 = mm_offset + begin_w4;
+        uint16_t loop_cnts_w4 = TCol_w4 >> 5;
+        if(TCol_w4 & 0x1F)
+            loop_cnts_w4++;
+        for(uint16_t t = 0; t < loop_cnts_w4; t++)
+        {
+            memcpy(local_buf[t], Weight + trans_offset_w4 + t*8, 8*sizeof(IO_Dtype));
+        }
+        Woffset += mm_offset;
+
+        uint16_t bp = begin_w4;
+        for(t3 = 0;t3 <Ksize; t3++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=K)
+            for(t4 = 0;t4 <Ksize; t4++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=K)
+                for(t1 = 0;t1 < Tm; t1++)
+                    for(t2 = 0;t2 < Tn; t2++)
+                    {
+HLS_PRAGMA(HLS PIPELINE II=1)
+                        bool Enable = (t1 < TM_MIN)&&(t2 < TN_MIN);
+                        if(Enable)
+                        {
+                            uint16_t word = (uint16_t)local_buf[bp >> 5][(bp >> 2) & 0x7];
+                            weight_buffer[t1][t2][t3][t4] = codebook[(word >> ((bp & 0x3)*4)) & 0xF];
+                            bp++;
+                        }
+                        else
+                            weight_buffer[t1][t2][t3][t4] = 0;
+                    }
+        return;
+    }
+
+    if(WeightBits == 8)
+    {
+        // W8 layers pack two int8 weights per 16-bit word (low byte first), so a
+        // 256-bit beat carries 16 weights and Woffset counts weights, not words.
+        uint32_t trans_offset_w8 = (Woffset >> 4) << 3;
+        uint8_t begin_w8 = Woffset & 0xF;
+        uint16_t TCol_w8 = mm_offset + begin_w8;
+        uint16_t loop_cnts_w8 = TCol_w8 >> 4;
+        if(TCol_w8 & 0xF)
+            loop_cnts_w8++;
+        for(uint16_t t = 0; t < loop_cnts_w8; t++)
+        {
+            memcpy(local_buf[t], Weight + trans_offset_w8 + t*8, 8*sizeof(IO_Dtype));
+        }
+        Woffset += mm_offset;
+
+        uint16_t bp = begin_w8;
+        for(t3 = 0;t3 <Ksize; t3++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=K)
+            for(t4 = 0;t4 <Ksize; t4++)
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=K)
+                for(t1 = 0;t1 < Tm; t1++)
+                    for(t2 = 0;t2 < Tn; t2++)
+                    {
+HLS_PRAGMA(HLS PIPELINE II=1)
+                        bool Enable = (t1 < TM_MIN)&&(t2 < TN_MIN);
+                        if(Enable)
+                        {
+                            IO_Dtype word = local_buf[bp >> 4][(bp >> 1) & 0x7];
+                            weight_buffer[t1][t2][t3][t4] = (bp & 0x1) ? (IO_Dtype)(int8_t)(word >> 8) : (IO_Dtype)(int8_t)(word & 0xFF);
+                            bp++;
+                        }
+                        else
+                            weight_buffer[t1][t2][t3][t4] = 0;
+                    }
+        return;
+    }
+#else
+    (void)WeightBits;
+#endif
+
     uint32_t trans_offset = (Woffset >> 3) << 3;
     uint8_t begin_num = Woffset & 0x7;
     uint16_t TCol_a = mm_offset + begin_num;
@@ -200,7 +349,7 @@ HLS_PRAGMA(HLS PIPELINE II=1)
 
 void copy_input_weight(IO_Dtype *input, IO_Dtype *Weight, int IFM_num, int Input_w, int IW_align_256b, int Input_h, int Ksize, int Kstride, int r, int c, int m, int n,
                        int TM_MIN, int TN, int TRow, int TCol, int Padding, IO_Dtype input_buffer[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype weight_buffer[Tm][Tn][K][K], int n_next[1],
-                       bool enable, bool weight_load_enable, bool initialize, const int IHxIW, const int KxK, const int IFM_numxKxK, const int LayerType)
+                       bool enable, bool weight_load_enable, bool initialize, const int IHxIW, const int KxK, const int IFM_numxKxK, const int LayerType, int WeightBits)
 {
     (void)initialize; // Not used in current implementation but kept for signature compatibility
     if(!enable)
@@ -211,10 +360,10 @@ void copy_input_weight(IO_Dtype *input, IO_Dtype *Weight, int IFM_num, int Input
 
     input_load(input, input_buffer, r, c, n, Kstride, Padding, TRow, TCol, Input_w, IW_align_256b, Input_h, TN_MIN, IHxIW, LayerType);
 #ifdef REORG_TEST
-    weight_load_reorg(Weight, weight_buffer, weight_load_enable, m, n, IFM_numxKxK, KxK, Ksize, TM_MIN, TN_MIN);
+    weight_load_reorg(Weight, weight_buffer, weight_load_enable, m, n, IFM_numxKxK, KxK, Ksize, TM_MIN, TN_MIN, WeightBits);
 #else
     // Note: weight_load function not implemented in modular code, using reorg version
-    weight_load_reorg(Weight, weight_buffer, weight_load_enable, m, n, IFM_numxKxK, KxK, Ksize, TM_MIN, TN_MIN);
+    weight_load_reorg(Weight, weight_buffer, weight_load_enable, m, n, IFM_numxKxK, KxK, Ksize, TM_MIN, TN_MIN, WeightBits);
 #endif
 }
 
@@ -231,11 +380,31 @@ HLS_PRAGMA(HLS PIPELINE II=1)
     }
 }
 
-void beta_copy(IO_Dtype beta_buffer[MAX_BETA_LENGTH], IO_Dtype *Beta, int OFM_num)
+void beta_load(IO_Dtype *Beta, int OFM_num, int WeightBits, IO_Dtype beta_buffer[MAX_BETA_LENGTH],
+               uint16_t mult_buffer[MAX_BETA_LENGTH], uint8_t shift_buffer[MAX_BETA_LENGTH])
 {
-    memcpy(beta_buffer, Beta, OFM_num * sizeof(IO_Dtype));
+    if(!yolo2_wbits_requant(WeightBits))
+    {
+        memcpy(beta_buffer, Beta, OFM_num * sizeof(IO_Dtype));
+        return;
+    }
+#ifdef INT16_MODE
+    for(int o = 0; o < OFM_num; o++)
+    {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=MAX_BETA_LENGTH)
+HLS_PRAGMA(HLS PIPELINE II=3)
+        beta_buffer[o] = Beta[o*YOLO2_REQUANT_WORDS];
+        mult_buffer[o] = static_cast<uint16_t>(Beta[o*YOLO2_REQUANT_WORDS + 1]);
+        shift_buffer[o] = static_cast<uint8_t>(Beta[o*YOLO2_REQUANT_WORDS + 2]);
+    }
+#else
+    (void)mult_buffer; (void)shift_buffer;
+    assert(0 && "per-channel requantization needs INT16_MODE");
+#endif
 }
 
+YOLO2_NS_END
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
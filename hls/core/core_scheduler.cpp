@@ -11,21 +11,33 @@
 #pragma GCC diagnostic ignored "-Wunknown-pragmas"
 #endif
 
-void intra_pingpong_wrapper(IO_Dtype *Input, IO_Dtype *Weight, IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype beta_buffer[MAX_BETA_LENGTH],
+YOLO2_NS_BEGIN
+
+void intra_pingpong_wrapper(IO_Dtype *Input, IO_Dtype *Weight, Acc_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype beta_buffer[MAX_BETA_LENGTH],
                             IO_Dtype input_buffer0[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype input_buffer1[Tn][OnChipIB_Height][OnChipIB_Width],
+                            IO_Dtype weight_buffer0[Tm][Tn][K][K], IO_Dtype weight_buffer1[Tm][Tn][K][K],
                             int IFM_num,int Input_w,int IW_align_256b,int Input_h,int OFM_num,int Ksize,int Kstride,
                             int TMP_R,int TMP_C,int TMP_M,int TM_MIN,int TR_MIN,int TC_MIN,int TN,int TRow,int TCol,int Padding,
                             int IHxIW,int KxK,int IFM_numxKxK,int LayerType,int TM,int TMP_X_next[1],int TX_MIN_next[1],bool pingpongx,bool input_flag,bool process_flag,
-                            int Qw, int Qa_in, int Qa_out, int Qb)
+                            int Qw, int Qa_in, int Qa_out, int Qb, int WeightBits, bool first_weights_ready)
 {
-    static IO_Dtype weight_buffer0[Tm][Tn][K][K];
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer0 complete dim=1)
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer0 complete dim=2)
-
-    static IO_Dtype weight_buffer1[Tm][Tn][K][K];
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer1 complete dim=1)
 HLS_PRAGMA(HLS ARRAY_PARTITION variable=weight_buffer1 complete dim=2)
 
+#if SPLIT_K == 2
+    // Slices loaded into input_buffer1 (n = TN, 3*TN, ...) accumulate here.
+    static Acc_Dtype partial_buffer1[Tm][Tr][Tc];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=partial_buffer1 complete dim=1)
+HLS_PRAGMA(HLS BIND_STORAGE variable=partial_buffer1 type=RAM_S2P impl=LUTRAM)
+    Acc_Dtype (*acc_buffer1)[Tr][Tc] = partial_buffer1;
+    const int first_n1 = TN;
+#else
+    Acc_Dtype (*acc_buffer1)[Tr][Tc] = output_buffer;
+    const int first_n1 = 0;
+#endif
+
     static int NOP[1];
     static int tmp_x;
     static int tmp_tx_min;
@@ -48,17 +60,21 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
             if(pingpong == 1)
             {
                 copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M, n,
-                    TM_MIN,TN,TRow,TCol,Padding,input_buffer1,weight_buffer1, n1, n < IFM_num,1,(TMP_M==0)&&(n==0),IHxIW,KxK,IFM_numxKxK,LayerType);
-                compute(input_buffer0,output_buffer,weight_buffer0,beta_buffer, n0,Ksize,Kstride,TMP_M,TM_MIN,TR_MIN,TC_MIN, n!=0, Qw, Qa_in, Qa_out, Qb);
+                    TM_MIN,TN,TRow,TCol,Padding,input_buffer1,weight_buffer1, n1, n < IFM_num,1,(TMP_M==0)&&(n==0),IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
+                compute(input_buffer0,output_buffer,weight_buffer0,beta_buffer, n0,Ksize,Kstride,TMP_M,TM_MIN,TR_MIN,TC_MIN, n!=0, 0, Qw, Qa_in, Qa_out, Qb);
                 pingpong = 0;
             }else
             {
                 copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M, n,
-                    TM_MIN,TN,TRow,TCol,Padding,input_buffer0,weight_buffer0, n0, n < IFM_num,1,(TMP_M==0)&&(n==0),IHxIW,KxK,IFM_numxKxK,LayerType);
-                compute(input_buffer1,output_buffer,weight_buffer1,beta_buffer, n1,Ksize,Kstride,TMP_M,TM_MIN,TR_MIN,TC_MIN, n!=0, Qw, Qa_in, Qa_out, Qb);
+                    TM_MIN,TN,TRow,TCol,Padding,input_buffer0,weight_buffer0, n0, n < IFM_num,!(first_weights_ready&&(n==0)),(TMP_M==0)&&(n==0),IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
+                compute(input_buffer1,acc_buffer1,weight_buffer1,beta_buffer, n1,Ksize,Kstride,TMP_M,TM_MIN,TR_MIN,TC_MIN, n!=0, first_n1, Qw, Qa_in, Qa_out, Qb);
                 pingpong = 1;
             }
         }
+#if SPLIT_K == 2
+        if(IFM_num > TN)
+            add_partial_sums(output_buffer, partial_buffer1, TR_MIN, TC_MIN);
+#endif
     }
     else if(LayerType==1)
     {
@@ -70,7 +86,7 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
             tmp_tx_min = TM_MIN;
 
             copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M,TMP_M,
-                TM_MIN,TM,TRow,TCol,0,input_buffer0,weight_buffer0,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType);
+                TM_MIN,TM,TRow,TCol,0,input_buffer0,weight_buffer0,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
             pool_yolo2(input_buffer1,output_buffer,Ksize,Kstride,TX_MIN_next[0],TR_MIN,TC_MIN,process_flag);
         }else
         {
@@ -80,7 +96,7 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
             tmp_tx_min = TM_MIN;
 
             copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M,TMP_M,
-                TM_MIN,TM,TRow,TCol,0,input_buffer1,weight_buffer1,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType);
+                TM_MIN,TM,TRow,TCol,0,input_buffer1,weight_buffer1,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
             pool_yolo2(input_buffer0,output_buffer,Ksize,Kstride,TX_MIN_next[0],TR_MIN,TC_MIN,process_flag);
         }
 
@@ -95,7 +111,7 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
             tmp_tx_min = TM_MIN;
 
             copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M,TMP_M,
-                TM_MIN,TM,TRow,TCol,0,input_buffer0,weight_buffer0,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType);
+                TM_MIN,TM,TRow,TCol,0,input_buffer0,weight_buffer0,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
             reorg_yolo2(input_buffer1,output_buffer,Ksize,Kstride,TX_MIN_next[0],TR_MIN,TC_MIN,process_flag);
         }else
         {
@@ -105,13 +121,15 @@ DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
             tmp_tx_min = TM_MIN;
 
             copy_input_weight(Input,Weight,IFM_num,Input_w,IW_align_256b,Input_h,Ksize,Kstride,TMP_R,TMP_C,TMP_M,TMP_M,
-                TM_MIN,TM,TRow,TCol,0,input_buffer1,weight_buffer1,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType);
+                TM_MIN,TM,TRow,TCol,0,input_buffer1,weight_buffer1,NOP,input_flag,0,0,IHxIW,KxK,IFM_numxKxK,LayerType,WeightBits);
             reorg_yolo2(input_buffer0,output_buffer,Ksize,Kstride,TX_MIN_next[0],TR_MIN,TC_MIN,process_flag);
         }
 
     }
 }
 
+YOLO2_NS_END
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
@@ -6,9 +6,26 @@
 #include "core_compute.hpp"
 #include <models/yolov2/yolov2_acc_pragmas.h>
 
-void intra_pingpong_wrapper(IO_Dtype *Input, IO_Dtype *Weight, IO_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype beta_buffer[MAX_BETA_LENGTH],
+YOLO2_NS_BEGIN
+
+// Split-K: number of partial-sum accumulators the input-channel loop of a conv
+// is spread over (1 or 2). With 2, the slices loaded into the two ping-pong
+// input buffers accumulate into separate buffers, so the two compute() calls
+// have no data dependency; the partial sums are added before write-back.
+#ifndef SPLIT_K
+#define SPLIT_K 1
+#endif
+static_assert(SPLIT_K == 1 || SPLIT_K == 2, "SPLIT_K must be 1 or 2");
+
+// weight_buffer0 receives the n = 0 slice of every conv tile. When
+// first_weights_ready is set it already holds it (prefetched by the caller
+// while the previous layer drained), so that weight load is skipped.
+void intra_pingpong_wrapper(IO_Dtype *Input, IO_Dtype *Weight, Acc_Dtype output_buffer[Tm][Tr][Tc], IO_Dtype beta_buffer[MAX_BETA_LENGTH],
                             IO_Dtype input_buffer0[Tn][OnChipIB_Height][OnChipIB_Width], IO_Dtype input_buffer1[Tn][OnChipIB_Height][OnChipIB_Width],
+                            IO_Dtype weight_buffer0[Tm][Tn][K][K], IO_Dtype weight_buffer1[Tm][Tn][K][K],
                             int IFM_num,int Input_w,int IW_align_256b,int Input_h,int OFM_num,int Ksize,int Kstride,
                             int TMP_R,int TMP_C,int TMP_M,int TM_MIN,int TR_MIN,int TC_MIN,int TN,int TRow,int TCol,int Padding,
                             int IHxIW,int KxK,int IFM_numxKxK,int LayerType,int TM,int TMP_X_next[1],int TX_MIN_next[1],bool pingpongx,bool input_flag,bool process_flag,
-                            int Qw, int Qa_in, int Qa_out, int Qb);
+                            int Qw, int Qa_in, int Qa_out, int Qb, int WeightBits, bool first_weights_ready);
+
+YOLO2_NS_END
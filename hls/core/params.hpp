@@ -0,0 +1,16 @@
+#pragma once
+
+// Auto-generated hardware parameter header. Do not edit by hand.
+// Generated by scripts/hw_params_gen.py
+
+constexpr int S = 2;
+constexpr int K = 3;
+constexpr int MAX_BETA_LENGTH = 1024;
+constexpr int Tn = 4;
+constexpr int Tm = 32;
+constexpr int Tr = 13;
+constexpr int Tc = 13;
+constexpr int OnChipIB_Width = 27;
+constexpr int OnChipIB_Height = 27;
+constexpr int TRow_max = 27;
+constexpr int TCol_max = 27;
@@ -3,14 +3,34 @@
 
 #include <cstdint>
 
+// Precision namespace. The synthesis top and the cosim testbench build one
+// precision at global scope. Host builds compile the accelerator sources once
+// per precision with YOLO2_PRECISION_NS=yolo2_fp32 / yolo2_int16 (plus
+// INT16_MODE), so both datapaths link into one binary; yolov2_hls_ps()
+// picks one at run time.
+#ifdef YOLO2_PRECISION_NS
+#define YOLO2_NS_BEGIN namespace YOLO2_PRECISION_NS {
+#define YOLO2_NS_END }
+#else
+#define YOLO2_NS_BEGIN
+#define YOLO2_NS_END
+#endif
+
+YOLO2_NS_BEGIN
+
 // Common accelerator type aliases.
 // In INT16_MODE, IO_Dtype is fixed-point and Acc_Dtype is widened for accumulation.
+// Conv partial sums are kept in Acc_Dtype at ACC_GUARD_BITS more fractional bits
+// than the output (Qa_out + ACC_GUARD_BITS) and rounded once, at write-back.
 #ifdef INT16_MODE
 using IO_Dtype = int16_t;
 using Acc_Dtype = int32_t;
+constexpr int ACC_GUARD_BITS = 8;
 #else
 using IO_Dtype = float;
 using Acc_Dtype = float;
 #endif
 
+YOLO2_NS_END
+
 #endif // YOLOV2_HLS_TYPES_HPP
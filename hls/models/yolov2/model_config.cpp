@@ -1,4 +1,11 @@
 #include "model_config.hpp"
+#include "yolo2_act_layout.h"
+
+#include <core/yolo.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
 
 namespace {
 constexpr std::array<int, 32> kYolo2WeightOffsets = {864, 18432, 73728, 8192, 73728,
@@ -8,6 +15,9 @@ constexpr std::array<int, 32> kYolo2WeightOffsets = {864, 18432, 73728, 8192, 73
 
 constexpr std::array<int, 32> kYolo2BetaOffsets = {32, 64, 128, 64, 128, 256, 128, 256, 512, 256, 512, 256, 512, 1024,
                                                    512, 1024, 512, 1024, 1024, 1024, 64, 1024, 425, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+constexpr std::array<int, 32> kYolo2WeightBits = {16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16,
+                                                  16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16};
 } // namespace
 
 const ModelConfig &yolo2_model_config()
@@ -17,12 +27,74 @@ const ModelConfig &yolo2_model_config()
     // This ensures wrapc writes stay in-bounds during co-simulation.
     static const ModelConfig cfg{
         /*mem_len=*/6922240,
-        /*route16_len=*/(26*32*512),
-        /*conv27_len=*/(13*16*256),
-        /*conv24_len=*/(13*16*1024),
+        /*route16_len=*/static_cast<int>(yolo2_act_words(512, 26, 26)),
+        /*conv27_len=*/static_cast<int>(yolo2_act_words(256, 13, 13)),
+        /*conv24_len=*/static_cast<int>(yolo2_act_words(1024, 13, 13)),
         /*detection_workspace=*/(3*13*425),
         kYolo2WeightOffsets,
-        kYolo2BetaOffsets
+        kYolo2BetaOffsets,
+        kYolo2WeightBits
     };
     return cfg;
 }
+
+std::vector<int> yolo2_weight_bits(const std::string &weights_dir, int conv_layers)
+{
+    const ModelConfig &cfg = yolo2_model_config();
+    std::vector<int> bits(conv_layers, 16);
+    for (int i = 0; i < conv_layers && i < static_cast<int>(cfg.weight_bits.size()); ++i) bits[i] = cfg.weight_bits[i];
+
+    const std::string path = weights_dir + "/weight_bits.bin";
+    FILE *fp = std::fopen(path.c_str(), "rb");
+    if (!fp) return bits;
+    int32_t v = 0;
+    for (int i = 0; i < conv_layers && std::fread(&v, sizeof(v), 1, fp) == 1; ++i) {
+        const int prec = yolo2_wbits_precision(v);
+        if ((prec != 4 && prec != 8 && prec != 16) || (v & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT))) {
+            std::fclose(fp);
+            throw std::runtime_error("Invalid entry " + std::to_string(v) + " for conv " + std::to_string(i) + " in " + path);
+        }
+        bits[i] = v;
+    }
+    std::fclose(fp);
+    return bits;
+}
+
+yolo2_plan_t yolo2_make_plan(const network *net, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                             const std::vector<int> &weight_bits)
+{
+    if (net->n > YOLO2_PLAN_MAX_LAYERS)
+        throw std::runtime_error("Network has " + std::to_string(net->n) + " layers, a layer plan holds " +
+                                 std::to_string(YOLO2_PLAN_MAX_LAYERS));
+    yolo2_plan_t plan{};
+    plan.n = net->n;
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        yolo2_plan_layer_t &p = plan.layers[i];
+        switch (l.type) {
+            case CONVOLUTIONAL: p.type = YOLO2_PLAN_CONV; break;
+            case MAXPOOL: p.type = YOLO2_PLAN_MAXPOOL; break;
+            case REORG: p.type = YOLO2_PLAN_REORG; break;
+            case ROUTE: p.type = YOLO2_PLAN_ROUTE; break;
+            case REGION: p.type = YOLO2_PLAN_REGION; break;
+            default: p.type = YOLO2_PLAN_OTHER; break;
+        }
+        p.ifm = l.c;
+        p.ofm = (l.type == CONVOLUTIONAL) ? l.n : l.out_c;
+        p.ksize = l.size;
+        p.stride = l.stride;
+        p.pad = l.pad;
+        p.in_w = l.w;
+        p.in_h = l.h;
+        p.out_w = l.out_w;
+        p.out_h = l.out_h;
+        p.is_nl = l.activation == LEAKY ? 1 : 0;
+        p.is_bn = l.batch_normalize ? 1 : 0;
+        p.route_layer = (l.type == ROUTE && l.n == 1) ? l.input_layers[0] : -1;
+    }
+    const std::vector<int32_t> bits(weight_bits.begin(), weight_bits.end());
+    if (yolo2_plan_build(&plan, tm, tn, tr, tc, ib_height, ib_width, bits.data(), static_cast<int>(bits.size()),
+                         yolo2_model_config().mem_len) != 0)
+        throw std::runtime_error("Failed to build the layer plan");
+    return plan;
+}
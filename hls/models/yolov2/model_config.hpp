@@ -1,6 +1,13 @@
 #pragma once
 
 #include <array>
+#include <string>
+#include <vector>
+
+#include "yolo2_plan.h"
+#include "yolo2_requant.h"
+
+struct network;
 
 struct ModelConfig {
     int mem_len;
@@ -10,7 +17,34 @@ struct ModelConfig {
     int detection_workspace;
     std::array<int, 32> weight_offsets;
     std::array<int, 32> beta_offsets;
+    // Per-conv weight precision for the INT16 datapath: 16 (one weight per
+    // 16-bit word), 8 (two int8 weights per word) or 4 (a 16-entry int16
+    // codebook, then four 4-bit indices per word), unpacked by weight_load_reorg.
+    // YOLO2_WBITS_REQUANT on top marks per-channel requantization (yolo2_requant.h).
+    std::array<int, 32> weight_bits;
 };
 
 // Descriptor for the YOLOv2 float32/HLS layout.
 const ModelConfig &yolo2_model_config();
+
+// Per-conv weight precision: <weights_dir>/weight_bits.bin (one int32 per conv
+// layer, like the Q tables) when present, otherwise ModelConfig::weight_bits.
+// Throws on entries other than 4, 8 or 16, each optionally with
+// YOLO2_WBITS_REQUANT.
+std::vector<int> yolo2_weight_bits(const std::string &weights_dir, int conv_layers);
+
+// 16-bit words a conv layer occupies in weights_reorg_int16.bin: count words
+// at 16 bits, count/2 at 8 bits, 16 + count/4 at 4 bits, padded to an even
+// number of words.
+inline int yolo2_weight_words(int count, int weight_bits)
+{
+    const int bits = yolo2_wbits_precision(weight_bits);
+    const int words = (bits == 8) ? (count + 1) / 2 : (bits == 4) ? 16 + (count + 3) / 4 : count;
+    return words + (words & 0x1);
+}
+
+// Layer plan (yolo2_plan.h) of a parsed network for the given accelerator
+// tiling and per-conv weight precision. Throws when the network does not fit
+// a plan.
+yolo2_plan_t yolo2_make_plan(const network *net, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                             const std::vector<int> &weight_bits);
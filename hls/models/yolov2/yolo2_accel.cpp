@@ -22,12 +22,179 @@
 #pragma GCC diagnostic ignored "-Wunknown-pragmas"
 #endif
 
+YOLO2_NS_BEGIN
+
+// Tile loops of one conv/maxpool/reorg layer; shared by YOLO2_FPGA and the
+// fused tail, which passes on-chip feature map buffers as Input/Output.
+//
+// NextWeight/NextBeta describe the conv layer that runs after this one (NULL
+// if none). Its bias and first weight tile are loaded during this layer's
+// final drain step, while the last output tile is written back, so the next
+// call starts computing without waiting for them. The bias and requant
+// buffers are banked: the prefetch fills the idle bank, since the last
+// write-back still reads this layer's per-channel multipliers.
+static void accel_layer(IO_Dtype *Input, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *Beta, int IFM_num, int OFM_num,
+                        int Ksize, int Kstride,
+                        int Input_w, int Input_h, int Output_w, int Output_h, int Padding, bool IsNL,
+                        int TM, int TN, int TR, int TC,
+                        int OFM_num_bound, int mLoopsxTM, int mLoops_a1xTM, int LayerType,
+                        int Qw, int Qa_in, int Qa_out, int Qb, int WeightBits,
+                        IO_Dtype *NextWeight, IO_Dtype *NextBeta, int NextIFM_num, int NextOFM_num, int NextKsize, int NextWeightBits)
+{
+#ifdef ACT_BLOCKED_LAYOUT
+    // Blocked rows are unpadded; the *_align_256b names stay for the CHW path.
+    // The reorg path (LayerType 2) is CHW-only; the executors run reorg on the CPU.
+    assert(LayerType != 2);
+    uint16_t IW_align_256b = Input_w;
+    uint16_t OW_align_256b = Output_w;
+#else
+    uint16_t IW_align_256b = (Input_w >> 3) << 3;
+    if(Input_w & 0x7)
+        IW_align_256b += 8;
+    uint16_t OW_align_256b = (Output_w >> 3) << 3;
+    if(Output_w & 0x7)
+        OW_align_256b += 8;
+#endif
+
+    const int OHxOW = Output_h*OW_align_256b;
+    const int TRow = (TR-1)*Kstride+Ksize;
+    const int TCol = (TC-1)*Kstride+Ksize;
+    const int IHxIW   = Input_h*IW_align_256b;
+    const int KxK = Ksize*Ksize;
+    const int IFM_numxKxK = IFM_num*KxK;
+
+    static IO_Dtype input_buffer0[Tn][OnChipIB_Height][OnChipIB_Width];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer0 complete dim=1)
+    static IO_Dtype input_buffer1[Tn][OnChipIB_Height][OnChipIB_Width];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer1 complete dim=1)
+    // Conv partial sums stay Acc_Dtype until write-back drops the guard bits.
+#ifdef INT16_MODE
+    const int OutShift = (LayerType == 0) ? ACC_GUARD_BITS : 0;
+#else
+    const int OutShift = 0;
+#endif
+    const int WeightPrec = yolo2_wbits_precision(WeightBits);
+    const bool Requant = (LayerType == 0) && yolo2_wbits_requant(WeightBits);
+    static Acc_Dtype output_buffer[Tm][Tr][Tc];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer complete dim=1)
+HLS_PRAGMA(HLS BIND_STORAGE variable=output_buffer type=RAM_S2P impl=LUTRAM)
+    static Acc_Dtype output_buffer1[Tm][Tr][Tc];
+HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer1 complete dim=1)
+HLS_PRAGMA(HLS BIND_STORAGE variable=output_buffer1 type=RAM_S2P impl=LUTRAM)
+    static IO_Dtype beta_buffer[2][MAX_BETA_LENGTH];
+    static uint16_t mult_buffer[2][MAX_BETA_LENGTH];
+    static uint8_t shift_buffer[2][MAX_BETA_LENGTH];
+    static int beta_bank = 0;
+    static IO_Dtype weight_buffer0[Tm][Tn][K][K];
+    static IO_Dtype weight_buffer1[Tm][Tn][K][K];
+    // Set when the previous call left this layer's bias in the idle beta
+    // bank and its (m = 0, n = 0) weight tile in weight_buffer0.
+    static bool prefetched = false;
+    const bool weights_ready = prefetched;
+    prefetched = false;
+    if(weights_ready)
+        beta_bank ^= 1;
+    const int bank = beta_bank;
+
+/////////////////////////////////param
+    int r, c, m;
+    int TM_MIN,TR_MIN,TC_MIN;
+///////////////////////////////////////
+
+    int m0[1], m1[1];
+    int TM_MIN0[1], TM_MIN1[1];
+    bool pingpongm;
+
+    if(LayerType==0 && !weights_ready)
+        beta_load(Beta, OFM_num, WeightBits, beta_buffer[bank], mult_buffer[bank], shift_buffer[bank]);
+
+    for(r = 0; r < Output_h; r += TR)
+    {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=1024)
+        TR_MIN = MIN(TR,Output_h-r);
+        for(c = 0; c < Output_w; c += TC)
+        {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=1024)
+            TC_MIN = MIN(TC,Output_w-c);
+            pingpongm = 0;
+            for(m = 0; m < OFM_num_bound; m += TM)
+            {
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
+                TM_MIN = MIN(TM, OFM_num-m);
+                bool Mne0 = (m!=0);
+                bool Mne1 = (m!=TM);
+                bool MnemLps = (m!=mLoopsxTM);
+                bool MneMLps_a1 = (m!=mLoops_a1xTM);
+                bool input_flag = LayerType ? MnemLps&&MneMLps_a1: MnemLps;
+                bool process_flag = LayerType ? Mne0&&MneMLps_a1 : MnemLps;
+                bool write_flag = LayerType ? Mne0&&Mne1 : Mne0;
+                bool first_tile = weights_ready && (r==0) && (c==0) && (m==0);
+                bool last_drain = (LayerType==0) && (r+TR >= Output_h) && (c+TC >= Output_w) && !MnemLps;
+
+                if(last_drain && NextWeight)
+                {
+                    beta_load(NextBeta, NextOFM_num, NextWeightBits, beta_buffer[bank^1], mult_buffer[bank^1], shift_buffer[bank^1]);
+                    weight_load_reorg(NextWeight, weight_buffer0, true, 0, 0, NextIFM_num*NextKsize*NextKsize, NextKsize*NextKsize,
+                                      NextKsize, MIN(NextOFM_num, Tm), MIN(NextIFM_num, Tn), yolo2_wbits_precision(NextWeightBits));
+                    prefetched = true;
+                }
+
+                if(pingpongm==0)
+                {
+                    intra_pingpong_wrapper(Input,Weight,output_buffer1,beta_buffer[bank],input_buffer0,input_buffer1,weight_buffer0,weight_buffer1,
+                                    IFM_num, Input_w, IW_align_256b, Input_h, OFM_num, Ksize, Kstride,
+                                    r, c, m, TM_MIN, TR_MIN, TC_MIN, TN, TRow, TCol, Padding,IHxIW,KxK,IFM_numxKxK,LayerType,TM, m1,TM_MIN1, pingpongm, input_flag, process_flag,
+                                    Qw, Qa_in, Qa_out, Qb, WeightPrec, first_tile);
+
+                    write_back_output_reorg(output_buffer,Output, r, c, m0[0],OW_align_256b,Output_h, TM_MIN0[0], TR_MIN, TC_MIN, OHxOW, IsNL, OutShift,
+                                            mult_buffer[bank], shift_buffer[bank], Requant, write_flag);
+                    pingpongm = 1;
+                }else
+                {
+                    intra_pingpong_wrapper(Input,Weight,output_buffer,beta_buffer[bank],input_buffer0,input_buffer1,weight_buffer0,weight_buffer1,
+                                    IFM_num, Input_w, IW_align_256b, Input_h, OFM_num, Ksize, Kstride,
+                                    r, c, m, TM_MIN, TR_MIN, TC_MIN, TN, TRow, TCol, Padding,IHxIW,KxK,IFM_numxKxK,LayerType,TM, m0,TM_MIN0, pingpongm, input_flag, process_flag,
+                                    Qw, Qa_in, Qa_out, Qb, WeightPrec, first_tile);
+
+                    write_back_output_reorg(output_buffer1,Output, r, c, m1[0],OW_align_256b,Output_h, TM_MIN1[0], TR_MIN, TC_MIN, OHxOW, IsNL, OutShift,
+                                            mult_buffer[bank], shift_buffer[bank], Requant, write_flag);
+                    pingpongm = 0;
+                }
+
+            }
+        }
+    }
+}
+
+// Capability block (yolo2_caps.h): the build parameters of this IP
+static void write_caps(uint32_t Caps[YOLO2_CAPS_WORDS])
+{
+    uint32_t features = YOLO2_CAP_CONV | YOLO2_CAP_MAXPOOL;
+#ifdef ACT_BLOCKED_LAYOUT
+    features |= YOLO2_CAP_ACT_BLOCKED;
+#else
+    features |= YOLO2_CAP_REORG;
+#endif
+#ifdef INT16_MODE
+    features |= YOLO2_CAP_INT16 | YOLO2_CAP_WEIGHTS_8BIT | YOLO2_CAP_WEIGHTS_4BIT | YOLO2_CAP_REQUANT;
+#endif
+    Caps[0] = YOLO2_CAPS_MAGIC;
+    Caps[1] = (YOLO2_CAPS_VERSION_MAJOR << 16) | YOLO2_CAPS_VERSION_MINOR;
+    Caps[2] = Tm | (Tn << 16);
+    Caps[3] = Tr | (Tc << 16);
+    Caps[4] = OnChipIB_Height | (OnChipIB_Width << 16);
+    Caps[5] = K | (S << 8) | (SPLIT_K << 16);
+    Caps[6] = features;
+    Caps[7] = MAX_BETA_LENGTH;
+}
+
 void YOLO2_FPGA(IO_Dtype *Input, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *Beta, int IFM_num, int OFM_num,
                 int Ksize, int Kstride,
                 int Input_w, int Input_h, int Output_w, int Output_h, int Padding, bool IsNL, bool IsBN,
                 int TM, int TN, int TR, int TC,
                 int OFM_num_bound, int mLoopsxTM, int mLoops_a1xTM, int LayerType,
-                int Qw, int Qa_in, int Qa_out, int Qb)
+                int Qw, int Qa_in, int Qa_out, int Qb, int WeightBits,
+                uint32_t Caps[YOLO2_CAPS_WORDS])
 {
 // Depth values for co-simulation (in 32-bit words):
 // Input: max 416*416*3 = 519,168 words (~2MB)
@@ -39,11 +206,11 @@ void YOLO2_FPGA(IO_Dtype *Input, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *B
 // Input: mem_len = 416*416*32 + 208*208*32 = 6,922,240 words
 // Output: layer0 = 416*416*32 = 5,537,792 words
 // Weight: weights_reorg.bin = 50,941,792 words
-// Beta: bias.bin = 10,761 words
+// Beta: bias.bin = 10,761 words; 32,283 with per-channel requant triplets
 HLS_PRAGMA(HLS INTERFACE m_axi depth=6922240  port=Input    offset=slave bundle=DATA_BUS_IN  num_read_outstanding=4 num_write_outstanding=4 max_read_burst_length=64 max_write_burst_length=64)
 HLS_PRAGMA(HLS INTERFACE m_axi depth=5537792  port=Output   offset=slave bundle=DATA_BUS_OUT num_read_outstanding=4 num_write_outstanding=4 max_read_burst_length=64 max_write_burst_length=64)
 HLS_PRAGMA(HLS INTERFACE m_axi depth=50941792 port=Weight  offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
-HLS_PRAGMA(HLS INTERFACE m_axi depth=10761    port=Beta    offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=32283    port=Beta    offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
 
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=return bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=IFM_num bundle=CTRL_BUS)
@@ -66,11 +233,18 @@ HLS_PRAGMA(HLS INTERFACE s_axilite register port=OFM_num_bound bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=mLoopsxTM bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=mLoops_a1xTM bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=LayerType bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=WeightBits bundle=CTRL_BUS)
 
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=Input bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=Output bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=Weight bundle=CTRL_BUS)
 HLS_PRAGMA(HLS INTERFACE s_axilite register port=Beta bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite port=Caps bundle=CTRL_BUS)
+
+    if (LayerType == YOLO2_LAYER_CAPS) {
+        write_caps(Caps);
+        return;
+    }
 
     assert((OFM_num > 0)&&(OFM_num <= 2048));
     assert((IFM_num > 0)&&(IFM_num <= 2048));
@@ -85,91 +259,102 @@ HLS_PRAGMA(HLS INTERFACE s_axilite register port=Beta bundle=CTRL_BUS)
     assert((TN >= 0)&&(TN <= Tn));
     assert((TR > 0)&&(TR <= Tr));
     assert((TC > 0)&&(TC <= Tc));
+    assert((yolo2_wbits_precision(WeightBits) == 4)||(yolo2_wbits_precision(WeightBits) == 8)||(yolo2_wbits_precision(WeightBits) == 16));
+    assert((WeightBits & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT)) == 0);
 
-    uint16_t IW_align_256b = (Input_w >> 3) << 3;
-    if(Input_w & 0x7)
-        IW_align_256b += 8;
-    uint16_t OW_align_256b = (Output_w >> 3) << 3;
-    if(Output_w & 0x7)
-        OW_align_256b += 8;
+    accel_layer(Input, Output, Weight, Beta, IFM_num, OFM_num, Ksize, Kstride,
+                Input_w, Input_h, Output_w, Output_h, Padding, IsNL,
+                TM, TN, TR, TC, OFM_num_bound, mLoopsxTM, mLoops_a1xTM, LayerType,
+                Qw, Qa_in, Qa_out, Qb, WeightBits, NULL, NULL, 0, 0, 0, 16);
+}
 
-    const int OHxOW = Output_h*OW_align_256b;
-    const int TRow = (TR-1)*Kstride+Ksize;
-    const int TCol = (TC-1)*Kstride+Ksize;
-    const int IHxIW   = Input_h*IW_align_256b;
-    const int KxK = Ksize*Ksize;
-    const int IFM_numxKxK = IFM_num*KxK;
+void YOLO2_FPGA_TAIL(IO_Dtype *Input, IO_Dtype *Route, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *Beta,
+                     int *Desc, int LayerCount)
+{
+HLS_PRAGMA(HLS INTERFACE m_axi depth=6922240  port=Input    offset=slave bundle=DATA_BUS_IN  num_read_outstanding=4 max_read_burst_length=64)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=6922240  port=Route    offset=slave bundle=DATA_BUS_IN  num_read_outstanding=4 max_read_burst_length=64)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=5537792  port=Output   offset=slave bundle=DATA_BUS_OUT num_write_outstanding=4 max_write_burst_length=64)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=50941792 port=Weight  offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=32283    port=Beta    offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
+HLS_PRAGMA(HLS INTERFACE m_axi depth=192      port=Desc    offset=slave bundle=DATA_BUS1    num_read_outstanding=4 max_read_burst_length=128)
 
-    static IO_Dtype input_buffer0[Tn][OnChipIB_Height][OnChipIB_Width];
-HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer0 complete dim=1)
-    static IO_Dtype input_buffer1[Tn][OnChipIB_Height][OnChipIB_Width];
-HLS_PRAGMA(HLS ARRAY_PARTITION variable=input_buffer1 complete dim=1)
-    static IO_Dtype output_buffer[Tm][Tr][Tc];
-HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer complete dim=1)
-HLS_PRAGMA(HLS BIND_STORAGE variable=output_buffer type=RAM_S2P impl=LUTRAM)
-    static IO_Dtype output_buffer1[Tm][Tr][Tc];
-HLS_PRAGMA(HLS ARRAY_PARTITION variable=output_buffer1 complete dim=1)
-HLS_PRAGMA(HLS BIND_STORAGE variable=output_buffer1 type=RAM_S2P impl=LUTRAM)
-    static IO_Dtype beta_buffer[MAX_BETA_LENGTH];
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=return bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=LayerCount bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Input bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Route bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Output bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Weight bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Beta bundle=CTRL_BUS)
+HLS_PRAGMA(HLS INTERFACE s_axilite register port=Desc bundle=CTRL_BUS)
 
-/////////////////////////////////param
-    int r, c, m;
-    int TM_MIN,TR_MIN,TC_MIN;
-///////////////////////////////////////
+    assert((LayerCount > 0)&&(LayerCount <= TAIL_MAX_LAYERS));
 
-    int m0[1], m1[1];
-    int TM_MIN0[1], TM_MIN1[1];
-    bool pingpongm;
+#ifdef ACT_BLOCKED_LAYOUT
+    const int plane = TAIL_H*TAIL_W;    // per channel; Tn channels share a block
+#else
+    const int plane = TAIL_H*TAIL_W_ALIGN;
+#endif
+    // 2 x 1280 x 13 x 16 words: ~1 MB of URAM at int16.
+    static IO_Dtype fmap0[TAIL_GUARD + TAIL_MAX_C*TAIL_H*TAIL_W_ALIGN + TAIL_GUARD];
+HLS_PRAGMA(HLS BIND_STORAGE variable=fmap0 type=RAM_2P impl=URAM)
+HLS_PRAGMA(HLS ARRAY_RESHAPE variable=fmap0 cyclic factor=8 dim=1)
+    static IO_Dtype fmap1[TAIL_GUARD + TAIL_MAX_C*TAIL_H*TAIL_W_ALIGN + TAIL_GUARD];
+HLS_PRAGMA(HLS BIND_STORAGE variable=fmap1 type=RAM_2P impl=URAM)
+HLS_PRAGMA(HLS ARRAY_RESHAPE variable=fmap1 cyclic factor=8 dim=1)
+    static int desc[TAIL_MAX_LAYERS][TAIL_DESC_WORDS];
 
-    if(LayerType==0)
-        memcpy(beta_buffer,Beta, OFM_num*sizeof(IO_Dtype));
+    memcpy(desc, Desc, LayerCount*TAIL_DESC_WORDS*sizeof(int));
+    assert((desc[0][TAIL_IFM] > 0)&&(desc[0][TAIL_IFM] <= TAIL_MAX_C));
 
-    for(r = 0; r < Output_h; r += TR)
+    // Stage the first input on chip once; every Tm block re-reads it.
+    memcpy(fmap1 + TAIL_GUARD, Input, desc[0][TAIL_IFM]*plane*sizeof(IO_Dtype));
+    IO_Dtype *in = fmap1 + TAIL_GUARD;
+    bool out_fmap1 = false;
+    for(int l = 0; l < LayerCount; l++)
     {
-DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=1024)
-        TR_MIN = MIN(TR,Output_h-r);
-        for(c = 0; c < Output_w; c += TC)
-        {
-DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=1024)
-            TC_MIN = MIN(TC,Output_w-c);
-            pingpongm = 0;
-            for(m = 0; m < OFM_num_bound; m += TM)
-            {
-DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=2048)
-                TM_MIN = MIN(TM, OFM_num-m);
-                bool Mne0 = (m!=0);
-                bool Mne1 = (m!=TM);
-                bool MnemLps = (m!=mLoopsxTM);
-                bool MneMLps_a1 = (m!=mLoops_a1xTM);
-                bool input_flag = LayerType ? MnemLps&&MneMLps_a1: MnemLps;
-                bool process_flag = LayerType ? Mne0&&MneMLps_a1 : MnemLps;
-                bool write_flag = LayerType ? Mne0&&Mne1 : Mne0;
+DO_PRAGMA(HLS LOOP_TRIPCOUNT min=1 max=TAIL_MAX_LAYERS)
+        const int IFM_num = desc[l][TAIL_IFM];
+        const int OFM_num = desc[l][TAIL_OFM];
+        const int Ksize = desc[l][TAIL_KSIZE];
+        assert((IFM_num > 0)&&(IFM_num <= TAIL_MAX_C));
+        assert((OFM_num > 0)&&(OFM_num <= TAIL_MAX_C));
+        assert((Ksize > 0)&&(Ksize <= K));
 
-                if(pingpongm==0)
-                {
-                    intra_pingpong_wrapper(Input,Weight,output_buffer1,beta_buffer,input_buffer0,input_buffer1,
-                                    IFM_num, Input_w, IW_align_256b, Input_h, OFM_num, Ksize, Kstride,
-                                    r, c, m, TM_MIN, TR_MIN, TC_MIN, TN, TRow, TCol, Padding,IHxIW,KxK,IFM_numxKxK,LayerType,TM, m1,TM_MIN1, pingpongm, input_flag, process_flag,
-                                    Qw, Qa_in, Qa_out, Qb);
+        // The next layer's route channels go in front of this layer's output.
+        int route_c = 0;
+        if(l + 1 < LayerCount && desc[l + 1][TAIL_IFM] > OFM_num)
+            route_c = desc[l + 1][TAIL_IFM] - OFM_num;
+        assert(route_c + OFM_num <= TAIL_MAX_C);
 
-                    write_back_output_reorg(output_buffer,Output, r, c, m0[0],OW_align_256b,Output_h, TM_MIN0[0], TR_MIN, TC_MIN, OHxOW, IsNL, write_flag);
-                    pingpongm = 1;
-                }else
-                {
-                    intra_pingpong_wrapper(Input,Weight,output_buffer,beta_buffer,input_buffer0,input_buffer1,
-                                    IFM_num, Input_w, IW_align_256b, Input_h, OFM_num, Ksize, Kstride,
-                                    r, c, m, TM_MIN, TR_MIN, TC_MIN, TN, TRow, TCol, Padding,IHxIW,KxK,IFM_numxKxK,LayerType,TM, m0,TM_MIN0, pingpongm, input_flag, process_flag,
-                                    Qw, Qa_in, Qa_out, Qb);
+        IO_Dtype *fmap = out_fmap1 ? fmap1 + TAIL_GUARD : fmap0 + TAIL_GUARD;
+        IO_Dtype *out = (l == LayerCount - 1) ? Output : fmap + route_c*plane;
+        if(route_c > 0)
+            memcpy(fmap, Route, route_c*plane*sizeof(IO_Dtype));
 
-                    write_back_output_reorg(output_buffer1,Output, r, c, m1[0],OW_align_256b,Output_h, TM_MIN1[0], TR_MIN, TC_MIN, OHxOW, IsNL, write_flag);
-                    pingpongm = 0;
-                }
+        const int TR = MIN(MIN((OnChipIB_Height-Ksize)+1, Tr), TAIL_H);
+        const int TC = MIN(MIN((OnChipIB_Width-Ksize)+1, Tc), TAIL_W);
+        const int TM = MIN(OFM_num, Tm);
+        const int TN = MIN(IFM_num, Tn);
+        const int mLoops = (OFM_num + TM - 1)/TM;
 
-            }
-        }
+        // Layer l+1's first weight tile and bias load while layer l drains.
+        const bool has_next = (l + 1 < LayerCount);
+        const int nl = has_next ? l + 1 : l;
+
+        accel_layer(in, out, Weight + desc[l][TAIL_WOFFSET], Beta + desc[l][TAIL_BOFFSET], IFM_num, OFM_num,
+                    Ksize, 1, TAIL_W, TAIL_H, TAIL_W, TAIL_H, desc[l][TAIL_PAD], desc[l][TAIL_ISNL] != 0,
+                    TM, TN, TR, TC, (mLoops + 1)*TM, mLoops*TM, (mLoops + 1)*TM, 0,
+                    desc[l][TAIL_QW], desc[l][TAIL_QA_IN], desc[l][TAIL_QA_OUT], desc[l][TAIL_QB], desc[l][TAIL_WBITS],
+                    has_next ? Weight + desc[nl][TAIL_WOFFSET] : NULL, has_next ? Beta + desc[nl][TAIL_BOFFSET] : NULL,
+                    desc[nl][TAIL_IFM], desc[nl][TAIL_OFM], desc[nl][TAIL_KSIZE], desc[nl][TAIL_WBITS]);
+
+        in = fmap;
+        out_fmap1 = !out_fmap1;
     }
 }
 
+YOLO2_NS_END
+
 #if defined(__GNUC__)
 #pragma GCC diagnostic pop
 #endif
@@ -1,12 +1,22 @@
 #pragma once
 
 #include <cstdint>
+#ifndef __SYNTHESIS__
+#include <memory>
+#endif
 
 #include "params.hpp"
 #include "types.hpp"
+#include "yolo2_caps.h"
+#include "yolo2_requant.h"
+
+YOLO2_NS_BEGIN
 
 // Public accelerator entry points. These are host-callable simulation
 // shims that mirror the HLS design.
+//
+// LayerType YOLO2_LAYER_CAPS only fills Caps (yolo2_caps.h) and returns;
+// every other call leaves Caps untouched and may pass NULL.
 void YOLO2_FPGA(IO_Dtype *Input, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *Beta,
                 int IFM_num, int OFM_num, int Ksize, int Kstride,
                 int Input_w, int Input_h, int Output_w, int Output_h,
@@ -14,11 +24,98 @@ void YOLO2_FPGA(IO_Dtype *Input, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *B
                 int TM, int TN, int TR, int TC,
                 int OFM_num_bound, int mLoopsxTM,
                 int mLoops_a1xTM, int LayerType,
-                int Qw, int Qa_in, int Qa_out, int Qb);
+                int Qw, int Qa_in, int Qa_out, int Qb, int WeightBits,
+                uint32_t Caps[YOLO2_CAPS_WORDS]);
+
+// Fused 13x13 tail (convs 18-24, 29, 30). All layers run inside one call and
+// their feature maps stay in two on-chip buffers (CHW, rows padded to
+// TAIL_W_ALIGN). Only the first layer's input, the route channels and the
+// last layer's output touch DDR. Desc holds TAIL_DESC_WORDS ints per layer.
+// A layer whose IFM exceeds the previous layer's OFM reads the route
+// concatenation: the first (IFM - previous OFM) channels come from Route,
+// and the previous layer's output follows.
+constexpr int TAIL_MAX_LAYERS = 16;
+constexpr int TAIL_H = 13;
+constexpr int TAIL_W = 13;
+constexpr int TAIL_W_ALIGN = 16;
+constexpr int TAIL_MAX_C = 1280;    // route-28 concat (256 + 1024) feeding conv 29
+constexpr int TAIL_GUARD = 64;      // input_load reads a padding row/column outside the map
+
+enum Yolo2TailDescField {
+    TAIL_IFM = 0,
+    TAIL_OFM,
+    TAIL_KSIZE,
+    TAIL_PAD,
+    TAIL_ISNL,
+    TAIL_WOFFSET,   // IO words from Weight
+    TAIL_BOFFSET,   // IO words from Beta
+    TAIL_QW,
+    TAIL_QA_IN,
+    TAIL_QA_OUT,
+    TAIL_QB,
+    TAIL_WBITS,     // WeightBits word, with YOLO2_WBITS_REQUANT
+    TAIL_DESC_WORDS
+};
+
+void YOLO2_FPGA_TAIL(IO_Dtype *Input, IO_Dtype *Route, IO_Dtype *Output, IO_Dtype *Weight, IO_Dtype *Beta,
+                     int *Desc, int LayerCount);
+
+YOLO2_NS_END
 
 #ifndef __SYNTHESIS__
 // Host-only helper (excluded from RTL synthesis)
 struct network;
 enum class Precision;
-void yolov2_hls_ps(network *net, const float *input, Precision precision);
+
+// Accelerator-visible output of one layer as it sits in DDR: CHW with rows
+// padded to row_stride elements. type uses the LayerType codes (0 conv,
+// 1 maxpool, 2 reorg). data holds float values for Precision::FP32 and
+// int16_t for Precision::INT16 (is_float).
+struct Yolo2LayerView {
+    int layer;
+    int type;
+    const void *data;
+    bool is_float;
+    int c, h, w, row_stride;
+};
+using Yolo2LayerObserver = void (*)(const Yolo2LayerView &view, void *user);
+
+// observer (optional) is called after every conv/maxpool/reorg layer, e.g.
+// by the calibration tool to collect activation statistics.
+// weight_bits (optional, one entry per conv layer) overrides weights/weight_bits.bin;
+// FP32 runs emulate 8-bit layers by rounding their weights onto the 8-bit grid.
+// YOLO2_FUSED_TAIL=1 runs convs 18-30 through YOLO2_FPGA_TAIL. The observer and
+// the golden store then only see the layers whose output reaches DDR.
+// Runs the precision namespace (types.hpp) given by precision; throws if the
+// binary was not built with it. The simulated accelerator state is global, so
+// concurrent calls (from any precision) run one at a time.
+void yolov2_hls_ps(network *net, const float *input, Precision precision,
+                   Yolo2LayerObserver observer = nullptr, void *observer_user = nullptr,
+                   const int *weight_bits = nullptr);
+
+// Weights, bias and Q tables of one precision as yolov2_hls_ps() would load
+// them from weights_dir. A session (yolo2_session.hpp) loads them once and
+// passes them to every run instead of rereading the files per frame; runs
+// only read them, so one set may be shared by concurrent runs.
+struct Yolo2Weights {
+    virtual ~Yolo2Weights() = default;
+    Precision precision;
+};
+
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, Precision precision,
+                                              const char *weights_dir = "weights",
+                                              const int *weight_bits = nullptr);
+
+// yolov2_hls_ps() on weights from yolov2_hls_load() for the same network
+void yolov2_hls_ps(network *net, const float *input, const Yolo2Weights &weights,
+                   Yolo2LayerObserver observer = nullptr, void *observer_user = nullptr);
+
+YOLO2_NS_BEGIN
+// The host model at this build's IO_Dtype (yolov2_hls_ps() dispatches here)
+void yolov2_hls_run(network *net, const float *input, Yolo2LayerObserver observer,
+                    void *observer_user, const int *weight_bits);
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, const char *weights_dir, const int *weight_bits);
+void yolov2_hls_run(network *net, const float *input, const Yolo2Weights &weights,
+                    Yolo2LayerObserver observer, void *observer_user);
+YOLO2_NS_END
 #endif
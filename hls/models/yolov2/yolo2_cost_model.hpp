@@ -0,0 +1,210 @@
+#pragma once
+
+// Host-only analytical model of one YOLO2_FPGA conv call on the INT16
+// datapath. It walks the same (r, c, m, n) tile loops as yolo2_accel.cpp and
+// charges each step max(load, compute) cycles, assuming the ping-pong buffers
+// overlap the next copy_input_weight() with the current compute():
+//   load    = weight_load_reorg unpack loop (K*K*Tm*Tn) + weight and input
+//             burst beats (8 words / 128 bits per beat); 4-bit layers also
+//             fetch their 16-word codebook at the start of each output tile
+//   compute = K*K*TR_MIN*TC_MIN (PIPELINE II=1 over the output tile)
+// plus the bias burst (three words per channel when requantized) and the output write-back beats per (r, c, m). Bursts follow the activation
+// layout (ACT_BLOCKED_LAYOUT: one burst per Tn-channel block row, or one per
+// block when the tile spans full rows). Good enough to rank configurations
+// (e.g. weight precision); not a substitute for cosim.
+//
+// In the fused tail, layer N+1's bias and first weight tile load while layer
+// N writes back its last output tile; yolo2_prefetch_hidden_cycles() gives the
+// start-up latency that overlap hides.
+//
+// Every estimate takes the engine tiling (default: the compiled params.hpp)
+// so two differently-tiled engines can be compared; yolo2_choose_engine_split()
+// picks the layer boundary for the two-engine frame pipeline.
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "params.hpp"
+#include "yolo2_requant.h"
+
+constexpr double kYolo2ClockHz = 200e6;  // 5 ns, vitis/*_cli.tcl
+constexpr int kYolo2BeatWords = 8;       // IO words per burst beat
+constexpr int kYolo2WordBytes = 2;       // int16 datapath
+
+struct Yolo2ConvShape {
+    int ifm, ofm, ksize, stride, pad;
+    int in_w, in_h;
+};
+
+// Tile sizes of one YOLO2_FPGA build (scripts/hw_params_gen.py).
+struct Yolo2EngineTiling {
+    int tm = Tm, tn = Tn, tr = Tr, tc = Tc;
+
+    int ib_height() const { return (tr - 1) * S + K; }
+    int ib_width() const { return (tc - 1) * S + K; }
+};
+
+struct Yolo2LayerCost {
+    int64_t weight_bytes = 0;  // DDR reads; weights are re-streamed for every output tile
+    int64_t input_bytes = 0;   // DDR reads; inputs are re-read for every Tm block
+    int64_t output_bytes = 0;  // DDR writes
+    int64_t cycles = 0;
+    int64_t prefetch_cycles = 0;  // bias + first weight tile (+ codebook) before the first compute
+    int64_t drain_cycles = 0;     // write-back of the last output tile, with no compute behind it
+
+    int64_t ddr_bytes() const { return weight_bytes + input_bytes + output_bytes; }
+    double seconds() const { return static_cast<double>(cycles) / kYolo2ClockHz; }
+};
+
+inline int64_t yolo2_beats(int64_t words)
+{
+    return (words + kYolo2BeatWords - 1) / kYolo2BeatWords;
+}
+
+inline Yolo2LayerCost yolo2_conv_cost(const Yolo2ConvShape &s, int weight_bits,
+                                      const Yolo2EngineTiling &e = Yolo2EngineTiling())
+{
+    const int out_w = (s.in_w - s.ksize + 2 * s.pad) / s.stride + 1;
+    const int out_h = (s.in_h - s.ksize + 2 * s.pad) / s.stride + 1;
+    const int TR = std::min(std::min((e.ib_height() - s.ksize) / s.stride + 1, e.tr), out_h);
+    const int TC = std::min(std::min((e.ib_width() - s.ksize) / s.stride + 1, e.tc), out_w);
+    const int TM = std::min(s.ofm, e.tm);
+    const int TN = std::min(s.ifm, e.tn);
+    const int TRow = (TR - 1) * s.stride + s.ksize;
+    const int TCol = (TC - 1) * s.stride + s.ksize;
+    const int KxK = s.ksize * s.ksize;
+    const int64_t unpack_cycles = static_cast<int64_t>(KxK) * e.tm * e.tn;
+    const int bits = yolo2_wbits_precision(weight_bits);
+    const int64_t beta_words = static_cast<int64_t>(s.ofm) * yolo2_beta_words(weight_bits);
+
+    Yolo2LayerCost cost;
+    cost.cycles += yolo2_beats(beta_words);
+    cost.prefetch_cycles = yolo2_beats(beta_words) + (bits == 4 ? yolo2_beats(16) : 0);
+    for (int r = 0; r < out_h; r += TR) {
+        const int TR_MIN = std::min(TR, out_h - r);
+        for (int c = 0; c < out_w; c += TC) {
+            const int TC_MIN = std::min(TC, out_w - c);
+            const int64_t compute_cycles = static_cast<int64_t>(KxK) * TR_MIN * TC_MIN;
+            if (bits == 4) {
+                cost.weight_bytes += 16 * kYolo2WordBytes;
+                cost.cycles += yolo2_beats(16);
+            }
+            for (int m = 0; m < s.ofm; m += TM) {
+                const int TM_MIN = std::min(TM, s.ofm - m);
+                for (int n = 0; n < s.ifm; n += TN) {
+                    const int TN_MIN = std::min(TN, s.ifm - n);
+                    const int64_t weights = static_cast<int64_t>(TM_MIN) * TN_MIN * KxK;
+                    const int64_t w_words = (bits == 8)   ? (weights + 1) / 2
+                                            : (bits == 4) ? (weights + 3) / 4
+                                                                 : weights;
+                    const int64_t w_beats = yolo2_beats(w_words) + 1;  // unaligned start
+#ifdef ACT_BLOCKED_LAYOUT
+                    const int64_t in_beats = (TCol >= s.in_w)
+                                                 ? yolo2_beats(static_cast<int64_t>(TRow) * s.in_w * e.tn) + 1
+                                                 : static_cast<int64_t>(TRow) * (yolo2_beats(TCol * e.tn) + 1);
+#else
+                    const int64_t in_beats = static_cast<int64_t>(TN_MIN) * TRow * (yolo2_beats(TCol) + 1);
+#endif
+                    const int64_t load_cycles = unpack_cycles + w_beats + in_beats;
+                    cost.weight_bytes += w_words * kYolo2WordBytes;
+                    cost.input_bytes += in_beats * kYolo2BeatWords * kYolo2WordBytes;
+                    cost.cycles += std::max(load_cycles, compute_cycles);
+                    if (r == 0 && c == 0 && m == 0 && n == 0)
+                        cost.prefetch_cycles += unpack_cycles + w_beats;
+                }
+#ifdef ACT_BLOCKED_LAYOUT
+                const int64_t out_blocks = (TM_MIN + e.tn - 1) / e.tn;
+                const int64_t out_beats = (TC_MIN == out_w)
+                                              ? out_blocks * yolo2_beats(static_cast<int64_t>(TR_MIN) * TC_MIN * e.tn)
+                                              : out_blocks * TR_MIN * yolo2_beats(TC_MIN * e.tn);
+#else
+                const int64_t out_beats = static_cast<int64_t>(TM_MIN) * TR_MIN * yolo2_beats(TC_MIN);
+#endif
+                cost.output_bytes += static_cast<int64_t>(TM_MIN) * TR_MIN * TC_MIN * kYolo2WordBytes;
+                cost.cycles += out_beats;
+                cost.drain_cycles = out_beats;
+            }
+        }
+    }
+    return cost;
+}
+
+// Maxpool through YOLO2_FPGA (LayerType 1): min(Tm, Tn) channels per step,
+// K*K compares per output pixel, same input/output bursts as a conv. `pad` is
+// Darknet's total maxpool padding, as for the layer's out_w/out_h.
+inline Yolo2LayerCost yolo2_pool_cost(const Yolo2ConvShape &s, const Yolo2EngineTiling &e = Yolo2EngineTiling())
+{
+    const int out_w = (s.in_w + s.pad - s.ksize) / s.stride + 1;
+    const int out_h = (s.in_h + s.pad - s.ksize) / s.stride + 1;
+    const int TR = std::min(std::min((e.ib_height() - s.ksize) / s.stride + 1, e.tr), out_h);
+    const int TC = std::min(std::min((e.ib_width() - s.ksize) / s.stride + 1, e.tc), out_w);
+    const int TM = std::min(std::min(e.tm, e.tn), s.ifm);
+    const int TRow = (TR - 1) * s.stride + s.ksize;
+    const int TCol = (TC - 1) * s.stride + s.ksize;
+
+    Yolo2LayerCost cost;
+    for (int r = 0; r < out_h; r += TR) {
+        const int TR_MIN = std::min(TR, out_h - r);
+        for (int c = 0; c < out_w; c += TC) {
+            const int TC_MIN = std::min(TC, out_w - c);
+            for (int m = 0; m < s.ifm; m += TM) {
+                const int TM_MIN = std::min(TM, s.ifm - m);
+#ifdef ACT_BLOCKED_LAYOUT
+                const int64_t in_beats = static_cast<int64_t>(TRow) * (yolo2_beats(TCol * e.tn) + 1);
+                const int64_t out_beats = static_cast<int64_t>(TR_MIN) * yolo2_beats(TC_MIN * e.tn);
+#else
+                const int64_t in_beats = static_cast<int64_t>(TM_MIN) * TRow * (yolo2_beats(TCol) + 1);
+                const int64_t out_beats = static_cast<int64_t>(TM_MIN) * TR_MIN * yolo2_beats(TC_MIN);
+#endif
+                const int64_t compute_cycles = static_cast<int64_t>(s.ksize) * s.ksize * TR_MIN * TC_MIN;
+                cost.input_bytes += in_beats * kYolo2BeatWords * kYolo2WordBytes;
+                cost.output_bytes += static_cast<int64_t>(TM_MIN) * TR_MIN * TC_MIN * kYolo2WordBytes;
+                cost.cycles += std::max(in_beats, compute_cycles) + out_beats;
+            }
+        }
+    }
+    return cost;
+}
+
+// Start-up cycles of `next` that overlap the drain of `cur` when the two run
+// back to back in the fused tail.
+inline int64_t yolo2_prefetch_hidden_cycles(const Yolo2LayerCost &cur, const Yolo2LayerCost &next)
+{
+    return std::min(cur.drain_cycles, next.prefetch_cycles);
+}
+
+// Two-engine frame pipeline: engine A runs layers [0, last_a] of frame N+1
+// while engine B runs layers (last_a, end) of frame N, handing off through
+// DDR. Steady-state frame interval is max(a_cycles, b_cycles).
+struct Yolo2EngineSplit {
+    int last_a = -1;
+    int64_t a_cycles = 0;
+    int64_t b_cycles = 0;
+
+    int64_t interval() const { return std::max(a_cycles, b_cycles); }
+};
+
+// a[i] / b[i]: cycles of layer i on engine A / B (0 for CPU layers). Picks the
+// boundary that minimizes the slower stage; force_last_a >= 0 overrides it.
+// Boundaries before min_last_a are skipped (engine B's weight stream only
+// holds the layers after it).
+inline Yolo2EngineSplit yolo2_choose_engine_split(const std::vector<int64_t> &a, const std::vector<int64_t> &b,
+                                                  int force_last_a = -1, int min_last_a = 0)
+{
+    const int n = static_cast<int>(std::min(a.size(), b.size()));
+    std::vector<int64_t> prefix_a(n + 1, 0), suffix_b(n + 1, 0);
+    for (int i = 0; i < n; ++i) prefix_a[i + 1] = prefix_a[i] + a[i];
+    for (int i = n - 1; i >= 0; --i) suffix_b[i] = suffix_b[i + 1] + b[i];
+
+    Yolo2EngineSplit best;
+    for (int k = std::max(0, min_last_a); k + 1 < n; ++k) {
+        if (force_last_a >= 0 && k != force_last_a) continue;
+        Yolo2EngineSplit cand;
+        cand.last_a = k;
+        cand.a_cycles = prefix_a[k + 1];
+        cand.b_cycles = suffix_b[k + 1];
+        if (best.last_a < 0 || cand.interval() < best.interval()) best = cand;
+    }
+    return best;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+// Host-side (CPU) helpers shared by the host model, the weight generator and
+// the benchmark/tool binaries. Nothing in here is part of the HLS top.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "params.hpp"
+#include "yolo2_requant.h"
+
+// Largest power-of-two Q so that maxabs * 2^Q still fits in a signed
+// `bits`-bit integer (the fixed-point convention of the INT16 datapath).
+inline int select_q(float maxabs, int bits) {
+    const float qmax = static_cast<float>((1 << (bits - 1)) - 1);
+    if (!(maxabs > 0.0f)) return bits - 1;
+    return static_cast<int>(std::floor(std::log2(qmax / maxabs)));
+}
+
+// 4-bit weight sharing (WeightBits == 4): a conv layer stores 16 int16 values
+// and one 4-bit index per weight, expanded by weight_load_reorg().
+constexpr int kYolo2CodebookSize = 16;
+
+struct Yolo2Codebook {
+    int q = 0;                              // fixed-point Q of the entries
+    int16_t code[kYolo2CodebookSize] = {};  // ascending
+
+    float value(int i) const { return std::ldexp(static_cast<float>(code[i]), -q); }
+
+    // Nearest entry; the lower one on ties.
+    int index(float v) const {
+        const float x = v * std::ldexp(1.0f, q);
+        int best = 0;
+        for (int i = 1; i < kYolo2CodebookSize; ++i) {
+            if (std::fabs(x - code[i]) < std::fabs(x - code[best])) best = i;
+        }
+        return best;
+    }
+};
+
+// 1-D k-means over one layer's weights. The centroids start evenly spaced
+// between min and max, so the few large weights keep entries of their own,
+// and are rounded onto the int16 grid at the end. Deterministic, so the FP32
+// emulation and yolov2_weight_gen agree on the table.
+inline Yolo2Codebook yolo2_fit_codebook(const float *w, size_t count) {
+    constexpr int N = kYolo2CodebookSize;
+    std::vector<float> sorted(w, w + count);
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<double> prefix(count + 1, 0.0);
+    for (size_t i = 0; i < count; ++i) prefix[i + 1] = prefix[i] + sorted[i];
+
+    double c[N];
+    const double lo = count ? sorted.front() : 0.0;
+    const double hi = count ? sorted.back() : 0.0;
+    for (int i = 0; i < N; ++i) c[i] = lo + (hi - lo) * i / (N - 1);
+
+    for (int iter = 0; iter < 100; ++iter) {
+        bool moved = false;
+        size_t begin = 0;
+        for (int i = 0; i < N; ++i) {
+            size_t end = count;
+            if (i + 1 < N) {
+                const float mid = static_cast<float>((c[i] + c[i + 1]) / 2);
+                end = std::lower_bound(sorted.begin() + begin, sorted.end(), mid) - sorted.begin();
+            }
+            if (end > begin) {
+                const double mean = (prefix[end] - prefix[begin]) / static_cast<double>(end - begin);
+                moved |= (mean != c[i]);
+                c[i] = mean;
+            }
+            begin = end;
+        }
+        if (!moved) break;
+    }
+
+    Yolo2Codebook cb;
+    float maxabs = 0.0f;
+    for (int i = 0; i < N; ++i) maxabs = std::max(maxabs, static_cast<float>(std::fabs(c[i])));
+    cb.q = select_q(maxabs, 16);
+    const float scale = std::ldexp(1.0f, cb.q);
+    for (int i = 0; i < N; ++i) {
+        const float v = std::nearbyint(static_cast<float>(c[i]) * scale);
+        cb.code[i] = static_cast<int16_t>(std::min(32767.0f, std::max(-32768.0f, v)));
+    }
+    return cb;
+}
+
+// Per-channel requantization (YOLO2_WBITS_REQUANT, yolo2_requant.h). A
+// channel's scale follows its max |w| relative to the layer's, floored so the
+// scaled bias grows at most 2x over the layer's bias max, and at
+// YOLO2_REQUANT_MIN_SCALE. It is snapped to the Q16 multiplier and shift
+// write-back applies, so dividing the channel by `scale` is undone exactly.
+struct Yolo2ChannelRequant {
+    int mult = 65535;
+    int shift = 16;
+    float scale = 1.0f;  // mult * 2^-shift
+};
+
+inline std::vector<Yolo2ChannelRequant> yolo2_channel_requant(const float *chan_maxabs, const float *bias, int ofm) {
+    float wmax = 0.0f, bmax = 0.0f;
+    for (int o = 0; o < ofm; ++o) {
+        wmax = std::max(wmax, chan_maxabs[o]);
+        if (bias) bmax = std::max(bmax, std::fabs(bias[o]));
+    }
+    std::vector<Yolo2ChannelRequant> rq(ofm);
+    for (int o = 0; o < ofm; ++o) {
+        double r = (wmax > 0.0f) ? chan_maxabs[o] / wmax : 1.0;
+        if (bmax > 0.0f) r = std::max(r, std::fabs(bias[o]) / (2.0 * bmax));
+        r = std::min(1.0, std::max(YOLO2_REQUANT_MIN_SCALE, r));
+        int e = 0;
+        while (std::ldexp(r, e) <= 0.5) ++e;  // r * 2^e in (0.5, 1]
+        rq[o].shift = 16 + e;
+        rq[o].mult = std::min(65535, static_cast<int>(std::lround(std::ldexp(r, rq[o].shift))));
+        rq[o].scale = static_cast<float>(std::ldexp(static_cast<double>(rq[o].mult), -rq[o].shift));
+    }
+    return rq;
+}
+
+// Output channel of each weight of a layer, in the order WeightReorgBlock()
+// writes them.
+inline std::vector<int> yolo2_reorg_ofm(int IFM_NUM, int OFM_NUM, int Ksize) {
+    std::vector<int> ofm;
+    ofm.reserve(static_cast<size_t>(IFM_NUM) * OFM_NUM * Ksize * Ksize);
+    for (int m = 0; m < OFM_NUM; m += Tm) {
+        const int TM_MIN = std::min(Tm, OFM_NUM - m);
+        for (int n = 0; n < IFM_NUM; n += Tn) {
+            const int TN_MIN = std::min(Tn, IFM_NUM - n);
+            for (int tk = 0; tk < Ksize * Ksize; tk++)
+                for (int tm = 0; tm < TM_MIN; tm++) ofm.insert(ofm.end(), TN_MIN, m + tm);
+        }
+    }
+    return ofm;
+}
+
+// Darknet reorg (forward, non-flatten) on a CHW tensor.
+template <typename T>
+void reorg_cpu(const T *x, int w, int h, int c, int stride, T *out)
+{
+    int out_c = c/(stride*stride);
+
+    for(int k = 0; k < c; ++k){
+        for(int j = 0; j < h; ++j){
+            for(int i = 0; i < w; ++i){
+                int in_index  = i + w*(j + h*k);
+                int c2 = k % out_c;
+                int offset = k / out_c;
+                int w2 = i*stride + offset % stride;
+                int h2 = j*stride + offset / stride;
+                int out_index = w2 + w*stride*(h2 + h*stride*c2);
+                out[in_index] = x[out_index];
+            }
+        }
+    }
+}
+
+// Reorders output-channel block [m, m+tile_m) of one conv layer of OIHW
+// weights into the TM x TN, KxK-major tile stream consumed by
+// weight_load_reorg(). The block lands at weight_reorg + m*IFM_NUM*Ksize*Ksize,
+// so blocks can be produced independently (and in parallel). convert(value,
+// ofm) maps each source weight to the output type, e.g. for BN folding or
+// quantization. tile_m/tile_n default to the compiled Tm/Tn; another engine
+// build (yolo2_pipeline.h on the board) needs its own.
+template <typename Tin, typename Tout, typename Convert>
+void WeightReorgBlock(const Tin *weight, Tout *weight_reorg, int IFM_NUM, int OFM_NUM, int Ksize, int m,
+                      Convert convert, int tile_m = Tm, int tile_n = Tn) {
+    const int KxK = Ksize * Ksize;
+    const int IFM_NUMxKxK = IFM_NUM * KxK;
+    const int TM_MIN = std::min(tile_m, OFM_NUM - m);
+    Tout *out = weight_reorg + static_cast<size_t>(m) * IFM_NUMxKxK;
+
+    for (int n = 0; n < IFM_NUM; n += tile_n) {
+        const int TN_MIN = std::min(tile_n, IFM_NUM - n);
+        const int TN_MINxTM_MIN = TN_MIN * TM_MIN;
+        const Tin *src = weight + static_cast<size_t>(m) * IFM_NUMxKxK + n * KxK;
+
+        for (int tm = 0; tm < TM_MIN; tm++) {
+            const Tin *row = src + static_cast<size_t>(tm) * IFM_NUMxKxK;
+            for (int tn = 0; tn < TN_MIN; tn++) {
+                for (int tk = 0; tk < KxK; tk++) {
+                    out[tk * TN_MINxTM_MIN + tm * TN_MIN + tn] = convert(row[tn * KxK + tk], m + tm);
+                }
+            }
+        }
+        out += TN_MINxTM_MIN * KxK;
+    }
+}
+
+// Reorders one conv layer of OIHW weights into the TM x TN, KxK-major tile
+// stream consumed by weight_load_reorg().
+template <typename T>
+void WeightReorg(const T *weight, T *weight_reorg, int IFM_NUM, int OFM_NUM, int Ksize) {
+    for (int m = 0; m < OFM_NUM; m += Tm) {
+        WeightReorgBlock(weight, weight_reorg, IFM_NUM, OFM_NUM, Ksize, m, [](T v, int) { return v; });
+    }
+}
@@ -15,6 +15,13 @@
 #include "core_io.hpp"
 #include "core_compute.hpp"
 #include "model_config.hpp"
+#include "yolo2_host_ops.hpp"
+#include "yolo2_golden.h"
+#include "yolo2_tensor.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_ofm_split.h"
+#include "yolo2_cpu_conv.h"
+#include "yolo2_cost_model.hpp"
 #include <core/precision.hpp>
 
 #ifndef __SYNTHESIS__
@@ -29,104 +36,273 @@
 #include <cmath>
 #include <cstdint>
 #include <type_traits>
+#include <chrono>
 
-#ifndef __SYNTHESIS__
-static void dump_float_array_text(const char *path, const float *data, size_t count)
-{
-    if (!path || !path[0] || !data || count == 0) {
-        return;
-    }
+YOLO2_NS_BEGIN
 
-    FILE *fp = std::fopen(path, "w");
-    if (!fp) {
-        std::fprintf(stderr, "Warning: cannot open dump file %s\n", path);
-        return;
-    }
+#ifdef ACT_BLOCKED_LAYOUT
+// The host converts activations with yolo2_act_index(); the IP blocks Tn channels
+static_assert(Tn == YOLO2_ACT_BLOCK, "ACT_BLOCKED_LAYOUT blocks Tn channels; yolo2_act_layout.h assumes YOLO2_ACT_BLOCK");
+#endif
 
-    for (size_t i = 0; i < count; ++i) {
-        std::fprintf(fp, "%.9g\n", data[i]);
-    }
+namespace {
 
-    std::fclose(fp);
-    std::printf("Dumped %zu floats to %s\n", count, path);
+// Convs 18..30 run at 13x13 and can be chained through YOLO2_FPGA_TAIL;
+// route 25 / conv 26 / reorg 27 (the route-16 skip) still go through DDR.
+constexpr int kTailFirst = 18;
+constexpr int kTailLast = 30;
+constexpr int kRouteConv = 26;
+
+bool in_fused_tail(int i) {
+    return i >= kTailFirst && i <= kTailLast && i != kRouteConv;
 }
-#endif
 
-namespace {
-void generate_iofm_offset(IO_Dtype* in_ptr[32], IO_Dtype* out_ptr[32], IO_Dtype *Memory_buf, network *net, const ModelConfig &cfg)
-{
-    IO_Dtype *Memory_top = Memory_buf+512;
-    IO_Dtype *Memory_bottom = Memory_top + cfg.mem_len;
-    for(int x=0;x<18;x++)
-    {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if(out_w & 0x7)
-            out_w_align_256b += 8;
+bool fused_tail_env_enabled() {
+    const char *v = std::getenv("YOLO2_FUSED_TAIL");
+    return v && v[0] && v[0] != '0';
+}
 
-        if(x%2==0)
-        {
-            in_ptr[x] = Memory_top;
-            out_ptr[x] = Memory_bottom - net->layers[x].out_c *  net->layers[x].out_h * out_w_align_256b;
-        }
-        else
-        {
-            in_ptr[x] = out_ptr[x-1];
-            out_ptr[x] = Memory_top;
+// Estimated start-up latency the tail hides by loading each layer's bias and
+// first weight tile while the previous layer drains (see accel_layer()).
+// Printed once per process.
+void report_tail_prefetch(const std::vector<int> &desc) {
+    static bool reported = false;
+    if (reported) return;
+    reported = true;
+    const int layers = static_cast<int>(desc.size()) / TAIL_DESC_WORDS;
+    std::vector<Yolo2LayerCost> costs;
+    for (int l = 0; l < layers; ++l) {
+        const int *d = desc.data() + l * TAIL_DESC_WORDS;
+        const Yolo2ConvShape shape{d[TAIL_IFM], d[TAIL_OFM], d[TAIL_KSIZE], 1, d[TAIL_PAD], TAIL_W, TAIL_H};
+        costs.push_back(yolo2_conv_cost(shape, d[TAIL_WBITS]));
+    }
+    int64_t hidden = 0, total = 0;
+    for (int l = 0; l < layers; ++l) {
+        total += costs[l].cycles;
+        if (l + 1 < layers) hidden += yolo2_prefetch_hidden_cycles(costs[l], costs[l + 1]);
+    }
+    std::printf("Fused tail: cross-layer weight prefetch hides ~%lld cycles (%.1f us, %.2f%% of %lld) over %d layer boundaries\n",
+                static_cast<long long>(hidden), hidden / kYolo2ClockHz * 1e6,
+                total ? 100.0 * hidden / total : 0.0, static_cast<long long>(total), layers - 1);
+}
+
+void check_fused_tail(const network *net) {
+    if (net->n <= kTailLast) throw std::runtime_error("YOLO2_FUSED_TAIL: network has no layer 30");
+    int convs = 0;
+    for (int i = kTailFirst; i <= kTailLast; ++i) {
+        const layer &l = net->layers[i];
+        if (l.type != CONVOLUTIONAL || !in_fused_tail(i)) continue;
+        if (l.w != TAIL_W || l.h != TAIL_H || l.stride != 1 || l.c > TAIL_MAX_C || l.n > TAIL_MAX_C) {
+            throw std::runtime_error("YOLO2_FUSED_TAIL: layer " + std::to_string(i) + " is not a 13x13 stride-1 conv");
         }
+        convs++;
     }
+    if (convs > TAIL_MAX_LAYERS || net->layers[kTailLast].type != CONVOLUTIONAL) {
+        throw std::runtime_error("YOLO2_FUSED_TAIL: unexpected layers between 18 and 30");
+    }
+}
 
-    for(int x=18;x<25;x++)
-    {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if(out_w & 0x7)
-            out_w_align_256b += 8;
+// YOLO2_TWO_ENGINE="tm,tn,tr,tc" gives the tiling of a second YOLO2_FPGA
+// build (engine B); engine A is the compiled params.hpp.
+Yolo2EngineTiling parse_engine_tiling(const char *v) {
+    Yolo2EngineTiling e;
+    if (std::sscanf(v, "%d,%d,%d,%d", &e.tm, &e.tn, &e.tr, &e.tc) != 4 || e.tm <= 0 || e.tn <= 0 ||
+        e.tr <= 0 || e.tc <= 0) {
+        throw std::runtime_error(std::string("YOLO2_TWO_ENGINE: expected tm,tn,tr,tc, got '") + v + "'");
+    }
+    return e;
+}
 
-        if(x%2==0)
-        {
-            in_ptr[x] = Memory_top;
-            out_ptr[x] = Memory_bottom - cfg.route16_len - net->layers[x].out_c *  net->layers[x].out_h * out_w_align_256b;
-        }else
-        {
-            in_ptr[x] = out_ptr[x-1];
-            out_ptr[x] = Memory_top;
+// Plans the two-engine frame pipeline with the cost model and simulates its
+// overlap: engine A runs layers [0, k] of frame N+1 while engine B runs
+// layers (k, end] of frame N, handing off through DDR. The functional run is
+// unaffected (both halves use the compiled tiling here). Printed once per
+// process.
+//
+// An engine B with another Tm/Tn reads its own weight stream, written by
+// yolov2_weight_gen --engine-b; engine_b_stream is its engine_b_tiling.bin
+// ({tm, tn, first conv}, empty when absent) and keeps the split after the
+// last conv layer it lacks, as on the board.
+void report_two_engine_plan(const network *net, const std::vector<int> &weight_bits, const char *tiling,
+                            const std::vector<int32_t> &engine_b_stream) {
+    static bool reported = false;
+    if (reported) return;
+    reported = true;
+
+    const Yolo2EngineTiling engine_a;
+    const Yolo2EngineTiling engine_b = parse_engine_tiling(tiling);
+    int first_b_conv = 0;
+    if (engine_b.tm != engine_a.tm || engine_b.tn != engine_a.tn) {
+        if (engine_b_stream.size() < 3 || engine_b_stream[0] != engine_b.tm || engine_b_stream[1] != engine_b.tn) {
+            throw std::runtime_error("YOLO2_TWO_ENGINE: engine B has Tm=" + std::to_string(engine_b.tm) +
+                                     " Tn=" + std::to_string(engine_b.tn) +
+                                     " but the weights have no stage-B stream for it (yolov2_weight_gen --engine-b)");
+        }
+        first_b_conv = engine_b_stream[2];
+    }
+    std::vector<int64_t> a(net->n, 0), b(net->n, 0);
+    int conv = 0;
+    int min_last_a = 0;
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        if (l.type == CONVOLUTIONAL && conv < first_b_conv) min_last_a = i;
+        const Yolo2ConvShape shape{l.c, l.type == CONVOLUTIONAL ? l.n : l.c, l.size, l.stride, l.pad, l.w, l.h};
+        if (l.type == CONVOLUTIONAL) {
+            const int bits = conv < static_cast<int>(weight_bits.size()) ? weight_bits[conv] : 16;
+            a[i] = yolo2_conv_cost(shape, bits, engine_a).cycles;
+            b[i] = yolo2_conv_cost(shape, bits, engine_b).cycles;
+            conv++;
+        } else if (l.type == MAXPOOL) {
+            a[i] = yolo2_pool_cost(shape, engine_a).cycles;
+            b[i] = yolo2_pool_cost(shape, engine_b).cycles;
         }
     }
 
-    in_ptr[26] = Memory_bottom - cfg.route16_len;
-    out_ptr[26] = Memory_top;
-
-    in_ptr[27] = Memory_top;
-    out_ptr[27] = Memory_bottom - cfg.route16_len - cfg.conv24_len - cfg.conv27_len;
+    const char *force = std::getenv("YOLO2_ENGINE_SPLIT");
+    const int force_last_a = (force && force[0]) ? std::atoi(force) : -1;
+    const Yolo2EngineSplit split = yolo2_choose_engine_split(a, b, force_last_a, min_last_a);
+    if (split.last_a < 0) {
+        throw std::runtime_error("YOLO2_ENGINE_SPLIT: no such layer boundary at or after layer " +
+                                 std::to_string(min_last_a));
+    }
+    int64_t single = 0;
+    for (int64_t c : a) single += c;
+
+    std::printf("Two-engine plan: A = %dx%dx%dx%d (compiled), B = %dx%dx%dx%d\n", engine_a.tm, engine_a.tn, engine_a.tr,
+                engine_a.tc, engine_b.tm, engine_b.tn, engine_b.tr, engine_b.tc);
+    std::printf("  %-5s %12s %12s  %s\n", "layer", "A cycles", "B cycles", "engine");
+    for (int i = 0; i < net->n; ++i) {
+        if (!a[i] && !b[i]) continue;
+        std::printf("  %-5d %12lld %12lld  %c\n", i, static_cast<long long>(a[i]), static_cast<long long>(b[i]),
+                    i <= split.last_a ? 'A' : 'B');
+    }
+    std::printf("  split after layer %d%s: stage A %.2f ms, stage B %.2f ms\n", split.last_a,
+                force_last_a >= 0 ? " (YOLO2_ENGINE_SPLIT)" : "", split.a_cycles / kYolo2ClockHz * 1e3,
+                split.b_cycles / kYolo2ClockHz * 1e3);
+
+    // Event simulation of a short frame stream: stage B of frame f waits for
+    // stage A of frame f and for stage B of frame f-1.
+    const int frames = 8;
+    int64_t a_end = 0, b_end = 0;
+    for (int f = 0; f < frames; ++f) {
+        a_end += split.a_cycles;
+        b_end = std::max(a_end, b_end) + split.b_cycles;
+    }
+    std::printf("  %d frames: single engine %.2f ms, two engines %.2f ms; steady state %.2f ms/frame (%.1f fps) vs %.2f ms "
+                "(%.1f fps), latency %.2f ms\n",
+                frames, frames * single / kYolo2ClockHz * 1e3, b_end / kYolo2ClockHz * 1e3,
+                split.interval() / kYolo2ClockHz * 1e3, kYolo2ClockHz / split.interval(), single / kYolo2ClockHz * 1e3,
+                kYolo2ClockHz / single, (split.a_cycles + split.b_cycles) / kYolo2ClockHz * 1e3);
+}
 
-    in_ptr[29] = out_ptr[27];
-    out_ptr[29] = Memory_top;
+// Tiling limits of the accelerator, read from its capability block
+// (yolo2_caps.h) as linux_app does on the board.
+yolo2_caps_t query_accel_caps() {
+    uint32_t words[YOLO2_CAPS_WORDS] = {};
+    YOLO2_FPGA(nullptr, nullptr, nullptr, nullptr, 0, 0, 0, 0, 0, 0, 0, 0, 0, false, false,
+               0, 0, 0, 0, 0, 0, 0, YOLO2_LAYER_CAPS, 0, 0, 0, 0, 16, words);
+    yolo2_caps_t caps;
+    if (yolo2_caps_decode(words, &caps) != 0)
+        throw std::runtime_error("YOLO2_FPGA returned no capability block");
+    return caps;
+}
 
-    in_ptr[30] = Memory_top;
-    out_ptr[30] = Memory_bottom - (net->layers[30].outputs + cfg.detection_workspace);
+// YOLO2_ACCEL_INSTANCES=N runs every conv layer as N output-channel slices
+// (yolo2_ofm_split.h), one YOLO2_FPGA call each, as linux_app does on N
+// instances. The calls run one after another here, so the output must stay
+// bit-identical to N=1.
+int accel_instances_env() {
+    const char *v = std::getenv("YOLO2_ACCEL_INSTANCES");
+    if (!v || !v[0]) return 1;
+    const int n = std::atoi(v);
+    if (n < 1) throw std::runtime_error(std::string("YOLO2_ACCEL_INSTANCES: expected a count >= 1, got '") + v + "'");
+    return n;
+}
 
-    in_ptr[31] = out_ptr[30];
+// YOLO2_CPU_OFFLOAD=<fraction>|auto computes the last output channels of
+// every conv with the CPU kernel that linux_app overlaps with the accelerator
+// (yolo2_cpu_conv.h). Here it runs after the YOLO2_FPGA call, so the output
+// must stay bit-identical. "auto" balances host wall times, which say nothing
+// about the board; it only exercises the tuner.
+bool cpu_offload_env(yolo2_cpu_offload_t *state) {
+    const char *v = std::getenv("YOLO2_CPU_OFFLOAD");
+    const int on = yolo2_cpu_offload_init(state, v);
+    if (on < 0) throw std::runtime_error(std::string("YOLO2_CPU_OFFLOAD: expected a fraction in [0, 1) or 'auto', got '") + v + "'");
+#ifndef INT16_MODE
+    if (on > 0) throw std::runtime_error("YOLO2_CPU_OFFLOAD needs --precision int16");
+#endif
+    return on > 0;
 }
 
-void reorg_cpu(IO_Dtype *x, int w, int h, int c, int stride, IO_Dtype *out)
-{
-    int out_c = c/(stride*stride);
-
-    for(int k = 0; k < c; ++k){
-        for(int j = 0; j < h; ++j){
-            for(int i = 0; i < w; ++i){
-                int in_index  = i + w*(j + h*k);
-                int c2 = k % out_c;
-                int offset = k / out_c;
-                int w2 = i*stride + offset % stride;
-                int h2 = j*stride + offset / stride;
-                int out_index = w2 + w*stride*(h2 + h*stride*c2);
-                out[in_index] = x[out_index];
-            }
+// Cost-model estimate for N identical instances, per conv layer and per
+// frame: output-channel splitting (frame time = sum over layers of the
+// slowest slice) against whole-frame assignment (N frames in flight, each at
+// single-engine latency). Printed once per process.
+void report_multi_instance_plan(const network *net, const std::vector<int> &weight_bits, int instances) {
+    static bool reported = false;
+    if (reported) return;
+    reported = true;
+
+    int64_t single = 0, split = 0, single_bytes = 0, split_bytes = 0;
+    int conv = 0;
+    std::printf("%d-instance plan (%dx%dx%dx%d each):\n", instances, Tm, Tn, Tr, Tc);
+    std::printf("  %-5s %12s %12s %8s\n", "layer", "1 engine", "OFM split", "speedup");
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        const Yolo2ConvShape shape{l.c, l.type == CONVOLUTIONAL ? l.n : l.c, l.size, l.stride, l.pad, l.w, l.h};
+        if (l.type == MAXPOOL) {
+            const Yolo2LayerCost pool = yolo2_pool_cost(shape);
+            single += pool.cycles;
+            split += pool.cycles;
+            single_bytes += pool.ddr_bytes();
+            split_bytes += pool.ddr_bytes();
+            continue;
         }
+        if (l.type != CONVOLUTIONAL) continue;
+        const int bits = conv < static_cast<int>(weight_bits.size()) ? weight_bits[conv] : 16;
+        conv++;
+        const Yolo2LayerCost whole = yolo2_conv_cost(shape, bits);
+        yolo2_ofm_slice_t slices[64];
+        const int n = yolo2_ofm_split(l.n, l.c, l.size, std::min(l.n, Tm), bits, std::min(instances, 64), slices);
+        int64_t slowest = 0;
+        for (int k = 0; k < n; ++k) {
+            Yolo2ConvShape part = shape;
+            part.ofm = slices[k].ofm;
+            const Yolo2LayerCost c = yolo2_conv_cost(part, bits);
+            slowest = std::max(slowest, c.cycles);
+            split_bytes += c.ddr_bytes();
+        }
+        single += whole.cycles;
+        split += slowest;
+        single_bytes += whole.ddr_bytes();
+        std::printf("  %-5d %12lld %12lld %7.2fx\n", i, static_cast<long long>(whole.cycles),
+                    static_cast<long long>(slowest), static_cast<double>(whole.cycles) / slowest);
     }
+    std::printf("  OFM split: %.2f ms/frame (%.1f fps) vs %.2f ms (%.1f fps); DDR %.1f MB/frame vs %.1f MB\n",
+                split / kYolo2ClockHz * 1e3, kYolo2ClockHz / split, single / kYolo2ClockHz * 1e3,
+                kYolo2ClockHz / single, split_bytes / 1e6, single_bytes / 1e6);
+    std::printf("  whole frames: %.1f fps at %.2f ms latency\n", instances * kYolo2ClockHz / single,
+                single / kYolo2ClockHz * 1e3);
+}
+
+// Compact CHW <-> accelerator activation layout (yolo2_act_layout.h); padding is zeroed.
+void chw_to_act(const IO_Dtype *src, IO_Dtype *dst, int c, int h, int w)
+{
+    std::fill(dst, dst + yolo2_act_words(c, h, w), static_cast<IO_Dtype>(0));
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[yolo2_act_index(ch, y, x, h, w)] = src[(static_cast<size_t>(ch) * h + y) * w + x];
+}
+
+void act_to_chw(const IO_Dtype *src, IO_Dtype *dst, int c, int h, int w)
+{
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[(static_cast<size_t>(ch) * h + y) * w + x] = src[yolo2_act_index(ch, y, x, h, w)];
 }
+
 } // namespace
 
 template <typename T>
@@ -153,13 +329,84 @@ struct WeightsPack {
     std::vector<int> weight_q; // per-layer weight Q
     std::vector<int> bias_q;   // per-layer bias Q
     std::vector<int> act_q;    // per-layer activation Q (iofm_Q)
+    std::vector<int> weight_bits; // per-layer WeightBits word (4, 8 or 16, maybe | YOLO2_WBITS_REQUANT)
+    std::string dir;              // weights directory (golden model key)
+};
+
+// yolov2_hls_load() result for this precision namespace
+struct LoadedWeights : Yolo2Weights {
+    WeightsPack pack;
 };
 
-WeightsPack load_weights(const network *net, Precision precision) {
+// Golden store session; discarded unless close() was reached
+struct GoldenGuard {
+    yolo2_golden_t *g = nullptr;
+    ~GoldenGuard() {
+        if (g) yolo2_golden_discard(g);
+    }
+    int close() {
+        yolo2_golden_t *done = g;
+        g = nullptr;
+        return done ? yolo2_golden_close(done) : -1;
+    }
+};
+
+// Releases the CPU offload state (YOLO2_CPU_OFFLOAD) on every exit from a run
+struct CpuOffloadGuard {
+    yolo2_cpu_offload_t *s;
+    ~CpuOffloadGuard() { yolo2_cpu_offload_cleanup(s); }
+};
+
+// FP32 emulation of a reduced-precision layer: round the weights onto the grid
+// the INT16 datapath uses for it (power-of-two Q from the layer max-abs), or
+// at 4 bits onto the layer's codebook.
+template <typename T>
+void fake_quantize_weights(T *w, size_t count, int bits) {
+    if (bits == 4) {
+        const std::vector<float> f(w, w + count);
+        const Yolo2Codebook cb = yolo2_fit_codebook(f.data(), count);
+        for (size_t i = 0; i < count; ++i) w[i] = static_cast<T>(cb.value(cb.index(f[i])));
+        return;
+    }
+    float maxabs = 0.0f;
+    for (size_t i = 0; i < count; ++i) maxabs = std::max(maxabs, std::fabs(static_cast<float>(w[i])));
+    const int q = select_q(maxabs, bits);
+    const float scale = std::ldexp(1.0f, q);
+    const float inv_scale = std::ldexp(1.0f, -q);
+    const float hi = static_cast<float>((1 << (bits - 1)) - 1);
+    const float lo = -hi - 1.0f;
+    for (size_t i = 0; i < count; ++i) {
+        const float v = std::nearbyint(static_cast<float>(w[i]) * scale);
+        w[i] = static_cast<T>(std::min(hi, std::max(lo, v)) * inv_scale);
+    }
+}
+
+// FP32 emulation of a per-channel requantized layer: every output channel is
+// divided by its scale (yolo2_channel_requant), rounded as above, and scaled
+// back, as yolov2_weight_gen and write-back do. w is in reorganized order.
+template <typename T>
+void fake_quantize_channels(T *w, const T *bias, int ifm, int ofm, int ksize, int bits) {
+    const std::vector<int> ch = yolo2_reorg_ofm(ifm, ofm, ksize);
+    std::vector<float> chan_max(ofm, 0.0f);
+    for (size_t i = 0; i < ch.size(); ++i)
+        chan_max[ch[i]] = std::max(chan_max[ch[i]], std::fabs(static_cast<float>(w[i])));
+    const std::vector<float> b(bias, bias + ofm);
+    const std::vector<Yolo2ChannelRequant> rq = yolo2_channel_requant(chan_max.data(), b.data(), ofm);
+    for (size_t i = 0; i < ch.size(); ++i) w[i] = static_cast<T>(static_cast<float>(w[i]) / rq[ch[i]].scale);
+    fake_quantize_weights(w, ch.size(), bits);
+    for (size_t i = 0; i < ch.size(); ++i) w[i] = static_cast<T>(static_cast<float>(w[i]) * rq[ch[i]].scale);
+}
+
+WeightsPack load_weights(const network *net, Precision precision, const int *weight_bits, const std::string &dir) {
     const ModelConfig &cfg = yolo2_model_config();
     int conv_layers = 0;
     for (int i = 0; i < net->n; ++i) if (net->layers[i].type == CONVOLUTIONAL) conv_layers++;
 
+    std::vector<int> bits = weight_bits ? std::vector<int>(weight_bits, weight_bits + conv_layers)
+                                        : yolo2_weight_bits(dir, conv_layers);
+    std::vector<const layer *> convs;
+    for (int i = 0; i < net->n; ++i) if (net->layers[i].type == CONVOLUTIONAL) convs.push_back(&net->layers[i]);
+
     size_t expected_w = 0;
     size_t expected_b = 0;
     for (int i = 0; i < conv_layers && i < static_cast<int>(cfg.weight_offsets.size()); ++i) {
@@ -168,21 +415,40 @@ WeightsPack load_weights(const network *net, Precision precision) {
     }
 
     if (precision == Precision::FP32) {
-        auto w = read_binary<float>("weights/weights_reorg.bin");
-        auto b = read_binary<float>("weights/bias.bin");
+        auto w = read_binary<float>(dir + "/weights_reorg.bin");
+        auto b = read_binary<float>(dir + "/bias.bin");
         if (w.size() < expected_w) throw std::runtime_error("weights file too small");
         if (b.size() < expected_b) throw std::runtime_error("bias file too small");
         std::vector<IO_Dtype> wbuf(w.begin(), w.begin() + expected_w);
         std::vector<IO_Dtype> bbuf(b.begin(), b.begin() + expected_b);
-        return {std::move(wbuf), std::move(bbuf), {}, {}, {}};
+        size_t off = 0, boff = 0;
+        for (int li = 0; li < conv_layers; ++li) {
+            const int prec = yolo2_wbits_precision(bits[li]);
+            if (yolo2_wbits_requant(bits[li]))
+                fake_quantize_channels(wbuf.data() + off, bbuf.data() + boff, convs[li]->c, convs[li]->n, convs[li]->size, prec);
+            else if (prec < 16)
+                fake_quantize_weights(wbuf.data() + off, cfg.weight_offsets[li], prec);
+            // bias.bin keeps one word per channel, so the plan sees plain layers.
+            bits[li] = prec;
+            off += cfg.weight_offsets[li];
+            boff += cfg.beta_offsets[li];
+        }
+        return {std::move(wbuf), std::move(bbuf), {}, {}, {}, std::move(bits), dir};
     } else {
-        auto w = read_binary<int16_t>("weights/weights_reorg_int16.bin");
-        auto b = read_binary<int16_t>("weights/bias_int16.bin");
-        if (w.size() < expected_w) throw std::runtime_error("weights file too small");
-        if (b.size() < expected_b) throw std::runtime_error("bias file too small");
-
-        auto wQ = read_binary<int32_t>("weights/weight_int16_Q.bin");
-        auto bQ = read_binary<int32_t>("weights/bias_int16_Q.bin");
+        auto w = read_binary<int16_t>(dir + "/weights_reorg_int16.bin");
+        auto b = read_binary<int16_t>(dir + "/bias_int16.bin");
+        // W8/W4 layers are stored packed, so the file keeps its per-layer word layout.
+        size_t total_w = 0;
+        for (int li = 0; li < conv_layers; ++li) total_w += yolo2_weight_words(cfg.weight_offsets[li], bits[li]);
+        if (w.size() < total_w) throw std::runtime_error("weights file too small for weight_bits.bin");
+        // Per-channel requantized layers store {bias, mult, shift} per channel.
+        size_t total_b = 0;
+        for (int li = 0; li < conv_layers; ++li)
+            total_b += static_cast<size_t>(cfg.beta_offsets[li]) * yolo2_beta_words(bits[li]);
+        if (b.size() < total_b) throw std::runtime_error("bias file too small for weight_bits.bin");
+
+        auto wQ = read_binary<int32_t>(dir + "/weight_int16_Q.bin");
+        auto bQ = read_binary<int32_t>(dir + "/bias_int16_Q.bin");
         if (wQ.size() < static_cast<size_t>(conv_layers) || bQ.size() < static_cast<size_t>(conv_layers)) {
             throw std::runtime_error("Q tables too small for conv layers");
         }
@@ -190,66 +456,102 @@ WeightsPack load_weights(const network *net, Precision precision) {
         // Optional activation Q table (iofm)
         std::vector<int> act_q;
         try {
-            act_q = read_binary<int32_t>("weights/iofm_Q.bin");
+            act_q = read_binary<int32_t>(dir + "/iofm_Q.bin");
         } catch (...) {
             act_q.clear();
         }
 
-        std::vector<IO_Dtype> wbuf(expected_w);
-        std::vector<IO_Dtype> bbuf(expected_b);
+        std::vector<IO_Dtype> wbuf(w.begin(), w.begin() + total_w);
+        std::vector<IO_Dtype> bbuf(total_b);
 
-        size_t w_file_off = 0;
-        size_t w_out_off = 0;
         size_t b_file_off = 0;
         size_t b_out_off = 0;
         for (int li = 0; li < conv_layers; ++li) {
-            const int wlen = cfg.weight_offsets[li];
-            const int blen = cfg.beta_offsets[li];
+            const int blen = cfg.beta_offsets[li] * yolo2_beta_words(bits[li]);
 
-            if (w_file_off + wlen > w.size()) throw std::runtime_error("int16 weight truncated at layer " + std::to_string(li));
             if (b_out_off + blen > bbuf.size()) throw std::runtime_error("int16 bias output buffer overflow at layer " + std::to_string(li));
             if (b_file_off + blen > b.size()) throw std::runtime_error("int16 bias truncated at layer " + std::to_string(li));
 
-            std::copy_n(w.data() + w_file_off, wlen, wbuf.data() + w_out_off);
             std::copy_n(b.data() + b_file_off, blen, bbuf.data() + b_out_off);
 
             // Handle per-layer padding inserted during quantization for odd counts.
-            const int wpad = (wlen & 0x1) ? 1 : 0;
             const int bpad = (blen & 0x1) ? 1 : 0;
 
-            w_file_off += wlen + wpad;
-            w_out_off  += wlen;
             b_file_off += blen + bpad;
             b_out_off  += blen;
         }
-        return {std::move(wbuf), std::move(bbuf), std::move(wQ), std::move(bQ), std::move(act_q)};
+        return {std::move(wbuf), std::move(bbuf), std::move(wQ), std::move(bQ), std::move(act_q), std::move(bits), dir};
     }
 }
 
-void yolov2_hls_ps(network *net, const float *input, Precision precision)
+constexpr Precision kPrecision = std::is_floating_point<IO_Dtype>::value ? Precision::FP32 : Precision::INT16;
+
+void run_model(network *net, const float *input, const WeightsPack &wpack, Yolo2LayerObserver observer,
+               void *observer_user)
 {
     const ModelConfig &cfg = yolo2_model_config();
-
-#ifdef INT16_MODE
-    if (precision == Precision::FP32) {
-        throw std::runtime_error("FP32 precision requested while INT16_MODE is enabled. Rebuild without INT16_MODE for FP32.");
+    const Precision precision = kPrecision;
+
+    const yolo2_caps_t caps = query_accel_caps();
+    if (const char *two_engine = std::getenv("YOLO2_TWO_ENGINE")) {
+        if (two_engine[0]) {
+            const std::string stream = wpack.dir + "/engine_b_tiling.bin";
+            report_two_engine_plan(net, wpack.weight_bits, two_engine,
+                                   std::filesystem::exists(stream) ? read_binary<int32_t>(stream) : std::vector<int32_t>());
+        }
     }
-#endif
-
-    WeightsPack wpack = load_weights(net, precision);
-    IO_Dtype *Weight_buf = wpack.weights.data();
-    IO_Dtype *Beta_buf   = wpack.bias.data();
+    const int accel_instances = accel_instances_env();
+    if (accel_instances > 1) report_multi_instance_plan(net, wpack.weight_bits, accel_instances);
+    yolo2_cpu_offload_t cpu_offload;
+    const bool cpu_offload_on = cpu_offload_env(&cpu_offload);
+    const CpuOffloadGuard cpu_offload_guard{&cpu_offload};
+    if (cpu_offload_on && accel_instances > 1)
+        throw std::runtime_error("YOLO2_CPU_OFFLOAD cannot be combined with YOLO2_ACCEL_INSTANCES");
+    // The accelerator only reads Weight and Beta, so a session's pack is shared by its runs.
+    IO_Dtype *Weight_buf = const_cast<IO_Dtype *>(wpack.weights.data());
+    IO_Dtype *Beta_buf   = const_cast<IO_Dtype *>(wpack.bias.data());
 
 //leave some memories for overflow, because the load_module will load extra pixels near boundary for padding
-    IO_Dtype *Memory_buf = (IO_Dtype*)calloc(cfg.mem_len+512*2,sizeof(IO_Dtype));
-    if (!Memory_buf || !Weight_buf || !Beta_buf) {
-        printf("Allocation failed in yolov2_hls_ps\n");
+    std::vector<IO_Dtype> memory(cfg.mem_len + 512*2, 0);
+    IO_Dtype *Memory_buf = memory.data();
+    if (!Weight_buf || !Beta_buf) {
+        printf("Allocation failed in yolov2_hls_run\n");
         return;
     }
+#ifdef YOLO2_STATIC_PLAN
+    // make plan follows weight_bits.bin as written; FP32 loads it without the
+    // requant flag (one bias word per channel), so its copy of the plan does too.
+    yolo2_plan_t plan = yolo2_static_plan;
+    if (precision == Precision::FP32) yolo2_plan_strip_requant(&plan);
+    if (plan.n != net->n ||
+        yolo2_plan_check(&plan, caps.tm, caps.tn, caps.tr, caps.tc, caps.ib_height, caps.ib_width,
+                         wpack.weight_bits.data(), static_cast<int>(wpack.weight_bits.size())) != 0) {
+        throw std::runtime_error("Compiled-in layer plan does not match this network, accelerator or weight_bits.bin "
+                                 "(rerun make plan)");
+    }
+#else
+    const yolo2_plan_t plan = yolo2_make_plan(net, caps.tm, caps.tn, caps.tr, caps.tc, caps.ib_height, caps.ib_width,
+                                              wpack.weight_bits);
+#endif
     IO_Dtype* in_ptr[32];
     IO_Dtype* out_ptr[32];
     IO_Dtype* tmp_ptr_f0 = nullptr;
-    generate_iofm_offset( in_ptr, out_ptr, Memory_buf, net, cfg);
+    IO_Dtype *Memory_top = Memory_buf + 512;
+    for (int x = 0; x < plan.n; ++x) {
+        const yolo2_plan_layer_t &p = plan.layers[x];
+        in_ptr[x] = (p.in_offset == YOLO2_PLAN_NONE) ? nullptr : Memory_top + p.in_offset;
+        out_ptr[x] = (p.out_offset == YOLO2_PLAN_NONE) ? nullptr : Memory_top + p.out_offset;
+    }
+
+    const bool fused_tail = fused_tail_env_enabled();
+    std::vector<int> tail_desc;
+    if (fused_tail) {
+        check_fused_tail(net);
+        // Conv 26 runs before the tail, so it must not overwrite layer 17's output
+        // (the tail input); layer 24's DDR slot is free because 24 stays on chip.
+        out_ptr[kRouteConv] = out_ptr[24];
+        in_ptr[kRouteConv + 1] = out_ptr[24];
+    }
 
     const int input_elems = 416*416*3;
     std::vector<IO_Dtype> input_q;
@@ -275,58 +577,112 @@ void yolov2_hls_ps(network *net, const float *input, Precision precision)
         input_data = reinterpret_cast<const IO_Dtype *>(input);
     }
 
-    memcpy(in_ptr[0], input_data, input_elems*sizeof(IO_Dtype));//416x416x3 input_pic
+    chw_to_act(input_data, in_ptr[0], 3, 416, 416);//416x416x3 input_pic
+
+    // Optional per-layer golden record/verify (YOLO2_GOLDEN_DIR / YOLO2_GOLDEN_MODE).
+    GoldenGuard golden_store;
+    if (yolo2_golden_env_enabled()) {
+        golden_store.g = yolo2_golden_open_env(
+            yolo2_golden_model_key(wpack.dir.c_str(), precision == Precision::INT16),
+            yolo2_hash64(0, input_data, input_elems * sizeof(IO_Dtype)),
+            static_cast<int>(sizeof(IO_Dtype)), std::is_floating_point<IO_Dtype>::value);
+        if (!golden_store.g) {
+            throw std::runtime_error("Golden store could not be opened (YOLO2_GOLDEN_DIR)");
+        }
+    }
+    yolo2_golden_t *const golden = golden_store.g;
 
     const int region_len = 13*16*425;
     std::vector<IO_Dtype> region_buf(region_len, 0);
     std::vector<IO_Dtype> region_buf2(region_len, 0);
+    std::vector<IO_Dtype> view_buf;
 
-    int offset_index = 0;
-    int woffset = 0;
-    int boffset = 0;
-    int TR,TC,TM,TN;
-    int output_w,output_h;
-    int mLoops;
     int current_Qa = (!wpack.act_q.empty()) ? wpack.act_q.front() : 0;
     int route24_q = 0;
     int pending_route_q = -1;
 
-    for(int i = 0; i < net->n; ++i)
+    for(int i = 0; i < plan.n; ++i)
     {
-        layer l = net->layers[i];
-        switch(l.type)
+        const yolo2_plan_layer_t &p = plan.layers[i];
+        switch(p.type)
         {
-            case CONVOLUTIONAL: {
-                output_w = (l.w - l.size + 2*l.pad)/l.stride + 1;
-                output_h = (l.h - l.size + 2*l.pad)/l.stride + 1;
-
-                TR = std::min(((OnChipIB_Height-l.size)/l.stride+1),Tr);//keep Kstride>=1
-                TR = std::min(output_h,TR);
-                TC = std::min(((OnChipIB_Width-l.size)/l.stride+1),Tc);
-                TC = std::min(output_w,TC);
-                TM = std::min(l.n,Tm);
-                TN = std::min(l.c,Tn);
-                mLoops = (int)ceil(((float)l.n)/TM);
+            case YOLO2_PLAN_CONV: {
+                const int woffset = static_cast<int>((precision == Precision::INT16) ? p.weight_word_offset : p.weight_offset);
+                const int boffset = static_cast<int>(p.beta_offset);
+                const int bits = p.weight_bits;
 
                 int Qw = 0, Qb = 0, Qa_in = 0, Qa_out = 0;
                 if (precision == Precision::INT16) {
                     const size_t act_entries = wpack.act_q.size();
-                    Qa_in = (offset_index < static_cast<int>(act_entries)) ? wpack.act_q[offset_index] : current_Qa;
-                    Qa_out = (offset_index + 1 < static_cast<int>(act_entries)) ? wpack.act_q[offset_index + 1] : Qa_in;
-                    Qw = (offset_index < static_cast<int>(wpack.weight_q.size())) ? wpack.weight_q[offset_index] : 0;
-                    Qb = (offset_index < static_cast<int>(wpack.bias_q.size())) ? wpack.bias_q[offset_index] : 0;
+                    Qa_in = (p.conv_index < static_cast<int>(act_entries)) ? wpack.act_q[p.conv_index] : current_Qa;
+                    Qa_out = (p.conv_index + 1 < static_cast<int>(act_entries)) ? wpack.act_q[p.conv_index + 1] : Qa_in;
+                    Qw = (p.conv_index < static_cast<int>(wpack.weight_q.size())) ? wpack.weight_q[p.conv_index] : 0;
+                    Qb = (p.conv_index < static_cast<int>(wpack.bias_q.size())) ? wpack.bias_q[p.conv_index] : 0;
                     if (pending_route_q >= 0) {
                         Qa_in = pending_route_q;
                     }
                 }
-                YOLO2_FPGA(in_ptr[i],out_ptr[i],Weight_buf+woffset,Beta_buf+boffset,
-                    l.c,l.n,l.size,
-                    l.stride,l.w,l.h,output_w, output_h, l.pad,l.activation==LEAKY?1:0,l.batch_normalize?1:0,
-                    TM,TN,TR,TC, (mLoops + 1)*TM, mLoops*TM, (mLoops + 1)*TM, 0,
-                    Qw, Qa_in, Qa_out, Qb);
-
-                woffset += cfg.weight_offsets[offset_index];
-                boffset += cfg.beta_offsets[offset_index];
+                if (fused_tail && in_fused_tail(i)) {
+                    const int desc[TAIL_DESC_WORDS] = {p.ifm, p.ofm, p.ksize, p.pad, p.is_nl, woffset, boffset,
+                                                       Qw, Qa_in, Qa_out, Qb, bits};
+                    tail_desc.insert(tail_desc.end(), desc, desc + TAIL_DESC_WORDS);
+                    if (i == kTailLast) {
+                        // Route: reorg 27 output, the first channels of the route-28 concat.
+                        YOLO2_FPGA_TAIL(in_ptr[kTailFirst], out_ptr[27], out_ptr[i], Weight_buf, Beta_buf,
+                                        tail_desc.data(), static_cast<int>(tail_desc.size()) / TAIL_DESC_WORDS);
+                        report_tail_prefetch(tail_desc);
+                    }
+                } else {
+                    yolo2_ofm_slice_t slices[64];
+                    const int cpu_ch = cpu_offload_on ? yolo2_cpu_offload_channels(&cpu_offload, i, p.ofm, p.tm) : 0;
+                    const int fpga_ofm = p.ofm - cpu_ch;
+                    const auto fpga_start = std::chrono::steady_clock::now();
+                    const int num_slices = yolo2_ofm_split(fpga_ofm, p.ifm, p.ksize, p.tm,
+                                                           precision == Precision::INT16 ? bits : 16,
+                                                           std::min(accel_instances, 64), slices);
+                    if (num_slices == 1 && fpga_ofm == p.ofm) {
+                        YOLO2_FPGA(in_ptr[i], out_ptr[i], Weight_buf + woffset, Beta_buf + boffset,
+                            p.ifm,p.ofm,p.ksize,
+                            p.stride,p.in_w,p.in_h,p.out_w, p.out_h, p.pad,p.is_nl,p.is_bn,
+                            p.tm,p.tn,p.tr,p.tc, p.ofm_num_bound, p.mloopsxtm, p.mloops_a1xtm, 0,
+                            Qw, Qa_in, Qa_out, Qb, bits, nullptr);
+                    } else {
+                        for (int s = 0; s < num_slices; ++s) {
+                            const int slice_tm = std::min(slices[s].ofm, p.tm);
+                            const int slice_loops = (slices[s].ofm + slice_tm - 1) / slice_tm;
+                            YOLO2_FPGA(in_ptr[i], out_ptr[i] + yolo2_act_words(slices[s].m0, p.out_h, p.out_w),
+                                Weight_buf + woffset + slices[s].weight_offset, Beta_buf + boffset + slices[s].beta_offset,
+                                p.ifm,slices[s].ofm,p.ksize,
+                                p.stride,p.in_w,p.in_h,p.out_w, p.out_h, p.pad,p.is_nl,p.is_bn,
+                                slice_tm,p.tn,p.tr,p.tc, (slice_loops + 1)*slice_tm, slice_loops*slice_tm, (slice_loops + 1)*slice_tm, 0,
+                                Qw, Qa_in, Qa_out, Qb, bits, nullptr);
+                        }
+                    }
+#ifdef INT16_MODE
+                    if (cpu_ch > 0) {
+                        const auto cpu_start = std::chrono::steady_clock::now();
+                        yolo2_cpu_conv_t cl;
+                        cl.ifm = p.ifm; cl.ofm = p.ofm; cl.ksize = p.ksize; cl.stride = p.stride; cl.pad = p.pad;
+                        cl.in_w = p.in_w; cl.in_h = p.in_h; cl.out_w = p.out_w; cl.out_h = p.out_h;
+                        cl.tm = p.tm; cl.tn = p.tn; cl.weight_bits = bits;
+                        cl.qw = Qw; cl.qa_in = Qa_in; cl.qa_out = Qa_out; cl.qb = Qb;
+                        cl.is_nl = p.is_nl;
+                        cl.split_k = caps.split_k;
+                        const int16_t *cpu_weights =
+                            yolo2_cpu_offload_weights(&cpu_offload, i, &cl, Weight_buf + woffset, fpga_ofm);
+                        if (!cpu_weights || yolo2_cpu_conv(&cl, in_ptr[i], cpu_weights, Beta_buf + boffset, out_ptr[i],
+                                                           fpga_ofm, p.ofm, yolo2_cpu_conv_threads(0)) != 0)
+                            throw std::runtime_error("CPU conv failed");
+                        const auto cpu_end = std::chrono::steady_clock::now();
+                        yolo2_cpu_offload_update(&cpu_offload, i, fpga_ofm,
+                                                 std::chrono::duration<double, std::micro>(cpu_start - fpga_start).count(),
+                                                 cpu_ch, std::chrono::duration<double, std::micro>(cpu_end - cpu_start).count());
+                    }
+#else
+                    (void)fpga_start;
+#endif
+                }
+
                 if (precision == Precision::INT16) {
                     current_Qa = Qa_out;
                     if (i == 24) {
@@ -334,54 +690,27 @@ void yolov2_hls_ps(network *net, const float *input, Precision precision)
                     }
                     pending_route_q = -1;
                 }
-                offset_index++;
 
                 break;
             }
-            case MAXPOOL:
-                output_w = l.out_h;
-                output_h = l.out_w;
-
-                TR = std::min(((OnChipIB_Height-l.size)/l.stride+1),Tr);//keep Kstride>=1
-                TC = std::min(((OnChipIB_Width-l.size)/l.stride+1),Tc);
-                TR = std::min(output_h,TR);
-                TC = std::min(output_w,TC);
-                TM = std::min(Tm,Tn);
-                TM = std::min(l.c,TM);
-                mLoops = (int)ceil(((float)l.c)/TM);
-
-                YOLO2_FPGA(in_ptr[i],out_ptr[i],NULL,NULL,l.c,l.c,
-                    l.size,l.stride,l.w,l.h, output_w, output_h, l.pad,0,0,TM,0,TR,TC, (mLoops + 2)*TM, mLoops*TM, (mLoops + 1)*TM, 1,
-                    0,0,0,0);
+            case YOLO2_PLAN_MAXPOOL:
+                YOLO2_FPGA(in_ptr[i],out_ptr[i],NULL,NULL,p.ifm,p.ifm,
+                    p.ksize,p.stride,p.in_w,p.in_h, p.out_w, p.out_h, p.pad,0,0,p.tm,0,p.tr,p.tc,
+                    p.ofm_num_bound, p.mloopsxtm, p.mloops_a1xtm, 1,
+                    0,0,0,0,16,nullptr);
 
                 break;
-            case REORG:
-                output_w = 26;
-                output_h = 32*13;
-
-                TR = std::min(((OnChipIB_Height-l.stride)/l.stride+1),Tr);//keep Kstride>=1
-                TR = std::min(output_h,TR);
-                TC = std::min(((OnChipIB_Width-l.stride)/l.stride+1),Tc);
-                TC = std::min(output_w,TC);
-                TM = std::min(Tm,Tn);
-                TM = std::min(4,TM);
-                mLoops = (int)ceil(((float)4)/TM);
-
-                tmp_ptr_f0 = in_ptr[i];
-                for(int k = 0; k<26*64; k++)
-                    memcpy((IO_Dtype *)(region_buf.data() + k*26), (IO_Dtype *)(tmp_ptr_f0 + k*32), 26*sizeof(IO_Dtype));
-                reorg_cpu(region_buf.data(), output_w, output_h, 4, 2, region_buf2.data());
-                tmp_ptr_f0 = region_buf.data();
-                memset(region_buf.data(), 0,  13*16*256*sizeof(IO_Dtype));
-                for(int k = 0; k<13*256; k++)
-                    memcpy((IO_Dtype *)(tmp_ptr_f0 + k*16), (IO_Dtype *)(region_buf2.data() + k*13), 13*sizeof(IO_Dtype));
+            case YOLO2_PLAN_REORG:
+                act_to_chw(in_ptr[i], region_buf.data(), 64, 26, 26);
+                reorg_cpu(region_buf.data(), 26, 32*13, 4, 2, region_buf2.data());
+                tmp_ptr_f0 = region_buf2.data();
 
                 if (precision == Precision::INT16 && route24_q > 0) {
                     // Align the reorg branch scale with the skip connection branch before concatenation.
                     const int target_q = std::min(route24_q, current_Qa);
                     const int shift = current_Qa - target_q;
                     if (shift != 0) {
-                        const int total = 13 * 16 * 256;
+                        const int total = 13 * 13 * 256;
                         for (int idx = 0; idx < total; ++idx) {
                             int32_t v = static_cast<int32_t>(tmp_ptr_f0[idx]);
                             if (shift > 0) {
@@ -398,19 +727,22 @@ void yolov2_hls_ps(network *net, const float *input, Precision precision)
                     pending_route_q = current_Qa;
                 }
 
-                memcpy(out_ptr[i], tmp_ptr_f0, 13*16*256*sizeof(IO_Dtype));
+                chw_to_act(tmp_ptr_f0, out_ptr[i], 256, 13, 13);
 
                 break;
-            case ROUTE:
-                break;
-            case REGION: {
-                tmp_ptr_f0 = in_ptr[i];
-                for(int k = 0; k<13*425; k++)
-                    for(int j = 0; j < 16; j++)
-                    {
-                        if(j < 13)
-                            region_buf[k*13 + j] = tmp_ptr_f0[k*16 + j];
+            case YOLO2_PLAN_ROUTE:
+                if (precision == Precision::INT16 && p.route_conv >= 0) {
+                    // The next conv reads the routed layer, so its input Q is the output Q of the last
+                    // conv at or before that layer (matches the cosim TB's layer-26 handling).
+                    if (p.route_conv + 1 < static_cast<int>(wpack.act_q.size())) {
+                        current_Qa = wpack.act_q[p.route_conv + 1];
+                        pending_route_q = current_Qa;
                     }
+                }
+                break;
+            case YOLO2_PLAN_REGION: {
+                const layer &l = net->layers[i];
+                act_to_chw(in_ptr[i], region_buf.data(), 425, 13, 13);
                 std::vector<float> region_f(region_buf.size());
                 if (precision == Precision::INT16 && !wpack.act_q.empty()) {
                     const int q_out = current_Qa;
@@ -431,10 +763,10 @@ void yolov2_hls_ps(network *net, const float *input, Precision precision)
                     dump_raw = std::getenv("YOLO2_DUMP_REGION_RAW");
                 }
                 if (!dump_raw || !dump_raw[0]) {
-                    dump_raw = "yolov2_region_raw_cpu.txt";
+                    dump_raw = "yolov2_region_raw_cpu.y2t";
                 }
-                if (do_dump) {
-                    dump_float_array_text(dump_raw, region_f.data(), static_cast<size_t>(l.outputs));
+                if (do_dump && yolo2_tensor_dump_floats(dump_raw, region_f.data(), static_cast<size_t>(l.outputs)) == 0) {
+                    std::printf("Dumped %d floats to %s\n", l.outputs, dump_raw);
                 }
 #endif
                 forward_region_layer(l, region_f.data());
@@ -443,7 +775,76 @@ void yolov2_hls_ps(network *net, const float *input, Precision precision)
             default:
                 break;
         }
+
+        // Fused tail layers before the last one never reach DDR.
+        const bool on_chip = fused_tail && p.type == YOLO2_PLAN_CONV && in_fused_tail(i) && i != kTailLast;
+        const bool tap = yolo2_tensor_tap_enabled(i) != 0;
+        if ((golden || observer || tap) && !on_chip) {
+            const bool is_float = std::is_floating_point<IO_Dtype>::value;
+            Yolo2LayerView view{i, -1, out_ptr[i], is_float, 0, 0, 0, 0};
+            if (p.type == YOLO2_PLAN_CONV || p.type == YOLO2_PLAN_MAXPOOL) {
+                view.type = (p.type == YOLO2_PLAN_CONV) ? YOLO2_GOLDEN_CONV : YOLO2_GOLDEN_MAXPOOL;
+                view.c = p.ofm;
+                view.h = p.out_h;
+                view.w = p.out_w;
+                view.row_stride = (p.out_w + 7) & ~7;
+            } else if (p.type == YOLO2_PLAN_REORG) {
+                view = {i, YOLO2_GOLDEN_REORG, out_ptr[i], is_float, 256, 13, 13, 16};
+            }
+            if (view.type >= 0) {
+#ifdef ACT_BLOCKED_LAYOUT
+                // Golden hashes and observers see compact CHW regardless of the DDR layout.
+                view_buf.resize(static_cast<size_t>(view.c) * view.h * view.w);
+                act_to_chw(static_cast<const IO_Dtype *>(view.data), view_buf.data(), view.c, view.h, view.w);
+                view.data = view_buf.data();
+                view.row_stride = view.w;
+#endif
+                if (golden) {
+                    yolo2_golden_layer(golden, i, view.type, view.data, view.c, view.h, view.w,
+                                       view.row_stride, p.tm, p.tr, p.tc);
+                }
+                if (observer) {
+                    observer(view, observer_user);
+                }
+                if (tap) {
+                    yolo2_tensor_tap(i, view.type, is_float ? YOLO2_TENSOR_F32 : YOLO2_TENSOR_I16,
+                                     is_float ? 0 : current_Qa, view.data, view.c, view.h, view.w, view.row_stride);
+                }
+            }
+        }
+    }
+
+    const int golden_rc = golden_store.close();
+    if (golden_rc >= 0) {
+        throw std::runtime_error("Golden verification failed at layer " + std::to_string(golden_rc));
+    } else if (golden_rc == -2) {
+        throw std::runtime_error("Golden store error");
     }
+}
 
-    free(Memory_buf);
+void yolov2_hls_run(network *net, const float *input, Yolo2LayerObserver observer, void *observer_user,
+                    const int *weight_bits)
+{
+    const WeightsPack wpack = load_weights(net, kPrecision, weight_bits, "weights");
+    run_model(net, input, wpack, observer, observer_user);
 }
+
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, const char *weights_dir, const int *weight_bits)
+{
+    std::unique_ptr<LoadedWeights> w(new LoadedWeights);
+    w->precision = kPrecision;
+    w->pack = load_weights(net, kPrecision, weight_bits, weights_dir);
+    return w;
+}
+
+void yolov2_hls_run(network *net, const float *input, const Yolo2Weights &weights, Yolo2LayerObserver observer,
+                    void *observer_user)
+{
+    if (weights.precision != kPrecision) {
+        throw std::runtime_error(std::string("Weights were loaded for ") + to_string(weights.precision) +
+                                 ", not " + to_string(kPrecision));
+    }
+    run_model(net, input, static_cast<const LoadedWeights &>(weights).pack, observer, observer_user);
+}
+
+YOLO2_NS_END
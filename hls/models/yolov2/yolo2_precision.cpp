@@ -0,0 +1,73 @@
+#include "yolo2_accel.hpp"
+
+#include <core/precision.hpp>
+
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+// Host builds link the accelerator sources once per precision namespace
+// (hls/core/types.hpp); this translation unit is built outside of them.
+namespace yolo2_fp32 {
+void yolov2_hls_run(network *net, const float *input, Yolo2LayerObserver observer,
+                    void *observer_user, const int *weight_bits);
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, const char *weights_dir, const int *weight_bits);
+void yolov2_hls_run(network *net, const float *input, const Yolo2Weights &weights,
+                    Yolo2LayerObserver observer, void *observer_user);
+}
+namespace yolo2_int16 {
+void yolov2_hls_run(network *net, const float *input, Yolo2LayerObserver observer,
+                    void *observer_user, const int *weight_bits);
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, const char *weights_dir, const int *weight_bits);
+void yolov2_hls_run(network *net, const float *input, const Yolo2Weights &weights,
+                    Yolo2LayerObserver observer, void *observer_user);
+}
+
+namespace {
+// The simulated accelerator keeps its on-chip buffers, weight stream offset
+// and codebook in function statics (yolo2_accel.cpp, core_io.cpp), so runs
+// are serialized across all callers and both precisions.
+std::mutex model_mutex;
+}
+
+void yolov2_hls_ps(network *net, const float *input, Precision precision,
+                   Yolo2LayerObserver observer, void *observer_user, const int *weight_bits)
+{
+    std::lock_guard<std::mutex> lock(model_mutex);
+    switch (precision) {
+        case Precision::FP32:
+            yolo2_fp32::yolov2_hls_run(net, input, observer, observer_user, weight_bits);
+            return;
+        case Precision::INT16:
+            yolo2_int16::yolov2_hls_run(net, input, observer, observer_user, weight_bits);
+            return;
+    }
+    throw std::runtime_error(std::string("Unsupported precision: ") + to_string(precision));
+}
+
+std::unique_ptr<Yolo2Weights> yolov2_hls_load(network *net, Precision precision, const char *weights_dir,
+                                              const int *weight_bits)
+{
+    switch (precision) {
+        case Precision::FP32:
+            return yolo2_fp32::yolov2_hls_load(net, weights_dir, weight_bits);
+        case Precision::INT16:
+            return yolo2_int16::yolov2_hls_load(net, weights_dir, weight_bits);
+    }
+    throw std::runtime_error(std::string("Unsupported precision: ") + to_string(precision));
+}
+
+void yolov2_hls_ps(network *net, const float *input, const Yolo2Weights &weights,
+                   Yolo2LayerObserver observer, void *observer_user)
+{
+    std::lock_guard<std::mutex> lock(model_mutex);
+    switch (weights.precision) {
+        case Precision::FP32:
+            yolo2_fp32::yolov2_hls_run(net, input, weights, observer, observer_user);
+            return;
+        case Precision::INT16:
+            yolo2_int16::yolov2_hls_run(net, input, weights, observer, observer_user);
+            return;
+    }
+    throw std::runtime_error(std::string("Unsupported precision: ") + to_string(weights.precision));
+}
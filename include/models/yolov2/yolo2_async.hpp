@@ -0,0 +1,106 @@
+#pragma once
+
+// Asynchronous front end of a yolo2::Session (libyolo2).
+//
+// An AsyncSession owns a Session and one executor thread that runs the
+// queued frames in submission order, so callers can overlap their own I/O
+// with inference and keep several frames in flight:
+//
+//   yolo2::AsyncSession async(yolo2::SessionOptions{}, 4);
+//   yolo2::AsyncSession::Ticket t = async.submit(frame);   // blocks while 4 are queued
+//   ... read the next frame ...
+//   yolo2::Detections dets = t.result.get();
+//
+// A submitted Frame is not copied: its pixels must stay valid until its
+// result or callback has been delivered. Callbacks run on the executor
+// thread, so they should hand the detections off rather than do heavy work.
+// A callback may call try_submit(), cancel() and cancel_all(). submit() on a
+// full queue and drain() would wait for the executor itself, so from a
+// callback they throw std::runtime_error instead. A callback must never
+// destroy its AsyncSession (the destructor joins the executor thread).
+
+#include "yolo2_session.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace yolo2 {
+
+// Error delivered for requests cancelled before they ran
+class Cancelled : public std::runtime_error {
+public:
+    Cancelled() : std::runtime_error("Inference request cancelled") {}
+};
+
+class AsyncSession {
+public:
+    // error is null on success; dets is then the frame's result
+    using Callback = std::function<void(std::exception_ptr error, Detections &&dets)>;
+
+    struct Ticket {
+        uint64_t id = 0;
+        std::future<Detections> result;
+    };
+
+    // queue_depth bounds the requests waiting to run (not counting the running one)
+    explicit AsyncSession(Session session, size_t queue_depth = 4);
+    explicit AsyncSession(const SessionOptions &options, size_t queue_depth = 4);
+    // Cancels the queued requests and waits for the running one; must not
+    // run on the executor thread (i.e. from a callback)
+    ~AsyncSession();
+    AsyncSession(const AsyncSession &) = delete;
+    AsyncSession &operator=(const AsyncSession &) = delete;
+
+    // Queue frame, blocking while the queue is full (from a callback: throws instead)
+    Ticket submit(const Frame &frame);
+    uint64_t submit(const Frame &frame, Callback done);
+    // Same, but return false instead of blocking when the queue is full
+    bool try_submit(const Frame &frame, Ticket &ticket);
+    bool try_submit(const Frame &frame, Callback done, uint64_t *id = nullptr);
+
+    // Drop a queued request; its result fails with Cancelled. Returns false
+    // when the request already started or finished.
+    bool cancel(uint64_t id);
+    // Cancel every queued request; returns how many were dropped
+    size_t cancel_all();
+    // Wait until the queue is empty and nothing is running; throws from a callback
+    void drain();
+
+    size_t queued() const;
+    size_t queue_depth() const { return depth_; }
+    // Read-only access to options and network shape; never call detect() on it
+    const Session &session() const { return session_; }
+
+private:
+    struct Job {
+        uint64_t id;
+        Frame frame;
+        Callback done;
+    };
+
+    bool enqueue(const Frame &frame, Callback done, bool block, uint64_t *id);
+    bool on_executor() const;
+    void run();
+
+    Session session_;
+    const size_t depth_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable idle_;
+    std::deque<Job> queue_;
+    uint64_t next_id_ = 1;
+    bool busy_ = false;
+    bool stop_ = false;
+    std::thread executor_;
+};
+
+} // namespace yolo2
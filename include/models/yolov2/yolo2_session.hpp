@@ -0,0 +1,123 @@
+#pragma once
+
+// Embeddable YOLOv2 detector (libyolo2, `make lib`).
+//
+// A Session parses the network cfg and loads the weights once; every
+// detect() call then only preprocesses the frame, runs the selected backend
+// and decodes the boxes, so a service can keep one Session alive
+// instead of spawning yolov2_detect per image:
+//
+//   yolo2::Session session({});                  // config/yolov2.cfg, weights/
+//   yolo2::Frame frame(pixels, w, h, yolo2::PixelFormat::RGB8, stride);
+//   yolo2::Detections dets = session.detect(frame);
+//   for (size_t i = 0; i < dets.size(); ++i) use(dets.cls[i], dets.score[i], dets.x[i], ...);
+//
+// Errors are reported as std::runtime_error. A Session is not thread-safe:
+// call it from one thread at a time, or queue frames to an AsyncSession
+// (yolo2_async.hpp). Sessions on different threads are safe but do not run in
+// parallel: every run goes through the one simulated accelerator
+// (yolov2_hls_ps()), so detect() calls in a process are serialized.
+
+#include <core/precision.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yolo2 {
+
+// Pixel layout of a Frame. The 8-bit formats are interleaved rows, YUYV is
+// packed 4:2:2 (even width); F32_PLANAR is the darknet image layout (one
+// plane per channel, values in [0, 1], each plane height rows of stride bytes).
+enum class PixelFormat {
+    RGB8,
+    BGR8,
+    RGBX8,
+    BGRX8,
+    YUYV,
+    F32_PLANAR
+};
+
+// Caller-owned input image; the Session only reads it during detect(). It is
+// letterboxed straight from the caller's rows into the network input
+// (linux_app/include/yolo2_input.h), without a full-size float copy. A
+// letterboxed, tightly packed F32_PLANAR frame at the network size is passed
+// to the backend as is.
+struct Frame {
+    const void *data = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t stride = 0;    // bytes between rows, 0 for tightly packed rows
+    PixelFormat format = PixelFormat::RGB8;
+    bool letterboxed = false;   // already the network-size letterbox: no resize
+
+    Frame() = default;
+    Frame(const void *data, int width, int height, PixelFormat format, size_t stride = 0,
+          bool letterboxed = false)
+        : data(data), width(width), height(height), stride(stride), format(format), letterboxed(letterboxed) {}
+};
+
+// Detection results as parallel arrays, one entry per (box, class) whose
+// score passed the threshold. Boxes are centre/size relative to the frame
+// (0..1); entries of one box share the same box index and come in class
+// order, boxes in NMS order.
+struct Detections {
+    std::vector<float> x, y, w, h;
+    std::vector<int> cls;
+    std::vector<float> score;
+    std::vector<int> box;
+
+    size_t size() const { return score.size(); }
+    bool empty() const { return score.empty(); }
+    void clear();
+};
+
+// Only the host model of the HLS accelerator is available; its fp32/int16
+// datapath is chosen at run time with SessionOptions::precision.
+enum class Backend {
+    Hls     // host model of the HLS accelerator (fp32 or int16 datapath)
+};
+
+const char *to_string(Backend b);
+Backend parse_backend(const std::string &v);
+
+struct SessionOptions {
+    std::string cfg_path = "config/yolov2.cfg";
+    std::string weights_dir = "weights";
+    Backend backend = Backend::Hls;
+    Precision precision = Precision::FP32;
+    float thresh = 0.25f;
+    float hier_thresh = 0.5f;
+    float nms = 0.45f;      // NMS IoU threshold, 0 disables NMS
+};
+
+class Session {
+public:
+    explicit Session(const SessionOptions &options);
+    ~Session();
+    Session(Session &&other) noexcept;
+    Session &operator=(Session &&other) noexcept;
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+
+    // Letterbox frame to the network input, run it and decode the boxes.
+    Detections detect(const Frame &frame);
+    // Same, reusing the storage of out.
+    void detect(const Frame &frame, Detections &out);
+
+    const SessionOptions &options() const;
+    int input_width() const;
+    int input_height() const;
+    int classes() const;
+
+    // Region layer output of the last detect() (yolov2_region_proc dumps)
+    const float *region_output() const;
+    size_t region_outputs() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace yolo2
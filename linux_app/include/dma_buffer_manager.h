@@ -128,6 +128,14 @@ int memory_allocate_inference_buffer(memory_buffer_t *buffer);
  */
 uint64_t memory_get_phys_addr(void *virt_addr);
 
+/**
+ * Check whether [addr, addr + size) lies in one tracked DMA buffer, so the
+ * accelerator can read it in place
+ *
+ * Returns: 1 if it does, 0 otherwise
+ */
+int memory_is_dma(const void *addr, size_t size);
+
 /**
  * Flush cache for memory region (no-op for uncached DMA buffers)
  */
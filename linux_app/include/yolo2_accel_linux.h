@@ -10,6 +10,62 @@
 
 #include <stdint.h>
 
+/**
+ * One YOLO2_FPGA instance: its CTRL_BUS registers, Q value GPIOs and the
+ * tile sizes it was built with, read from its capability block
+ * (yolo2_caps.h) when it has one. The single-engine API below drives the
+ * instance at YOLO2_CTRL_BASE; further instances (two-engine pipeline, see
+ * yolo2_pipeline.h, or output-channel splitting, see yolo2_ofm_split.h) are
+ * opened with yolo2_accel_open_instance().
+ */
+typedef struct {
+    volatile uint32_t *ctrl_regs;
+    volatile uint32_t *gpio_qw;
+    volatile uint32_t *gpio_qa_in;
+    volatile uint32_t *gpio_qa_out;
+    volatile uint32_t *gpio_qb;
+    uint64_t ctrl_base;
+
+    // Tile sizes and on-chip input buffer size
+    int tm, tn, tr, tc;
+    int ib_height, ib_width;
+
+    // Split-K depth, YOLO2_CAP_* features and the beta buffer depth (output
+    // channels per layer); has_caps = 0 when the IP has no capability block,
+    // the values passed to yolo2_accel_open() apply and max_beta_length is 0
+    int split_k;
+    uint32_t features;
+    int max_beta_length;
+    int has_caps;
+} yolo2_accel_t;
+
+/**
+ * Map one accelerator instance and read its capability block
+ *
+ * gpio_base: Qw, Qa_in, Qa_out and Qb GPIO base addresses
+ * tm..tc:    tiling assumed when the IP has no capability block; with one,
+ *            the IP's own tiling is used (and a difference is logged)
+ * Returns: YOLO2_SUCCESS on success, error code on failure
+ */
+int yolo2_accel_open(yolo2_accel_t *accel, uint64_t ctrl_base, const uint64_t gpio_base[4],
+                     int tm, int tn, int tr, int tc);
+
+/**
+ * Map instance `index` (0 .. YOLO2_MAX_ACCELS-1) at its yolo2_config.h
+ * addresses (index 0 = YOLO2_CTRL_BASE)
+ */
+int yolo2_accel_open_instance(yolo2_accel_t *accel, int index, int tm, int tn, int tr, int tc);
+
+/**
+ * Unmap one accelerator instance
+ */
+void yolo2_accel_close(yolo2_accel_t *accel);
+
+/**
+ * Instance behind the single-engine API (NULL before yolo2_accel_init)
+ */
+yolo2_accel_t *yolo2_accel_default(void);
+
 /**
  * Initialize accelerator driver
  * Maps control registers and GPIO peripherals via /dev/mem
@@ -60,11 +116,17 @@ int yolo2_wait_for_completion(uint32_t timeout_ms);
  */
 uint32_t yolo2_get_status(void);
 
+/**
+ * Set Q values of one instance
+ */
+void yolo2_accel_set_q_values(yolo2_accel_t *accel, int32_t qw, int32_t qa_in, int32_t qa_out, int32_t qb);
+
 /**
  * Execute convolutional layer on accelerator
  * 
  * All buffer addresses must be physical addresses accessible by the accelerator.
  * The accelerator performs DMA directly to/from DDR via AXI HP ports.
+ * yolo2_accel_conv() takes the same arguments after the instance.
  */
 int yolo2_execute_conv_layer(
     uint64_t input_addr,      // Physical address of input buffer
@@ -94,11 +156,35 @@ int yolo2_execute_conv_layer(
     int qa_in,                // Input activation Q value
     int qa_out,               // Output activation Q value
     int qb,                   // Bias Q value
+    int weight_bits,          // Weight precision: 16, 8 (two int8 per 16-bit word) or 4 (codebook + indices)
     uint32_t timeout_ms       // Timeout in milliseconds
 );
 
+/**
+ * Program and start a conv layer on one instance without waiting, so
+ * several instances can run at once; finish with yolo2_accel_wait()
+ */
+int yolo2_accel_conv_start(yolo2_accel_t *accel,
+                           uint64_t input_addr, uint64_t output_addr, uint64_t weight_addr, uint64_t beta_addr,
+                           int ifm_num, int ofm_num, int ksize, int kstride,
+                           int input_w, int input_h, int output_w, int output_h, int padding,
+                           int is_nl, int is_bn, int tm, int tn, int tr, int tc,
+                           int ofm_num_bound, int mloopsxTM, int mloops_a1xTM, int layer_type,
+                           int qw, int qa_in, int qa_out, int qb, int weight_bits);
+
+int yolo2_accel_wait(yolo2_accel_t *accel, uint32_t timeout_ms);
+
+int yolo2_accel_conv(yolo2_accel_t *accel,
+                     uint64_t input_addr, uint64_t output_addr, uint64_t weight_addr, uint64_t beta_addr,
+                     int ifm_num, int ofm_num, int ksize, int kstride,
+                     int input_w, int input_h, int output_w, int output_h, int padding,
+                     int is_nl, int is_bn, int tm, int tn, int tr, int tc,
+                     int ofm_num_bound, int mloopsxTM, int mloops_a1xTM, int layer_type,
+                     int qw, int qa_in, int qa_out, int qb, int weight_bits, uint32_t timeout_ms);
+
 /**
  * Execute maxpool layer on accelerator
+ * yolo2_accel_maxpool() takes the same arguments after the instance.
  */
 int yolo2_execute_maxpool_layer(
     uint64_t input_addr,      // Physical address of input buffer
@@ -120,6 +206,13 @@ int yolo2_execute_maxpool_layer(
     uint32_t timeout_ms       // Timeout in milliseconds
 );
 
+int yolo2_accel_maxpool(yolo2_accel_t *accel,
+                        uint64_t input_addr, uint64_t output_addr,
+                        int channels, int ksize, int kstride,
+                        int input_w, int input_h, int output_w, int output_h, int padding,
+                        int tm, int tr, int tc,
+                        int ofm_num_bound, int mloopsxTM, int mloops_a1xTM, uint32_t timeout_ms);
+
 /**
  * Read register value (for debugging)
  * offset: Register offset from base address
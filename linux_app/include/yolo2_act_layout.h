@@ -0,0 +1,50 @@
+/**
+ * YOLOv2 activation layout in DDR
+ *
+ * Shared by the host model, the Vitis cosim testbench and linux_app. It must
+ * match the layout the accelerator was built with (ACT_BLOCKED_LAYOUT).
+ *
+ * Default (CHW): one plane per channel, every row padded to a multiple of 8
+ * elements. The accelerator moves a tile as one short burst per channel per
+ * row, and 13-wide rows waste 3 of every 16 elements.
+ *
+ * ACT_BLOCKED_LAYOUT: channels are grouped into blocks of YOLO2_ACT_BLOCK
+ * (= Tn). Each block is stored HWC with its channels interleaved per pixel
+ * and unpadded rows. The last block is zero-padded to full width. A tile
+ * moves as one burst per block row, and a full-width tile as a single burst.
+ *
+ *   CHW:     index = (c*h + y)*align8(w) + x
+ *   blocked: index = ((c/B)*h*w + y*w + x)*B + c%B
+ */
+
+#ifndef YOLO2_ACT_LAYOUT_H
+#define YOLO2_ACT_LAYOUT_H
+
+#include <stddef.h>
+
+#define YOLO2_ACT_BLOCK 4   /* = Tn of ACT_BLOCKED_LAYOUT builds; the HLS and host sources static_assert it */
+
+/* Elements a c x h x w tensor occupies. */
+static inline size_t yolo2_act_words(int c, int h, int w)
+{
+#ifdef ACT_BLOCKED_LAYOUT
+    const size_t blocks = (size_t)((c + YOLO2_ACT_BLOCK - 1) / YOLO2_ACT_BLOCK);
+    return blocks * YOLO2_ACT_BLOCK * (size_t)h * (size_t)w;
+#else
+    return (size_t)c * (size_t)h * (size_t)((w + 7) & ~7);
+#endif
+}
+
+/* Element offset of (channel, y, x) in an h x w tensor. */
+static inline size_t yolo2_act_index(int ch, int y, int x, int h, int w)
+{
+#ifdef ACT_BLOCKED_LAYOUT
+    const size_t block = (size_t)(ch / YOLO2_ACT_BLOCK);
+    return (block * (size_t)h * (size_t)w + (size_t)y * (size_t)w + (size_t)x) * YOLO2_ACT_BLOCK +
+           (size_t)(ch % YOLO2_ACT_BLOCK);
+#else
+    return ((size_t)ch * (size_t)h + (size_t)y) * (size_t)((w + 7) & ~7) + (size_t)x;
+#endif
+}
+
+#endif /* YOLO2_ACT_LAYOUT_H */
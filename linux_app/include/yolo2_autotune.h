@@ -0,0 +1,87 @@
+/**
+ * YOLOv2 per-layer tiling autotuner and tuning cache
+ *
+ * The weight stream is reorganized for the bitstream's TM/TN, so only the
+ * spatial tile (TR, TC) of a conv/maxpool layer can change at run time. Any
+ * TR/TC up to the engine limits gives bit-identical outputs (the rounding
+ * follows the TN blocks, not the spatial tiles), but the DMA burst shapes and
+ * the overlap of load/compute/store change, so the fastest tile depends on the
+ * layer shape and the memory system.
+ *
+ * --autotune runs every conv/maxpool layer of one frame under each legal
+ * (TR, TC), times repeated runs, checks the output hash against the default
+ * tiling and keeps the fastest. The results go to a text cache keyed by
+ * (bitstream ID, model key, layer):
+ *
+ *   <bitstream:016x> <model:016x> <layer> <tr> <tc> <us>
+ *
+ * Normal runs load the entries of the current bitstream and model and use
+ * them in yolo2_run_inference_layers().
+ *
+ * Runtime control via env vars:
+ *   YOLO2_AUTOTUNE_REPEATS=<n>  timed runs per candidate (default 5)
+ *   YOLO2_BITSTREAM=<path>      bitstream hashed into the bitstream ID
+ *                               (default YOLO2_BITSTREAM_DEFAULT)
+ */
+
+#ifndef YOLO2_AUTOTUNE_H
+#define YOLO2_AUTOTUNE_H
+
+#include <stdint.h>
+
+#include "yolo2_accel_linux.h"
+#include "yolo2_inference.h"
+
+#define YOLO2_TUNING_LAYERS 32
+#define YOLO2_BITSTREAM_DEFAULT "/lib/firmware/xilinx/yolov2_accel/yolov2_accel.bit.bin"
+
+typedef struct yolo2_tuning {
+    uint64_t bitstream_id;
+    uint64_t model_key;
+    int valid[YOLO2_TUNING_LAYERS];
+    int tr[YOLO2_TUNING_LAYERS];
+    int tc[YOLO2_TUNING_LAYERS];
+    uint64_t us[YOLO2_TUNING_LAYERS];   /* median layer time when tuned */
+} yolo2_tuning_t;
+
+/**
+ * Bitstream ID: hash of the loaded bitstream file, the engine tiling and the
+ * activation layout (the tiling and layout only when the file is missing)
+ */
+uint64_t yolo2_tuning_bitstream_id(const yolo2_accel_t *engine);
+
+/**
+ * Load the entries of t->bitstream_id / t->model_key from `path`
+ *
+ * Returns: the number of tuned layers (0 when the file does not exist), -1 on error
+ */
+int yolo2_tuning_load(const char *path, yolo2_tuning_t *t);
+
+/**
+ * Write the tuned layers of `t` to `path`, keeping the entries of other
+ * bitstreams and models
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_tuning_save(const char *path, const yolo2_tuning_t *t);
+
+/**
+ * Replace the default tile of layer `layer` with the tuned one, if any.
+ * The tuned tile is ignored unless it fits the default (the engine limits).
+ */
+void yolo2_tuning_apply(const yolo2_tuning_t *t, int layer, int *tr, int *tc);
+
+/**
+ * Tune every conv/maxpool layer of one frame of `input_image`
+ *
+ * Each candidate (TR, TC) runs `repeats` times from the same layer input;
+ * its time is the median. Candidates whose output differs from the default
+ * tiling are rejected. The frame completes with the chosen tiles, so ctx
+ * holds a normal result afterwards. The tuned layers are added to `t`
+ * (bitstream_id and model_key must be set).
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_autotune(yolo2_inference_context_t *ctx, float *input_image, int repeats, yolo2_tuning_t *t);
+
+#endif /* YOLO2_AUTOTUNE_H */
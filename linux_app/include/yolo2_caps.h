@@ -0,0 +1,81 @@
+/**
+ * YOLOv2 accelerator capability block
+ *
+ * Shared by the HLS IP, the host model, the Vitis cosim testbench and
+ * linux_app. YOLO2_FPGA called with LayerType == YOLO2_LAYER_CAPS touches no
+ * memory: it fills its Caps array (read-only on CTRL_BUS) with the build
+ * parameters of the IP and returns. Executors query it once and size their
+ * tiling plan from it instead of from compile-time constants, so one runtime
+ * can drive bitstreams built with different tile sizes.
+ *
+ *   word 0  YOLO2_CAPS_MAGIC
+ *   word 1  version: major << 16 | minor
+ *   word 2  Tm | Tn << 16
+ *   word 3  Tr | Tc << 16
+ *   word 4  on-chip input buffer: height | width << 16
+ *   word 5  K | S << 8 | SPLIT_K << 16
+ *   word 6  YOLO2_CAP_* feature bits
+ *   word 7  MAX_BETA_LENGTH
+ *
+ * An IP built before the block existed ignores the query (it has no output
+ * rows to walk) and reads back zeros, which yolo2_caps_decode() rejects.
+ */
+
+#ifndef YOLO2_CAPS_H
+#define YOLO2_CAPS_H
+
+#include <stdint.h>
+
+#define YOLO2_LAYER_CAPS 3          /* LayerType of the query call */
+#define YOLO2_CAPS_WORDS 8
+#define YOLO2_CAPS_MAGIC 0x59324350u  /* "Y2CP" */
+#define YOLO2_CAPS_VERSION_MAJOR 1
+#define YOLO2_CAPS_VERSION_MINOR 1
+
+/* Feature bits (word 6) */
+#define YOLO2_CAP_CONV           (1u << 0)
+#define YOLO2_CAP_MAXPOOL        (1u << 1)
+#define YOLO2_CAP_REORG          (1u << 2)
+#define YOLO2_CAP_INT16          (1u << 3)  /* INT16_MODE build; FP32 otherwise */
+#define YOLO2_CAP_WEIGHTS_8BIT   (1u << 4)
+#define YOLO2_CAP_WEIGHTS_4BIT   (1u << 5)
+#define YOLO2_CAP_ACT_BLOCKED    (1u << 6)  /* ACT_BLOCKED_LAYOUT (yolo2_act_layout.h) */
+#define YOLO2_CAP_REQUANT        (1u << 7)  /* per-channel requantization (yolo2_requant.h), minor >= 1 */
+
+typedef struct {
+    int version_major, version_minor;
+    int tm, tn, tr, tc;
+    int ib_height, ib_width;
+    int ksize, stride;
+    int split_k;
+    uint32_t features;
+    int max_beta_length;
+} yolo2_caps_t;
+
+/* Returns 0 when `words` holds a capability block this code understands, -1 otherwise. */
+static inline int yolo2_caps_decode(const uint32_t *words, yolo2_caps_t *caps)
+{
+    if (words[0] != YOLO2_CAPS_MAGIC || (int)(words[1] >> 16) != YOLO2_CAPS_VERSION_MAJOR) {
+        return -1;
+    }
+    caps->version_major = (int)(words[1] >> 16);
+    caps->version_minor = (int)(words[1] & 0xffffu);
+    caps->tm = (int)(words[2] & 0xffffu);
+    caps->tn = (int)(words[2] >> 16);
+    caps->tr = (int)(words[3] & 0xffffu);
+    caps->tc = (int)(words[3] >> 16);
+    caps->ib_height = (int)(words[4] & 0xffffu);
+    caps->ib_width = (int)(words[4] >> 16);
+    caps->ksize = (int)(words[5] & 0xffu);
+    caps->stride = (int)((words[5] >> 8) & 0xffu);
+    caps->split_k = (int)((words[5] >> 16) & 0xffu);
+    caps->features = words[6];
+    caps->max_beta_length = (int)words[7];
+    if (caps->tm < 1 || caps->tn < 1 || caps->tr < 1 || caps->tc < 1 ||
+        caps->ib_height < caps->tr || caps->ib_width < caps->tc || caps->split_k < 1) {
+        return -1;
+    }
+    return 0;
+}
+
+#endif /* YOLO2_CAPS_H */
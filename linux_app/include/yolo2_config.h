@@ -21,6 +21,12 @@
 #define AXI_GPIO_QA_OUT_BASE   0xA0030000UL  // Output activation Q value
 #define AXI_GPIO_QB_BASE       0xA0040000UL  // Bias Q value
 
+// Further YOLO2_FPGA instances (yolo2_accel_open_instance): instance i has its
+// CTRL_BUS and Q GPIOs at the addresses above + i * YOLO2_ACCEL_STRIDE, so
+// instance 1 is at 0xA0050000 with its GPIOs at 0xA0060000-0xA0090000.
+#define YOLO2_MAX_ACCELS       4
+#define YOLO2_ACCEL_STRIDE     0x50000UL
+
 // Memory region sizes for mmap
 #define YOLO2_CTRL_SIZE        0x1000   // 4KB for control registers
 #define AXI_GPIO_SIZE          0x1000   // 4KB per GPIO
@@ -73,6 +79,11 @@
 #define CTRL_MLOOPSXTM_OFFSET  0xc0     // mLoops * TM
 #define CTRL_MLOOPS_A1XTM_OFFSET 0xc8   // (mLoops+1) * TM
 #define CTRL_LAYER_TYPE_OFFSET 0xd0     // Layer type
+#define CTRL_WEIGHT_BITS_OFFSET 0xd8    // Weight precision (16, 8 = two int8 per word, 4 = codebook)
+
+// Read-only capability block (yolo2_caps.h): YOLO2_CAPS_WORDS words, filled
+// by a LayerType YOLO2_LAYER_CAPS call (XYOLO2_FPGA_CTRL_BUS_ADDR_CAPS_BASE)
+#define CTRL_CAPS_OFFSET       0xe0
 
 // NOTE: Q values are passed via AXI GPIO, not control registers
 // The HLS IP does not have Q value registers in CTRL_BUS
@@ -91,9 +102,12 @@
 #define BIAS_SIZE_BYTES        (10761 * 2)     // ~21KB bias
 
 /*===========================================================================
- * Tiling Parameters (must match HLS design)
+ * Tiling Parameters (fallback)
  *===========================================================================*/
-// Keep these in sync with `hls/core/params.hpp` used to build the HLS IP.
+// The driver reads the tiling from the IP's capability block. These values
+// (kept in sync with `hls/core/params.hpp` by hw_params_gen.py) are assumed
+// only for IP built without one, and are the tiling the weight files are
+// reorganized for.
 #define Tm                     32       // Output channel tile (max)
 #define Tn                     4        // Input channel tile (max)
 #define Tr                     13       // Row tile (max)
@@ -0,0 +1,132 @@
+/**
+ * YOLOv2 INT16 conv kernel on the CPU
+ *
+ * Shared by the host model and linux_app. Computes output channels
+ * [c0, c1) of a conv layer bit-exactly as the accelerator's INT16 compute()
+ * does, so a layer's output channels can be split between the accelerator
+ * (the first channels) and the A53 cores (the rest) writing one output tensor:
+ *
+ *   acc  = bias shifted to Qacc = Qa_out + ACC_GUARD_BITS (rounded)
+ *   per Tn input-channel block, per (ky, kx):
+ *          acc = sat32(acc + round_shift(sum over the block of w * x))
+ *   out  = sat16(round(acc >> ACC_GUARD_BITS)), leaky: negative / 10
+ *          (per-channel requantized layers: yolo2_requant(), yolo2_requant.h)
+ *
+ * The sum over a block is exact (int64); the rounding and saturation per
+ * block and kernel tap is what makes the result depend on the tiling, so the
+ * kernel takes the layer's TM/TN. With split_k == 2, odd blocks accumulate
+ * separately and are added at the end (core_scheduler.cpp, SPLIT_K).
+ *
+ * Weights come from the reorganized stream (16-, 8- or 4-bit, see
+ * weight_load_reorg()), decoded once per layer. The accelerator's part of a
+ * split must be whole TM blocks from channel 0 so its stream layout is
+ * unchanged: yolo2_cpu_offload_channels() picks the CPU part on that grid.
+ *
+ * Uses NEON on aarch64 (vmull_s16 products widened into int64), plain C
+ * elsewhere. Output channels are spread over `threads` pthreads.
+ */
+
+#ifndef YOLO2_CPU_CONV_H
+#define YOLO2_CPU_CONV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Must match ACC_GUARD_BITS in hls/core/types.hpp. */
+#define YOLO2_CPU_CONV_GUARD_BITS 8
+
+typedef struct {
+    int ifm, ofm, ksize, stride, pad;
+    int in_w, in_h, out_w, out_h;
+    int tm, tn;             /* layer tiling: min(ofm, Tm), min(ifm, Tn) */
+    int weight_bits;        /* 16, 8 or 4, maybe | YOLO2_WBITS_REQUANT */
+    int qw, qa_in, qa_out, qb;
+    int is_nl;
+    int split_k;            /* 1 or 2 (SPLIT_K of the bitstream) */
+} yolo2_cpu_conv_t;
+
+/**
+ * Decode the weights of output channels [c0, c1) from the layer's
+ * reorganized stream (starting at its first word) into compute order
+ *
+ * dst: (c1 - c0) * ifm * ksize * ksize values
+ */
+void yolo2_cpu_conv_decode(const yolo2_cpu_conv_t *l, const int16_t *weights, int c0, int c1, int16_t *dst);
+
+/**
+ * Compute output channels [c0, c1)
+ *
+ * input:   the layer input in the activation layout (yolo2_act_layout.h)
+ * weights: channels [c0, c1) from yolo2_cpu_conv_decode()
+ * bias:    the layer's Beta block (bias, or {bias, mult, shift} per channel)
+ * output:  the layer output; only channels [c0, c1) are written (plus the
+ *          zero lanes of the last channel block in the blocked layout)
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_cpu_conv(const yolo2_cpu_conv_t *l, const int16_t *input, const int16_t *weights,
+                   const int16_t *bias, int16_t *output, int c0, int c1, int threads);
+
+/**
+ * Worker threads for yolo2_cpu_conv(): YOLO2_CPU_THREADS, default the
+ * online CPU count minus `busy` (threads the caller keeps for itself)
+ */
+int yolo2_cpu_conv_threads(int busy);
+
+/*
+ * Per-layer CPU/accelerator split. `fraction` > 0 gives the CPU a fixed
+ * share; fraction < 0 (auto) balances the measured rates of each layer.
+ */
+#define YOLO2_CPU_OFFLOAD_LAYERS 32
+
+typedef struct {
+    double fraction;                                /* < 0: auto */
+    double fpga_us_per_ch[YOLO2_CPU_OFFLOAD_LAYERS];  /* 0 = not measured */
+    double cpu_us_per_ch[YOLO2_CPU_OFFLOAD_LAYERS];
+    int16_t *weights[YOLO2_CPU_OFFLOAD_LAYERS];     /* decoded channels [weights_c0, ofm) */
+    int weights_c0[YOLO2_CPU_OFFLOAD_LAYERS];
+} yolo2_cpu_offload_t;
+
+/**
+ * Parse YOLO2_CPU_OFFLOAD (a fraction in (0, 1) or "auto")
+ *
+ * Returns: 1 when enabled (state initialized), 0 when unset or 0, -1 on error
+ */
+int yolo2_cpu_offload_init(yolo2_cpu_offload_t *s, const char *env);
+
+/**
+ * Output channels of layer `layer` to compute on the CPU: the tail of the
+ * layer past the last whole TM block kept by the accelerator (0 = none).
+ * The accelerator always keeps at least one block.
+ */
+int yolo2_cpu_offload_channels(const yolo2_cpu_offload_t *s, int layer, int ofm, int tm);
+
+/**
+ * Record one split run of layer `layer` (wall time of each side)
+ */
+void yolo2_cpu_offload_update(yolo2_cpu_offload_t *s, int layer, int fpga_ch, double fpga_us,
+                              int cpu_ch, double cpu_us);
+
+/**
+ * Decoded weights of channels [c0, ofm) of layer `layer`, kept until the
+ * split moves (the weight buffer may be uncached DMA memory)
+ *
+ * weights: the layer's first reorganized weight word
+ * Returns: NULL on error
+ */
+const int16_t *yolo2_cpu_offload_weights(yolo2_cpu_offload_t *s, int layer, const yolo2_cpu_conv_t *l,
+                                         const int16_t *weights, int c0);
+
+/**
+ * Free the cached weights
+ */
+void yolo2_cpu_offload_cleanup(yolo2_cpu_offload_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YOLO2_CPU_CONV_H */
@@ -0,0 +1,118 @@
+/**
+ * YOLOv2 golden store - per-layer checksums for host/cosim/board regression
+ *
+ * A golden file records, for every accelerator-visible layer output, a hash
+ * per output tile plus ~256 evenly strided sample values. Files live in a
+ * directory and are keyed by (model hash, input hash):
+ *
+ *   <dir>/<model_key:016x>_<input_key:016x>.y2g
+ *
+ * The same C implementation is linked into the host model (yolov2_detect),
+ * the Vitis cosim testbench and linux_app so the three executors can record
+ * and verify each other. Verification reports the first diverging layer and
+ * the first diverging tile inside it.
+ *
+ * Runtime control via env vars:
+ *   YOLO2_GOLDEN_DIR=<dir>              enable, store location
+ *   YOLO2_GOLDEN_MODE=record|verify     default: verify
+ *   YOLO2_GOLDEN_TOL=<float>            accept hash mismatches whose sampled
+ *                                       max |diff| is <= tol (default 0)
+ */
+
+#ifndef YOLO2_GOLDEN_H
+#define YOLO2_GOLDEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YOLO2_GOLDEN_VERSION 1
+#define YOLO2_GOLDEN_MAX_SAMPLES 256
+
+/* Layer type codes stored in the file (match the accelerator LayerType). */
+#define YOLO2_GOLDEN_CONV    0
+#define YOLO2_GOLDEN_MAXPOOL 1
+#define YOLO2_GOLDEN_REORG   2
+
+typedef enum {
+    YOLO2_GOLDEN_OFF = 0,
+    YOLO2_GOLDEN_RECORD,
+    YOLO2_GOLDEN_VERIFY
+} yolo2_golden_mode_t;
+
+typedef struct yolo2_golden yolo2_golden_t;
+
+/**
+ * 64-bit non-cryptographic hash, chainable through seed.
+ */
+uint64_t yolo2_hash64(uint64_t seed, const void *data, size_t len);
+
+/**
+ * Hash a list of files in order (missing files are skipped).
+ * Used to derive the model key from the weight/bias/Q files.
+ */
+uint64_t yolo2_golden_hash_files(const char *const *paths, int count);
+
+/**
+ * Model key for a weights directory: hash of the reorganized weights, bias
+ * and (INT16) Q tables and weight_bits.bin, in that order, so all executors
+ * agree on the key.
+ */
+uint64_t yolo2_golden_model_key(const char *weights_dir, int is_int16);
+
+/**
+ * Returns non-zero when YOLO2_GOLDEN_DIR is set, so callers can skip
+ * computing keys when the golden store is unused.
+ */
+int yolo2_golden_env_enabled(void);
+
+/**
+ * Open a golden session.
+ *
+ * elem_size/is_float describe the tensors passed to yolo2_golden_layer()
+ * (2/0 for INT16 builds, 4/1 for FP32). In verify mode the stored file is
+ * loaded immediately. Returns NULL on error or when mode is OFF.
+ */
+yolo2_golden_t *yolo2_golden_open(const char *dir, yolo2_golden_mode_t mode,
+                                  uint64_t model_key, uint64_t input_key,
+                                  int elem_size, int is_float);
+
+/**
+ * Open from YOLO2_GOLDEN_DIR / YOLO2_GOLDEN_MODE. Returns NULL when disabled.
+ */
+yolo2_golden_t *yolo2_golden_open_env(uint64_t model_key, uint64_t input_key,
+                                      int elem_size, int is_float);
+
+/**
+ * Record or verify one layer output.
+ *
+ * data points at a CHW tensor whose rows are row_stride elements apart (the
+ * DDR layout pads rows to 8 elements); only the first w of each row are used.
+ * tile_c/tile_h/tile_w give the tile grid for recording; verify mode uses the
+ * grid stored in the file.
+ *
+ * Returns 0 on match (or recorded), 1 on divergence, -1 on error.
+ */
+int yolo2_golden_layer(yolo2_golden_t *g, int layer, int type, const void *data,
+                       int c, int h, int w, int row_stride,
+                       int tile_c, int tile_h, int tile_w);
+
+/**
+ * Finish the session. Record mode writes the file; verify mode prints a
+ * summary. Returns the first diverging layer index, -1 if none, or -2 on error.
+ */
+int yolo2_golden_close(yolo2_golden_t *g);
+
+/**
+ * Release a session without writing anything (e.g. inference failed midway).
+ */
+void yolo2_golden_discard(yolo2_golden_t *g);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YOLO2_GOLDEN_H */
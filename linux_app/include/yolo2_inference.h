@@ -9,7 +9,14 @@
 
 #include <stdint.h>
 #include "dma_buffer_manager.h"
+#include "yolo2_accel_linux.h"
+#include "yolo2_config.h"
+#include "yolo2_cpu_conv.h"
+#include "yolo2_input.h"
 #include "yolo2_network.h"
+#include "yolo2_plan.h"
+
+struct yolo2_tuning;
 
 /**
  * Inference context structure
@@ -20,6 +27,10 @@ typedef struct {
     memory_buffer_t weights_buf;
     memory_buffer_t bias_buf;
     memory_buffer_t inference_buf;
+
+    // First weight word weights_buf holds: 0, or where the stage-B stream of
+    // a two-engine pipeline starts (yolo2_pipeline.h)
+    long weights_word_base;
     
     // Q values (INT16 quantization mode)
     int32_t *weight_q;
@@ -28,6 +39,10 @@ typedef struct {
     size_t weight_q_size;
     size_t bias_q_size;
     size_t act_q_size;
+
+    // Per-conv weight precision (weight_bits.bin; NULL = all 16-bit)
+    int32_t *weight_bits;
+    size_t weight_bits_size;
     
     // Layer tracking
     int current_layer;
@@ -51,6 +66,41 @@ typedef struct {
     float *region_output;
     size_t region_output_size;
     int region_layer_idx;
+
+    // Golden store model key (see yolo2_golden.h); 0 when unused
+    uint64_t golden_model_key;
+
+    // Accelerator instance for conv/maxpool layers; NULL = yolo2_accel_default().
+    // Tile sizes follow the instance.
+    yolo2_accel_t *accel;
+
+    // Further instances that share every conv layer's output channels with
+    // `accel` (yolo2_ofm_split.h); they need the same or larger tile sizes
+    yolo2_accel_t *ofm_peers[YOLO2_MAX_ACCELS - 1];
+    int num_ofm_peers;
+
+    // CPU share of every conv layer's output channels, computed while the
+    // accelerator runs the rest (yolo2_cpu_conv.h); NULL = accelerator only.
+    // Not used together with ofm_peers.
+    yolo2_cpu_offload_t *cpu_offload;
+
+    // Per-layer tile sizes from the tuning cache (yolo2_autotune.h);
+    // NULL = the engine defaults
+    const struct yolo2_tuning *tuning;
+
+    // Wall time of each layer in the last run (us)
+    uint64_t layer_time_us[32];
+
+    // Layer plan of the engine running the current frame (yolo2_plan.h).
+    // Built per engine on its first frame and kept for the two engines a
+    // pipeline slot alternates between; with YOLO2_STATIC_PLAN it is the
+    // compiled-in yolo2_static_plan, checked once per engine.
+    const yolo2_plan_t *plan;
+    const yolo2_accel_t *plan_engines[2];
+    yolo2_plan_t plan_storage[2];
+
+    // yolo2_inference_load_input() quantized the next frame into in_ptr[0]
+    int input_loaded;
 } yolo2_inference_context_t;
 
 /**
@@ -127,10 +177,18 @@ int yolo2_inference_maxpool_layer(yolo2_inference_context_t *ctx,
 int yolo2_dequantize_output(int16_t *input, float *output, size_t count, int32_t q_out);
 
 /**
- * Generate IOFM offset pointers (memory layout)
+ * Generate IOFM offset pointers (memory layout) from ctx->plan
  */
 int yolo2_generate_iofm_offset(yolo2_inference_context_t *ctx);
 
+/**
+ * Make ctx->plan the layer plan for `engine`: build it from ctx->net and
+ * ctx->weight_bits, or check the compiled-in plan against them
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_inference_plan(yolo2_inference_context_t *ctx, const yolo2_accel_t *engine);
+
 /**
  * Execute REORG layer on CPU
  */
@@ -155,6 +213,50 @@ int yolo2_execute_region_layer(yolo2_inference_context_t *ctx, int layer_idx);
  */
 int yolo2_run_inference(yolo2_inference_context_t *ctx, float *input_image);
 
+/**
+ * Run complete inference pipeline on a caller-owned frame
+ *
+ * input: frame to letterbox and quantize straight into the accelerator
+ *        input (yolo2_input.h); a YOLO2_INPUT_ACT_Q16 frame in DMA memory is
+ *        read in place. It must stay valid until the call returns. NULL
+ *        runs the frame yolo2_inference_load_input() quantized.
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_run_inference_input(yolo2_inference_context_t *ctx, const yolo2_input_t *input);
+
+/**
+ * Letterbox and quantize `input` into ctx's input buffer (never read in
+ * place) for the next run with a NULL input. The caller may release the
+ * frame as soon as this returns, e.g. re-queue a V4L2 capture buffer
+ * before the network runs.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_inference_load_input(yolo2_inference_context_t *ctx, const yolo2_input_t *input);
+
+/**
+ * Run layers [first, last] of one frame
+ *
+ * first == 0 starts a new frame from input_image (NULL: the frame
+ * yolo2_inference_load_input() quantized); otherwise the frame
+ * already in ctx continues where the previous call stopped (input_image is
+ * ignored). The golden check and latency summary need the full range.
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_run_inference_layers(yolo2_inference_context_t *ctx, float *input_image, int first, int last);
+
+/**
+ * yolo2_run_inference_layers() on a frame given by an input descriptor
+ */
+int yolo2_run_inference_input_layers(yolo2_inference_context_t *ctx, const yolo2_input_t *input,
+                                     int first, int last);
+
+/**
+ * Default spatial tile of a conv or maxpool layer on `engine`: the engine's
+ * TR/TC, limited by its input buffer and the layer's output size
+ */
+void yolo2_layer_tile(const yolo2_accel_t *engine, const layer_t *l, int *tr, int *tc);
+
 /**
  * Get region layer output (for post-processing)
  */
@@ -0,0 +1,89 @@
+/**
+ * YOLOv2 input descriptors
+ *
+ * Describes a caller-owned frame (pointer, size, row stride, pixel format)
+ * so the runtime can letterbox it straight into the network input instead
+ * of first converting the whole frame to float CHW. Output rows are built
+ * from at most two source rows at a time; results match
+ * yolo2_letterbox_image() on the float CHW copy of the same frame.
+ *
+ * YOLO2_INPUT_ACT_Q16 is the network input itself: int16 at act_q[0] in the
+ * accelerator activation layout (yolo2_act_layout.h). When it lies in a
+ * tracked DMA buffer the accelerator reads it in place.
+ */
+
+#ifndef YOLO2_INPUT_H
+#define YOLO2_INPUT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    YOLO2_INPUT_RGB24,    // interleaved 8-bit R, G, B
+    YOLO2_INPUT_BGR24,
+    YOLO2_INPUT_RGBX32,   // 8-bit R, G, B + one ignored byte
+    YOLO2_INPUT_BGRX32,
+    YOLO2_INPUT_YUYV,     // packed 4:2:2 (V4L2_PIX_FMT_YUYV), even width
+    YOLO2_INPUT_F32_CHW,  // float planes in [0, 1], each `height` rows of `stride` bytes
+    YOLO2_INPUT_ACT_Q16   // network input, letterboxed and quantized (see above)
+} yolo2_input_format_t;
+
+typedef struct {
+    const void *data;
+    int width;
+    int height;
+    size_t stride;        // bytes between rows; 0 = packed rows
+    yolo2_input_format_t format;
+    int letterboxed;      // already the INPUT_WIDTH x INPUT_HEIGHT letterbox: no resize
+} yolo2_input_t;
+
+/**
+ * Describe a packed INPUT_WIDTH x INPUT_HEIGHT float CHW network input
+ * (the yolo2_load_image() / yolo2_letterbox_image() output)
+ */
+yolo2_input_t yolo2_input_chw(const float *chw);
+
+/**
+ * Bytes per row of `in` (its stride, or the packed row size)
+ */
+size_t yolo2_input_row_bytes(const yolo2_input_t *in);
+
+/**
+ * Letterbox `in` to out_w x out_h float CHW in [0, 1] (gray padding)
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_input_letterbox(const yolo2_input_t *in, float *output, int out_w, int out_h);
+
+/**
+ * Letterbox `in` into the accelerator input: INPUT_WIDTH x INPUT_HEIGHT,
+ * quantized at q_in, in the activation layout
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_input_quantize(const yolo2_input_t *in, int16_t *output, int32_t q_in);
+
+/**
+ * YUYV pixel pair (Y0 U Y1 V) -> two RGB24 pixels, integer BT.601
+ */
+static inline uint8_t yolo2_clamp_u8(int v)
+{
+    return (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+static inline void yolo2_yuyv_pair_to_rgb24(const uint8_t *src, uint8_t *dst)
+{
+    const int c0 = (int)src[0] - 16;
+    const int d = (int)src[1] - 128;
+    const int c1 = (int)src[2] - 16;
+    const int e = (int)src[3] - 128;
+
+    dst[0] = yolo2_clamp_u8((298 * c0 + 409 * e + 128) >> 8);
+    dst[1] = yolo2_clamp_u8((298 * c0 - 100 * d - 208 * e + 128) >> 8);
+    dst[2] = yolo2_clamp_u8((298 * c0 + 516 * d + 128) >> 8);
+    dst[3] = yolo2_clamp_u8((298 * c1 + 409 * e + 128) >> 8);
+    dst[4] = yolo2_clamp_u8((298 * c1 - 100 * d - 208 * e + 128) >> 8);
+    dst[5] = yolo2_clamp_u8((298 * c1 + 516 * d + 128) >> 8);
+}
+
+#endif /* YOLO2_INPUT_H */
@@ -0,0 +1,65 @@
+/**
+ * YOLOv2 output-channel split across accelerator instances
+ *
+ * Shared by the host model and linux_app. A conv layer's OFM range is cut
+ * into contiguous slices of whole TM blocks, one per instance. Every slice
+ * reads the full input and writes its own channel range of the output, so
+ * each instance is called with offset pointers and no change to the IP:
+ *
+ *   weights: the reorganized layer is TM-block major, so block m0/TM starts
+ *            m0 * IFM * K*K weights in (halved for 8-bit layers)
+ *   bias:    + m0 words, m0 * 3 for per-channel requantized layers
+ *            (yolo2_requant.h)
+ *   output:  + yolo2_act_words(m0, out_h, out_w)
+ *
+ * 4-bit layers are not split: their codebook sits in front of the indices.
+ */
+
+#ifndef YOLO2_OFM_SPLIT_H
+#define YOLO2_OFM_SPLIT_H
+
+#include <stddef.h>
+
+#include "yolo2_act_layout.h"
+#include "yolo2_requant.h"
+
+typedef struct {
+    int m0;                 /* first output channel */
+    int ofm;                /* output channels in this slice */
+    size_t weight_offset;   /* IO words from the layer's first weight */
+    size_t beta_offset;     /* IO words from the layer's first bias */
+} yolo2_ofm_slice_t;
+
+/* Fills up to `instances` slices and returns how many are used (1 = no split). */
+static inline int yolo2_ofm_split(int ofm, int ifm, int ksize, int tm, int weight_bits,
+                                  int instances, yolo2_ofm_slice_t *slices)
+{
+    const int bits = yolo2_wbits_precision(weight_bits);
+    const int blocks = (ofm + tm - 1) / tm;
+    int n = instances < blocks ? instances : blocks;
+#ifdef ACT_BLOCKED_LAYOUT
+    if (tm % YOLO2_ACT_BLOCK != 0) {
+        n = 1;
+    }
+#endif
+    /* 8-bit slices must start on a whole 16-bit word */
+    if (bits == 4 || (bits == 8 && ((size_t)tm * ifm * ksize * ksize) % 2) || n < 1) {
+        n = 1;
+    }
+
+    int block = 0;
+    for (int s = 0; s < n; ++s) {
+        const int count = blocks / n + (s < blocks % n ? 1 : 0);
+        const int m0 = block * tm;
+        const int m1 = (block + count) * tm < ofm ? (block + count) * tm : ofm;
+        const size_t weights = (size_t)m0 * (size_t)ifm * (size_t)(ksize * ksize);
+        slices[s].m0 = m0;
+        slices[s].ofm = m1 - m0;
+        slices[s].weight_offset = (bits == 8) ? weights / 2 : weights;
+        slices[s].beta_offset = (size_t)m0 * (size_t)yolo2_beta_words(weight_bits);
+        block += count;
+    }
+    return n;
+}
+
+#endif /* YOLO2_OFM_SPLIT_H */
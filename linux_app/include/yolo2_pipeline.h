@@ -0,0 +1,80 @@
+/**
+ * YOLOv2 two-engine layer pipeline
+ *
+ * Engine A (the default instance at YOLO2_CTRL_BASE) runs layers [0, split]
+ * of frame N+1 while engine B (instance 1) runs layers (split, end] of frame
+ * N on a second thread. Each in-flight frame owns one of two frame slots: an
+ * inference context with its own activation buffer that shares the primary
+ * context's weights, bias and Q tables, so the hand-off at the split needs no
+ * copy.
+ *
+ * The primary weights are reorganized for engine A's Tm/Tn. An engine B with
+ * the same Tm/Tn reads them too. An engine B with another Tm/Tn reads its own
+ * stream, weights_reorg_int16_b.bin from yolov2_weight_gen --engine-b, which
+ * holds the conv layers from the one engine_b_tiling.bin names on; engine B
+ * then never runs a layer before that one. Biases and Q tables do not depend
+ * on the tiling and are shared.
+ *
+ * The first frame runs entirely on A and then on B (from its first layer) to
+ * measure every layer on both engines; the split minimizes max(stage A,
+ * stage B). After that, results lag the input by one frame.
+ *
+ * Runtime control via env vars:
+ *   YOLO2_TWO_ENGINE=1|tm,tn,tr,tc  enable (main.c camera/video modes); the
+ *                                   tiling of engine B when it has no
+ *                                   capability block (default: Tm,Tn,Tr,Tc)
+ *   YOLO2_ENGINE_SPLIT=<layer>      force the last layer of stage A
+ */
+
+#ifndef YOLO2_PIPELINE_H
+#define YOLO2_PIPELINE_H
+
+#include "yolo2_accel_linux.h"
+#include "yolo2_inference.h"
+
+typedef struct {
+    yolo2_inference_context_t *primary;  // weights/Q owner; receives region output
+    yolo2_inference_context_t slot[2];   // per-frame state and activations
+    yolo2_accel_t engine_b;
+    int split;                           // last layer of stage A; -1 until measured
+    int next_slot;                       // slot of the next new frame
+    int pending;                         // a frame waits for stage B
+    int16_t *measure_input;              // loaded first frame, re-run on B
+    memory_buffer_t weights_b;           // stage-B stream for engine B's Tm/Tn; unset when it has A's
+    long weights_b_base;                 // first weight word of weights_b
+    int b_first;                         // first layer engine B has weights for
+} yolo2_pipeline_t;
+
+/**
+ * Open engine B, allocate the second frame slot and, when engine B's Tm/Tn
+ * differ from A's, load its weight stream
+ *
+ * primary: initialized context with weights, bias, Q tables and network
+ * weights_dir: directory of weights_reorg_int16_b.bin and engine_b_tiling.bin
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_pipeline_init(yolo2_pipeline_t *p, yolo2_inference_context_t *primary, const char *weights_dir);
+
+/**
+ * Quantize a frame into the slot the next yolo2_pipeline_step(p, NULL) runs
+ * (see yolo2_inference_load_input()); the caller may release it on return.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_pipeline_load_input(yolo2_pipeline_t *p, const yolo2_input_t *input);
+
+/**
+ * Feed one frame (caller-owned, read until the call returns; NULL runs the
+ * frame yolo2_pipeline_load_input() quantized)
+ *
+ * Returns: 1 when a frame completed (its region output is in the primary
+ * context), 0 while the pipeline fills, -1 on error
+ */
+int yolo2_pipeline_step(yolo2_pipeline_t *p, const yolo2_input_t *input);
+
+/**
+ * Close engine B and free the frame slots (the primary context is untouched)
+ */
+void yolo2_pipeline_cleanup(yolo2_pipeline_t *p);
+
+#endif /* YOLO2_PIPELINE_H */
@@ -0,0 +1,118 @@
+/**
+ * YOLOv2 layer plan
+ *
+ * Shared by the host model and linux_app. Holds everything an executor needs
+ * per layer that follows from the network shape and the accelerator tiling:
+ * output shape, tile sizes, the loop-bound registers, weight/bias offsets, and
+ * the activation buffer offsets of the ping-pong layout (the former
+ * generate_iofm_offset()). The executors build it once from the parsed network
+ * and the capability block (yolo2_caps.h). Per frame they only index it.
+ *
+ * With YOLO2_STATIC_PLAN, the plan is compiled in instead. `make plan` runs
+ * yolov2_plan_gen on the cfg and writes yolo2_plan_table.h, which holds
+ * yolo2_static_plan: constexpr in C++, static const in C. The table is fixed
+ * to one tiling, activation layout and set of weight precisions, so the
+ * executors only check that the accelerator and weight_bits.bin match it.
+ *
+ * Buffer offsets are in activation words from Memory_top (the inference
+ * buffer + 512 words). YOLO2_PLAN_NONE marks layers without a DDR tensor.
+ */
+
+#ifndef YOLO2_PLAN_H
+#define YOLO2_PLAN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YOLO2_PLAN_MAX_LAYERS 32
+#define YOLO2_PLAN_NONE (-1L)
+
+/* Layer kinds (independent of the Darknet and linux_app enums) */
+#define YOLO2_PLAN_CONV    0
+#define YOLO2_PLAN_MAXPOOL 1
+#define YOLO2_PLAN_REORG   2
+#define YOLO2_PLAN_ROUTE   3
+#define YOLO2_PLAN_REGION  4
+#define YOLO2_PLAN_OTHER   5
+
+typedef struct {
+    /* From the cfg, filled in by the caller of yolo2_plan_build() */
+    int type;
+    int ifm, ofm, ksize, stride, pad;
+    int in_w, in_h, out_w, out_h;   /* conv outputs are recomputed */
+    int is_nl, is_bn;
+    int route_layer;                /* single-input route: source layer, else -1 */
+
+    /* Derived */
+    int tm, tn, tr, tc;
+    int ofm_num_bound, mloopsxtm, mloops_a1xtm;
+    int conv_index;                 /* per-conv tables (Q, weight bits); -1 when not a conv */
+    int weight_bits;
+    long weight_offset;             /* first weight, fp32 elements */
+    long weight_word_offset;        /* first word in weights_reorg_int16.bin */
+    long beta_offset;               /* first Beta word; 3 words per channel with YOLO2_WBITS_REQUANT */
+    int route_conv;                 /* conv whose output Q a single-input route forwards, else -1 */
+    long in_offset, out_offset;     /* words from Memory_top, or YOLO2_PLAN_NONE */
+} yolo2_plan_layer_t;
+
+typedef struct yolo2_plan {
+    int n;
+    int tm, tn, tr, tc;
+    int ib_height, ib_width;
+    int act_blocked;                /* built for ACT_BLOCKED_LAYOUT */
+    long mem_len;
+    yolo2_plan_layer_t layers[YOLO2_PLAN_MAX_LAYERS];
+} yolo2_plan_t;
+
+/**
+ * Derive the plan from the cfg fields of plan->layers[0..plan->n)
+ *
+ * weight_bits: per-conv WeightBits word (4, 8 or 16, optionally with
+ *              YOLO2_WBITS_REQUANT); NULL or short = 16
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_plan_build(yolo2_plan_t *plan, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                     const int32_t *weight_bits, int weight_bits_count, long mem_len);
+
+/**
+ * Check that `plan` (usually yolo2_static_plan) was built for this
+ * accelerator tiling, this build's activation layout and these weight
+ * precisions
+ *
+ * Returns: 0 when it matches, -1 otherwise (the difference is printed)
+ */
+int yolo2_plan_check(const yolo2_plan_t *plan, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                     const int32_t *weight_bits, int weight_bits_count);
+
+/**
+ * Drop YOLO2_WBITS_REQUANT from every conv of `plan` and recompute the beta
+ * offsets at one word per channel: the FP32 bias.bin layout, whose loader
+ * strips the flag the same way
+ */
+void yolo2_plan_strip_requant(yolo2_plan_t *plan);
+
+/**
+ * Write `plan` as the yolo2_plan_table.h source for YOLO2_STATIC_PLAN
+ *
+ * Returns: 0 on success, -1 on error
+ */
+int yolo2_plan_write(FILE *fp, const yolo2_plan_t *plan, const char *source);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef YOLO2_STATIC_PLAN
+#ifdef __cplusplus
+#define YOLO2_PLAN_STORAGE static constexpr
+#else
+#define YOLO2_PLAN_STORAGE static const __attribute__((unused))
+#endif
+#include "yolo2_plan_table.h"
+#endif
+
+#endif /* YOLO2_PLAN_H */
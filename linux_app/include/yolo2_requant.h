@@ -0,0 +1,66 @@
+/**
+ * YOLOv2 per-channel requantization (INT16)
+ *
+ * Shared by the HLS IP, the host model, the Vitis cosim testbench, linux_app
+ * and the weight tools. A conv layer accumulates in one power-of-two domain,
+ * Qacc = Qa_out + ACC_GUARD_BITS, and write-back shifts the accumulator down
+ * to Qa_out. A single Qw per layer then fits the channel with the largest
+ * weights, and channels with small weights use few of the int8/int16 levels.
+ *
+ * With YOLO2_WBITS_REQUANT set in a layer's WeightBits word (its
+ * weight_bits.bin entry), yolov2_weight_gen scales the weights and bias of
+ * each output channel c by 1 / r[c], r[c] in [1/64, 1], so every channel
+ * spans the full Qw grid. Write-back multiplies by r[c] again, TFLite-style,
+ * with a Q16 multiplier and a shift:
+ *
+ *   out[c] = sat16(round(acc[c] * mult[c] >> (ACC_GUARD_BITS + shift[c])))
+ *   mult[c] = round(r[c] * 2^shift[c]) in [2^15, 2^16), shift[c] in [16, 22]
+ *
+ * The layer's Beta block then holds three words per channel, {bias, mult,
+ * shift}, instead of one bias word, and the accelerator loads both into its
+ * beta buffer. Layers without the flag are unchanged (mult = 1, shift = 0).
+ */
+
+#ifndef YOLO2_REQUANT_H
+#define YOLO2_REQUANT_H
+
+#include <stdint.h>
+
+#define YOLO2_WBITS_REQUANT 0x100   /* WeightBits flag: per-channel requantization */
+#define YOLO2_WBITS_MASK    0xff    /* WeightBits precision: 16, 8 or 4 */
+
+#define YOLO2_REQUANT_WORDS 3       /* Beta words per channel of a requantized layer */
+#define YOLO2_REQUANT_MIN_SCALE (1.0 / 64)
+
+/* Weight precision of a WeightBits word */
+static inline int yolo2_wbits_precision(int weight_bits)
+{
+    return weight_bits & YOLO2_WBITS_MASK;
+}
+
+static inline int yolo2_wbits_requant(int weight_bits)
+{
+    return (weight_bits & YOLO2_WBITS_REQUANT) != 0;
+}
+
+/* Beta words per output channel */
+static inline int yolo2_beta_words(int weight_bits)
+{
+    return yolo2_wbits_requant(weight_bits) ? YOLO2_REQUANT_WORDS : 1;
+}
+
+/* acc * mult, rounded (half up) and shifted right by `shift` (left if < 0); magnitudes clamp at 30 */
+static inline int64_t yolo2_requant(int64_t acc, int mult, int shift)
+{
+    int64_t v = acc * mult;
+    if (shift > 0) {
+        const int mag = (shift > 30) ? 30 : shift;
+        v = (v + ((int64_t)1 << (mag - 1))) >> mag;
+    } else if (shift < 0) {
+        const int mag = (-shift > 30) ? 30 : -shift;
+        v = v * ((int64_t)1 << mag);
+    }
+    return v;
+}
+
+#endif /* YOLO2_REQUANT_H */
@@ -0,0 +1,114 @@
+/**
+ * YOLOv2 tensor dumps - binary tensors for per-layer host/cosim/board debugging
+ *
+ * A .y2t file holds one tensor: a 64-byte header (shape, dtype, Q value,
+ * layer) followed by the raw little-endian values, so a reader can mmap it
+ * and use the data in place. Writing one is a single fwrite per row instead
+ * of a formatted line per value.
+ *
+ * The same C implementation is linked into the host model (yolov2_detect),
+ * the Vitis cosim testbench and linux_app. Each of them can tap every layer
+ * output into a directory, and yolov2_tensor_cmp compares two such
+ * directories (or two files) layer by layer.
+ *
+ * Runtime control via env vars:
+ *   YOLO2_TAP_DIR=<dir>      write each conv/maxpool/reorg output as
+ *                            <dir>/layer_NN.y2t (compact CHW)
+ *   YOLO2_TAP_LAYERS=<list>  only these layers, e.g. "0-5,30" (default: all)
+ *
+ * The region dumps (YOLO2_DUMP_REGION_RAW, YOLO2_DUMP_REGION) are written
+ * with yolo2_tensor_dump_floats(): .y2t unless the path ends in ".txt".
+ */
+
+#ifndef YOLO2_TENSOR_H
+#define YOLO2_TENSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define YOLO2_TENSOR_VERSION 1
+#define YOLO2_TENSOR_HEADER_SIZE 64
+
+/* Element types */
+#define YOLO2_TENSOR_F32 0
+#define YOLO2_TENSOR_I16 1
+
+typedef struct {
+    char magic[4];          /* "Y2T" */
+    uint32_t version;
+    uint32_t dtype;         /* YOLO2_TENSOR_F32 or YOLO2_TENSOR_I16 */
+    int32_t q;              /* I16: value = raw * 2^-q; F32: 0 */
+    int32_t layer;          /* network layer index, -1 if none */
+    int32_t type;           /* YOLO2_GOLDEN_* layer type, -1 if none */
+    uint32_t c, h, w;       /* CHW shape; flat dumps use c = count, h = w = 1 */
+    uint32_t reserved0;
+    uint64_t data_offset;   /* YOLO2_TENSOR_HEADER_SIZE */
+    uint64_t data_bytes;
+    uint64_t reserved1;
+} yolo2_tensor_header_t;
+
+/* A file mapped by yolo2_tensor_map(); data points into the mapping. */
+typedef struct {
+    const yolo2_tensor_header_t *hdr;
+    const void *data;
+    size_t count;
+    void *map;
+    size_t map_size;
+} yolo2_tensor_file_t;
+
+/**
+ * Write one tensor. data points at a CHW tensor of F32 or I16 elements whose
+ * rows are row_stride elements apart (the DDR layout pads rows to 8); only
+ * the first w of each row are written.
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int yolo2_tensor_write(const char *path, int layer, int type, int dtype, int q,
+                       const void *data, int c, int h, int w, int row_stride);
+
+/**
+ * Dump a flat float array: a .y2t tensor, or one "%.9g" value per line when
+ * path ends in ".txt" (the format older comparison scripts read).
+ *
+ * Returns 0 on success, -1 on error.
+ */
+int yolo2_tensor_dump_floats(const char *path, const float *data, size_t count);
+
+/**
+ * Returns non-zero when YOLO2_TAP_DIR is set and selects layer, so callers
+ * can skip unpacking a tensor that is not written.
+ */
+int yolo2_tensor_tap_enabled(int layer);
+
+/**
+ * Write a layer output to YOLO2_TAP_DIR/layer_NN.y2t if the layer is
+ * selected (see yolo2_tensor_write() for the arguments).
+ *
+ * Returns 0 when written or not selected, -1 on error.
+ */
+int yolo2_tensor_tap(int layer, int type, int dtype, int q,
+                     const void *data, int c, int h, int w, int row_stride);
+
+/**
+ * Map a .y2t file read-only and validate its header.
+ *
+ * Returns 0 on success, -1 on error (message on stderr).
+ */
+int yolo2_tensor_map(const char *path, yolo2_tensor_file_t *f);
+
+void yolo2_tensor_unmap(yolo2_tensor_file_t *f);
+
+/**
+ * Element i of a mapped tensor as a real value (I16 is scaled by 2^-q).
+ */
+double yolo2_tensor_value(const yolo2_tensor_file_t *f, size_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* YOLO2_TENSOR_H */
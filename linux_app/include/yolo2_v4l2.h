@@ -2,6 +2,17 @@
  * YOLOv2 Linux App - Minimal V4L2 camera capture helpers
  *
  * Supports MJPEG (decoded via stb_image) and YUYV (software convert) capture.
+ *
+ * Capture buffers come from one of (YOLO2_V4L2_MEMORY=mmap|userptr|dmabuf):
+ *   mmap:    the driver's own buffers (default)
+ *   userptr: one udmabuf region (dma_buffer_manager.h) split into the
+ *            buffers, so frames land in tracked DMA memory; the region is
+ *            mapped uncached, so CPU reads of the frame are slow
+ *   dmabuf:  buffers allocated from a DMA heap (YOLO2_V4L2_DMA_HEAP, default
+ *            /dev/dma_heap/linux,cma) and imported by fd; mapped cached,
+ *            with DMA_BUF_IOCTL_SYNC around each dequeue/enqueue
+ * userptr and dmabuf fall back to mmap when the driver or the memory source
+ * does not support them.
  */
 
 #ifndef YOLO2_V4L2_H
@@ -10,6 +21,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "dma_buffer_manager.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -19,10 +32,17 @@ typedef enum {
     YOLO2_V4L2_FMT_YUYV = 1,
 } yolo2_v4l2_format_t;
 
+typedef enum {
+    YOLO2_V4L2_MEM_MMAP = 0,
+    YOLO2_V4L2_MEM_USERPTR = 1,
+    YOLO2_V4L2_MEM_DMABUF = 2,
+} yolo2_v4l2_memory_t;
+
 typedef struct {
     void *start;
     size_t length;
-} yolo2_v4l2_mmap_buf_t;
+    int dmabuf_fd;                  // DMABUF mode, else -1
+} yolo2_v4l2_buf_t;
 
 typedef struct {
     int fd;
@@ -30,8 +50,12 @@ typedef struct {
     int height;
     int fps;
     uint32_t pixfmt;                // actual V4L2 pixfmt (e.g., V4L2_PIX_FMT_MJPEG)
-    yolo2_v4l2_mmap_buf_t *buffers; // mmap'd V4L2 buffers
+    size_t stride;                  // bytes per row (YUYV)
+    size_t sizeimage;               // bytes per frame buffer
+    yolo2_v4l2_memory_t memory;     // how the buffers below were provided
+    yolo2_v4l2_buf_t *buffers;      // CPU mappings of the V4L2 buffers
     unsigned int num_buffers;
+    memory_buffer_t region;         // USERPTR: the udmabuf region holding all buffers
 } yolo2_v4l2_camera_t;
 
 typedef struct {
@@ -41,6 +65,7 @@ typedef struct {
 } yolo2_v4l2_frame_t;
 
 const char *yolo2_v4l2_pixfmt_name(uint32_t pixfmt);
+const char *yolo2_v4l2_memory_name(yolo2_v4l2_memory_t memory);
 
 int yolo2_v4l2_open(
     yolo2_v4l2_camera_t *cam,
@@ -469,6 +469,21 @@ uint64_t memory_get_phys_addr(void *virt_addr)
     return (uint64_t)(uintptr_t)virt_addr;
 }
 
+/**
+ * Check that a range lies in one tracked buffer
+ */
+int memory_is_dma(const void *addr, size_t size)
+{
+    const char *p = (const char *)addr;
+    for (int i = 0; i < mem_ctx.count; i++) {
+        const char *start = (const char *)mem_ctx.buffers[i].ptr;
+        if (p >= start && size <= mem_ctx.buffers[i].size && (size_t)(p - start) <= mem_ctx.buffers[i].size - size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 /**
  * Flush cache (no-op for uncached DMA buffers)
  */
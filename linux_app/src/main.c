@@ -32,6 +32,7 @@
 #include "yolo2_accel_linux.h"
 #include "dma_buffer_manager.h"
 #include "yolo2_inference.h"
+#include "yolo2_pipeline.h"
 #include "yolo2_network.h"
 #include "yolo2_image_loader.h"
 #include "yolo2_draw.h"
@@ -42,6 +43,11 @@
 #include "yolo2_labels.h"
 #include "file_loader.h"
 #include "yolo2_log.h"
+#include "yolo2_golden.h"
+#include "yolo2_tensor.h"
+#include "yolo2_autotune.h"
+#include "yolo2_caps.h"
+#include "yolo2_requant.h"
 
 // Default paths
 static char weights_dir[512] = "/home/ubuntu/weights";
@@ -80,6 +86,10 @@ static int stream_mjpeg_port = 0;     // 0 = disabled
 static int stream_mjpeg_quality = 80; // JPEG quality 1..100
 static int stream_mjpeg_fps = 4;      // send rate for MJPEG (keeps VLC alive even when inference is slow)
 
+// Per-layer tiling (yolo2_autotune.h)
+static int autotune = 0;
+static char tune_cache_path[PATH_MAX] = "";  // "" = <weights_dir>/tuning_cache.txt
+
 typedef enum {
     INPUT_MODE_IMAGE = 0,
     INPUT_MODE_CAMERA = 1,
@@ -186,20 +196,6 @@ static int parse_bind_port(const char *s, char *bind_out, size_t bind_out_size,
     return 0;
 }
 
-static void rgb24_to_chw_float(const uint8_t *rgb, float *chw, int width, int height)
-{
-    const size_t plane = (size_t)width * (size_t)height;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const size_t idx = (size_t)y * (size_t)width + (size_t)x;
-            const size_t src = idx * 3u;
-            chw[idx] = (float)rgb[src + 0] / 255.0f;
-            chw[plane + idx] = (float)rgb[src + 1] / 255.0f;
-            chw[2u * plane + idx] = (float)rgb[src + 2] / 255.0f;
-        }
-    }
-}
-
 static void json_write_escaped(FILE *fp, const char *s)
 {
     fputc('"', fp);
@@ -268,6 +264,8 @@ static void print_usage(const char *prog_name) {
     printf("  --stream-mjpeg <p|b:p>    Stream annotated frames as MJPEG over HTTP (e.g. 8080 or 0.0.0.0:8080)\n");
     printf("  --stream-mjpeg-quality <q> JPEG quality 1..100 (default: %d)\n", stream_mjpeg_quality);
     printf("  --stream-mjpeg-fps <fps>  MJPEG send rate (default: %d)\n", stream_mjpeg_fps);
+    printf("  --autotune                Time every legal tiling per layer on the image and save the fastest\n");
+    printf("  --tune-cache <path>       Tuning cache (default: <weights>/tuning_cache.txt)\n");
     printf("  -h            Show this help\n");
     printf("\n");
     printf("Notes:\n");
@@ -282,24 +280,34 @@ static double get_time_ms(void) {
     return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
 }
 
-static int dump_float_array_text(const char *path, const float *data, size_t count)
+// One streaming inference: plain, or through the two-engine pipeline when
+// `pipeline` is set. Returns 1 when ctx holds a new region output, 0 while
+// the pipeline fills, -1 on error.
+static int run_stream_inference(yolo2_inference_context_t *ctx, yolo2_pipeline_t *pipeline,
+                                const yolo2_input_t *input)
 {
-    if (!path || !path[0] || !data) {
-        return -1;
+    if (pipeline) {
+        return yolo2_pipeline_step(pipeline, input);
     }
+    return yolo2_run_inference_input(ctx, input) == 0 ? 1 : -1;
+}
 
-    FILE *fp = fopen(path, "w");
-    if (!fp) {
-        fprintf(stderr, "ERROR: Cannot open dump file %s: %s\n", path, strerror(errno));
-        return -1;
+// Quantize a frame for the next run_stream_inference(..., NULL), so the
+// caller can release it first. Returns 0 on success, -1 on error.
+static int load_stream_input(yolo2_inference_context_t *ctx, yolo2_pipeline_t *pipeline,
+                             const yolo2_input_t *input)
+{
+    if (pipeline) {
+        return yolo2_pipeline_load_input(pipeline, input);
     }
+    return yolo2_inference_load_input(ctx, input);
+}
 
-    for (size_t i = 0; i < count; ++i) {
-        // One value per line for easy diffing.
-        fprintf(fp, "%.9g\n", data[i]);
+static int dump_float_array(const char *path, const float *data, size_t count)
+{
+    if (yolo2_tensor_dump_floats(path, data, count) != 0) {
+        return -1;
     }
-
-    fclose(fp);
     YOLO2_LOG_INFO("  Dumped %zu floats to %s\n", count, path);
     return 0;
 }
@@ -329,6 +337,8 @@ int main(int argc, char *argv[]) {
         OPT_STREAM_MJPEG,
         OPT_STREAM_MJPEG_QUALITY,
         OPT_STREAM_MJPEG_FPS,
+        OPT_AUTOTUNE,
+        OPT_TUNE_CACHE,
     };
 
     static const struct option long_opts[] = {
@@ -348,6 +358,8 @@ int main(int argc, char *argv[]) {
         {"stream-mjpeg", required_argument, NULL, OPT_STREAM_MJPEG},
         {"stream-mjpeg-quality", required_argument, NULL, OPT_STREAM_MJPEG_QUALITY},
         {"stream-mjpeg-fps", required_argument, NULL, OPT_STREAM_MJPEG_FPS},
+        {"autotune", no_argument, NULL, OPT_AUTOTUNE},
+        {"tune-cache", required_argument, NULL, OPT_TUNE_CACHE},
         {NULL, 0, NULL, 0},
     };
     
@@ -466,6 +478,12 @@ int main(int argc, char *argv[]) {
                     return 1;
                 }
                 break;
+            case OPT_AUTOTUNE:
+                autotune = 1;
+                break;
+            case OPT_TUNE_CACHE:
+                strncpy(tune_cache_path, optarg, sizeof(tune_cache_path) - 1);
+                break;
         }
     }
 
@@ -485,6 +503,13 @@ int main(int argc, char *argv[]) {
         fprintf(stderr, "ERROR: -i cannot be used with --camera/--video\n");
         return 1;
     }
+    if (input_mode != INPUT_MODE_IMAGE && autotune) {
+        fprintf(stderr, "ERROR: --autotune needs an image (-i)\n");
+        return 1;
+    }
+    if (!tune_cache_path[0]) {
+        snprintf(tune_cache_path, sizeof(tune_cache_path), "%s/tuning_cache.txt", weights_dir);
+    }
 
     // Apply per-mode defaults (only if user did not override).
     if (max_frames < 0) {
@@ -538,13 +563,15 @@ int main(int argc, char *argv[]) {
     YOLO2_LOG_INFO("\n");
     
     // Build weight file paths
-    char weights_file[512], bias_file[512];
-    char weight_q_file[512], bias_q_file[512], iofm_q_file[512];
+    // PATH_MAX leaves room for any weights_dir plus the file name.
+    char weights_file[PATH_MAX], bias_file[PATH_MAX];
+    char weight_q_file[PATH_MAX], bias_q_file[PATH_MAX], iofm_q_file[PATH_MAX], weight_bits_file[PATH_MAX];
     snprintf(weights_file, sizeof(weights_file), "%s/weights_reorg_int16.bin", weights_dir);
     snprintf(bias_file, sizeof(bias_file), "%s/bias_int16.bin", weights_dir);
     snprintf(weight_q_file, sizeof(weight_q_file), "%s/weight_int16_Q.bin", weights_dir);
     snprintf(bias_q_file, sizeof(bias_q_file), "%s/bias_int16_Q.bin", weights_dir);
     snprintf(iofm_q_file, sizeof(iofm_q_file), "%s/iofm_Q.bin", weights_dir);
+    snprintf(weight_bits_file, sizeof(weight_bits_file), "%s/weight_bits.bin", weights_dir);
     
     yolo2_inference_context_t ctx;
     void *weights_data = NULL, *bias_data = NULL;
@@ -554,9 +581,18 @@ int main(int argc, char *argv[]) {
     int num_labels = 0;
     FILE *json_fp = NULL;
     yolo2_mjpeg_streamer_t *mjpeg_stream = NULL;
+    yolo2_pipeline_t pipeline;
+    yolo2_pipeline_t *stream_pipeline = NULL;
+    yolo2_accel_t ofm_peers[YOLO2_MAX_ACCELS - 1];
+    int num_ofm_peers = 0;
+    yolo2_cpu_offload_t cpu_offload;
+    yolo2_tuning_t tuning;
     
     // Initialize inference context
     yolo2_inference_init(&ctx);
+    memset(&pipeline, 0, sizeof(pipeline));
+    memset(&cpu_offload, 0, sizeof(cpu_offload));
+    memset(&tuning, 0, sizeof(tuning));
     
     // Step 1: Initialize accelerator driver
     YOLO2_LOG_INFO("[1/8] Initializing accelerator driver...\n");
@@ -566,6 +602,76 @@ int main(int argc, char *argv[]) {
         goto cleanup;
     }
     YOLO2_LOG_INFO("      Accelerator driver initialized OK\n\n");
+    if (yolo2_accel_default()->tm != Tm || yolo2_accel_default()->tn != Tn) {
+        // The weight stream layout depends on Tm/Tn (weight_load_reorg)
+        fprintf(stderr, "ERROR: The bitstream has Tm=%d Tn=%d; the weights are reorganized for Tm=%d Tn=%d "
+                "(regenerate them and rebuild with the bitstream's tiling)\n",
+                yolo2_accel_default()->tm, yolo2_accel_default()->tn, Tm, Tn);
+        result = 1;
+        goto cleanup;
+    }
+
+    // YOLO2_ACCEL_INSTANCES=N splits every conv layer's output channels over
+    // instances 0..N-1 (yolo2_ofm_split.h), all built with the compiled tiling.
+    {
+        const char *instances_env = getenv("YOLO2_ACCEL_INSTANCES");
+        const int instances = (instances_env && instances_env[0]) ? atoi(instances_env) : 1;
+        if (instances < 1 || instances > YOLO2_MAX_ACCELS) {
+            fprintf(stderr, "ERROR: YOLO2_ACCEL_INSTANCES must be 1..%d\n", YOLO2_MAX_ACCELS);
+            result = 1;
+            goto cleanup;
+        }
+        const char *two_engine_env = getenv("YOLO2_TWO_ENGINE");
+        if (instances > 1 && two_engine_env && two_engine_env[0] && strcmp(two_engine_env, "0") != 0) {
+            fprintf(stderr, "ERROR: YOLO2_ACCEL_INSTANCES and YOLO2_TWO_ENGINE both use instance 1\n");
+            result = 1;
+            goto cleanup;
+        }
+        for (int k = 1; k < instances; ++k) {
+            result = yolo2_accel_open_instance(&ofm_peers[num_ofm_peers], k, Tm, Tn, Tr, Tc);
+            if (result != YOLO2_SUCCESS) {
+                fprintf(stderr, "ERROR: Failed to open accelerator instance %d\n", k);
+                goto cleanup;
+            }
+            // Every slice reads the weight stream reorganized for the default instance
+            if (ofm_peers[num_ofm_peers].tm != yolo2_accel_default()->tm ||
+                ofm_peers[num_ofm_peers].tn != yolo2_accel_default()->tn) {
+                fprintf(stderr, "ERROR: Accelerator instance %d has Tm=%d Tn=%d; instance 0 has Tm=%d Tn=%d\n", k,
+                        ofm_peers[num_ofm_peers].tm, ofm_peers[num_ofm_peers].tn,
+                        yolo2_accel_default()->tm, yolo2_accel_default()->tn);
+                yolo2_accel_close(&ofm_peers[num_ofm_peers]);
+                result = 1;
+                goto cleanup;
+            }
+            ctx.ofm_peers[num_ofm_peers] = &ofm_peers[num_ofm_peers];
+            num_ofm_peers++;
+        }
+        ctx.num_ofm_peers = num_ofm_peers;
+        if (num_ofm_peers > 0) {
+            YOLO2_LOG_INFO("      Conv output channels split over %d instances\n\n", instances);
+        }
+    }
+
+    // YOLO2_CPU_OFFLOAD=<fraction>|auto computes the last output channels of
+    // every conv layer on the CPU while the accelerator runs the rest.
+    {
+        const char *offload_env = getenv("YOLO2_CPU_OFFLOAD");
+        const int offload = yolo2_cpu_offload_init(&cpu_offload, offload_env);
+        if (offload < 0) {
+            result = 1;
+            goto cleanup;
+        }
+        if (offload > 0 && num_ofm_peers > 0) {
+            fprintf(stderr, "ERROR: YOLO2_CPU_OFFLOAD cannot be combined with YOLO2_ACCEL_INSTANCES\n");
+            result = 1;
+            goto cleanup;
+        }
+        if (offload > 0) {
+            ctx.cpu_offload = &cpu_offload;
+            YOLO2_LOG_INFO("      CPU offload: %s of conv output channels on %d threads\n\n",
+                           offload_env, yolo2_cpu_conv_threads(1));
+        }
+    }
     
     // Step 2: Initialize DMA buffer manager
     YOLO2_LOG_INFO("[2/8] Initializing DMA buffer manager...\n");
@@ -612,6 +718,57 @@ int main(int argc, char *argv[]) {
         ctx.current_Qa = ctx.act_q[0];
         YOLO2_LOG_INFO("      Q values loaded OK\n");
     }
+    
+    // Optional per-layer weight precision (all layers 16-bit when absent)
+    if (access(weight_bits_file, R_OK) == 0) {
+        result = load_q_values(weight_bits_file, &ctx.weight_bits, &ctx.weight_bits_size);
+        if (result != 0) {
+            fprintf(stderr, "ERROR: Failed to load %s\n", weight_bits_file);
+            goto cleanup;
+        }
+        int w8_layers = 0, w4_layers = 0, requant_layers = 0;
+        for (size_t k = 0; k < ctx.weight_bits_size; k++) {
+            const int bits = yolo2_wbits_precision(ctx.weight_bits[k]);
+            if ((bits != 4 && bits != 8 && bits != 16) ||
+                (ctx.weight_bits[k] & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT))) {
+                fprintf(stderr, "ERROR: %s: invalid entry %d for conv %zu (expected 4, 8 or 16, "
+                        "optionally | 0x%x)\n", weight_bits_file, ctx.weight_bits[k], k, YOLO2_WBITS_REQUANT);
+                result = -1;
+                goto cleanup;
+            }
+            if (bits == 8) w8_layers++;
+            if (bits == 4) w4_layers++;
+            if (yolo2_wbits_requant(ctx.weight_bits[k])) requant_layers++;
+        }
+        if (requant_layers > 0 && !(yolo2_accel_default()->features & YOLO2_CAP_REQUANT)) {
+            fprintf(stderr, "ERROR: %s: %d conv layers use per-channel requantization, which this "
+                    "accelerator does not support\n", weight_bits_file, requant_layers);
+            result = -1;
+            goto cleanup;
+        }
+        YOLO2_LOG_INFO("      Weight precision: %d 8-bit and %d 4-bit of %zu conv layers, %d requantized per channel\n",
+                       w8_layers, w4_layers, ctx.weight_bits_size, requant_layers);
+    }
+    if (yolo2_golden_env_enabled()) {
+        ctx.golden_model_key = yolo2_golden_model_key(weights_dir, 1);
+        YOLO2_LOG_INFO("      Golden model key: %016llx\n", (unsigned long long)ctx.golden_model_key);
+    }
+
+    // Tuned tile sizes of this bitstream and model, if any
+    {
+        tuning.bitstream_id = yolo2_tuning_bitstream_id(yolo2_accel_default());
+        tuning.model_key = ctx.golden_model_key ? ctx.golden_model_key : yolo2_golden_model_key(weights_dir, 1);
+        const int tuned = yolo2_tuning_load(tune_cache_path, &tuning);
+        if (tuned < 0) {
+            result = 1;
+            goto cleanup;
+        }
+        if (tuned > 0) {
+            ctx.tuning = &tuning;
+        }
+        YOLO2_LOG_INFO("      Tuning cache: %s (%d tuned layers, bitstream %016llx)\n", tune_cache_path, tuned,
+                       (unsigned long long)tuning.bitstream_id);
+    }
     YOLO2_LOG_INFO("\n");
     
     // Step 5: Allocate DMA buffers
@@ -766,6 +923,28 @@ int main(int argc, char *argv[]) {
     // Step 8: Run inference
     YOLO2_LOG_INFO("\n[8/8] Running inference...\n");
 
+    if (input_mode == INPUT_MODE_IMAGE && autotune) {
+        const char *repeats_env = getenv("YOLO2_AUTOTUNE_REPEATS");
+        int repeats = 5;
+        if (repeats_env && repeats_env[0] && (parse_int(repeats_env, &repeats) != 0 || repeats < 1)) {
+            fprintf(stderr, "ERROR: Invalid YOLO2_AUTOTUNE_REPEATS: %s\n", repeats_env);
+            result = 1;
+            goto cleanup;
+        }
+        result = yolo2_autotune(&ctx, input_image, repeats, &tuning);
+        if (result == 0) {
+            result = yolo2_tuning_save(tune_cache_path, &tuning);
+        }
+        if (result != 0) {
+            fprintf(stderr, "ERROR: Autotune failed\n");
+            goto cleanup;
+        }
+        YOLO2_LOG_INFO("Saved tuning to %s\n", tune_cache_path);
+        // The run below uses the tuned tiles (and checks them against
+        // YOLO2_GOLDEN_DIR when set)
+        ctx.tuning = &tuning;
+    }
+
     if (input_mode == INPUT_MODE_IMAGE) {
         start_time = get_time_ms();
         result = yolo2_run_inference(&ctx, input_image);
@@ -811,9 +990,9 @@ int main(int argc, char *argv[]) {
 
             // - `YOLO2_DUMP_REGION_RAW`: raw dequantized conv30 output (pre-sigmoid/softmax)
             const char *dump_raw = getenv("YOLO2_DUMP_REGION_RAW");
-            const char *dump_raw_path = (dump_raw && dump_raw[0]) ? dump_raw : "yolov2_region_raw_hw.txt";
+            const char *dump_raw_path = (dump_raw && dump_raw[0]) ? dump_raw : "yolov2_region_raw_hw.y2t";
             if (do_dump) {
-                dump_float_array_text(dump_raw_path, ctx.region_output, ctx.region_output_size);
+                dump_float_array(dump_raw_path, ctx.region_output, ctx.region_output_size);
             }
 
             // Allocate output buffer
@@ -833,9 +1012,9 @@ int main(int argc, char *argv[]) {
 
             // - `YOLO2_DUMP_REGION`: region output after sigmoid/softmax (what post-processing consumes)
             const char *dump_processed = getenv("YOLO2_DUMP_REGION");
-            const char *dump_processed_path = (dump_processed && dump_processed[0]) ? dump_processed : "yolov2_region_proc_hw.txt";
+            const char *dump_processed_path = (dump_processed && dump_processed[0]) ? dump_processed : "yolov2_region_proc_hw.y2t";
             if (do_dump) {
-                dump_float_array_text(dump_processed_path, region_output_processed, ctx.region_output_size);
+                dump_float_array(dump_processed_path, region_output_processed, ctx.region_output_size);
             }
 
             // Get detections
@@ -881,7 +1060,6 @@ int main(int argc, char *argv[]) {
         int frame_w = 0;
         int frame_h = 0;
         uint8_t *rgb_frame = NULL;
-        float *frame_chw = NULL;
 
         int frame_idx = 0;
         int infer_idx = 0;
@@ -900,6 +1078,16 @@ int main(int argc, char *argv[]) {
             mjpeg_started = 1;
         }
 
+        // Two-engine layer pipeline (yolo2_pipeline.h); detections lag one frame.
+        const char *two_engine = getenv("YOLO2_TWO_ENGINE");
+        if (two_engine && two_engine[0] && strcmp(two_engine, "0") != 0) {
+            if (yolo2_pipeline_init(&pipeline, &ctx, weights_dir) != 0) {
+                result = 1;
+                goto cleanup;
+            }
+            stream_pipeline = &pipeline;
+        }
+
         if (input_mode == INPUT_MODE_CAMERA) {
             yolo2_v4l2_camera_t cam;
             if (yolo2_v4l2_open(&cam, camera_device, cam_width, cam_height, cam_fps, cam_format) != 0) {
@@ -916,11 +1104,9 @@ int main(int argc, char *argv[]) {
             frame_h = cam.height;
             const size_t rgb_size = (size_t)frame_w * (size_t)frame_h * 3u;
             rgb_frame = (uint8_t *)malloc(rgb_size);
-            frame_chw = (float *)malloc((size_t)frame_w * (size_t)frame_h * 3u * sizeof(float));
-            if (!rgb_frame || !frame_chw) {
+            if (!rgb_frame) {
                 fprintf(stderr, "ERROR: Failed to allocate frame buffers\n");
                 free(rgb_frame);
-                free(frame_chw);
                 yolo2_v4l2_stop(&cam);
                 yolo2_v4l2_close(&cam);
                 goto cleanup;
@@ -933,12 +1119,16 @@ int main(int argc, char *argv[]) {
             if (!dets) {
                 fprintf(stderr, "ERROR: Failed to allocate detections array\n");
                 free(rgb_frame);
-                free(frame_chw);
                 yolo2_v4l2_stop(&cam);
                 yolo2_v4l2_close(&cam);
                 goto cleanup;
             }
 
+            // YUYV frames feed the network straight from the capture buffer,
+            // which stays dequeued until the input is consumed; RGB24 is only
+            // needed for annotated output.
+            const int want_rgb = (save_annotated_dir[0] != '\0') || mjpeg_started;
+
             while (max_frames == 0 || infer_idx < max_frames) {
 
                 yolo2_v4l2_frame_t frame;
@@ -953,20 +1143,29 @@ int main(int argc, char *argv[]) {
 
                 const int do_infer = (infer_every <= 1) || ((frame_idx % infer_every) == 0);
                 int decode_rc = 0;
+                int hold_frame = 0;
+                yolo2_input_t frame_in = {rgb_frame, frame_w, frame_h, 0, YOLO2_INPUT_RGB24, 0};
                 if (do_infer) {
                     if (cam.pixfmt == V4L2_PIX_FMT_MJPEG) {
                         decode_rc = yolo2_decode_mjpeg_to_rgb24(frame.data, frame.size, rgb_frame, frame_w, frame_h);
                     } else if (cam.pixfmt == V4L2_PIX_FMT_YUYV) {
-                        yolo2_yuyv_to_rgb24(frame.data, rgb_frame, frame_w, frame_h);
-                        decode_rc = 0;
+                        if (want_rgb) {
+                            yolo2_yuyv_to_rgb24(frame.data, rgb_frame, frame_w, frame_h);
+                        }
+                        frame_in.data = frame.data;
+                        frame_in.stride = cam.stride;
+                        frame_in.format = YOLO2_INPUT_YUYV;
+                        hold_frame = 1;
                     } else {
                         fprintf(stderr, "ERROR: Unsupported camera pixfmt 0x%08x\n", cam.pixfmt);
                         decode_rc = -1;
                     }
                 }
 
-                // Always re-queue ASAP.
-                (void)yolo2_v4l2_enqueue(&cam, &frame);
+                // Re-queue ASAP; a YUYV buffer once it is quantized below.
+                if (!hold_frame) {
+                    (void)yolo2_v4l2_enqueue(&cam, &frame);
+                }
 
                 frame_idx++;
                 if (!do_infer || decode_rc != 0) {
@@ -975,21 +1174,25 @@ int main(int argc, char *argv[]) {
 
                 infer_idx++;
 
-                // Preprocess: RGB24 -> float CHW -> letterbox 416x416.
-                rgb24_to_chw_float(rgb_frame, frame_chw, frame_w, frame_h);
-                if (yolo2_letterbox_image(frame_chw, frame_w, frame_h, 3, input_image, INPUT_WIDTH, INPUT_HEIGHT) != 0) {
-                    fprintf(stderr, "ERROR: Letterbox preprocess failed\n");
-                    continue;
-                }
-
+                // Letterboxed and quantized straight from the frame (yolo2_input.h).
                 start_time = get_time_ms();
-                result = yolo2_run_inference(&ctx, input_image);
+                int ready;
+                if (hold_frame) {
+                    const int load_rc = load_stream_input(&ctx, stream_pipeline, &frame_in);
+                    (void)yolo2_v4l2_enqueue(&cam, &frame);
+                    ready = load_rc == 0 ? run_stream_inference(&ctx, stream_pipeline, NULL) : -1;
+                } else {
+                    ready = run_stream_inference(&ctx, stream_pipeline, &frame_in);
+                }
                 end_time = get_time_ms();
-                if (result != 0) {
+                if (ready < 0) {
                     fprintf(stderr, "ERROR: Inference failed\n");
                     stream_ok = 0;
                     break;
                 }
+                if (!ready) {
+                    continue;
+                }
 
                 YOLO2_LOG_INFO("Frame %d (infer %d) inference time: %.2f ms\n", frame_idx, infer_idx, end_time - start_time);
 
@@ -1109,12 +1312,10 @@ int main(int argc, char *argv[]) {
             frame_h = vid.height;
             const size_t rgb_size = (size_t)frame_w * (size_t)frame_h * 3u;
             rgb_frame = (uint8_t *)malloc(rgb_size);
-            frame_chw = (float *)malloc((size_t)frame_w * (size_t)frame_h * 3u * sizeof(float));
-            if (!rgb_frame || !frame_chw) {
+            if (!rgb_frame) {
                 fprintf(stderr, "ERROR: Failed to allocate frame buffers\n");
                 (void)yolo2_ffmpeg_video_close(&vid);
                 free(rgb_frame);
-                free(frame_chw);
                 goto cleanup;
             }
 
@@ -1126,7 +1327,6 @@ int main(int argc, char *argv[]) {
                 fprintf(stderr, "ERROR: Failed to allocate detections array\n");
                 (void)yolo2_ffmpeg_video_close(&vid);
                 free(rgb_frame);
-                free(frame_chw);
                 goto cleanup;
             }
 
@@ -1148,20 +1348,19 @@ int main(int argc, char *argv[]) {
 
                 infer_idx++;
 
-                rgb24_to_chw_float(rgb_frame, frame_chw, frame_w, frame_h);
-                if (yolo2_letterbox_image(frame_chw, frame_w, frame_h, 3, input_image, INPUT_WIDTH, INPUT_HEIGHT) != 0) {
-                    fprintf(stderr, "ERROR: Letterbox preprocess failed\n");
-                    continue;
-                }
+                const yolo2_input_t frame_in = {rgb_frame, frame_w, frame_h, 0, YOLO2_INPUT_RGB24, 0};
 
                 start_time = get_time_ms();
-                result = yolo2_run_inference(&ctx, input_image);
+                const int ready = run_stream_inference(&ctx, stream_pipeline, &frame_in);
                 end_time = get_time_ms();
-                if (result != 0) {
+                if (ready < 0) {
                     fprintf(stderr, "ERROR: Inference failed\n");
                     stream_ok = 0;
                     break;
                 }
+                if (!ready) {
+                    continue;
+                }
 
                 YOLO2_LOG_INFO("Frame %d (infer %d) inference time: %.2f ms\n", frame_idx, infer_idx, end_time - start_time);
 
@@ -1271,7 +1470,6 @@ int main(int argc, char *argv[]) {
         }
 
         free(rgb_frame);
-        free(frame_chw);
 
         if (!stream_ok) {
             result = 1;
@@ -1297,6 +1495,9 @@ cleanup:
     if (mjpeg_stream) yolo2_mjpeg_streamer_stop(mjpeg_stream);
     if (ctx.net) yolo2_free_network(ctx.net);
     
+    if (stream_pipeline) yolo2_pipeline_cleanup(stream_pipeline);
+    for (int k = 0; k < num_ofm_peers; ++k) yolo2_accel_close(&ofm_peers[k]);
+    yolo2_cpu_offload_cleanup(&cpu_offload);
     yolo2_inference_cleanup(&ctx);
     dma_buffer_cleanup();
     yolo2_accel_cleanup();
@@ -6,6 +6,8 @@
  */
 
 #include "yolo2_accel_linux.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_caps.h"
 #include "yolo2_config.h"
 #include "yolo2_log.h"
 
@@ -18,15 +20,17 @@
 #include <time.h>
 #include <errno.h>
 
-// Memory-mapped register pointers
-static volatile uint32_t *ctrl_regs = NULL;
-static volatile uint32_t *gpio_qw = NULL;
-static volatile uint32_t *gpio_qa_in = NULL;
-static volatile uint32_t *gpio_qa_out = NULL;
-static volatile uint32_t *gpio_qb = NULL;
+// Split-K depth assumed for IP without a capability block (make SPLIT_K=2)
+#ifndef SPLIT_K
+#define SPLIT_K 1
+#endif
 
-// File descriptor for /dev/mem
+// File descriptor for /dev/mem, shared by all open instances
 static int mem_fd = -1;
+static int mem_users = 0;
+
+// Instance behind the single-engine API (yolo2_accel_init)
+static yolo2_accel_t default_accel;
 
 // Initialization flag
 static int initialized = 0;
@@ -61,125 +65,284 @@ static void unmap_region(volatile void *addr, size_t size)
     }
 }
 
+static int wait_for_idle(yolo2_accel_t *accel, uint32_t timeout_ms);
+
 /**
- * Initialize accelerator driver
+ * Run the capability query (LayerType YOLO2_LAYER_CAPS) and read the block.
+ * All other parameters are zero, so an IP without the block walks no output
+ * rows and returns at once; its CAPS range reads back as zeros.
  */
-int yolo2_accel_init(void)
+static int query_caps(yolo2_accel_t *accel, yolo2_caps_t *caps)
 {
-    if (initialized) {
-        return YOLO2_SUCCESS;
+    uint32_t words[YOLO2_CAPS_WORDS];
+    uint32_t status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
+    if (!(status & CTRL_AP_IDLE)) {
+        return -1;
     }
-    
-    YOLO2_LOG_INFO("Initializing YOLOv2 accelerator driver...\n");
-    
+    for (uint32_t off = CTRL_INPUT_OFFSET; off <= CTRL_WEIGHT_BITS_OFFSET; off += 4) {
+        accel->ctrl_regs[off / 4] = 0;
+    }
+    accel->ctrl_regs[CTRL_LAYER_TYPE_OFFSET / 4] = YOLO2_LAYER_CAPS;
+    accel->ctrl_regs[CTRL_WEIGHT_BITS_OFFSET / 4] = 16;
+    __sync_synchronize();
+    accel->ctrl_regs[CTRL_AP_CTRL / 4] = CTRL_AP_START;
+    __sync_synchronize();
+    if (wait_for_idle(accel, 100) != YOLO2_SUCCESS) {
+        return -1;
+    }
+    for (int k = 0; k < YOLO2_CAPS_WORDS; ++k) {
+        words[k] = accel->ctrl_regs[CTRL_CAPS_OFFSET / 4 + k];
+    }
+    return yolo2_caps_decode(words, caps);
+}
+
+// The build options of this binary must match the IP
+static int check_caps(const yolo2_accel_t *accel)
+{
+#ifdef ACT_BLOCKED_LAYOUT
+    const int blocked = 1;
+#else
+    const int blocked = 0;
+#endif
+    if (!(accel->features & YOLO2_CAP_INT16)) {
+        fprintf(stderr, "ERROR: Accelerator 0x%lx is an FP32 build; this application runs INT16 only\n",
+                (unsigned long)accel->ctrl_base);
+        return -1;
+    }
+    if (((accel->features & YOLO2_CAP_ACT_BLOCKED) != 0) != blocked) {
+        fprintf(stderr, "ERROR: Accelerator 0x%lx uses the %s activation layout; rebuild with make LAYOUT=%s\n",
+                (unsigned long)accel->ctrl_base, blocked ? "CHW" : "blocked", blocked ? "chw" : "blocked");
+        return -1;
+    }
+    if (blocked && accel->tn != YOLO2_ACT_BLOCK) {
+        fprintf(stderr, "ERROR: Accelerator 0x%lx has Tn=%d; the blocked layout needs Tn=%d\n",
+                (unsigned long)accel->ctrl_base, accel->tn, YOLO2_ACT_BLOCK);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Open one accelerator instance
+ */
+int yolo2_accel_open(yolo2_accel_t *accel, uint64_t ctrl_base, const uint64_t gpio_base[4],
+                     int tm, int tn, int tr, int tc)
+{
+    memset(accel, 0, sizeof(*accel));
+
     // Open /dev/mem
-    mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
     if (mem_fd < 0) {
-        fprintf(stderr, "ERROR: Cannot open /dev/mem: %s\n", strerror(errno));
-        fprintf(stderr, "       Run with sudo or ensure proper permissions\n");
-        return YOLO2_MMAP_ERROR;
+        mem_fd = open("/dev/mem", O_RDWR | O_SYNC);
+        if (mem_fd < 0) {
+            fprintf(stderr, "ERROR: Cannot open /dev/mem: %s\n", strerror(errno));
+            fprintf(stderr, "       Run with sudo or ensure proper permissions\n");
+            return YOLO2_MMAP_ERROR;
+        }
     }
+    mem_users++;
     
     // Map accelerator control registers
-    ctrl_regs = (volatile uint32_t*)map_physical(YOLO2_CTRL_BASE, YOLO2_CTRL_SIZE);
-    if (!ctrl_regs) {
+    accel->ctrl_base = ctrl_base;
+    accel->ctrl_regs = (volatile uint32_t*)map_physical((off_t)ctrl_base, YOLO2_CTRL_SIZE);
+    if (!accel->ctrl_regs) {
         fprintf(stderr, "ERROR: Failed to map control registers at 0x%lx\n", 
-                (unsigned long)YOLO2_CTRL_BASE);
-        close(mem_fd);
-        mem_fd = -1;
+                (unsigned long)ctrl_base);
+        yolo2_accel_close(accel);
         return YOLO2_MMAP_ERROR;
     }
     
     // Map Q value GPIOs
-    gpio_qw = (volatile uint32_t*)map_physical(AXI_GPIO_QW_BASE, AXI_GPIO_SIZE);
-    gpio_qa_in = (volatile uint32_t*)map_physical(AXI_GPIO_QA_IN_BASE, AXI_GPIO_SIZE);
-    gpio_qa_out = (volatile uint32_t*)map_physical(AXI_GPIO_QA_OUT_BASE, AXI_GPIO_SIZE);
-    gpio_qb = (volatile uint32_t*)map_physical(AXI_GPIO_QB_BASE, AXI_GPIO_SIZE);
+    accel->gpio_qw = (volatile uint32_t*)map_physical((off_t)gpio_base[0], AXI_GPIO_SIZE);
+    accel->gpio_qa_in = (volatile uint32_t*)map_physical((off_t)gpio_base[1], AXI_GPIO_SIZE);
+    accel->gpio_qa_out = (volatile uint32_t*)map_physical((off_t)gpio_base[2], AXI_GPIO_SIZE);
+    accel->gpio_qb = (volatile uint32_t*)map_physical((off_t)gpio_base[3], AXI_GPIO_SIZE);
     
-    if (!gpio_qw || !gpio_qa_in || !gpio_qa_out || !gpio_qb) {
+    if (!accel->gpio_qw || !accel->gpio_qa_in || !accel->gpio_qa_out || !accel->gpio_qb) {
         fprintf(stderr, "ERROR: Failed to map GPIO registers\n");
-        yolo2_accel_cleanup();
+        yolo2_accel_close(accel);
         return YOLO2_MMAP_ERROR;
     }
     
     // Initialize Q values to 0
-    gpio_qw[GPIO_DATA_OFFSET / 4] = 0;
-    gpio_qa_in[GPIO_DATA_OFFSET / 4] = 0;
-    gpio_qa_out[GPIO_DATA_OFFSET / 4] = 0;
-    gpio_qb[GPIO_DATA_OFFSET / 4] = 0;
-    
+    accel->gpio_qw[GPIO_DATA_OFFSET / 4] = 0;
+    accel->gpio_qa_in[GPIO_DATA_OFFSET / 4] = 0;
+    accel->gpio_qa_out[GPIO_DATA_OFFSET / 4] = 0;
+    accel->gpio_qb[GPIO_DATA_OFFSET / 4] = 0;
+
     // Check accelerator status
-    uint32_t status = ctrl_regs[CTRL_AP_CTRL / 4];
-    YOLO2_LOG_INFO("  Accelerator status: 0x%02x", status);
+    uint32_t status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
+    YOLO2_LOG_INFO("  Accelerator 0x%lx status: 0x%02x", (unsigned long)ctrl_base, status);
     if (status & CTRL_AP_IDLE) YOLO2_LOG_INFO(" [IDLE]");
     if (status & CTRL_AP_DONE) YOLO2_LOG_INFO(" [DONE]");
     if (status & CTRL_AP_READY) YOLO2_LOG_INFO(" [READY]");
     YOLO2_LOG_INFO("\n");
-    
-    initialized = 1;
-    YOLO2_LOG_INFO("  Accelerator driver initialized successfully\n");
-    
+
+    yolo2_caps_t caps;
+    if (query_caps(accel, &caps) == 0) {
+        accel->tm = caps.tm;
+        accel->tn = caps.tn;
+        accel->tr = caps.tr;
+        accel->tc = caps.tc;
+        accel->ib_height = caps.ib_height;
+        accel->ib_width = caps.ib_width;
+        accel->split_k = caps.split_k;
+        accel->features = caps.features;
+        accel->max_beta_length = caps.max_beta_length;
+        accel->has_caps = 1;
+        YOLO2_LOG_INFO("  Accelerator 0x%lx caps v%d.%d: Tm=%d Tn=%d Tr=%d Tc=%d IB=%dx%d SPLIT_K=%d "
+                       "features=0x%x MAX_BETA_LENGTH=%d\n",
+                       (unsigned long)ctrl_base, caps.version_major, caps.version_minor,
+                       caps.tm, caps.tn, caps.tr, caps.tc, caps.ib_height, caps.ib_width,
+                       caps.split_k, caps.features, caps.max_beta_length);
+        if (caps.tm != tm || caps.tn != tn || caps.tr != tr || caps.tc != tc) {
+            YOLO2_LOG_INFO("  Accelerator 0x%lx: using its tiling instead of Tm=%d Tn=%d Tr=%d Tc=%d\n",
+                           (unsigned long)ctrl_base, tm, tn, tr, tc);
+        }
+    } else {
+        accel->tm = tm;
+        accel->tn = tn;
+        accel->tr = tr;
+        accel->tc = tc;
+        accel->ib_height = (tr - 1) * 2 + 3;
+        accel->ib_width = (tc - 1) * 2 + 3;
+        accel->split_k = SPLIT_K;
+        accel->features = YOLO2_CAP_CONV | YOLO2_CAP_MAXPOOL | YOLO2_CAP_INT16 |
+                          YOLO2_CAP_WEIGHTS_8BIT | YOLO2_CAP_WEIGHTS_4BIT;
+#ifdef ACT_BLOCKED_LAYOUT
+        accel->features |= YOLO2_CAP_ACT_BLOCKED;
+#else
+        accel->features |= YOLO2_CAP_REORG;
+#endif
+        YOLO2_LOG_INFO("  Accelerator 0x%lx has no capability block; assuming Tm=%d Tn=%d Tr=%d Tc=%d SPLIT_K=%d\n",
+                       (unsigned long)ctrl_base, tm, tn, tr, tc, accel->split_k);
+    }
+    if (check_caps(accel) != 0) {
+        yolo2_accel_close(accel);
+        return YOLO2_ERROR;
+    }
+
     return YOLO2_SUCCESS;
 }
 
 /**
- * Cleanup accelerator driver
+ * Open instance `index` at its yolo2_config.h addresses (YOLO2_ACCEL_STRIDE apart)
  */
-void yolo2_accel_cleanup(void)
+int yolo2_accel_open_instance(yolo2_accel_t *accel, int index, int tm, int tn, int tr, int tc)
 {
-    if (ctrl_regs) {
-        unmap_region(ctrl_regs, YOLO2_CTRL_SIZE);
-        ctrl_regs = NULL;
+    if (index < 0 || index >= YOLO2_MAX_ACCELS) {
+        fprintf(stderr, "ERROR: Accelerator instance %d out of range (max %d)\n", index, YOLO2_MAX_ACCELS);
+        return YOLO2_ERROR;
     }
-    if (gpio_qw) {
-        unmap_region(gpio_qw, AXI_GPIO_SIZE);
-        gpio_qw = NULL;
+    const uint64_t offset = (uint64_t)index * YOLO2_ACCEL_STRIDE;
+    const uint64_t gpio_base[4] = {
+        AXI_GPIO_QW_BASE + offset,
+        AXI_GPIO_QA_IN_BASE + offset,
+        AXI_GPIO_QA_OUT_BASE + offset,
+        AXI_GPIO_QB_BASE + offset
+    };
+    return yolo2_accel_open(accel, YOLO2_CTRL_BASE + offset, gpio_base, tm, tn, tr, tc);
+}
+
+/**
+ * Close one accelerator instance
+ */
+void yolo2_accel_close(yolo2_accel_t *accel)
+{
+    if (accel->ctrl_regs) {
+        unmap_region(accel->ctrl_regs, YOLO2_CTRL_SIZE);
+    }
+    if (accel->gpio_qw) {
+        unmap_region(accel->gpio_qw, AXI_GPIO_SIZE);
+    }
+    if (accel->gpio_qa_in) {
+        unmap_region(accel->gpio_qa_in, AXI_GPIO_SIZE);
     }
-    if (gpio_qa_in) {
-        unmap_region(gpio_qa_in, AXI_GPIO_SIZE);
-        gpio_qa_in = NULL;
+    if (accel->gpio_qa_out) {
+        unmap_region(accel->gpio_qa_out, AXI_GPIO_SIZE);
     }
-    if (gpio_qa_out) {
-        unmap_region(gpio_qa_out, AXI_GPIO_SIZE);
-        gpio_qa_out = NULL;
+    if (accel->gpio_qb) {
+        unmap_region(accel->gpio_qb, AXI_GPIO_SIZE);
     }
-    if (gpio_qb) {
-        unmap_region(gpio_qb, AXI_GPIO_SIZE);
-        gpio_qb = NULL;
+    if (accel->ctrl_base || accel->ctrl_regs) {
+        if (mem_users > 0 && --mem_users == 0 && mem_fd >= 0) {
+            close(mem_fd);
+            mem_fd = -1;
+        }
+    }
+    memset(accel, 0, sizeof(*accel));
+}
+
+/**
+ * Initialize accelerator driver
+ */
+int yolo2_accel_init(void)
+{
+    if (initialized) {
+        return YOLO2_SUCCESS;
     }
     
-    if (mem_fd >= 0) {
-        close(mem_fd);
-        mem_fd = -1;
+    YOLO2_LOG_INFO("Initializing YOLOv2 accelerator driver...\n");
+
+    const uint64_t gpio_base[4] = {AXI_GPIO_QW_BASE, AXI_GPIO_QA_IN_BASE, AXI_GPIO_QA_OUT_BASE, AXI_GPIO_QB_BASE};
+    int result = yolo2_accel_open(&default_accel, YOLO2_CTRL_BASE, gpio_base, Tm, Tn, Tr, Tc);
+    if (result != YOLO2_SUCCESS) {
+        return result;
     }
     
+    initialized = 1;
+    YOLO2_LOG_INFO("  Accelerator driver initialized successfully\n");
+    
+    return YOLO2_SUCCESS;
+}
+
+/**
+ * Cleanup accelerator driver
+ */
+void yolo2_accel_cleanup(void)
+{
+    if (initialized) {
+        yolo2_accel_close(&default_accel);
+    }
     initialized = 0;
 }
 
+/**
+ * Instance behind the single-engine API
+ */
+yolo2_accel_t *yolo2_accel_default(void)
+{
+    return initialized ? &default_accel : NULL;
+}
+
 /**
  * Set Q values via AXI GPIO
  */
-void yolo2_set_q_values(int32_t qw, int32_t qa_in, int32_t qa_out, int32_t qb)
+void yolo2_accel_set_q_values(yolo2_accel_t *accel, int32_t qw, int32_t qa_in, int32_t qa_out, int32_t qb)
 {
-    if (!initialized) return;
+    if (!accel || !accel->ctrl_regs) return;
     
     YOLO2_LOG_DEBUG("    [DEBUG] Setting Q values via GPIO: Qw=%d, Qa_in=%d, Qa_out=%d, Qb=%d\n",
                     qw, qa_in, qa_out, qb);
     
-    gpio_qw[GPIO_DATA_OFFSET / 4] = (uint32_t)qw;
-    gpio_qa_in[GPIO_DATA_OFFSET / 4] = (uint32_t)qa_in;
-    gpio_qa_out[GPIO_DATA_OFFSET / 4] = (uint32_t)qa_out;
-    gpio_qb[GPIO_DATA_OFFSET / 4] = (uint32_t)qb;
+    accel->gpio_qw[GPIO_DATA_OFFSET / 4] = (uint32_t)qw;
+    accel->gpio_qa_in[GPIO_DATA_OFFSET / 4] = (uint32_t)qa_in;
+    accel->gpio_qa_out[GPIO_DATA_OFFSET / 4] = (uint32_t)qa_out;
+    accel->gpio_qb[GPIO_DATA_OFFSET / 4] = (uint32_t)qb;
     __sync_synchronize();
 }
 
+void yolo2_set_q_values(int32_t qw, int32_t qa_in, int32_t qa_out, int32_t qb)
+{
+    yolo2_accel_set_q_values(yolo2_accel_default(), qw, qa_in, qa_out, qb);
+}
+
 /**
  * Check if accelerator is busy
  */
 int yolo2_is_busy(void)
 {
-    if (!initialized || !ctrl_regs) return 0;
-    uint32_t status = ctrl_regs[CTRL_AP_CTRL / 4];
+    if (!initialized) return 0;
+    uint32_t status = default_accel.ctrl_regs[CTRL_AP_CTRL / 4];
     return !(status & CTRL_AP_DONE);
 }
 
@@ -188,8 +351,8 @@ int yolo2_is_busy(void)
  */
 int yolo2_is_done(void)
 {
-    if (!initialized || !ctrl_regs) return 1;
-    uint32_t status = ctrl_regs[CTRL_AP_CTRL / 4];
+    if (!initialized) return 1;
+    uint32_t status = default_accel.ctrl_regs[CTRL_AP_CTRL / 4];
     return (status & CTRL_AP_DONE) != 0;
 }
 
@@ -208,7 +371,7 @@ static uint64_t get_time_ms(void)
  */
 int yolo2_wait_for_completion(uint32_t timeout_ms)
 {
-    if (!initialized || !ctrl_regs) return YOLO2_INIT_ERROR;
+    if (!initialized) return YOLO2_INIT_ERROR;
     
     uint64_t start_time = get_time_ms();
     
@@ -231,8 +394,8 @@ int yolo2_wait_for_completion(uint32_t timeout_ms)
  */
 uint32_t yolo2_get_status(void)
 {
-    if (!initialized || !ctrl_regs) return 0;
-    return ctrl_regs[CTRL_AP_CTRL / 4];
+    if (!initialized) return 0;
+    return default_accel.ctrl_regs[CTRL_AP_CTRL / 4];
 }
 
 /**
@@ -240,8 +403,8 @@ uint32_t yolo2_get_status(void)
  */
 uint32_t yolo2_read_reg(uint32_t offset)
 {
-    if (!initialized || !ctrl_regs) return 0;
-    return ctrl_regs[offset / 4];
+    if (!initialized) return 0;
+    return default_accel.ctrl_regs[offset / 4];
 }
 
 /**
@@ -249,8 +412,8 @@ uint32_t yolo2_read_reg(uint32_t offset)
  */
 void yolo2_write_reg(uint32_t offset, uint32_t value)
 {
-    if (!initialized || !ctrl_regs) return;
-    ctrl_regs[offset / 4] = value;
+    if (!initialized) return;
+    default_accel.ctrl_regs[offset / 4] = value;
 }
 
 /**
@@ -263,7 +426,7 @@ void yolo2_write_reg(uint32_t offset, uint32_t value)
  * 
  * Strategy: Wait for IDLE after we've started (IDLE goes low during operation)
  */
-static int wait_for_idle(uint32_t timeout_ms)
+static int wait_for_idle(yolo2_accel_t *accel, uint32_t timeout_ms)
 {
     uint64_t start_time = get_time_ms();
     uint32_t status;
@@ -274,11 +437,11 @@ static int wait_for_idle(uint32_t timeout_ms)
     // First, wait for accelerator to leave IDLE (start running)
     // Give it a few ms to start
     for (int i = 0; i < 100; i++) {
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
         // Read DONE bit to clear it (clear-on-read)
         if (status & CTRL_AP_DONE) {
             // DONE is set - read it to clear, then check if IDLE
-            status = ctrl_regs[CTRL_AP_CTRL / 4]; // Re-read after clearing DONE
+            status = accel->ctrl_regs[CTRL_AP_CTRL / 4]; // Re-read after clearing DONE
         }
         if (!(status & CTRL_AP_IDLE)) {
             was_running = 1;
@@ -289,11 +452,11 @@ static int wait_for_idle(uint32_t timeout_ms)
     
     // If it never left IDLE, check if DONE is set (completed instantly)
     if (!was_running) {
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
         if ((status & CTRL_AP_DONE) || (status & CTRL_AP_READY)) {
             // Completed before we could see it running
             // Clear DONE by reading it
-            status = ctrl_regs[CTRL_AP_CTRL / 4];
+            status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
             YOLO2_LOG_DEBUG("    [DEBUG] Accelerator completed instantly (status=0x%02x)\n", status);
             return YOLO2_SUCCESS;
         }
@@ -302,12 +465,12 @@ static int wait_for_idle(uint32_t timeout_ms)
     // Now wait for IDLE to return (operation complete)
     // Also check for DONE bit (clear-on-read)
     while (1) {
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
         
         // Check for DONE bit (clear-on-read, so reading it clears it)
         if (status & CTRL_AP_DONE) {
             // Re-read to clear DONE, then check IDLE
-            status = ctrl_regs[CTRL_AP_CTRL / 4];
+            status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
             if (status & CTRL_AP_IDLE) {
                 return YOLO2_SUCCESS;
             }
@@ -366,10 +529,10 @@ static int wait_for_idle(uint32_t timeout_ms)
             if (status & CTRL_AP_START) {
                 fprintf(stderr, "       Attempting to clear START bit...\n");
                 // Write 0 to clear START (though this may not work if hardware is stuck)
-                ctrl_regs[CTRL_AP_CTRL / 4] = 0;
+                accel->ctrl_regs[CTRL_AP_CTRL / 4] = 0;
                 __sync_synchronize();
                 usleep(1000);
-                status = ctrl_regs[CTRL_AP_CTRL / 4];
+                status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
                 fprintf(stderr, "       Status after clear attempt: 0x%02x\n", status);
             }
             
@@ -381,6 +544,7 @@ static int wait_for_idle(uint32_t timeout_ms)
 }
 
 static int validate_conv_params(
+    const yolo2_accel_t *accel,
     int ifm_num,
     int ofm_num,
     int ksize,
@@ -406,17 +570,18 @@ static int validate_conv_params(
     if (output_w <= 0 || output_w > 1024) return 0;
     if (output_h <= 0 || output_h > 1024) return 0;
     if (padding < 0 || padding > 4) return 0;
-    if (tm <= 0 || tm > Tm) return 0;
-    if (tn < 0 || tn > Tn) return 0;
-    if (tr <= 0 || tr > Tr) return 0;
-    if (tc <= 0 || tc > Tc) return 0;
+    if (tm <= 0 || tm > accel->tm) return 0;
+    if (tn < 0 || tn > accel->tn) return 0;
+    if (tr <= 0 || tr > accel->tr) return 0;
+    if (tc <= 0 || tc > accel->tc) return 0;
     return 1;
 }
 
 /**
- * Execute convolutional layer
+ * Program and start a convolutional layer (returns without waiting)
  */
-int yolo2_execute_conv_layer(
+int yolo2_accel_conv_start(
+    yolo2_accel_t *accel,
     uint64_t input_addr,
     uint64_t output_addr,
     uint64_t weight_addr,
@@ -444,15 +609,15 @@ int yolo2_execute_conv_layer(
     int qa_in,
     int qa_out,
     int qb,
-    uint32_t timeout_ms
+    int weight_bits
 )
 {
-    if (!initialized || !ctrl_regs) {
+    if (!accel || !accel->ctrl_regs) {
         fprintf(stderr, "ERROR: Accelerator not initialized\n");
         return YOLO2_INIT_ERROR;
     }
 
-    if (!validate_conv_params(ifm_num, ofm_num, ksize, kstride,
+    if (!validate_conv_params(accel, ifm_num, ofm_num, ksize, kstride,
                               input_w, input_h, output_w, output_h, padding,
                               tm, tn, tr, tc)) {
         fprintf(stderr,
@@ -461,38 +626,38 @@ int yolo2_execute_conv_layer(
                 "TM=%d TN=%d TR=%d TC=%d (max TM=%d TN=%d TR=%d TC=%d)\n",
                 ifm_num, ofm_num, ksize, kstride,
                 input_w, input_h, output_w, output_h, padding,
-                tm, tn, tr, tc, Tm, Tn, Tr, Tc);
+                tm, tn, tr, tc, accel->tm, accel->tn, accel->tr, accel->tc);
         return YOLO2_ERROR;
     }
     
     // Set Q values first (INT16 mode)
     if (qw != 0 || qa_in != 0 || qa_out != 0 || qb != 0) {
-        yolo2_set_q_values(qw, qa_in, qa_out, qb);
+        yolo2_accel_set_q_values(accel, qw, qa_in, qa_out, qb);
     }
     
     // Wait for accelerator to be idle before starting
     // Also clear any previous DONE/READY bits (clear-on-read)
-    uint32_t status = ctrl_regs[CTRL_AP_CTRL / 4];
+    uint32_t status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
     if (status & CTRL_AP_DONE) {
         // Clear DONE by reading it again
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
     }
     if (status & CTRL_AP_READY) {
         // Clear READY by reading it again
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
     }
     
     if (!(status & CTRL_AP_IDLE)) {
         YOLO2_LOG_DEBUG("    [DEBUG] Waiting for IDLE before start (current status=0x%02x)...\n", status);
-        if (wait_for_idle(1000) != YOLO2_SUCCESS) {
+        if (wait_for_idle(accel, 1000) != YOLO2_SUCCESS) {
             fprintf(stderr, "ERROR: Accelerator not ready for new layer (status=0x%02x)\n", 
-                    ctrl_regs[CTRL_AP_CTRL / 4]);
+                    accel->ctrl_regs[CTRL_AP_CTRL / 4]);
             return YOLO2_TIMEOUT;
         }
         // Clear any DONE/READY bits after waiting
-        status = ctrl_regs[CTRL_AP_CTRL / 4];
+        status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
         if (status & (CTRL_AP_DONE | CTRL_AP_READY)) {
-            status = ctrl_regs[CTRL_AP_CTRL / 4]; // Clear by reading
+            status = accel->ctrl_regs[CTRL_AP_CTRL / 4]; // Clear by reading
         }
     }
     
@@ -506,41 +671,42 @@ int yolo2_execute_conv_layer(
     }
     
     // Write 64-bit addresses (split into low/high 32-bit)
-    ctrl_regs[CTRL_INPUT_OFFSET / 4] = (uint32_t)(input_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1] = (uint32_t)(input_addr >> 32);
-    ctrl_regs[CTRL_OUTPUT_OFFSET / 4] = (uint32_t)(output_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_OUTPUT_OFFSET / 4 + 1] = (uint32_t)(output_addr >> 32);
-    ctrl_regs[CTRL_WEIGHT_OFFSET / 4] = (uint32_t)(weight_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_WEIGHT_OFFSET / 4 + 1] = (uint32_t)(weight_addr >> 32);
-    ctrl_regs[CTRL_BETA_OFFSET / 4] = (uint32_t)(beta_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_BETA_OFFSET / 4 + 1] = (uint32_t)(beta_addr >> 32);
+    accel->ctrl_regs[CTRL_INPUT_OFFSET / 4] = (uint32_t)(input_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1] = (uint32_t)(input_addr >> 32);
+    accel->ctrl_regs[CTRL_OUTPUT_OFFSET / 4] = (uint32_t)(output_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_OUTPUT_OFFSET / 4 + 1] = (uint32_t)(output_addr >> 32);
+    accel->ctrl_regs[CTRL_WEIGHT_OFFSET / 4] = (uint32_t)(weight_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_WEIGHT_OFFSET / 4 + 1] = (uint32_t)(weight_addr >> 32);
+    accel->ctrl_regs[CTRL_BETA_OFFSET / 4] = (uint32_t)(beta_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_BETA_OFFSET / 4 + 1] = (uint32_t)(beta_addr >> 32);
     
     // Verify by reading back
     __sync_synchronize();
-    uint32_t input_lo = ctrl_regs[CTRL_INPUT_OFFSET / 4];
-    uint32_t input_hi = ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1];
+    uint32_t input_lo = accel->ctrl_regs[CTRL_INPUT_OFFSET / 4];
+    uint32_t input_hi = accel->ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1];
     YOLO2_LOG_DEBUG("      Read back Input: 0x%08x%08x\n", input_hi, input_lo);
     
     // Write layer parameters
-    ctrl_regs[CTRL_IFM_NUM_OFFSET / 4] = (uint32_t)ifm_num;
-    ctrl_regs[CTRL_OFM_NUM_OFFSET / 4] = (uint32_t)ofm_num;
-    ctrl_regs[CTRL_KSIZE_OFFSET / 4] = (uint32_t)ksize;
-    ctrl_regs[CTRL_KSTRIDE_OFFSET / 4] = (uint32_t)kstride;
-    ctrl_regs[CTRL_INPUT_W_OFFSET / 4] = (uint32_t)input_w;
-    ctrl_regs[CTRL_INPUT_H_OFFSET / 4] = (uint32_t)input_h;
-    ctrl_regs[CTRL_OUTPUT_W_OFFSET / 4] = (uint32_t)output_w;
-    ctrl_regs[CTRL_OUTPUT_H_OFFSET / 4] = (uint32_t)output_h;
-    ctrl_regs[CTRL_PADDING_OFFSET / 4] = (uint32_t)padding;
-    ctrl_regs[CTRL_ISNL_OFFSET / 4] = (uint32_t)is_nl;
-    ctrl_regs[CTRL_ISBN_OFFSET / 4] = (uint32_t)is_bn;
-    ctrl_regs[CTRL_TM_OFFSET / 4] = (uint32_t)tm;
-    ctrl_regs[CTRL_TN_OFFSET / 4] = (uint32_t)tn;
-    ctrl_regs[CTRL_TR_OFFSET / 4] = (uint32_t)tr;
-    ctrl_regs[CTRL_TC_OFFSET / 4] = (uint32_t)tc;
-    ctrl_regs[CTRL_OFM_NUM_BOUND_OFFSET / 4] = (uint32_t)ofm_num_bound;
-    ctrl_regs[CTRL_MLOOPSXTM_OFFSET / 4] = (uint32_t)mloopsxTM;
-    ctrl_regs[CTRL_MLOOPS_A1XTM_OFFSET / 4] = (uint32_t)mloops_a1xTM;
-    ctrl_regs[CTRL_LAYER_TYPE_OFFSET / 4] = (uint32_t)layer_type;
+    accel->ctrl_regs[CTRL_IFM_NUM_OFFSET / 4] = (uint32_t)ifm_num;
+    accel->ctrl_regs[CTRL_OFM_NUM_OFFSET / 4] = (uint32_t)ofm_num;
+    accel->ctrl_regs[CTRL_KSIZE_OFFSET / 4] = (uint32_t)ksize;
+    accel->ctrl_regs[CTRL_KSTRIDE_OFFSET / 4] = (uint32_t)kstride;
+    accel->ctrl_regs[CTRL_INPUT_W_OFFSET / 4] = (uint32_t)input_w;
+    accel->ctrl_regs[CTRL_INPUT_H_OFFSET / 4] = (uint32_t)input_h;
+    accel->ctrl_regs[CTRL_OUTPUT_W_OFFSET / 4] = (uint32_t)output_w;
+    accel->ctrl_regs[CTRL_OUTPUT_H_OFFSET / 4] = (uint32_t)output_h;
+    accel->ctrl_regs[CTRL_PADDING_OFFSET / 4] = (uint32_t)padding;
+    accel->ctrl_regs[CTRL_ISNL_OFFSET / 4] = (uint32_t)is_nl;
+    accel->ctrl_regs[CTRL_ISBN_OFFSET / 4] = (uint32_t)is_bn;
+    accel->ctrl_regs[CTRL_TM_OFFSET / 4] = (uint32_t)tm;
+    accel->ctrl_regs[CTRL_TN_OFFSET / 4] = (uint32_t)tn;
+    accel->ctrl_regs[CTRL_TR_OFFSET / 4] = (uint32_t)tr;
+    accel->ctrl_regs[CTRL_TC_OFFSET / 4] = (uint32_t)tc;
+    accel->ctrl_regs[CTRL_OFM_NUM_BOUND_OFFSET / 4] = (uint32_t)ofm_num_bound;
+    accel->ctrl_regs[CTRL_MLOOPSXTM_OFFSET / 4] = (uint32_t)mloopsxTM;
+    accel->ctrl_regs[CTRL_MLOOPS_A1XTM_OFFSET / 4] = (uint32_t)mloops_a1xTM;
+    accel->ctrl_regs[CTRL_LAYER_TYPE_OFFSET / 4] = (uint32_t)layer_type;
+    accel->ctrl_regs[CTRL_WEIGHT_BITS_OFFSET / 4] = (uint32_t)weight_bits;
     
     // NOTE: Q values are set via AXI GPIO (yolo2_set_q_values), NOT control registers
     // The HLS IP does not have Q registers in CTRL_BUS
@@ -555,7 +721,7 @@ int yolo2_execute_conv_layer(
     // for proper DMA coherency on ARM64 systems
     
     // Start accelerator
-    ctrl_regs[CTRL_AP_CTRL / 4] = CTRL_AP_START;
+    accel->ctrl_regs[CTRL_AP_CTRL / 4] = CTRL_AP_START;
     
     // Memory barrier after start (ensures START write is visible to accelerator)
     __sync_synchronize();
@@ -564,20 +730,116 @@ int yolo2_execute_conv_layer(
     usleep(10);
     
     // Verify accelerator actually started (status should show START bit)
-    status = ctrl_regs[CTRL_AP_CTRL / 4];
+    status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
     if (!(status & CTRL_AP_START)) {
         fprintf(stderr, "ERROR: Accelerator did not start (status=0x%02x)\n", status);
         return YOLO2_ERROR;
     }
     
-    // Wait for completion using IDLE-based detection
-    return wait_for_idle(timeout_ms);
+    return YOLO2_SUCCESS;
+}
+
+/**
+ * Wait for a started layer to finish
+ */
+int yolo2_accel_wait(yolo2_accel_t *accel, uint32_t timeout_ms)
+{
+    if (!accel || !accel->ctrl_regs) {
+        fprintf(stderr, "ERROR: Accelerator not initialized\n");
+        return YOLO2_INIT_ERROR;
+    }
+    // IDLE-based detection
+    return wait_for_idle(accel, timeout_ms);
+}
+
+int yolo2_accel_conv(
+    yolo2_accel_t *accel,
+    uint64_t input_addr,
+    uint64_t output_addr,
+    uint64_t weight_addr,
+    uint64_t beta_addr,
+    int ifm_num,
+    int ofm_num,
+    int ksize,
+    int kstride,
+    int input_w,
+    int input_h,
+    int output_w,
+    int output_h,
+    int padding,
+    int is_nl,
+    int is_bn,
+    int tm,
+    int tn,
+    int tr,
+    int tc,
+    int ofm_num_bound,
+    int mloopsxTM,
+    int mloops_a1xTM,
+    int layer_type,
+    int qw,
+    int qa_in,
+    int qa_out,
+    int qb,
+    int weight_bits,
+    uint32_t timeout_ms
+)
+{
+    int result = yolo2_accel_conv_start(accel, input_addr, output_addr, weight_addr, beta_addr,
+                                        ifm_num, ofm_num, ksize, kstride,
+                                        input_w, input_h, output_w, output_h, padding,
+                                        is_nl, is_bn, tm, tn, tr, tc,
+                                        ofm_num_bound, mloopsxTM, mloops_a1xTM, layer_type,
+                                        qw, qa_in, qa_out, qb, weight_bits);
+    if (result != YOLO2_SUCCESS) {
+        return result;
+    }
+    return yolo2_accel_wait(accel, timeout_ms);
+}
+
+int yolo2_execute_conv_layer(
+    uint64_t input_addr,
+    uint64_t output_addr,
+    uint64_t weight_addr,
+    uint64_t beta_addr,
+    int ifm_num,
+    int ofm_num,
+    int ksize,
+    int kstride,
+    int input_w,
+    int input_h,
+    int output_w,
+    int output_h,
+    int padding,
+    int is_nl,
+    int is_bn,
+    int tm,
+    int tn,
+    int tr,
+    int tc,
+    int ofm_num_bound,
+    int mloopsxTM,
+    int mloops_a1xTM,
+    int layer_type,
+    int qw,
+    int qa_in,
+    int qa_out,
+    int qb,
+    int weight_bits,
+    uint32_t timeout_ms
+)
+{
+    return yolo2_accel_conv(yolo2_accel_default(), input_addr, output_addr, weight_addr, beta_addr,
+                            ifm_num, ofm_num, ksize, kstride, input_w, input_h, output_w, output_h, padding,
+                            is_nl, is_bn, tm, tn, tr, tc, ofm_num_bound, mloopsxTM, mloops_a1xTM, layer_type,
+                            qw, qa_in, qa_out, qb, weight_bits, timeout_ms);
 }
 
 /**
  * Execute maxpool layer
  */
-int yolo2_execute_maxpool_layer(
+int yolo2_accel_maxpool(
+    yolo2_accel_t *accel,
     uint64_t input_addr,
     uint64_t output_addr,
     int channels,
@@ -597,59 +859,84 @@ int yolo2_execute_maxpool_layer(
     uint32_t timeout_ms
 )
 {
-    if (!initialized || !ctrl_regs) {
+    if (!accel || !accel->ctrl_regs) {
         fprintf(stderr, "ERROR: Accelerator not initialized\n");
         return YOLO2_INIT_ERROR;
     }
     
     // Wait for accelerator to be idle before starting
-    uint32_t status = ctrl_regs[CTRL_AP_CTRL / 4];
+    uint32_t status = accel->ctrl_regs[CTRL_AP_CTRL / 4];
     if (!(status & CTRL_AP_IDLE)) {
-        if (wait_for_idle(1000) != YOLO2_SUCCESS) {
+        if (wait_for_idle(accel, 1000) != YOLO2_SUCCESS) {
             return YOLO2_TIMEOUT;
         }
     }
     
     // Write addresses
-    ctrl_regs[CTRL_INPUT_OFFSET / 4] = (uint32_t)(input_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1] = (uint32_t)(input_addr >> 32);
-    ctrl_regs[CTRL_OUTPUT_OFFSET / 4] = (uint32_t)(output_addr & 0xFFFFFFFF);
-    ctrl_regs[CTRL_OUTPUT_OFFSET / 4 + 1] = (uint32_t)(output_addr >> 32);
-    ctrl_regs[CTRL_WEIGHT_OFFSET / 4] = 0;  // Not used for maxpool
-    ctrl_regs[CTRL_WEIGHT_OFFSET / 4 + 1] = 0;
-    ctrl_regs[CTRL_BETA_OFFSET / 4] = 0;    // Not used for maxpool
-    ctrl_regs[CTRL_BETA_OFFSET / 4 + 1] = 0;
+    accel->ctrl_regs[CTRL_INPUT_OFFSET / 4] = (uint32_t)(input_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_INPUT_OFFSET / 4 + 1] = (uint32_t)(input_addr >> 32);
+    accel->ctrl_regs[CTRL_OUTPUT_OFFSET / 4] = (uint32_t)(output_addr & 0xFFFFFFFF);
+    accel->ctrl_regs[CTRL_OUTPUT_OFFSET / 4 + 1] = (uint32_t)(output_addr >> 32);
+    accel->ctrl_regs[CTRL_WEIGHT_OFFSET / 4] = 0;  // Not used for maxpool
+    accel->ctrl_regs[CTRL_WEIGHT_OFFSET / 4 + 1] = 0;
+    accel->ctrl_regs[CTRL_BETA_OFFSET / 4] = 0;    // Not used for maxpool
+    accel->ctrl_regs[CTRL_BETA_OFFSET / 4 + 1] = 0;
     
     // Write layer parameters
-    ctrl_regs[CTRL_IFM_NUM_OFFSET / 4] = (uint32_t)channels;
-    ctrl_regs[CTRL_OFM_NUM_OFFSET / 4] = (uint32_t)channels;
-    ctrl_regs[CTRL_KSIZE_OFFSET / 4] = (uint32_t)ksize;
-    ctrl_regs[CTRL_KSTRIDE_OFFSET / 4] = (uint32_t)kstride;
-    ctrl_regs[CTRL_INPUT_W_OFFSET / 4] = (uint32_t)input_w;
-    ctrl_regs[CTRL_INPUT_H_OFFSET / 4] = (uint32_t)input_h;
-    ctrl_regs[CTRL_OUTPUT_W_OFFSET / 4] = (uint32_t)output_w;
-    ctrl_regs[CTRL_OUTPUT_H_OFFSET / 4] = (uint32_t)output_h;
-    ctrl_regs[CTRL_PADDING_OFFSET / 4] = (uint32_t)padding;
-    ctrl_regs[CTRL_ISNL_OFFSET / 4] = 0;
-    ctrl_regs[CTRL_ISBN_OFFSET / 4] = 0;
-    ctrl_regs[CTRL_TM_OFFSET / 4] = (uint32_t)tm;
-    ctrl_regs[CTRL_TN_OFFSET / 4] = 0;
-    ctrl_regs[CTRL_TR_OFFSET / 4] = (uint32_t)tr;
-    ctrl_regs[CTRL_TC_OFFSET / 4] = (uint32_t)tc;
-    ctrl_regs[CTRL_OFM_NUM_BOUND_OFFSET / 4] = (uint32_t)ofm_num_bound;
-    ctrl_regs[CTRL_MLOOPSXTM_OFFSET / 4] = (uint32_t)mloopsxTM;
-    ctrl_regs[CTRL_MLOOPS_A1XTM_OFFSET / 4] = (uint32_t)mloops_a1xTM;
-    ctrl_regs[CTRL_LAYER_TYPE_OFFSET / 4] = 1;  // MAXPOOL = 1
+    accel->ctrl_regs[CTRL_IFM_NUM_OFFSET / 4] = (uint32_t)channels;
+    accel->ctrl_regs[CTRL_OFM_NUM_OFFSET / 4] = (uint32_t)channels;
+    accel->ctrl_regs[CTRL_KSIZE_OFFSET / 4] = (uint32_t)ksize;
+    accel->ctrl_regs[CTRL_KSTRIDE_OFFSET / 4] = (uint32_t)kstride;
+    accel->ctrl_regs[CTRL_INPUT_W_OFFSET / 4] = (uint32_t)input_w;
+    accel->ctrl_regs[CTRL_INPUT_H_OFFSET / 4] = (uint32_t)input_h;
+    accel->ctrl_regs[CTRL_OUTPUT_W_OFFSET / 4] = (uint32_t)output_w;
+    accel->ctrl_regs[CTRL_OUTPUT_H_OFFSET / 4] = (uint32_t)output_h;
+    accel->ctrl_regs[CTRL_PADDING_OFFSET / 4] = (uint32_t)padding;
+    accel->ctrl_regs[CTRL_ISNL_OFFSET / 4] = 0;
+    accel->ctrl_regs[CTRL_ISBN_OFFSET / 4] = 0;
+    accel->ctrl_regs[CTRL_TM_OFFSET / 4] = (uint32_t)tm;
+    accel->ctrl_regs[CTRL_TN_OFFSET / 4] = 0;
+    accel->ctrl_regs[CTRL_TR_OFFSET / 4] = (uint32_t)tr;
+    accel->ctrl_regs[CTRL_TC_OFFSET / 4] = (uint32_t)tc;
+    accel->ctrl_regs[CTRL_OFM_NUM_BOUND_OFFSET / 4] = (uint32_t)ofm_num_bound;
+    accel->ctrl_regs[CTRL_MLOOPSXTM_OFFSET / 4] = (uint32_t)mloopsxTM;
+    accel->ctrl_regs[CTRL_MLOOPS_A1XTM_OFFSET / 4] = (uint32_t)mloops_a1xTM;
+    accel->ctrl_regs[CTRL_LAYER_TYPE_OFFSET / 4] = 1;  // MAXPOOL = 1
     
     // Memory barrier
     __sync_synchronize();
     
     // Start accelerator
-    ctrl_regs[CTRL_AP_CTRL / 4] = CTRL_AP_START;
+    accel->ctrl_regs[CTRL_AP_CTRL / 4] = CTRL_AP_START;
     
     // Memory barrier after start
     __sync_synchronize();
     
     // Wait for completion using IDLE-based detection
-    return wait_for_idle(timeout_ms);
+    return wait_for_idle(accel, timeout_ms);
+}
+
+int yolo2_execute_maxpool_layer(
+    uint64_t input_addr,
+    uint64_t output_addr,
+    int channels,
+    int ksize,
+    int kstride,
+    int input_w,
+    int input_h,
+    int output_w,
+    int output_h,
+    int padding,
+    int tm,
+    int tr,
+    int tc,
+    int ofm_num_bound,
+    int mloopsxTM,
+    int mloops_a1xTM,
+    uint32_t timeout_ms
+)
+{
+    return yolo2_accel_maxpool(yolo2_accel_default(), input_addr, output_addr, channels, ksize, kstride,
+                               input_w, input_h, output_w, output_h, padding, tm, tr, tc,
+                               ofm_num_bound, mloopsxTM, mloops_a1xTM, timeout_ms);
 }
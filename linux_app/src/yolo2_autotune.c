@@ -0,0 +1,329 @@
+/**
+ * YOLOv2 per-layer tiling autotuner and tuning cache
+ */
+
+#include "yolo2_autotune.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_golden.h"
+#include "yolo2_log.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TUNING_LINE_MAX 256
+#define TUNING_MAX_CANDIDATES 64
+
+uint64_t yolo2_tuning_bitstream_id(const yolo2_accel_t *engine)
+{
+    const char *env = getenv("YOLO2_BITSTREAM");
+    const char *path = (env && env[0]) ? env : YOLO2_BITSTREAM_DEFAULT;
+    int32_t params[7];
+    uint64_t h = 0;
+
+    if (access(path, R_OK) == 0) {
+        h = yolo2_golden_hash_files(&path, 1);
+    } else {
+        YOLO2_LOG_INFO("      Bitstream %s not readable; tuning cache keyed by the tiling only\n", path);
+    }
+
+    params[0] = engine->tm;
+    params[1] = engine->tn;
+    params[2] = engine->tr;
+    params[3] = engine->tc;
+    params[4] = engine->ib_height;
+    params[5] = engine->ib_width;
+#ifdef ACT_BLOCKED_LAYOUT
+    params[6] = 1 | (engine->split_k << 8);
+#else
+    params[6] = 0 | (engine->split_k << 8);
+#endif
+    return yolo2_hash64(h, params, sizeof(params));
+}
+
+// One cache line; returns 1 when parsed, 0 for blank/comment lines, -1 when malformed
+static int parse_tuning_line(const char *line, unsigned long long *bitstream, unsigned long long *model,
+                             int *layer, int *tr, int *tc, unsigned long long *us)
+{
+    while (*line == ' ' || *line == '\t') {
+        line++;
+    }
+    if (*line == '\0' || *line == '\n' || *line == '#') {
+        return 0;
+    }
+    if (sscanf(line, "%llx %llx %d %d %d %llu", bitstream, model, layer, tr, tc, us) != 6) {
+        return -1;
+    }
+    return 1;
+}
+
+int yolo2_tuning_load(const char *path, yolo2_tuning_t *t)
+{
+    char line[TUNING_LINE_MAX];
+    int line_no = 0;
+    int count = 0;
+
+    memset(t->valid, 0, sizeof(t->valid));
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        if (errno == ENOENT) {
+            return 0;
+        }
+        fprintf(stderr, "ERROR: Cannot open tuning cache %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned long long bitstream, model, us;
+        int layer, tr, tc;
+        line_no++;
+        const int rc = parse_tuning_line(line, &bitstream, &model, &layer, &tr, &tc, &us);
+        if (rc < 0) {
+            fprintf(stderr, "ERROR: %s:%d: malformed tuning entry\n", path, line_no);
+            fclose(fp);
+            return -1;
+        }
+        if (rc == 0 || bitstream != t->bitstream_id || model != t->model_key) {
+            continue;
+        }
+        if (layer < 0 || layer >= YOLO2_TUNING_LAYERS || tr < 1 || tc < 1) {
+            fprintf(stderr, "ERROR: %s:%d: invalid tuning entry\n", path, line_no);
+            fclose(fp);
+            return -1;
+        }
+        if (!t->valid[layer]) {
+            count++;
+        }
+        t->valid[layer] = 1;
+        t->tr[layer] = tr;
+        t->tc[layer] = tc;
+        t->us[layer] = us;
+    }
+    fclose(fp);
+    return count;
+}
+
+int yolo2_tuning_save(const char *path, const yolo2_tuning_t *t)
+{
+    char tmp_path[1024];
+    char line[TUNING_LINE_MAX];
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >= (int)sizeof(tmp_path)) {
+        fprintf(stderr, "ERROR: Tuning cache path too long: %s\n", path);
+        return -1;
+    }
+    FILE *out = fopen(tmp_path, "w");
+    if (!out) {
+        fprintf(stderr, "ERROR: Cannot create %s: %s\n", tmp_path, strerror(errno));
+        return -1;
+    }
+
+    // Keep every entry this run does not replace
+    FILE *in = fopen(path, "r");
+    if (in) {
+        while (fgets(line, sizeof(line), in)) {
+            unsigned long long bitstream, model, us;
+            int layer, tr, tc;
+            const int rc = parse_tuning_line(line, &bitstream, &model, &layer, &tr, &tc, &us);
+            if (rc == 1 && bitstream == t->bitstream_id && model == t->model_key &&
+                layer >= 0 && layer < YOLO2_TUNING_LAYERS && t->valid[layer]) {
+                continue;
+            }
+            if (rc >= 0) {
+                fputs(line, out);
+            }
+        }
+        fclose(in);
+    } else {
+        fprintf(out, "# bitstream model layer tr tc us\n");
+    }
+
+    for (int i = 0; i < YOLO2_TUNING_LAYERS; ++i) {
+        if (t->valid[i]) {
+            fprintf(out, "%016" PRIx64 " %016" PRIx64 " %d %d %d %" PRIu64 "\n",
+                    t->bitstream_id, t->model_key, i, t->tr[i], t->tc[i], t->us[i]);
+        }
+    }
+
+    if (fclose(out) != 0 || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "ERROR: Failed to write tuning cache %s: %s\n", path, strerror(errno));
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+void yolo2_tuning_apply(const yolo2_tuning_t *t, int layer, int *tr, int *tc)
+{
+    if (!t || layer < 0 || layer >= YOLO2_TUNING_LAYERS || !t->valid[layer]) {
+        return;
+    }
+    if (t->tr[layer] >= 1 && t->tr[layer] <= *tr && t->tc[layer] >= 1 && t->tc[layer] <= *tc) {
+        *tr = t->tr[layer];
+        *tc = t->tc[layer];
+    }
+}
+
+// Tile sizes worth trying for an output extent: the smallest tile for each
+// tile count from the default's count up (larger tiles at the same count only
+// add padding work)
+static int tile_candidates(int extent, int max_tile, int *out)
+{
+    int n = 0;
+    for (int k = (extent + max_tile - 1) / max_tile; k <= extent && n < TUNING_MAX_CANDIDATES; ++k) {
+        const int v = (extent + k - 1) / k;
+        if (n == 0 || v < out[n - 1]) {
+            out[n++] = v;
+        }
+    }
+    return n;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a;
+    const uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Layers [first, last] with the per-layer log silenced
+static int run_quiet(yolo2_inference_context_t *ctx, float *input_image, int first, int last)
+{
+    const int verbosity = yolo2_get_verbosity();
+    yolo2_set_verbosity(0);
+    const int rc = yolo2_run_inference_layers(ctx, first == 0 ? input_image : NULL, first, last);
+    yolo2_set_verbosity(verbosity);
+    return rc;
+}
+
+int yolo2_autotune(yolo2_inference_context_t *ctx, float *input_image, int repeats, yolo2_tuning_t *t)
+{
+    if (!ctx || !ctx->net || !input_image || !t || repeats < 1) {
+        fprintf(stderr, "ERROR: Invalid autotune arguments\n");
+        return -1;
+    }
+
+    network_t *net = ctx->net;
+    const yolo2_accel_t *engine = ctx->accel ? ctx->accel : yolo2_accel_default();
+    if (!engine) {
+        fprintf(stderr, "ERROR: Accelerator not initialized\n");
+        return -1;
+    }
+    uint64_t *times = (uint64_t *)malloc((size_t)repeats * sizeof(uint64_t));
+    if (!times) {
+        fprintf(stderr, "ERROR: Failed to allocate autotune timings\n");
+        return -1;
+    }
+
+    // The CPU offload tuner would move the split under the measurement
+    yolo2_cpu_offload_t *cpu_offload = ctx->cpu_offload;
+    const struct yolo2_tuning *tuning = ctx->tuning;
+    yolo2_tuning_t trial;
+    memset(&trial, 0, sizeof(trial));
+    ctx->cpu_offload = NULL;
+    ctx->tuning = &trial;
+
+    YOLO2_LOG_INFO("Autotuning %d layers, %d runs per tiling...\n", net->n, repeats);
+
+    int rc = 0;
+    int next = 0;  // first layer of the frame not yet run
+    for (int i = 0; i < net->n && i < YOLO2_TUNING_LAYERS && rc == 0; ++i) {
+        layer_t *l = &net->layers[i];
+        if (l->type != LAYER_CONVOLUTIONAL && l->type != LAYER_MAXPOOL) {
+            continue;
+        }
+        if (i > next && (rc = run_quiet(ctx, input_image, next, i - 1)) != 0) {
+            break;
+        }
+        next = i;
+
+        int def_tr, def_tc;
+        int tr_list[TUNING_MAX_CANDIDATES], tc_list[TUNING_MAX_CANDIDATES];
+        yolo2_layer_tile(engine, l, &def_tr, &def_tc);
+        const int out_c = (l->type == LAYER_CONVOLUTIONAL) ? l->filters : l->c;
+        const int out_h = (l->type == LAYER_CONVOLUTIONAL) ? (l->h - l->size + 2 * l->pad) / l->stride + 1 : l->out_h;
+        const int out_w = (l->type == LAYER_CONVOLUTIONAL) ? (l->w - l->size + 2 * l->pad) / l->stride + 1 : l->out_w;
+        const size_t out_bytes = yolo2_act_words(out_c, out_h, out_w) * sizeof(int16_t);
+        const int n_tr = tile_candidates(out_h, def_tr, tr_list);
+        const int n_tc = tile_candidates(out_w, def_tc, tc_list);
+
+        const yolo2_inference_context_t snapshot = *ctx;
+        uint64_t ref_hash = 0;
+        uint64_t default_us = 0, best_us = 0;
+        int best_tr = def_tr, best_tc = def_tc;
+        int rejected = 0;
+
+        // (def_tr, def_tc) comes first and sets the reference output
+        for (int a = 0; a < n_tr && rc == 0; ++a) {
+            for (int b = 0; b < n_tc && rc == 0; ++b) {
+                trial.valid[i] = 1;
+                trial.tr[i] = tr_list[a];
+                trial.tc[i] = tc_list[b];
+                int r;
+                for (r = 0; r < repeats; ++r) {
+                    *ctx = snapshot;
+                    if ((rc = run_quiet(ctx, input_image, i, i)) != 0) {
+                        break;
+                    }
+                    times[r] = ctx->layer_time_us[i];
+                    if (r == 0) {
+                        const uint64_t h = yolo2_hash64(0, ctx->out_ptr[i], out_bytes);
+                        if (a == 0 && b == 0) {
+                            ref_hash = h;
+                        } else if (h != ref_hash) {
+                            YOLO2_LOG_INFO("  WARNING: layer %d: TR=%d TC=%d output differs from the default tiling; rejected\n",
+                                           i, tr_list[a], tc_list[b]);
+                            rejected++;
+                            break;
+                        }
+                    }
+                }
+                if (rc != 0 || r < repeats) {
+                    continue;
+                }
+                qsort(times, (size_t)repeats, sizeof(uint64_t), cmp_u64);
+                const uint64_t us = times[repeats / 2];
+                if (a == 0 && b == 0) {
+                    default_us = us;
+                    best_us = us;
+                } else if (us < best_us) {
+                    best_us = us;
+                    best_tr = tr_list[a];
+                    best_tc = tc_list[b];
+                }
+            }
+        }
+        if (rc != 0) {
+            fprintf(stderr, "ERROR: Autotune run of layer %d failed\n", i);
+            break;
+        }
+
+        t->valid[i] = 1;
+        t->tr[i] = best_tr;
+        t->tc[i] = best_tc;
+        t->us[i] = best_us;
+        YOLO2_LOG_INFO("  Layer %2d: TR=%-3d TC=%-3d %8" PRIu64 " us (default %dx%d %" PRIu64 " us, %d tilings, %d rejected)\n",
+                       i, best_tr, best_tc, best_us, def_tr, def_tc, default_us, n_tr * n_tc, rejected);
+
+        // Continue the frame from the tuned layer's output
+        *ctx = snapshot;
+        trial.tr[i] = best_tr;
+        trial.tc[i] = best_tc;
+        if ((rc = run_quiet(ctx, input_image, i, i)) != 0) {
+            break;
+        }
+        next = i + 1;
+    }
+    if (rc == 0 && next < net->n) {
+        rc = run_quiet(ctx, input_image, next, net->n - 1);
+    }
+
+    ctx->cpu_offload = cpu_offload;
+    ctx->tuning = tuning;
+    free(times);
+    return rc == 0 ? 0 : -1;
+}
@@ -0,0 +1,541 @@
+/**
+ * YOLOv2 INT16 conv kernel on the CPU
+ */
+
+#include "yolo2_cpu_conv.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "yolo2_act_layout.h"
+#include "yolo2_requant.h"
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define YOLO2_CPU_CONV_NEON 1
+#endif
+
+#define YOLO2_CPU_CONV_MAX_THREADS 16
+
+// Requantization of one partial sum into the accumulator domain
+typedef struct {
+    int64_t round;
+    int shift;      // > 0: rounding right shift, < 0: left shift
+} qshift_t;
+
+static qshift_t make_shift(int shift)
+{
+    qshift_t q;
+    const int mag = (shift > 0 ? shift : -shift) > 30 ? 30 : (shift > 0 ? shift : -shift);
+    q.shift = shift > 0 ? mag : -mag;
+    q.round = (shift > 0 && mag > 0) ? (1LL << (mag - 1)) : 0;
+    return q;
+}
+
+static inline int64_t apply_shift(int64_t v, qshift_t q)
+{
+    if (q.shift > 0) {
+        return (v + q.round) >> q.shift;
+    }
+    if (q.shift < 0) {
+        return v << -q.shift;
+    }
+    return v;
+}
+
+static inline int32_t sat32(int64_t v)
+{
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < INT32_MIN) return INT32_MIN;
+    return (int32_t)v;
+}
+
+static inline int16_t output_value(int32_t acc, int mult, int shift, int is_nl)
+{
+    int64_t v = yolo2_requant((int64_t)acc, mult, YOLO2_CPU_CONV_GUARD_BITS + shift);
+    if (v > 32767) v = 32767;
+    if (v < -32768) v = -32768;
+    int32_t out = (int32_t)v;
+    if (is_nl && out < 0) {
+        out = out / 10;
+    }
+    return (int16_t)out;
+}
+
+// Weight `index` of the layer's reorganized stream (weight_load_reorg()).
+static inline int16_t stream_weight(const int16_t *weights, int weight_bits, size_t index)
+{
+    const int bits = yolo2_wbits_precision(weight_bits);
+    if (bits == 8) {
+        const uint16_t word = (uint16_t)weights[index >> 1];
+        return (index & 0x1) ? (int16_t)(int8_t)(word >> 8) : (int16_t)(int8_t)(word & 0xFF);
+    }
+    if (bits == 4) {
+        const uint16_t word = (uint16_t)weights[16 + (index >> 2)];
+        return weights[(word >> ((index & 0x3) * 4)) & 0xF];
+    }
+    return weights[index];
+}
+
+// Weights of output channel o in compute order: [n block][ky*K+kx][tn].
+static void decode_channel_weights(const yolo2_cpu_conv_t *l, const int16_t *weights, int o, int16_t *dst)
+{
+    const int kk_count = l->ksize * l->ksize;
+    const int mb = o / l->tm;
+    const int o_in = o % l->tm;
+    const int tm_min = (l->ofm - mb * l->tm) < l->tm ? (l->ofm - mb * l->tm) : l->tm;
+    const size_t block_base = (size_t)mb * l->tm * l->ifm * kk_count;
+    for (int n = 0; n < l->ifm; n += l->tn) {
+        const int tn_min = (l->ifm - n) < l->tn ? (l->ifm - n) : l->tn;
+        const size_t chunk = block_base + (size_t)n * tm_min * kk_count;
+        for (int kk = 0; kk < kk_count; ++kk) {
+            for (int t = 0; t < tn_min; ++t) {
+                *dst++ = stream_weight(weights, l->weight_bits, chunk + ((size_t)kk * tm_min + o_in) * tn_min + t);
+            }
+        }
+    }
+}
+
+/*
+ * One kernel tap over one output row: acc[x] = sat32(acc[x] + shift(sum_t
+ * w[t] * src[t][x * stride])). `first` replaces acc by `base` (the bias, or 0
+ * for a split-K partial) as the accumulator's first tap does in compute().
+ */
+static void tap_row(int32_t *acc, const int16_t *const *src, const int16_t *w, int tn_min, int out_w, int aw,
+                    int stride, int first, int64_t base, qshift_t q)
+{
+#ifdef YOLO2_CPU_CONV_NEON
+    if (stride == 1) {
+        const int64x2_t rnd = vdupq_n_s64(q.round);
+        const int64x2_t sh = vdupq_n_s64(-q.shift);
+        const int64x2_t basev = vdupq_n_s64(base);
+        for (int x = 0; x < aw; x += 8) {
+            int64x2_t s0 = vdupq_n_s64(0), s1 = s0, s2 = s0, s3 = s0;
+            for (int t = 0; t < tn_min; ++t) {
+                const int16x8_t xv = vld1q_s16(src[t] + x);
+                const int16x4_t wv = vdup_n_s16(w[t]);
+                const int32x4_t plo = vmull_s16(vget_low_s16(xv), wv);
+                const int32x4_t phi = vmull_s16(vget_high_s16(xv), wv);
+                s0 = vaddw_s32(s0, vget_low_s32(plo));
+                s1 = vaddw_high_s32(s1, plo);
+                s2 = vaddw_s32(s2, vget_low_s32(phi));
+                s3 = vaddw_high_s32(s3, phi);
+            }
+            // vshlq_s64 by a negative count is an arithmetic right shift
+            s0 = vshlq_s64(vaddq_s64(s0, rnd), sh);
+            s1 = vshlq_s64(vaddq_s64(s1, rnd), sh);
+            s2 = vshlq_s64(vaddq_s64(s2, rnd), sh);
+            s3 = vshlq_s64(vaddq_s64(s3, rnd), sh);
+            int64x2_t a0 = basev, a1 = basev, a2 = basev, a3 = basev;
+            if (!first) {
+                const int32x4_t lo = vld1q_s32(acc + x);
+                const int32x4_t hi = vld1q_s32(acc + x + 4);
+                a0 = vmovl_s32(vget_low_s32(lo));
+                a1 = vmovl_high_s32(lo);
+                a2 = vmovl_s32(vget_low_s32(hi));
+                a3 = vmovl_high_s32(hi);
+            }
+            vst1q_s32(acc + x, vcombine_s32(vqmovn_s64(vaddq_s64(a0, s0)), vqmovn_s64(vaddq_s64(a1, s1))));
+            vst1q_s32(acc + x + 4, vcombine_s32(vqmovn_s64(vaddq_s64(a2, s2)), vqmovn_s64(vaddq_s64(a3, s3))));
+        }
+        return;
+    }
+#else
+    (void)aw;
+#endif
+    for (int x = 0; x < out_w; ++x) {
+        int64_t sum = 0;
+        for (int t = 0; t < tn_min; ++t) {
+            sum += (int64_t)((int32_t)w[t] * (int32_t)src[t][x * stride]);
+        }
+        acc[x] = sat32((first ? base : (int64_t)acc[x]) + apply_shift(sum, q));
+    }
+}
+
+typedef struct {
+    const yolo2_cpu_conv_t *l;
+    const int16_t *input;
+    const int16_t *weights;     // decoded, (c1 - c0) x ifm*K*K
+    const int16_t *bias;
+    int16_t *output;
+    int16_t *pad_in;        // zero-padded CHW copy of the input
+    int hp, wp;
+    int c0, c1;
+    int index, threads;
+    int copy_phase;
+    int result;
+} cpu_conv_job_t;
+
+// Copy input channels index, index + threads, ... into the padded buffer.
+static void copy_input(cpu_conv_job_t *job)
+{
+    const yolo2_cpu_conv_t *l = job->l;
+    const int p = l->pad;
+#ifdef ACT_BLOCKED_LAYOUT
+    // One contiguous row per block, deinterleaved per channel
+    const int blocks = (l->ifm + YOLO2_ACT_BLOCK - 1) / YOLO2_ACT_BLOCK;
+    int16_t *row = (int16_t *)malloc((size_t)l->in_w * YOLO2_ACT_BLOCK * sizeof(int16_t));
+    if (!row) {
+        job->result = -1;
+        return;
+    }
+    for (int b = job->index; b < blocks; b += job->threads) {
+        for (int y = 0; y < l->in_h; ++y) {
+            memcpy(row, job->input + yolo2_act_index(b * YOLO2_ACT_BLOCK, y, 0, l->in_h, l->in_w),
+                   (size_t)l->in_w * YOLO2_ACT_BLOCK * sizeof(int16_t));
+            for (int lane = 0; lane < YOLO2_ACT_BLOCK && b * YOLO2_ACT_BLOCK + lane < l->ifm; ++lane) {
+                int16_t *dst = job->pad_in + ((size_t)(b * YOLO2_ACT_BLOCK + lane) * job->hp + y + p) * job->wp + p;
+                for (int x = 0; x < l->in_w; ++x) {
+                    dst[x] = row[x * YOLO2_ACT_BLOCK + lane];
+                }
+            }
+        }
+    }
+    free(row);
+#else
+    for (int c = job->index; c < l->ifm; c += job->threads) {
+        for (int y = 0; y < l->in_h; ++y) {
+            memcpy(job->pad_in + ((size_t)c * job->hp + y + p) * job->wp + p,
+                   job->input + yolo2_act_index(c, y, 0, l->in_h, l->in_w), (size_t)l->in_w * sizeof(int16_t));
+        }
+    }
+#endif
+}
+
+// Output channels c0 + index, c0 + index + threads, ...
+static void conv_channels(cpu_conv_job_t *job)
+{
+    const yolo2_cpu_conv_t *l = job->l;
+    const int kk_count = l->ksize * l->ksize;
+    const int aw = (l->out_w + 7) & ~7;
+    const int band = aw >= 4096 ? 1 : 4096 / aw;   // 16 KB of accumulators per band
+    const int nblocks = (l->ifm + l->tn - 1) / l->tn;
+    const int split = (l->split_k == 2 && nblocks > 1);
+    const qshift_t q_out = make_shift(l->qa_in + l->qw - (l->qa_out + YOLO2_CPU_CONV_GUARD_BITS));
+    const qshift_t q_bias = make_shift(l->qb - (l->qa_out + YOLO2_CPU_CONV_GUARD_BITS));
+    const size_t out_step = yolo2_act_index(0, 0, 1, l->out_h, l->out_w) - yolo2_act_index(0, 0, 0, l->out_h, l->out_w);
+
+    int32_t *acc = (int32_t *)malloc((size_t)2 * band * aw * sizeof(int32_t));
+    int16_t *row = (int16_t *)malloc((size_t)aw * sizeof(int16_t));
+    const int16_t **src = (const int16_t **)malloc((size_t)l->tn * sizeof(*src));
+    if (!acc || !row || !src) {
+        free(acc);
+        free(row);
+        free((void *)src);
+        job->result = -1;
+        return;
+    }
+
+    for (int o = job->c0 + job->index; o < job->c1; o += job->threads) {
+        const int16_t *wbuf = job->weights + (size_t)(o - job->c0) * l->ifm * kk_count;
+        const int16_t *beta = job->bias + (size_t)o * yolo2_beta_words(l->weight_bits);
+        const int64_t bias = apply_shift((int64_t)beta[0], q_bias);
+        const int requant = yolo2_wbits_requant(l->weight_bits);
+        const int mult = requant ? (int)(uint16_t)beta[1] : 1;
+        const int shift = requant ? (int)beta[2] : 0;
+
+        for (int y0 = 0; y0 < l->out_h; y0 += band) {
+            const int rows = (l->out_h - y0) < band ? (l->out_h - y0) : band;
+            for (int nb = 0; nb < nblocks; ++nb) {
+                const int n = nb * l->tn;
+                const int tn_min = (l->ifm - n) < l->tn ? (l->ifm - n) : l->tn;
+                int32_t *a = acc + ((split && (nb & 1)) ? (size_t)band * aw : 0);
+                const int acc_first = (nb == 0) || (split && nb == 1);
+                const int64_t base = (nb == 0) ? bias : 0;
+                for (int kk = 0; kk < kk_count; ++kk) {
+                    const int ky = kk / l->ksize, kx = kk % l->ksize;
+                    const int16_t *w = wbuf + (size_t)n * kk_count + (size_t)kk * tn_min;
+                    for (int r = 0; r < rows; ++r) {
+                        const int iy = (y0 + r) * l->stride + ky;
+                        for (int t = 0; t < tn_min; ++t) {
+                            src[t] = job->pad_in + ((size_t)(n + t) * job->hp + iy) * job->wp + kx;
+                        }
+                        tap_row(a + (size_t)r * aw, src, w, tn_min, l->out_w, aw, l->stride,
+                                acc_first && kk == 0, base, q_out);
+                    }
+                }
+            }
+            for (int r = 0; r < rows; ++r) {
+                int32_t *a = acc + (size_t)r * aw;
+                const int32_t *b = acc + (size_t)(band + r) * aw;
+                int16_t *dst = job->output + yolo2_act_index(o, y0 + r, 0, l->out_h, l->out_w);
+                for (int x = 0; x < l->out_w; ++x) {
+                    row[x] = output_value(split ? sat32((int64_t)a[x] + b[x]) : a[x], mult, shift, l->is_nl);
+                }
+                if (out_step == 1) {
+                    memcpy(dst, row, (size_t)l->out_w * sizeof(int16_t));
+                } else {
+                    for (int x = 0; x < l->out_w; ++x) {
+                        dst[x * out_step] = row[x];
+                    }
+                }
+            }
+        }
+    }
+    free(acc);
+    free(row);
+    free((void *)src);
+}
+
+static void *cpu_conv_thread(void *arg)
+{
+    cpu_conv_job_t *job = (cpu_conv_job_t *)arg;
+    if (job->copy_phase) {
+        copy_input(job);
+    } else {
+        conv_channels(job);
+    }
+    return NULL;
+}
+
+// Run one phase on `threads` jobs; job 0 runs on the calling thread.
+static int run_phase(cpu_conv_job_t *jobs, int threads, int copy_phase)
+{
+    pthread_t tid[YOLO2_CPU_CONV_MAX_THREADS];
+    int started = 1;
+    for (int t = 0; t < threads; ++t) {
+        jobs[t].copy_phase = copy_phase;
+        jobs[t].result = 0;
+    }
+    for (int t = 1; t < threads; ++t) {
+        if (pthread_create(&tid[t], NULL, cpu_conv_thread, &jobs[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    // Jobs that could not get a thread run here
+    cpu_conv_thread(&jobs[0]);
+    for (int t = started; t < threads; ++t) {
+        cpu_conv_thread(&jobs[t]);
+    }
+    int result = 0;
+    for (int t = 0; t < threads; ++t) {
+        if (t > 0 && t < started) {
+            pthread_join(tid[t], NULL);
+        }
+        if (jobs[t].result != 0) {
+            result = -1;
+        }
+    }
+    return result;
+}
+
+/**
+ * Decode the weights of output channels [c0, c1)
+ */
+void yolo2_cpu_conv_decode(const yolo2_cpu_conv_t *l, const int16_t *weights, int c0, int c1, int16_t *dst)
+{
+    const size_t per_channel = (size_t)l->ifm * l->ksize * l->ksize;
+    for (int o = c0; o < c1; ++o) {
+        decode_channel_weights(l, weights, o, dst + (size_t)(o - c0) * per_channel);
+    }
+}
+
+/**
+ * Compute output channels [c0, c1)
+ */
+int yolo2_cpu_conv(const yolo2_cpu_conv_t *l, const int16_t *input, const int16_t *weights,
+                   const int16_t *bias, int16_t *output, int c0, int c1, int threads)
+{
+    if (!l || !input || !weights || !bias || !output || c0 < 0 || c1 > l->ofm || c0 >= c1 ||
+        l->tn <= 0 || l->stride <= 0) {
+        fprintf(stderr, "ERROR: Invalid CPU conv arguments\n");
+        return -1;
+    }
+    threads = threads < 1 ? 1 : (threads > YOLO2_CPU_CONV_MAX_THREADS ? YOLO2_CPU_CONV_MAX_THREADS : threads);
+
+    // Padded on every side; the right edge also covers the 8-wide NEON loads.
+    const int aw = (l->out_w + 7) & ~7;
+    const int hp = l->in_h + 2 * l->pad;
+    int wp = l->in_w + 2 * l->pad;
+    if ((aw - 1) * l->stride + l->ksize > wp) {
+        wp = (aw - 1) * l->stride + l->ksize;
+    }
+    int16_t *pad_in = (int16_t *)calloc((size_t)l->ifm * hp * wp, sizeof(int16_t));
+    if (!pad_in) {
+        fprintf(stderr, "ERROR: Failed to allocate CPU conv input buffer\n");
+        return -1;
+    }
+
+    cpu_conv_job_t jobs[YOLO2_CPU_CONV_MAX_THREADS];
+    for (int t = 0; t < threads; ++t) {
+        jobs[t].l = l;
+        jobs[t].input = input;
+        jobs[t].weights = weights;
+        jobs[t].bias = bias;
+        jobs[t].output = output;
+        jobs[t].pad_in = pad_in;
+        jobs[t].hp = hp;
+        jobs[t].wp = wp;
+        jobs[t].c0 = c0;
+        jobs[t].c1 = c1;
+        jobs[t].index = t;
+        jobs[t].threads = threads;
+    }
+    int result = run_phase(jobs, threads, 1);
+    if (result == 0) {
+        result = run_phase(jobs, threads, 0);
+    }
+    free(pad_in);
+    if (result != 0) {
+        fprintf(stderr, "ERROR: CPU conv: out of memory\n");
+        return -1;
+    }
+
+#ifdef ACT_BLOCKED_LAYOUT
+    // The accelerator zero-fills the lanes past the last channel of a block
+    if (c1 == l->ofm && l->ofm % YOLO2_ACT_BLOCK) {
+        for (int c = l->ofm; c % YOLO2_ACT_BLOCK; ++c) {
+            for (int y = 0; y < l->out_h; ++y) {
+                for (int x = 0; x < l->out_w; ++x) {
+                    output[yolo2_act_index(c, y, x, l->out_h, l->out_w)] = 0;
+                }
+            }
+        }
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Worker threads for yolo2_cpu_conv()
+ */
+int yolo2_cpu_conv_threads(int busy)
+{
+    const char *env = getenv("YOLO2_CPU_THREADS");
+    int n = (env && env[0]) ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN) - busy;
+    if (n < 1) n = 1;
+    return n > YOLO2_CPU_CONV_MAX_THREADS ? YOLO2_CPU_CONV_MAX_THREADS : n;
+}
+
+/**
+ * Parse YOLO2_CPU_OFFLOAD
+ */
+int yolo2_cpu_offload_init(yolo2_cpu_offload_t *s, const char *env)
+{
+    memset(s, 0, sizeof(*s));
+    if (!env || !env[0]) {
+        return 0;
+    }
+    if (strcmp(env, "auto") == 0) {
+        s->fraction = -1.0;
+        return 1;
+    }
+    char *end = NULL;
+    const double f = strtod(env, &end);
+    if (end == env || *end != '\0' || f < 0.0 || f >= 1.0) {
+        fprintf(stderr, "ERROR: YOLO2_CPU_OFFLOAD must be a fraction in [0, 1) or 'auto' (got '%s')\n", env);
+        return -1;
+    }
+    s->fraction = f;
+    return f > 0.0 ? 1 : 0;
+}
+
+/**
+ * Decoded weights of a layer's CPU channels, cached
+ */
+const int16_t *yolo2_cpu_offload_weights(yolo2_cpu_offload_t *s, int layer, const yolo2_cpu_conv_t *l,
+                                         const int16_t *weights, int c0)
+{
+    if (!s || layer < 0 || layer >= YOLO2_CPU_OFFLOAD_LAYERS || c0 < 0 || c0 >= l->ofm) {
+        return NULL;
+    }
+    const int bits = yolo2_wbits_precision(l->weight_bits);
+    if ((bits != 16 && bits != 8 && bits != 4) || (l->weight_bits & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT))) {
+        fprintf(stderr, "ERROR: CPU conv: unsupported weight bits 0x%x\n", l->weight_bits);
+        return NULL;
+    }
+    if (s->weights[layer] && s->weights_c0[layer] == c0) {
+        return s->weights[layer];
+    }
+    free(s->weights[layer]);
+    s->weights[layer] = (int16_t *)malloc((size_t)(l->ofm - c0) * l->ifm * l->ksize * l->ksize * sizeof(int16_t));
+    if (!s->weights[layer]) {
+        fprintf(stderr, "ERROR: Failed to allocate CPU conv weights for layer %d\n", layer);
+        return NULL;
+    }
+    yolo2_cpu_conv_decode(l, weights, c0, l->ofm, s->weights[layer]);
+    s->weights_c0[layer] = c0;
+    return s->weights[layer];
+}
+
+/**
+ * Free the cached weights
+ */
+void yolo2_cpu_offload_cleanup(yolo2_cpu_offload_t *s)
+{
+    if (!s) {
+        return;
+    }
+    for (int i = 0; i < YOLO2_CPU_OFFLOAD_LAYERS; ++i) {
+        free(s->weights[i]);
+        s->weights[i] = NULL;
+    }
+}
+
+/**
+ * Output channels of a layer to compute on the CPU
+ */
+int yolo2_cpu_offload_channels(const yolo2_cpu_offload_t *s, int layer, int ofm, int tm)
+{
+    if (!s || tm <= 0 || layer < 0 || layer >= YOLO2_CPU_OFFLOAD_LAYERS) {
+        return 0;
+    }
+    const int blocks = (ofm + tm - 1) / tm;
+    if (blocks < 2) {
+        return 0;
+    }
+#ifdef ACT_BLOCKED_LAYOUT
+    // The accelerator's part must end on a whole channel block
+    if (tm % YOLO2_ACT_BLOCK != 0) {
+        return 0;
+    }
+#endif
+
+    int fpga_blocks;
+    if (s->fraction > 0.0) {
+        fpga_blocks = (int)((1.0 - s->fraction) * ofm / tm + 0.5);
+    } else if (s->fpga_us_per_ch[layer] <= 0.0 || s->cpu_us_per_ch[layer] <= 0.0) {
+        fpga_blocks = blocks - 1;   // first run: one block on the CPU to measure both
+    } else {
+        // Fewest FPGA blocks whose slower side is fastest
+        double best = 0.0;
+        fpga_blocks = blocks;
+        for (int b = blocks; b >= 1; --b) {
+            const int fpga_ch = b * tm < ofm ? b * tm : ofm;
+            const double fpga_us = s->fpga_us_per_ch[layer] * fpga_ch;
+            const double cpu_us = s->cpu_us_per_ch[layer] * (ofm - fpga_ch);
+            const double t = fpga_us > cpu_us ? fpga_us : cpu_us;
+            if (b == blocks || t < best) {
+                best = t;
+                fpga_blocks = b;
+            }
+        }
+    }
+    if (fpga_blocks < 1) fpga_blocks = 1;
+    if (fpga_blocks > blocks) fpga_blocks = blocks;
+    return fpga_blocks * tm < ofm ? ofm - fpga_blocks * tm : 0;
+}
+
+/**
+ * Record one split run of a layer
+ */
+void yolo2_cpu_offload_update(yolo2_cpu_offload_t *s, int layer, int fpga_ch, double fpga_us,
+                              int cpu_ch, double cpu_us)
+{
+    if (!s || layer < 0 || layer >= YOLO2_CPU_OFFLOAD_LAYERS) {
+        return;
+    }
+    // Running average, so one noisy frame does not flip the split
+    if (fpga_ch > 0 && fpga_us > 0.0) {
+        const double r = fpga_us / fpga_ch;
+        s->fpga_us_per_ch[layer] = s->fpga_us_per_ch[layer] > 0.0 ? 0.5 * (s->fpga_us_per_ch[layer] + r) : r;
+    }
+    if (cpu_ch > 0 && cpu_us > 0.0) {
+        const double r = cpu_us / cpu_ch;
+        s->cpu_us_per_ch[layer] = s->cpu_us_per_ch[layer] > 0.0 ? 0.5 * (s->cpu_us_per_ch[layer] + r) : r;
+    }
+}
@@ -0,0 +1,611 @@
+/**
+ * YOLOv2 golden store - per-layer checksums for host/cosim/board regression
+ *
+ * Shared by linux_app, the host model and the cosim testbench; keep this
+ * file valid C99 and C++ (the host build compiles it with g++).
+ */
+
+#include "yolo2_golden.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define GOLDEN_MAGIC "Y2GOLD\0\0"
+#define GOLDEN_MAX_LAYERS 64
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t elem_size;
+    uint32_t is_float;
+    uint32_t num_layers;
+    uint64_t model_key;
+    uint64_t input_key;
+} golden_file_header_t;
+
+typedef struct {
+    int32_t layer;
+    int32_t type;
+    int32_t c;
+    int32_t h;
+    int32_t w;
+    int32_t tile_c;
+    int32_t tile_h;
+    int32_t tile_w;
+    uint32_t num_tiles;
+    uint32_t num_samples;
+    uint64_t hash;
+} golden_layer_header_t;
+
+typedef struct {
+    golden_layer_header_t hdr;
+    uint64_t *tile_hash;
+    float *samples;
+} golden_layer_t;
+
+struct yolo2_golden {
+    yolo2_golden_mode_t mode;
+    char path[PATH_MAX];
+    uint64_t model_key;
+    uint64_t input_key;
+    int elem_size;
+    int is_float;
+    float tol;
+
+    golden_layer_t layers[GOLDEN_MAX_LAYERS];
+    int num_layers;
+
+    int checked;
+    int diverged;
+    int first_diverged;
+    int errors;
+    uint64_t elapsed_ns;
+};
+
+#define HASH_K1 0x9E3779B97F4A7C15ULL
+#define HASH_K2 0xC2B2AE3D27D4EB4FULL
+
+static uint64_t hash_fmix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t yolo2_hash64(uint64_t seed, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = seed ^ ((uint64_t)len * HASH_K1);
+
+    while (len >= 8) {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        h ^= v * HASH_K2;
+        h = ((h << 31) | (h >> 33)) * HASH_K1;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        uint64_t v = 0;
+        memcpy(&v, p, len);
+        h ^= v * HASH_K2;
+        h = ((h << 31) | (h >> 33)) * HASH_K1;
+    }
+    return hash_fmix(h);
+}
+
+uint64_t yolo2_golden_hash_files(const char *const *paths, int count)
+{
+    const size_t chunk = 1u << 20;
+    uint8_t *buf = (uint8_t *)malloc(chunk);
+    uint64_t h = 0;
+
+    if (!buf) {
+        return 0;
+    }
+    for (int i = 0; i < count; ++i) {
+        FILE *fp = paths[i] ? fopen(paths[i], "rb") : NULL;
+        if (!fp) {
+            continue;
+        }
+        size_t rd;
+        while ((rd = fread(buf, 1, chunk, fp)) > 0) {
+            h = yolo2_hash64(h, buf, rd);
+        }
+        fclose(fp);
+    }
+    free(buf);
+    return h;
+}
+
+uint64_t yolo2_golden_model_key(const char *weights_dir, int is_int16)
+{
+    static const char *const fp32_files[] = { "weights_reorg.bin", "bias.bin" };
+    static const char *const int16_files[] = {
+        "weights_reorg_int16.bin", "bias_int16.bin",
+        "weight_int16_Q.bin", "bias_int16_Q.bin", "iofm_Q.bin", "weight_bits.bin"
+    };
+    const char *const *names = is_int16 ? int16_files : fp32_files;
+    const int count = is_int16 ? 6 : 2;
+    char paths[6][PATH_MAX];
+    const char *path_ptrs[6];
+
+    for (int i = 0; i < count; ++i) {
+        snprintf(paths[i], sizeof(paths[i]), "%s/%s", weights_dir, names[i]);
+        path_ptrs[i] = paths[i];
+    }
+    return yolo2_golden_hash_files(path_ptrs, count);
+}
+
+int yolo2_golden_env_enabled(void)
+{
+    const char *dir = getenv("YOLO2_GOLDEN_DIR");
+    const char *mode = getenv("YOLO2_GOLDEN_MODE");
+    if (!dir || !dir[0]) {
+        return 0;
+    }
+    return !(mode && (strcmp(mode, "off") == 0 || strcmp(mode, "0") == 0));
+}
+
+static uint64_t golden_now_ns(void)
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void golden_free_layers(yolo2_golden_t *g)
+{
+    for (int i = 0; i < g->num_layers; ++i) {
+        free(g->layers[i].tile_hash);
+        free(g->layers[i].samples);
+    }
+    g->num_layers = 0;
+}
+
+static int golden_load(yolo2_golden_t *g)
+{
+    FILE *fp = fopen(g->path, "rb");
+    if (!fp) {
+        fprintf(stderr, "ERROR: No golden file %s (%s); record one with YOLO2_GOLDEN_MODE=record\n",
+                g->path, strerror(errno));
+        return -1;
+    }
+
+    golden_file_header_t fh;
+    if (fread(&fh, sizeof(fh), 1, fp) != 1 || memcmp(fh.magic, GOLDEN_MAGIC, 8) != 0 ||
+        fh.version != YOLO2_GOLDEN_VERSION || fh.num_layers > GOLDEN_MAX_LAYERS) {
+        fprintf(stderr, "ERROR: %s is not a v%d golden file\n", g->path, YOLO2_GOLDEN_VERSION);
+        fclose(fp);
+        return -1;
+    }
+    if ((int)fh.elem_size != g->elem_size || (int)fh.is_float != g->is_float) {
+        fprintf(stderr, "ERROR: Golden %s was recorded with %s%u tensors, this build uses %s%d\n",
+                g->path, fh.is_float ? "float" : "int", fh.elem_size * 8,
+                g->is_float ? "float" : "int", g->elem_size * 8);
+        fclose(fp);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < fh.num_layers; ++i) {
+        golden_layer_t *gl = &g->layers[g->num_layers];
+        memset(gl, 0, sizeof(*gl));
+        if (fread(&gl->hdr, sizeof(gl->hdr), 1, fp) != 1 ||
+            gl->hdr.num_samples > YOLO2_GOLDEN_MAX_SAMPLES) {
+            goto corrupt;
+        }
+        g->num_layers++;
+        gl->tile_hash = (uint64_t *)malloc((size_t)gl->hdr.num_tiles * sizeof(uint64_t));
+        gl->samples = (float *)malloc((size_t)gl->hdr.num_samples * sizeof(float) + 1);
+        if (!gl->tile_hash || !gl->samples ||
+            fread(gl->tile_hash, sizeof(uint64_t), gl->hdr.num_tiles, fp) != gl->hdr.num_tiles ||
+            fread(gl->samples, sizeof(float), gl->hdr.num_samples, fp) != gl->hdr.num_samples) {
+            goto corrupt;
+        }
+    }
+    fclose(fp);
+    return 0;
+
+corrupt:
+    fprintf(stderr, "ERROR: Golden file %s is truncated or corrupt\n", g->path);
+    fclose(fp);
+    golden_free_layers(g);
+    return -1;
+}
+
+static int golden_save(yolo2_golden_t *g)
+{
+    char tmp_path[PATH_MAX + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", g->path);
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write golden file %s: %s\n", tmp_path, strerror(errno));
+        return -1;
+    }
+
+    golden_file_header_t fh;
+    memset(&fh, 0, sizeof(fh));
+    memcpy(fh.magic, GOLDEN_MAGIC, 8);
+    fh.version = YOLO2_GOLDEN_VERSION;
+    fh.elem_size = (uint32_t)g->elem_size;
+    fh.is_float = (uint32_t)g->is_float;
+    fh.num_layers = (uint32_t)g->num_layers;
+    fh.model_key = g->model_key;
+    fh.input_key = g->input_key;
+
+    int ok = fwrite(&fh, sizeof(fh), 1, fp) == 1;
+    for (int i = 0; ok && i < g->num_layers; ++i) {
+        const golden_layer_t *gl = &g->layers[i];
+        ok = fwrite(&gl->hdr, sizeof(gl->hdr), 1, fp) == 1 &&
+             fwrite(gl->tile_hash, sizeof(uint64_t), gl->hdr.num_tiles, fp) == gl->hdr.num_tiles &&
+             fwrite(gl->samples, sizeof(float), gl->hdr.num_samples, fp) == gl->hdr.num_samples;
+    }
+    if (fclose(fp) != 0) {
+        ok = 0;
+    }
+    if (!ok || rename(tmp_path, g->path) != 0) {
+        fprintf(stderr, "ERROR: Failed to write golden file %s\n", g->path);
+        remove(tmp_path);
+        return -1;
+    }
+    printf("Golden: recorded %d layers to %s\n", g->num_layers, g->path);
+    return 0;
+}
+
+yolo2_golden_t *yolo2_golden_open(const char *dir, yolo2_golden_mode_t mode,
+                                  uint64_t model_key, uint64_t input_key,
+                                  int elem_size, int is_float)
+{
+    if (mode == YOLO2_GOLDEN_OFF || !dir || !dir[0]) {
+        return NULL;
+    }
+    if (elem_size != 2 && elem_size != 4) {
+        fprintf(stderr, "ERROR: Golden store supports 2- or 4-byte elements (got %d)\n", elem_size);
+        return NULL;
+    }
+
+    yolo2_golden_t *g = (yolo2_golden_t *)calloc(1, sizeof(yolo2_golden_t));
+    if (!g) {
+        return NULL;
+    }
+    g->mode = mode;
+    g->model_key = model_key;
+    g->input_key = input_key;
+    g->elem_size = elem_size;
+    g->is_float = is_float ? 1 : 0;
+    g->first_diverged = -1;
+    snprintf(g->path, sizeof(g->path), "%s/%016llx_%016llx.y2g", dir,
+             (unsigned long long)model_key, (unsigned long long)input_key);
+
+    if (mode == YOLO2_GOLDEN_RECORD) {
+        if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+            fprintf(stderr, "ERROR: Cannot create golden dir %s: %s\n", dir, strerror(errno));
+            free(g);
+            return NULL;
+        }
+    } else if (golden_load(g) != 0) {
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+yolo2_golden_t *yolo2_golden_open_env(uint64_t model_key, uint64_t input_key,
+                                      int elem_size, int is_float)
+{
+    const char *dir = getenv("YOLO2_GOLDEN_DIR");
+    if (!dir || !dir[0]) {
+        return NULL;
+    }
+
+    yolo2_golden_mode_t mode = YOLO2_GOLDEN_VERIFY;
+    const char *mode_env = getenv("YOLO2_GOLDEN_MODE");
+    if (mode_env && mode_env[0]) {
+        if (strcmp(mode_env, "record") == 0) {
+            mode = YOLO2_GOLDEN_RECORD;
+        } else if (strcmp(mode_env, "verify") == 0) {
+            mode = YOLO2_GOLDEN_VERIFY;
+        } else if (strcmp(mode_env, "off") == 0 || strcmp(mode_env, "0") == 0) {
+            return NULL;
+        } else {
+            fprintf(stderr, "WARNING: Invalid YOLO2_GOLDEN_MODE='%s', using verify\n", mode_env);
+        }
+    }
+
+    yolo2_golden_t *g = yolo2_golden_open(dir, mode, model_key, input_key, elem_size, is_float);
+    if (g) {
+        const char *tol = getenv("YOLO2_GOLDEN_TOL");
+        if (tol && tol[0]) {
+            g->tol = strtof(tol, NULL);
+        }
+        printf("Golden: %s %s\n", mode == YOLO2_GOLDEN_RECORD ? "recording" : "verifying", g->path);
+    }
+    return g;
+}
+
+static float golden_elem(const yolo2_golden_t *g, const void *data, size_t idx)
+{
+    if (g->elem_size == 2) {
+        return (float)((const int16_t *)data)[idx];
+    }
+    if (g->is_float) {
+        return ((const float *)data)[idx];
+    }
+    return (float)((const int32_t *)data)[idx];
+}
+
+static int ceil_div(int a, int b)
+{
+    return (a + b - 1) / b;
+}
+
+/* Tile hashes in (channel tile, row tile, col tile) order. */
+static void golden_hash_tiles(const yolo2_golden_t *g, const void *data,
+                              int c, int h, int w, int row_stride,
+                              int tile_c, int tile_h, int tile_w, uint64_t *out)
+{
+    const uint8_t *base = (const uint8_t *)data;
+    const size_t es = (size_t)g->elem_size;
+    const int nct = ceil_div(c, tile_c);
+    const int nrt = ceil_div(h, tile_h);
+    const int nwt = ceil_div(w, tile_w);
+    int t = 0;
+
+    for (int ct = 0; ct < nct; ++ct) {
+        const int c0 = ct * tile_c;
+        const int c1 = (c0 + tile_c < c) ? c0 + tile_c : c;
+        for (int rt = 0; rt < nrt; ++rt) {
+            const int r0 = rt * tile_h;
+            const int r1 = (r0 + tile_h < h) ? r0 + tile_h : h;
+            for (int wt = 0; wt < nwt; ++wt) {
+                const int x0 = wt * tile_w;
+                const int x1 = (x0 + tile_w < w) ? x0 + tile_w : w;
+                uint64_t hv = (uint64_t)t;
+                for (int ch = c0; ch < c1; ++ch) {
+                    for (int r = r0; r < r1; ++r) {
+                        const size_t off = ((size_t)ch * h + r) * row_stride + x0;
+                        hv = yolo2_hash64(hv, base + off * es, (size_t)(x1 - x0) * es);
+                    }
+                }
+                out[t++] = hv;
+            }
+        }
+    }
+}
+
+static void golden_sample(const yolo2_golden_t *g, const void *data,
+                          int c, int h, int w, int row_stride,
+                          uint32_t num_samples, float *out)
+{
+    const uint64_t total = (uint64_t)c * h * w;
+    for (uint32_t s = 0; s < num_samples; ++s) {
+        const uint64_t idx = (uint64_t)s * total / num_samples;
+        const uint64_t x = idx % (uint64_t)w;
+        const uint64_t y = (idx / (uint64_t)w) % (uint64_t)h;
+        const uint64_t ch = idx / ((uint64_t)w * h);
+        out[s] = golden_elem(g, data, (size_t)((ch * h + y) * row_stride + x));
+    }
+}
+
+static const char *golden_type_name(int type)
+{
+    switch (type) {
+        case YOLO2_GOLDEN_CONV:    return "conv";
+        case YOLO2_GOLDEN_MAXPOOL: return "maxpool";
+        case YOLO2_GOLDEN_REORG:   return "reorg";
+        default:                   return "unknown";
+    }
+}
+
+static int golden_record_layer(yolo2_golden_t *g, int layer, int type, const void *data,
+                               int c, int h, int w, int row_stride,
+                               int tile_c, int tile_h, int tile_w)
+{
+    if (g->num_layers >= GOLDEN_MAX_LAYERS) {
+        fprintf(stderr, "ERROR: Golden store is limited to %d layers\n", GOLDEN_MAX_LAYERS);
+        return -1;
+    }
+
+    golden_layer_t *gl = &g->layers[g->num_layers];
+    memset(gl, 0, sizeof(*gl));
+    gl->hdr.layer = layer;
+    gl->hdr.type = type;
+    gl->hdr.c = c;
+    gl->hdr.h = h;
+    gl->hdr.w = w;
+    gl->hdr.tile_c = tile_c;
+    gl->hdr.tile_h = tile_h;
+    gl->hdr.tile_w = tile_w;
+    gl->hdr.num_tiles = (uint32_t)(ceil_div(c, tile_c) * ceil_div(h, tile_h) * ceil_div(w, tile_w));
+    const uint64_t total = (uint64_t)c * h * w;
+    gl->hdr.num_samples = (uint32_t)(total < YOLO2_GOLDEN_MAX_SAMPLES ? total : YOLO2_GOLDEN_MAX_SAMPLES);
+
+    gl->tile_hash = (uint64_t *)malloc((size_t)gl->hdr.num_tiles * sizeof(uint64_t));
+    gl->samples = (float *)malloc((size_t)gl->hdr.num_samples * sizeof(float) + 1);
+    if (!gl->tile_hash || !gl->samples) {
+        free(gl->tile_hash);
+        free(gl->samples);
+        fprintf(stderr, "ERROR: Golden allocation failed for layer %d\n", layer);
+        return -1;
+    }
+
+    golden_hash_tiles(g, data, c, h, w, row_stride, tile_c, tile_h, tile_w, gl->tile_hash);
+    golden_sample(g, data, c, h, w, row_stride, gl->hdr.num_samples, gl->samples);
+    gl->hdr.hash = yolo2_hash64((uint64_t)layer, gl->tile_hash,
+                                (size_t)gl->hdr.num_tiles * sizeof(uint64_t));
+    g->num_layers++;
+    return 0;
+}
+
+static int golden_verify_layer(yolo2_golden_t *g, int layer, int type, const void *data,
+                               int c, int h, int w, int row_stride)
+{
+    const golden_layer_t *gl = NULL;
+    for (int i = 0; i < g->num_layers; ++i) {
+        if (g->layers[i].hdr.layer == layer) {
+            gl = &g->layers[i];
+            break;
+        }
+    }
+    if (!gl) {
+        fprintf(stderr, "WARNING: Golden has no entry for layer %d\n", layer);
+        return -1;
+    }
+
+    g->checked++;
+    const int report = (g->first_diverged < 0);
+    if (gl->hdr.type != type || gl->hdr.c != c || gl->hdr.h != h || gl->hdr.w != w) {
+        if (report) {
+            fprintf(stderr, "Golden: layer %d %s shape %dx%dx%d differs from golden %s %dx%dx%d\n",
+                    layer, golden_type_name(type), c, h, w,
+                    golden_type_name(gl->hdr.type), gl->hdr.c, gl->hdr.h, gl->hdr.w);
+            g->first_diverged = layer;
+        }
+        g->diverged++;
+        return 1;
+    }
+
+    uint64_t *tiles = (uint64_t *)malloc((size_t)gl->hdr.num_tiles * sizeof(uint64_t));
+    if (!tiles) {
+        return -1;
+    }
+    golden_hash_tiles(g, data, c, h, w, row_stride, gl->hdr.tile_c, gl->hdr.tile_h, gl->hdr.tile_w, tiles);
+    const uint64_t hash = yolo2_hash64((uint64_t)layer, tiles, (size_t)gl->hdr.num_tiles * sizeof(uint64_t));
+    if (hash == gl->hdr.hash) {
+        free(tiles);
+        return 0;
+    }
+
+    int first_tile = -1;
+    uint32_t bad_tiles = 0;
+    for (uint32_t t = 0; t < gl->hdr.num_tiles; ++t) {
+        if (tiles[t] != gl->tile_hash[t]) {
+            if (first_tile < 0) {
+                first_tile = (int)t;
+            }
+            bad_tiles++;
+        }
+    }
+    free(tiles);
+
+    float samples[YOLO2_GOLDEN_MAX_SAMPLES];
+    golden_sample(g, data, c, h, w, row_stride, gl->hdr.num_samples, samples);
+    float max_diff = 0.0f;
+    uint32_t max_at = 0;
+    for (uint32_t s = 0; s < gl->hdr.num_samples; ++s) {
+        const float d = fabsf(samples[s] - gl->samples[s]);
+        if (d > max_diff) {
+            max_diff = d;
+            max_at = s;
+        }
+    }
+
+    if (g->tol > 0.0f && max_diff <= g->tol) {
+        return 0;
+    }
+
+    g->diverged++;
+    if (report) {
+        g->first_diverged = layer;
+        const int nrt = ceil_div(h, gl->hdr.tile_h);
+        const int nwt = ceil_div(w, gl->hdr.tile_w);
+        const int ft = first_tile < 0 ? 0 : first_tile;
+        const int c0 = (ft / (nrt * nwt)) * gl->hdr.tile_c;
+        const int r0 = ((ft / nwt) % nrt) * gl->hdr.tile_h;
+        const int x0 = (ft % nwt) * gl->hdr.tile_w;
+        fprintf(stderr,
+                "Golden: first divergence at layer %d (%s %dx%dx%d): %u/%u tiles differ, "
+                "first tile #%d ch[%d..%d) row[%d..%d) col[%d..%d)\n",
+                layer, golden_type_name(type), c, h, w, bad_tiles, gl->hdr.num_tiles, ft,
+                c0, (c0 + gl->hdr.tile_c < c) ? c0 + gl->hdr.tile_c : c,
+                r0, (r0 + gl->hdr.tile_h < h) ? r0 + gl->hdr.tile_h : h,
+                x0, (x0 + gl->hdr.tile_w < w) ? x0 + gl->hdr.tile_w : w);
+        if (gl->hdr.num_samples > 0) {
+            fprintf(stderr, "Golden:   sampled max |diff| = %g at sample %u (got %g, golden %g)\n",
+                    (double)max_diff, max_at, (double)samples[max_at], (double)gl->samples[max_at]);
+        }
+    }
+    return 1;
+}
+
+int yolo2_golden_layer(yolo2_golden_t *g, int layer, int type, const void *data,
+                       int c, int h, int w, int row_stride,
+                       int tile_c, int tile_h, int tile_w)
+{
+    if (!g) {
+        return 0;
+    }
+    if (!data || c <= 0 || h <= 0 || w <= 0 || row_stride < w ||
+        tile_c <= 0 || tile_h <= 0 || tile_w <= 0) {
+        fprintf(stderr, "ERROR: Invalid golden tensor for layer %d\n", layer);
+        g->errors++;
+        return -1;
+    }
+
+    const uint64_t t0 = golden_now_ns();
+    int rc;
+    if (g->mode == YOLO2_GOLDEN_RECORD) {
+        rc = golden_record_layer(g, layer, type, data, c, h, w, row_stride, tile_c, tile_h, tile_w);
+    } else {
+        rc = golden_verify_layer(g, layer, type, data, c, h, w, row_stride);
+    }
+    if (rc < 0) {
+        g->errors++;
+    }
+    g->elapsed_ns += golden_now_ns() - t0;
+    return rc;
+}
+
+int yolo2_golden_close(yolo2_golden_t *g)
+{
+    if (!g) {
+        return -1;
+    }
+
+    int rc = g->first_diverged;
+    if (g->mode == YOLO2_GOLDEN_RECORD) {
+        if (g->errors > 0 || golden_save(g) != 0) {
+            rc = -2;
+        }
+    } else {
+        if (g->checked < g->num_layers) {
+            fprintf(stderr, "WARNING: Golden: only %d of %d recorded layers were checked\n",
+                    g->checked, g->num_layers);
+        }
+        if (g->diverged == 0) {
+            printf("Golden: %d layers match (%.1f us)\n", g->checked, (double)g->elapsed_ns / 1000.0);
+        } else {
+            printf("Golden: %d of %d layers diverged, first at layer %d (%.1f us)\n",
+                   g->diverged, g->checked, g->first_diverged, (double)g->elapsed_ns / 1000.0);
+        }
+        if (g->errors > 0 && rc < 0) {
+            rc = -2;
+        }
+    }
+
+    golden_free_layers(g);
+    free(g);
+    return rc;
+}
+
+void yolo2_golden_discard(yolo2_golden_t *g)
+{
+    if (!g) {
+        return;
+    }
+    golden_free_layers(g);
+    free(g);
+}
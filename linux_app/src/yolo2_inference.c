@@ -15,6 +15,13 @@
 #include "yolo2_network.h"
 #include "dma_buffer_manager.h"
 #include "yolo2_log.h"
+#include "yolo2_golden.h"
+#include "yolo2_tensor.h"
+#include "yolo2_ofm_split.h"
+#include "yolo2_cpu_conv.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_autotune.h"
+#include "yolo2_requant.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -23,6 +30,7 @@
 #include <stddef.h>
 #include <time.h>
 #include <inttypes.h>
+#include <pthread.h>
 
 // Weight offsets (from model_config.cpp)
 // Note: These are in elements (words), not bytes
@@ -42,6 +50,17 @@ static const size_t beta_offsets[] = {
 #define NUM_WEIGHT_OFFSETS (sizeof(weight_offsets) / sizeof(weight_offsets[0]))
 #define NUM_BETA_OFFSETS (sizeof(beta_offsets) / sizeof(beta_offsets[0]))
 
+// 16-bit words a conv layer occupies in weights_reorg_int16.bin (matches
+// yolo2_weight_words() in model_config.hpp): 8-bit layers pack two weights
+// per word, 4-bit layers a 16-word codebook and four indices per word; every
+// layer is padded to an even word count.
+static size_t yolo2_weight_words(size_t count, int weight_bits_word)
+{
+    const int weight_bits = yolo2_wbits_precision(weight_bits_word);
+    const size_t words = (weight_bits == 8) ? (count + 1) / 2 : (weight_bits == 4) ? 16 + (count + 3) / 4 : count;
+    return words + (words & 0x1);
+}
+
 static uint64_t yolo2_now_us(void)
 {
     struct timespec ts;
@@ -60,6 +79,27 @@ static uint64_t yolo2_now_us(void)
     return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
 }
 
+typedef struct {
+    const yolo2_cpu_conv_t *layer;
+    const int16_t *input;
+    const int16_t *weights;
+    const int16_t *bias;
+    int16_t *output;
+    int c0;
+    int result;
+    uint64_t end_us;
+} cpu_conv_job_t;
+
+static void *cpu_conv_thread(void *arg)
+{
+    cpu_conv_job_t *job = (cpu_conv_job_t *)arg;
+    // This thread polls the accelerator meanwhile, so leave it a core
+    job->result = yolo2_cpu_conv(job->layer, job->input, job->weights, job->bias, job->output,
+                                 job->c0, job->layer->ofm, yolo2_cpu_conv_threads(1));
+    job->end_us = yolo2_now_us();
+    return NULL;
+}
+
 static const char *yolo2_layer_type_name(int layer_type)
 {
     switch (layer_type) {
@@ -227,6 +267,9 @@ void yolo2_inference_cleanup(yolo2_inference_context_t *ctx)
     if (ctx->act_q) {
         free(ctx->act_q);
     }
+    if (ctx->weight_bits) {
+        free(ctx->weight_bits);
+    }
     if (ctx->region_output) {
         free(ctx->region_output);
     }
@@ -250,7 +293,11 @@ int yolo2_process_input_image(float *input_image, int16_t *output_buffer,
         scale = 1.0;
     }
     
+    // input_image is compact CHW; output_buffer uses the accelerator activation layout.
     for (int idx = 0; idx < INPUT_ELEMS; ++idx) {
+        const int x = idx % INPUT_WIDTH;
+        const int y = (idx / INPUT_WIDTH) % INPUT_HEIGHT;
+        const int ch = idx / (INPUT_WIDTH * INPUT_HEIGHT);
         double v = input_image[idx] * scale;
         // Clamp to int16_t range
         if (v > 32767.0) v = 32767.0;
@@ -259,7 +306,7 @@ int yolo2_process_input_image(float *input_image, int16_t *output_buffer,
         int64_t q = (int64_t)(v < 0 ? v - 0.5 : v + 0.5);
         if (q > 32767) q = 32767;
         if (q < -32768) q = -32768;
-        output_buffer[idx] = (int16_t)q;
+        output_buffer[yolo2_act_index(ch, y, x, INPUT_HEIGHT, INPUT_WIDTH)] = (int16_t)q;
     }
     
     return 0;
@@ -319,6 +366,11 @@ int yolo2_inference_conv_layer(yolo2_inference_context_t *ctx,
     
     // Get Q values (INT16 mode)
     int32_t Qw = 0, Qa_in = 0, Qa_out = 0, Qb = 0;
+    int weight_bits = 16;
+    
+    if (ctx->weight_bits && ctx->offset_index < (int)ctx->weight_bits_size) {
+        weight_bits = ctx->weight_bits[ctx->offset_index];
+    }
     
     if (ctx->weight_q && ctx->offset_index < (int)ctx->weight_q_size) {
         Qw = ctx->weight_q[ctx->offset_index];
@@ -344,8 +396,8 @@ int yolo2_inference_conv_layer(yolo2_inference_context_t *ctx,
     // Update current Q
     ctx->current_Qa = Qa_out;
     
-    YOLO2_LOG_LAYER("    Layer %d: Qw=%d, Qb=%d, Qa_in=%d, Qa_out=%d\n",
-                    layer_idx, Qw, Qb, Qa_in, Qa_out);
+    YOLO2_LOG_LAYER("    Layer %d: Qw=%d, Qb=%d, Qa_in=%d, Qa_out=%d, weight bits=%d\n",
+                    layer_idx, Qw, Qb, Qa_in, Qa_out, weight_bits);
     
     // Debug: Print physical addresses being sent to accelerator
     if (yolo2_get_verbosity() >= 3) {
@@ -359,25 +411,144 @@ int yolo2_inference_conv_layer(yolo2_inference_context_t *ctx,
     // CRITICAL: Flush cache for all buffers before starting accelerator
     // The accelerator uses DMA to access these buffers, so they must be
     // flushed to memory before the accelerator can read/write them
-    size_t input_size = input_w * input_h * ifm_num * sizeof(int16_t);
-    size_t output_size = output_w * output_h * ofm_num * sizeof(int16_t);
+    size_t input_size = yolo2_act_words(ifm_num, input_h, input_w) * sizeof(int16_t);
+    size_t output_size = yolo2_act_words(ofm_num, output_h, output_w) * sizeof(int16_t);
     memory_flush_cache(ctx->in_ptr[layer_idx], input_size);
+    const size_t layer_words = yolo2_weight_words(ifm_num * ofm_num * ksize * ksize, weight_bits);
     memory_flush_cache(ctx->weights_buf.ptr, 
-                       (ctx->woffset + (ifm_num * ofm_num * ksize * ksize)) * sizeof(int16_t));
+                       (ctx->woffset + layer_words) * sizeof(int16_t));
     memory_flush_cache(ctx->bias_buf.ptr, 
-                       (ctx->boffset + ofm_num) * sizeof(int16_t));
+                       (ctx->boffset + (size_t)ofm_num * yolo2_beta_words(weight_bits)) * sizeof(int16_t));
+    
+    // Split the output channels over the instances, if more than one (yolo2_ofm_split.h)
+    yolo2_accel_t *engines[YOLO2_MAX_ACCELS];
+    int num_engines = 0;
+    engines[num_engines++] = ctx->accel ? ctx->accel : yolo2_accel_default();
+    for (int e = 0; e < ctx->num_ofm_peers && num_engines < YOLO2_MAX_ACCELS; ++e) {
+        engines[num_engines++] = ctx->ofm_peers[e];
+    }
+    yolo2_ofm_slice_t slices[YOLO2_MAX_ACCELS];
+    const int num_slices = yolo2_ofm_split(ofm_num, ifm_num, ksize, tm, weight_bits, num_engines, slices);
+    
+    // With a single instance, the CPU may take the last output channels
+    const int cpu_ch = (ctx->cpu_offload && num_engines == 1)
+                           ? yolo2_cpu_offload_channels(ctx->cpu_offload, layer_idx, ofm_num, tm) : 0;
     
     // Execute layer
-    int result = yolo2_execute_conv_layer(
-        input_addr, output_addr, weight_addr, beta_addr,
-        ifm_num, ofm_num, ksize, kstride,
-        input_w, input_h, output_w, output_h, padding,
-        is_nl, is_bn, tm, tn, tr, tc,
-        ofm_num_bound, mloopsxTM, mloops_a1xTM,
-        0, // layer_type = CONV
-        Qw, Qa_in, Qa_out, Qb,
-        yolo2_get_layer_timeout_ms()
-    );
+    int result;
+    if (cpu_ch > 0) {
+        // Accelerator: whole TM blocks from channel 0, so its weight stream is unchanged
+        const int fpga_ofm = ofm_num - cpu_ch;
+        const int fpga_loops = fpga_ofm / tm;
+        yolo2_cpu_conv_t cl;
+        cl.ifm = ifm_num;
+        cl.ofm = ofm_num;
+        cl.ksize = ksize;
+        cl.stride = kstride;
+        cl.pad = padding;
+        cl.in_w = input_w;
+        cl.in_h = input_h;
+        cl.out_w = output_w;
+        cl.out_h = output_h;
+        cl.tm = tm;
+        cl.tn = tn;
+        cl.weight_bits = weight_bits;
+        cl.qw = Qw;
+        cl.qa_in = Qa_in;
+        cl.qa_out = Qa_out;
+        cl.qb = Qb;
+        cl.is_nl = is_nl;
+        cl.split_k = engines[0]->split_k;
+        cpu_conv_job_t job;
+        job.layer = &cl;
+        job.input = ctx->in_ptr[layer_idx];
+        job.weights = yolo2_cpu_offload_weights(ctx->cpu_offload, layer_idx, &cl,
+                                                (int16_t *)ctx->weights_buf.ptr + ctx->woffset, fpga_ofm);
+        job.bias = (int16_t *)ctx->bias_buf.ptr + ctx->boffset;
+        job.output = ctx->out_ptr[layer_idx];
+        job.c0 = fpga_ofm;
+        job.result = 0;
+        if (!job.weights) {
+            return -1;
+        }
+        YOLO2_LOG_LAYER("    Layer %d: OFM 0..%d on the accelerator, %d..%d on the CPU\n",
+                        layer_idx, fpga_ofm - 1, fpga_ofm, ofm_num - 1);
+
+        const uint64_t start_us = yolo2_now_us();
+        result = yolo2_accel_conv_start(engines[0],
+            input_addr, output_addr, weight_addr, beta_addr,
+            ifm_num, fpga_ofm, ksize, kstride,
+            input_w, input_h, output_w, output_h, padding,
+            is_nl, is_bn, tm, tn, tr, tc,
+            (fpga_loops + 1) * tm, fpga_loops * tm, (fpga_loops + 1) * tm,
+            0, // layer_type = CONV
+            Qw, Qa_in, Qa_out, Qb, weight_bits);
+        if (result == YOLO2_SUCCESS) {
+            pthread_t thread;
+            const int threaded = (pthread_create(&thread, NULL, cpu_conv_thread, &job) == 0);
+            if (!threaded) {
+                cpu_conv_thread(&job);
+            }
+            result = yolo2_accel_wait(engines[0], yolo2_get_layer_timeout_ms());
+            const uint64_t fpga_us = yolo2_now_us() - start_us;
+            if (threaded) {
+                pthread_join(thread, NULL);
+            }
+            if (job.result != 0) {
+                fprintf(stderr, "ERROR: Layer %d: CPU conv failed\n", layer_idx);
+                if (result == YOLO2_SUCCESS) {
+                    result = -1;
+                }
+            }
+            if (result == YOLO2_SUCCESS) {
+                const uint64_t cpu_us = job.end_us - start_us;
+                yolo2_cpu_offload_update(ctx->cpu_offload, layer_idx, fpga_ofm, (double)fpga_us, cpu_ch, (double)cpu_us);
+                YOLO2_LOG_LAYER("    Layer %d: accelerator %.2f ms, CPU %.2f ms\n",
+                                layer_idx, (double)fpga_us / 1000.0, (double)cpu_us / 1000.0);
+            }
+        }
+    } else if (num_slices == 1) {
+        result = yolo2_accel_conv(engines[0],
+            input_addr, output_addr, weight_addr, beta_addr,
+            ifm_num, ofm_num, ksize, kstride,
+            input_w, input_h, output_w, output_h, padding,
+            is_nl, is_bn, tm, tn, tr, tc,
+            ofm_num_bound, mloopsxTM, mloops_a1xTM,
+            0, // layer_type = CONV
+            Qw, Qa_in, Qa_out, Qb, weight_bits,
+            yolo2_get_layer_timeout_ms()
+        );
+    } else {
+        // Start every slice, then wait for all of them
+        int started = 0;
+        result = YOLO2_SUCCESS;
+        for (int s = 0; s < num_slices && result == YOLO2_SUCCESS; ++s) {
+            const int slice_tm = slices[s].ofm < tm ? slices[s].ofm : tm;
+            const int slice_loops = (slices[s].ofm + slice_tm - 1) / slice_tm;
+            YOLO2_LOG_LAYER("    Layer %d: OFM %d..%d on instance %d\n",
+                            layer_idx, slices[s].m0, slices[s].m0 + slices[s].ofm - 1, s);
+            result = yolo2_accel_conv_start(engines[s],
+                input_addr,
+                output_addr + yolo2_act_words(slices[s].m0, output_h, output_w) * sizeof(int16_t),
+                weight_addr + slices[s].weight_offset * sizeof(int16_t),
+                beta_addr + (uint64_t)slices[s].beta_offset * sizeof(int16_t),
+                ifm_num, slices[s].ofm, ksize, kstride,
+                input_w, input_h, output_w, output_h, padding,
+                is_nl, is_bn, slice_tm, tn, tr, tc,
+                (slice_loops + 1) * slice_tm, slice_loops * slice_tm, (slice_loops + 1) * slice_tm,
+                0, // layer_type = CONV
+                Qw, Qa_in, Qa_out, Qb, weight_bits);
+            if (result == YOLO2_SUCCESS) {
+                started++;
+            }
+        }
+        for (int s = 0; s < started; ++s) {
+            const int wait_result = yolo2_accel_wait(engines[s], yolo2_get_layer_timeout_ms());
+            if (result == YOLO2_SUCCESS) {
+                result = wait_result;
+            }
+        }
+    }
     
     if (result == YOLO2_SUCCESS) {
         // Save layer-24 output Q for later route/reorg concat alignment (route layer 28).
@@ -386,12 +557,12 @@ int yolo2_inference_conv_layer(yolo2_inference_context_t *ctx,
             YOLO2_LOG_LAYER("    Stored route24_q=%d for reorg/route alignment\n", ctx->route24_q);
         }
 
-        // Update offsets (in ELEMENTS, not bytes)
+        // Update offsets (in 16-bit words, not bytes; W8/W4 layers are packed)
         if (ctx->offset_index < (int)NUM_WEIGHT_OFFSETS) {
-            ctx->woffset += weight_offsets[ctx->offset_index];
+            ctx->woffset += yolo2_weight_words(weight_offsets[ctx->offset_index], weight_bits);
         }
         if (ctx->offset_index < (int)NUM_BETA_OFFSETS) {
-            ctx->boffset += beta_offsets[ctx->offset_index];
+            ctx->boffset += beta_offsets[ctx->offset_index] * yolo2_beta_words(weight_bits);
         }
         ctx->offset_index++;
     }
@@ -430,7 +601,7 @@ int yolo2_inference_maxpool_layer(yolo2_inference_context_t *ctx,
     YOLO2_LOG_LAYER("    Maxpool %d: tm=%d tr=%d tc=%d ofm_num_bound=%d mLoopsxTM=%d mLoops_a1xTM=%d\n",
                     layer_idx, tm, tr, tc, ofm_num_bound, mloopsxTM, mloops_a1xTM);
 
-    return yolo2_execute_maxpool_layer(
+    return yolo2_accel_maxpool(ctx->accel ? ctx->accel : yolo2_accel_default(),
         input_addr, output_addr,
         channels, ksize, kstride,
         input_w, input_h, output_w, output_h, padding,
@@ -460,93 +631,130 @@ int yolo2_dequantize_output(int16_t *input, float *output, size_t count, int32_t
     return 0;
 }
 
-// Memory layout constants
-#define ROUTE16_LEN (26*32*512)
-#define CONV27_LEN (13*16*256)
-#define CONV24_LEN (13*16*1024)
-#define DETECTION_WORKSPACE (3*13*425)
-
 /**
- * Generate IOFM offset pointers (memory layout)
+ * Generate IOFM offset pointers (memory layout) from the layer plan
  */
 int yolo2_generate_iofm_offset(yolo2_inference_context_t *ctx) {
-    if (!ctx || !ctx->inference_buf.ptr || !ctx->net) {
+    if (!ctx || !ctx->inference_buf.ptr || !ctx->plan) {
         fprintf(stderr, "ERROR: Invalid context for generate_iofm_offset\n");
         return -1;
     }
     
-    int16_t *Memory_buf = (int16_t *)ctx->inference_buf.ptr;
-    int16_t *Memory_top = Memory_buf + 512;
-    int16_t *Memory_bottom = Memory_top + MEM_LEN;
-    network_t *net = ctx->net;
-    
-    // Layers 0-17: Standard ping-pong
-    for (int x = 0; x < 18 && x < net->n; x++) {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if (out_w & 0x7) {
-            out_w_align_256b += 8;
-        }
-        
-        if (x % 2 == 0) {
-            ctx->in_ptr[x] = Memory_top;
-            ctx->out_ptr[x] = Memory_bottom - net->layers[x].out_c * net->layers[x].out_h * out_w_align_256b;
-        } else {
-            ctx->in_ptr[x] = ctx->out_ptr[x-1];
-            ctx->out_ptr[x] = Memory_top;
-        }
+    int16_t *Memory_top = (int16_t *)ctx->inference_buf.ptr + 512;
+    for (int x = 0; x < ctx->plan->n; x++) {
+        const yolo2_plan_layer_t *p = &ctx->plan->layers[x];
+        ctx->in_ptr[x] = (p->in_offset == YOLO2_PLAN_NONE) ? NULL : Memory_top + p->in_offset;
+        ctx->out_ptr[x] = (p->out_offset == YOLO2_PLAN_NONE) ? NULL : Memory_top + p->out_offset;
     }
     
-    // Layers 18-24: With route16_len offset
-    for (int x = 18; x < 25 && x < net->n; x++) {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if (out_w & 0x7) {
-            out_w_align_256b += 8;
-        }
-        
-        if (x % 2 == 0) {
-            ctx->in_ptr[x] = Memory_top;
-            ctx->out_ptr[x] = Memory_bottom - ROUTE16_LEN - net->layers[x].out_c * net->layers[x].out_h * out_w_align_256b;
-        } else {
-            ctx->in_ptr[x] = ctx->out_ptr[x-1];
-            ctx->out_ptr[x] = Memory_top;
-        }
+    return 0;
+}
+
+/*
+ * Every conv layer's output channels must fit the beta buffer of `engine`
+ * (MAX_BETA_LENGTH words). beta_load() unpacks the three-word Beta entries of
+ * a YOLO2_WBITS_REQUANT layer into per-channel bias, multiplier and shift
+ * buffers of the same depth, so its bound is also one entry per channel.
+ */
+static int check_beta_length(const yolo2_plan_t *plan, const yolo2_accel_t *engine) {
+    if (engine->max_beta_length <= 0) return 0;    // no capability block
+    for (int i = 0; i < plan->n; i++) {
+        const yolo2_plan_layer_t *p = &plan->layers[i];
+        if (p->type != YOLO2_PLAN_CONV || p->ofm <= engine->max_beta_length) continue;
+        fprintf(stderr, "ERROR: Layer %d has %d output channels; accelerator 0x%lx holds %d %s per layer "
+                "(MAX_BETA_LENGTH)\n", i, p->ofm, (unsigned long)engine->ctrl_base, engine->max_beta_length,
+                yolo2_wbits_requant(p->weight_bits) ? "bias/multiplier/shift entries" : "bias words");
+        return -1;
     }
-    
-    // Layer 26: Route layer input
-    if (26 < net->n) {
-        ctx->in_ptr[26] = Memory_bottom - ROUTE16_LEN;
-        ctx->out_ptr[26] = Memory_top;
+    return 0;
+}
+
+/**
+ * Layer plan for `engine`
+ */
+int yolo2_inference_plan(yolo2_inference_context_t *ctx, const yolo2_accel_t *engine) {
+    const int slot = (ctx->plan_engines[0] == engine || !ctx->plan_engines[0]) ? 0 : 1;
+    if (ctx->plan_engines[slot] == engine) {
+#ifdef YOLO2_STATIC_PLAN
+        ctx->plan = &yolo2_static_plan;
+#else
+        ctx->plan = &ctx->plan_storage[slot];
+#endif
+        return 0;
     }
-    
-    // Layer 27: After route concatenation
-    if (27 < net->n) {
-        ctx->in_ptr[27] = Memory_top;
-        ctx->out_ptr[27] = Memory_bottom - ROUTE16_LEN - CONV24_LEN - CONV27_LEN;
+    const network_t *net = ctx->net;
+#ifdef YOLO2_STATIC_PLAN
+    if (net->n != yolo2_static_plan.n) {
+        fprintf(stderr, "ERROR: Layer plan has %d layers, network has %d\n", yolo2_static_plan.n, net->n);
+        return -1;
     }
-    
-    // Layer 29: After layer 27
-    if (29 < net->n) {
-        ctx->in_ptr[29] = ctx->out_ptr[27];
-        ctx->out_ptr[29] = Memory_top;
+    if (yolo2_plan_check(&yolo2_static_plan, engine->tm, engine->tn, engine->tr, engine->tc,
+                         engine->ib_height, engine->ib_width, ctx->weight_bits, (int)ctx->weight_bits_size) != 0) {
+        fprintf(stderr, "ERROR: Compiled-in layer plan does not match; rebuild it with make plan\n");
+        return -1;
     }
-    
-    // Layer 30: Final conv before region
-    if (30 < net->n) {
-        ctx->in_ptr[30] = Memory_top;
-        ctx->out_ptr[30] = Memory_bottom - (net->layers[30].outputs + DETECTION_WORKSPACE);
+    ctx->plan = &yolo2_static_plan;
+#else
+    yolo2_plan_t *plan = &ctx->plan_storage[slot];
+    if (net->n > YOLO2_PLAN_MAX_LAYERS) {
+        fprintf(stderr, "ERROR: Layer plan supports at most %d layers\n", YOLO2_PLAN_MAX_LAYERS);
+        return -1;
     }
-    
-    // Layer 31: Region layer
-    if (31 < net->n) {
-        ctx->in_ptr[31] = ctx->out_ptr[30];
-        ctx->out_ptr[31] = NULL;
+    memset(plan, 0, sizeof(*plan));
+    plan->n = net->n;
+    for (int i = 0; i < net->n; i++) {
+        const layer_t *l = &net->layers[i];
+        yolo2_plan_layer_t *p = &plan->layers[i];
+        switch (l->type) {
+            case LAYER_CONVOLUTIONAL: p->type = YOLO2_PLAN_CONV; break;
+            case LAYER_MAXPOOL: p->type = YOLO2_PLAN_MAXPOOL; break;
+            case LAYER_REORG: p->type = YOLO2_PLAN_REORG; break;
+            case LAYER_ROUTE: p->type = YOLO2_PLAN_ROUTE; break;
+            case LAYER_REGION: p->type = YOLO2_PLAN_REGION; break;
+            default: p->type = YOLO2_PLAN_OTHER; break;
+        }
+        p->ifm = l->c;
+        p->ofm = (l->type == LAYER_CONVOLUTIONAL) ? l->filters : l->out_c;
+        p->ksize = l->size;
+        p->stride = l->stride;
+        p->pad = l->pad;
+        p->in_w = l->w;
+        p->in_h = l->h;
+        p->out_w = l->out_w;
+        p->out_h = l->out_h;
+        p->is_nl = (l->activation == ACT_LEAKY) ? 1 : 0;
+        p->is_bn = l->batch_normalize ? 1 : 0;
+        p->route_layer = (l->type == LAYER_ROUTE && l->n == 1 && l->input_layers) ? l->input_layers[0] : -1;
     }
-    
+    if (yolo2_plan_build(plan, engine->tm, engine->tn, engine->tr, engine->tc, engine->ib_height, engine->ib_width,
+                         ctx->weight_bits, (int)ctx->weight_bits_size, MEM_LEN) != 0) {
+        return -1;
+    }
+    ctx->plan = plan;
+#endif
+    if (check_beta_length(ctx->plan, engine) != 0) {
+        return -1;
+    }
+    ctx->plan_engines[slot] = engine;
     return 0;
 }
 
+// Compact CHW <-> accelerator activation layout (yolo2_act_layout.h); padding is zeroed.
+static void chw_to_act(const int16_t *src, int16_t *dst, int c, int h, int w) {
+    memset(dst, 0, yolo2_act_words(c, h, w) * sizeof(int16_t));
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[yolo2_act_index(ch, y, x, h, w)] = src[((size_t)ch * h + y) * w + x];
+}
+
+static void act_to_chw(const int16_t *src, int16_t *dst, int c, int h, int w) {
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[((size_t)ch * h + y) * w + x] = src[yolo2_act_index(ch, y, x, h, w)];
+}
+
 // Reorg CPU implementation
 static void reorg_cpu(int16_t *x, int w, int h, int c, int stride, int16_t *out) {
     int out_c = c / (stride * stride);
@@ -595,21 +803,13 @@ int yolo2_execute_reorg_layer(yolo2_inference_context_t *ctx, int layer_idx, int
         return -1;
     }
     
-    // Copy from input to region_buf
-    int16_t *tmp_ptr_f0 = in_ptr;
-    for (int k = 0; k < 26 * 64; k++) {
-        memcpy(region_buf + k * 26, tmp_ptr_f0 + k * 32, 26 * sizeof(int16_t));
-    }
+    // Unpack the 64x26x26 input to compact CHW
+    memory_invalidate_cache(in_ptr, yolo2_act_words(64, 26, 26) * sizeof(int16_t));
+    act_to_chw(in_ptr, region_buf, 64, 26, 26);
     
     // Perform reorg
     reorg_cpu(region_buf, 26, 32 * 13, 4, stride, region_buf2);
-    
-    // Copy back
-    tmp_ptr_f0 = region_buf;
-    memset(region_buf, 0, 13 * 16 * 256 * sizeof(int16_t));
-    for (int k = 0; k < 13 * 256; k++) {
-        memcpy(tmp_ptr_f0 + k * 16, region_buf2 + k * 13, 13 * sizeof(int16_t));
-    }
+    int16_t *tmp_ptr_f0 = region_buf2;
     
     // Q alignment for route layer concatenation.
     // Keep in sync with `hls/models/yolov2/yolo2_model.cpp`: only the reorg branch is rescaled.
@@ -619,17 +819,17 @@ int yolo2_execute_reorg_layer(yolo2_inference_context_t *ctx, int layer_idx, int
         if (shift != 0) {
             YOLO2_LOG_LAYER("    Aligning Q scales: current_Qa=%d, route24_q=%d, target=%d, shift=%d\n",
                             ctx->current_Qa, ctx->route24_q, target_q, shift);
-            yolo2_apply_q_shift_int16(tmp_ptr_f0, (size_t)(13 * 16 * 256), shift);
+            yolo2_apply_q_shift_int16(tmp_ptr_f0, (size_t)(13 * 13 * 256), shift);
             ctx->current_Qa = target_q;
         }
         ctx->pending_route_q = ctx->current_Qa;
     }
     
     // Copy to output
-    memcpy(out_ptr, tmp_ptr_f0, 13 * 16 * 256 * sizeof(int16_t));
+    chw_to_act(tmp_ptr_f0, out_ptr, 256, 13, 13);
     
     // Sync for device
-    memory_flush_cache(out_ptr, 13 * 16 * 256 * sizeof(int16_t));
+    memory_flush_cache(out_ptr, yolo2_act_words(256, 13, 13) * sizeof(int16_t));
     
     free(region_buf);
     free(region_buf2);
@@ -641,7 +841,7 @@ int yolo2_execute_reorg_layer(yolo2_inference_context_t *ctx, int layer_idx, int
  * Execute ROUTE layer
  */
 int yolo2_execute_route_layer(yolo2_inference_context_t *ctx, int layer_idx) {
-    if (!ctx || !ctx->net || layer_idx >= ctx->net->n) {
+    if (!ctx || !ctx->net || !ctx->plan || layer_idx >= ctx->net->n) {
         fprintf(stderr, "ERROR: Invalid layer index for ROUTE\n");
         return -1;
     }
@@ -650,6 +850,17 @@ int yolo2_execute_route_layer(yolo2_inference_context_t *ctx, int layer_idx) {
     if (layer_idx == 28) {
         YOLO2_LOG_LAYER("    ROUTE layer 28: Concatenating layers 27 and 24\n");
     }
+
+    // Single-input route (layer 25 -> 16): the next conv reads the routed layer, so its input Q
+    // is the output Q of the last conv at or before that layer, not current_Qa.
+    // Keep in sync with `hls/models/yolov2/yolo2_model.cpp`.
+    const yolo2_plan_layer_t *p = &ctx->plan->layers[layer_idx];
+    if (p->route_conv >= 0 && ctx->act_q && p->route_conv + 1 < (int)ctx->act_q_size) {
+        ctx->current_Qa = ctx->act_q[p->route_conv + 1];
+        ctx->pending_route_q = ctx->current_Qa;
+        YOLO2_LOG_LAYER("    ROUTE layer %d: input Q for next conv = %d (from layer %d)\n",
+                        layer_idx, ctx->current_Qa, p->route_layer);
+    }
     
     return 0;
 }
@@ -670,7 +881,7 @@ int yolo2_execute_region_layer(yolo2_inference_context_t *ctx, int layer_idx) {
         return -1;
     }
     
-    // Convert format: input is 13x16x425 (padded), output is 13x13x425 (actual)
+    // Convert format: input uses the accelerator layout, output is 13x13x425 (compact CHW)
     int region_output_len = 13 * 13 * 425;  // 71825 elements
     int16_t *region_buf = (int16_t*)malloc(region_output_len * sizeof(int16_t));
     if (!region_buf) {
@@ -680,18 +891,9 @@ int yolo2_execute_region_layer(yolo2_inference_context_t *ctx, int layer_idx) {
     memset(region_buf, 0, region_output_len * sizeof(int16_t));
     
     // Sync for CPU
-    memory_invalidate_cache(in_ptr, 13 * 16 * 425 * sizeof(int16_t));
-    
-    // Convert: 13x16x425 -> 13x13x425
-    // The data is arranged as 425 channels of 13x16 (padded from 13x13)
-    int16_t *tmp_ptr_f0 = in_ptr;
-    for (int k = 0; k < 13 * 425; k++) {
-        for (int j = 0; j < 16; j++) {
-            if (j < 13) {
-                region_buf[k * 13 + j] = tmp_ptr_f0[k * 16 + j];
-            }
-        }
-    }
+    memory_invalidate_cache(in_ptr, yolo2_act_words(425, 13, 13) * sizeof(int16_t));
+    
+    act_to_chw(in_ptr, region_buf, 425, 13, 13);
     
     // Dequantize to float
     if (!ctx->region_output || ctx->region_output_size != (size_t)region_output_len) {
@@ -761,149 +963,326 @@ float* yolo2_get_region_output(yolo2_inference_context_t *ctx, int layer_idx, si
  * Run complete inference pipeline
  */
 int yolo2_run_inference(yolo2_inference_context_t *ctx, float *input_image) {
-    if (!ctx || !ctx->net || !input_image) {
+    if (!ctx || !ctx->net) {
         fprintf(stderr, "ERROR: Invalid context or input image\n");
         return -1;
     }
-    
-    network_t *net = ctx->net;
-    int TR, TC, TM, TN;
-    int output_w, output_h;
-    int mLoops;
-    uint64_t layer_time_us[32] = {0};
-    
-    YOLO2_LOG_INFO("\n[Inference Engine v%s]\n", INFERENCE_VERSION);
-    YOLO2_LOG_INFO("Starting inference through %d layers...\n", net->n);
-    
-    // Generate memory layout
+    return yolo2_run_inference_layers(ctx, input_image, 0, ctx->net->n - 1);
+}
+
+/**
+ * Run complete inference pipeline on a caller-owned frame
+ */
+int yolo2_run_inference_input(yolo2_inference_context_t *ctx, const yolo2_input_t *input) {
+    if (!ctx || !ctx->net) {
+        fprintf(stderr, "ERROR: Invalid context or input image\n");
+        return -1;
+    }
+    return yolo2_run_inference_input_layers(ctx, input, 0, ctx->net->n - 1);
+}
+
+/*
+ * Letterbox and quantize the caller's frame into the input buffer, or, with
+ * in_place, read it in place when it already is the network input in DMA
+ * memory. The memory layout (in_ptr) must be generated.
+ */
+static int quantize_frame(yolo2_inference_context_t *ctx, const yolo2_input_t *input, int in_place) {
+    if (!ctx->act_q || ctx->act_q_size == 0) {
+        fprintf(stderr, "ERROR: FP32 mode not supported in this implementation\n");
+        return -1;
+    }
+    const int q_in = ctx->act_q[0];
+    const size_t in_bytes = yolo2_act_words(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH) * sizeof(int16_t);
+    if (in_place && input->format == YOLO2_INPUT_ACT_Q16 && memory_is_dma(input->data, in_bytes)) {
+        YOLO2_LOG_INFO("Reading input in place at %p\n", input->data);
+        ctx->in_ptr[0] = (int16_t *)input->data;  // yolo2_input_quantize() then only checks it
+    } else {
+        YOLO2_LOG_INFO("Quantizing input with Q=%d\n", q_in);
+    }
+    if (yolo2_input_quantize(input, ctx->in_ptr[0], q_in) != 0) {
+        return -1;
+    }
+    memory_flush_cache(ctx->in_ptr[0], in_bytes);
+    return 0;
+}
+
+/**
+ * Quantize a frame into the input buffer for the next run
+ */
+int yolo2_inference_load_input(yolo2_inference_context_t *ctx, const yolo2_input_t *input) {
+    if (!ctx || !ctx->net || !input) {
+        fprintf(stderr, "ERROR: Invalid context or input image\n");
+        return -1;
+    }
+    const yolo2_accel_t *engine = ctx->accel ? ctx->accel : yolo2_accel_default();
+    if (!engine) {
+        fprintf(stderr, "ERROR: Accelerator not initialized\n");
+        return -1;
+    }
+    ctx->input_loaded = 0;
+    if (yolo2_inference_plan(ctx, engine) != 0 || yolo2_generate_iofm_offset(ctx) != 0) {
+        return -1;
+    }
+    if (quantize_frame(ctx, input, 0) != 0) {
+        return -1;
+    }
+    ctx->input_loaded = 1;
+    return 0;
+}
+
+/**
+ * Start a frame: memory layout, quantized input, per-frame offsets and Q state
+ */
+static int yolo2_begin_frame(yolo2_inference_context_t *ctx, const yolo2_input_t *input) {
+    // Generate memory layout (run_inference_layers() prepared the plan). The
+    // input buffer is always at offset 0, so a loaded frame stays in place.
     if (yolo2_generate_iofm_offset(ctx) != 0) {
         fprintf(stderr, "ERROR: Failed to generate IOFM offsets\n");
         return -1;
     }
     
-    // Quantize and copy input image
-    if (ctx->act_q && ctx->act_q_size > 0) {
-        const int q_in = ctx->act_q[0];
-        ctx->current_Qa = q_in;
-        YOLO2_LOG_INFO("Quantizing input with Q=%d\n", q_in);
-        yolo2_process_input_image(input_image, ctx->in_ptr[0], q_in);
-        memory_flush_cache(ctx->in_ptr[0], INPUT_ELEMS * sizeof(int16_t));
-    } else {
-        fprintf(stderr, "ERROR: FP32 mode not supported in this implementation\n");
+    if (input && quantize_frame(ctx, input, 1) != 0) {
+        ctx->input_loaded = 0;
         return -1;
     }
-    
+    ctx->input_loaded = 0;
+    ctx->current_Qa = ctx->act_q[0];
+
     // Reset offsets
     ctx->offset_index = 0;
     ctx->woffset = 0;
     ctx->boffset = 0;
     ctx->route24_q = 0;
     ctx->pending_route_q = -1;
+    memset(ctx->layer_time_us, 0, sizeof(ctx->layer_time_us));
+    return 0;
+}
+
+void yolo2_layer_tile(const yolo2_accel_t *engine, const layer_t *l, int *tr, int *tc)
+{
+    const int output_h = (l->type == LAYER_CONVOLUTIONAL) ? (l->h - l->size + 2 * l->pad) / l->stride + 1 : l->out_h;
+    const int output_w = (l->type == LAYER_CONVOLUTIONAL) ? (l->w - l->size + 2 * l->pad) / l->stride + 1 : l->out_w;
+    int TR = ((engine->ib_height - l->size) / l->stride + 1) < engine->tr ?
+             ((engine->ib_height - l->size) / l->stride + 1) : engine->tr;
+    int TC = ((engine->ib_width - l->size) / l->stride + 1) < engine->tc ?
+             ((engine->ib_width - l->size) / l->stride + 1) : engine->tc;
+    *tr = output_h < TR ? output_h : TR;
+    *tc = output_w < TC ? output_w : TC;
+}
+
+/**
+ * Run a layer range of one frame
+ */
+int yolo2_run_inference_layers(yolo2_inference_context_t *ctx, float *input_image, int first, int last) {
+    const yolo2_input_t input = yolo2_input_chw(input_image);
+    return yolo2_run_inference_input_layers(ctx, input_image ? &input : NULL, first, last);
+}
+
+/**
+ * Run a layer range of one frame given by an input descriptor
+ */
+int yolo2_run_inference_input_layers(yolo2_inference_context_t *ctx, const yolo2_input_t *input,
+                                     int first, int last) {
+    if (!ctx || !ctx->net || (first == 0 && !input && !ctx->input_loaded)) {
+        fprintf(stderr, "ERROR: Invalid context or input image\n");
+        return -1;
+    }
+    if (first < 0 || last >= ctx->net->n || first > last) {
+        fprintf(stderr, "ERROR: Invalid layer range %d..%d\n", first, last);
+        return -1;
+    }
     
-    // Run through all layers
-    for (int i = 0; i < net->n; ++i) {
-        layer_t *l = &net->layers[i];
+    network_t *net = ctx->net;
+    const yolo2_accel_t *engine = ctx->accel ? ctx->accel : yolo2_accel_default();
+    if (!engine) {
+        fprintf(stderr, "ERROR: Accelerator not initialized\n");
+        return -1;
+    }
+    if (yolo2_inference_plan(ctx, engine) != 0) {
+        return -1;
+    }
+    const int full_run = (first == 0 && last == net->n - 1);
+    uint64_t *layer_time_us = ctx->layer_time_us;
+    
+    if (first == 0) {
+        YOLO2_LOG_INFO("\n[Inference Engine v%s]\n", INFERENCE_VERSION);
+        YOLO2_LOG_INFO("Starting inference through %d layers...\n", last + 1);
+        if (yolo2_begin_frame(ctx, input) != 0) {
+            return -1;
+        }
+    } else {
+        YOLO2_LOG_INFO("Continuing inference through layers %d..%d...\n", first, last);
+    }
+    
+    // Optional per-layer golden record/verify against the host model (full runs only)
+    // and tensor taps (YOLO2_TAP_DIR). Both see compact CHW, so blocked-layout
+    // tensors are unpacked into golden_buf first.
+    yolo2_golden_t *golden = NULL;
+    int16_t *golden_buf = NULL;
+    const int use_golden = full_run && yolo2_golden_env_enabled();
+    int taps = 0;
+    for (int i = first; i <= last && !taps; ++i) {
+        taps = yolo2_tensor_tap_enabled(i);
+    }
+    if (use_golden || taps) {
+        golden_buf = (int16_t *)malloc(yolo2_act_words(32, INPUT_HEIGHT, INPUT_WIDTH) * sizeof(int16_t));
+        if (!golden_buf) {
+            fprintf(stderr, "ERROR: Failed to allocate golden buffer\n");
+            return -1;
+        }
+    }
+    if (use_golden) {
+        act_to_chw(ctx->in_ptr[0], golden_buf, INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH);
+        golden = yolo2_golden_open_env(ctx->golden_model_key,
+                                       yolo2_hash64(0, golden_buf, INPUT_ELEMS * sizeof(int16_t)),
+                                       (int)sizeof(int16_t), 0);
+        if (!golden) {
+            free(golden_buf);
+            return -1;
+        }
+    }
+
+    // Run through the layer range
+    for (int i = first; i <= last; ++i) {
+        const yolo2_plan_layer_t *p = &ctx->plan->layers[i];
         const uint64_t layer_start_us = yolo2_now_us();
+        int TR = p->tr, TC = p->tc;
         
-        YOLO2_LOG_LAYER("  Processing Layer %d (Type: %d)...\n", i, l->type);
+        YOLO2_LOG_LAYER("  Processing Layer %d (Type: %d)...\n", i, net->layers[i].type);
         
-        switch (l->type) {
-            case LAYER_CONVOLUTIONAL: {
-                output_w = (l->w - l->size + 2 * l->pad) / l->stride + 1;
-                output_h = (l->h - l->size + 2 * l->pad) / l->stride + 1;
-                
-                TR = ((OnChipIB_Height - l->size) / l->stride + 1) < Tr ? 
-                     ((OnChipIB_Height - l->size) / l->stride + 1) : Tr;
-                TR = output_h < TR ? output_h : TR;
-                TC = ((OnChipIB_Width - l->size) / l->stride + 1) < Tc ? 
-                     ((OnChipIB_Width - l->size) / l->stride + 1) : Tc;
-                TC = output_w < TC ? output_w : TC;
-                TM = l->filters < Tm ? l->filters : Tm;
-                TN = l->c < Tn ? l->c : Tn;
-                mLoops = (int)ceil(((float)l->filters) / TM);
+        switch (p->type) {
+            case YOLO2_PLAN_CONV: {
+                yolo2_tuning_apply(ctx->tuning, i, &TR, &TC);
+                ctx->offset_index = p->conv_index;
+                if (p->weight_word_offset < ctx->weights_word_base) {
+                    fprintf(stderr, "ERROR: Layer %d: its weights precede this weight stream (word %ld)\n",
+                            i, ctx->weights_word_base);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
+                    return -1;
+                }
+                ctx->woffset = (int)(p->weight_word_offset - ctx->weights_word_base);
+                ctx->boffset = (int)p->beta_offset;
                 
                 int result = yolo2_inference_conv_layer(ctx, i,
-                    l->c, l->filters, l->size, l->stride,
-                    l->w, l->h, output_w, output_h, l->pad,
-                    (l->activation == ACT_LEAKY) ? 1 : 0,
-                    l->batch_normalize ? 1 : 0,
-                    TM, TN, TR, TC,
-                    (mLoops + 1) * TM, mLoops * TM, (mLoops + 1) * TM);
+                    p->ifm, p->ofm, p->ksize, p->stride,
+                    p->in_w, p->in_h, p->out_w, p->out_h, p->pad,
+                    p->is_nl, p->is_bn,
+                    p->tm, p->tn, TR, TC,
+                    p->ofm_num_bound, p->mloopsxtm, p->mloops_a1xtm);
                 
                 if (result != 0) {
                     fprintf(stderr, "ERROR: Conv layer %d failed\n", i);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
                     return -1;
                 }
                 
-                memory_invalidate_cache(ctx->out_ptr[i], output_w * output_h * l->filters * sizeof(int16_t));
+                memory_invalidate_cache(ctx->out_ptr[i], yolo2_act_words(p->ofm, p->out_h, p->out_w) * sizeof(int16_t));
                 break;
             }
-            case LAYER_MAXPOOL: {
-                output_w = l->out_w;
-                output_h = l->out_h;
-                
-                TR = ((OnChipIB_Height - l->size) / l->stride + 1) < Tr ? 
-                     ((OnChipIB_Height - l->size) / l->stride + 1) : Tr;
-                TC = ((OnChipIB_Width - l->size) / l->stride + 1) < Tc ? 
-                     ((OnChipIB_Width - l->size) / l->stride + 1) : Tc;
-                TR = output_h < TR ? output_h : TR;
-                TC = output_w < TC ? output_w : TC;
-                TM = Tm < Tn ? Tm : Tn;
-                TM = l->c < TM ? l->c : TM;
-                mLoops = (int)ceil(((float)l->c) / TM);
+            case YOLO2_PLAN_MAXPOOL: {
+                yolo2_tuning_apply(ctx->tuning, i, &TR, &TC);
                 
                 int result = yolo2_inference_maxpool_layer(ctx, i,
-                    l->c, l->size, l->stride,
-                    l->w, l->h, output_w, output_h, l->pad,
-                    TM, TR, TC,
-                    (mLoops + 2) * TM,    // OFM_num_bound
-                    mLoops * TM,          // mLoopsxTM
-                    (mLoops + 1) * TM);   // mLoops_a1xTM
+                    p->ifm, p->ksize, p->stride,
+                    p->in_w, p->in_h, p->out_w, p->out_h, p->pad,
+                    p->tm, TR, TC,
+                    p->ofm_num_bound, p->mloopsxtm, p->mloops_a1xtm);
                 
                 if (result != 0) {
                     fprintf(stderr, "ERROR: Maxpool layer %d failed\n", i);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
                     return -1;
                 }
                 
-                memory_invalidate_cache(ctx->out_ptr[i], output_w * output_h * l->c * sizeof(int16_t));
+                memory_invalidate_cache(ctx->out_ptr[i], yolo2_act_words(p->ofm, p->out_h, p->out_w) * sizeof(int16_t));
                 break;
             }
-            case LAYER_REORG: {
-                int result = yolo2_execute_reorg_layer(ctx, i, l->stride);
+            case YOLO2_PLAN_REORG: {
+                int result = yolo2_execute_reorg_layer(ctx, i, p->stride);
                 if (result != 0) {
                     fprintf(stderr, "ERROR: Reorg layer %d failed\n", i);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
                     return -1;
                 }
                 break;
             }
-            case LAYER_ROUTE: {
+            case YOLO2_PLAN_ROUTE: {
                 int result = yolo2_execute_route_layer(ctx, i);
                 if (result != 0) {
                     fprintf(stderr, "ERROR: Route layer %d failed\n", i);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
                     return -1;
                 }
                 break;
             }
-            case LAYER_REGION: {
+            case YOLO2_PLAN_REGION: {
                 int result = yolo2_execute_region_layer(ctx, i);
                 if (result != 0) {
                     fprintf(stderr, "ERROR: Region layer %d failed\n", i);
+                    yolo2_golden_discard(golden);
+                    free(golden_buf);
                     return -1;
                 }
                 break;
             }
             default:
-                YOLO2_LOG_LAYER("    Layer %d: UNKNOWN type %d (skipping)\n", i, l->type);
+                YOLO2_LOG_LAYER("    Layer %d: UNKNOWN type %d (skipping)\n", i, net->layers[i].type);
                 break;
         }
 
+        const int tap = taps && yolo2_tensor_tap_enabled(i);
+        if (golden || tap) {
+            int golden_c = 0, golden_h = 0, golden_w = 0;
+            int golden_type = -1;
+            if (p->type == YOLO2_PLAN_CONV || p->type == YOLO2_PLAN_MAXPOOL) {
+                golden_type = (p->type == YOLO2_PLAN_CONV) ? YOLO2_GOLDEN_CONV : YOLO2_GOLDEN_MAXPOOL;
+                golden_c = p->ofm;
+                golden_h = p->out_h;
+                golden_w = p->out_w;
+            } else if (p->type == YOLO2_PLAN_REORG) {
+                golden_type = YOLO2_GOLDEN_REORG;
+                golden_c = 256;
+                golden_h = 13;
+                golden_w = 13;
+            }
+            if (golden_type >= 0) {
+                memory_invalidate_cache(ctx->out_ptr[i],
+                                        yolo2_act_words(golden_c, golden_h, golden_w) * sizeof(int16_t));
+                act_to_chw(ctx->out_ptr[i], golden_buf, golden_c, golden_h, golden_w);
+                if (golden) {
+                    yolo2_golden_layer(golden, i, golden_type, golden_buf,
+                                       golden_c, golden_h, golden_w, golden_w, p->tm, TR, TC);
+                }
+                if (tap) {
+                    yolo2_tensor_tap(i, golden_type, YOLO2_TENSOR_I16, ctx->current_Qa, golden_buf,
+                                     golden_c, golden_h, golden_w, golden_w);
+                }
+            }
+        }
+
         const uint64_t layer_end_us = yolo2_now_us();
         layer_time_us[i] = (layer_end_us >= layer_start_us) ? (layer_end_us - layer_start_us) : 0;
         YOLO2_LOG_LAYER("    Layer %d runtime: %" PRIu64 " us (%.3f ms)\n",
                         i, layer_time_us[i], (double)layer_time_us[i] / 1000.0);
     }
 
-    yolo2_print_layer_latency_summary(net, layer_time_us);
+    if (full_run) {
+        yolo2_print_layer_latency_summary(net, layer_time_us);
+    }
+
+    free(golden_buf);
+    if (golden) {
+        const int golden_rc = yolo2_golden_close(golden);
+        if (golden_rc != -1) {
+            fprintf(stderr, "ERROR: Golden verification failed (first diverging layer %d)\n", golden_rc);
+            return -1;
+        }
+    }
     
     YOLO2_LOG_INFO("\nInference completed successfully!\n");
     return 0;
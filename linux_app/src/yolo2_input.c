@@ -0,0 +1,332 @@
+/**
+ * YOLOv2 input descriptors - letterbox straight from caller memory
+ *
+ * Same arithmetic as yolo2_letterbox_image(): a horizontal then a vertical
+ * bilinear pass, gray (0.5) padding. Only the two source rows an output row
+ * interpolates between are converted and resampled, so no full-frame float
+ * copy is made.
+ */
+
+#include "yolo2_input.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void (*emit_row_fn)(void *user, int y, const float *row, int new_w, int dx, int out_w);
+
+typedef struct {
+    const yolo2_input_t *in;
+    size_t stride;
+    int new_w;
+    int new_h;
+    float w_scale;
+    float *src;          // one source row, 3 planes of in->width
+    uint8_t *rgb;        // YUYV row converted to RGB24
+    float *mid[2];       // horizontally resampled rows, 3 planes of new_w
+    int mid_y[2];
+} row_cache_t;
+
+yolo2_input_t yolo2_input_chw(const float *chw)
+{
+    yolo2_input_t in;
+    memset(&in, 0, sizeof(in));
+    in.data = chw;
+    in.width = INPUT_WIDTH;
+    in.height = INPUT_HEIGHT;
+    in.format = YOLO2_INPUT_F32_CHW;
+    in.letterboxed = 1;
+    return in;
+}
+
+static int input_bpp(yolo2_input_format_t format)
+{
+    switch (format) {
+        case YOLO2_INPUT_RGB24:
+        case YOLO2_INPUT_BGR24:
+            return 3;
+        case YOLO2_INPUT_RGBX32:
+        case YOLO2_INPUT_BGRX32:
+            return 4;
+        case YOLO2_INPUT_YUYV:
+        case YOLO2_INPUT_ACT_Q16:
+            return 2;
+        case YOLO2_INPUT_F32_CHW:
+            return (int)sizeof(float);
+    }
+    return 0;
+}
+
+size_t yolo2_input_row_bytes(const yolo2_input_t *in)
+{
+    if (!in) {
+        return 0;
+    }
+    return in->stride ? in->stride : (size_t)in->width * (size_t)input_bpp(in->format);
+}
+
+static int input_check(const yolo2_input_t *in, int out_w, int out_h)
+{
+    if (!in || !in->data || in->width <= 0 || in->height <= 0 || input_bpp(in->format) == 0) {
+        fprintf(stderr, "ERROR: Invalid input descriptor\n");
+        return -1;
+    }
+    if (yolo2_input_row_bytes(in) < (size_t)in->width * (size_t)input_bpp(in->format)) {
+        fprintf(stderr, "ERROR: Input stride %zu is shorter than a %d-pixel row\n", in->stride, in->width);
+        return -1;
+    }
+    if (in->format == YOLO2_INPUT_YUYV && (in->width & 1)) {
+        fprintf(stderr, "ERROR: YUYV input needs an even width (got %d)\n", in->width);
+        return -1;
+    }
+    if ((in->letterboxed || in->format == YOLO2_INPUT_ACT_Q16) && (in->width != out_w || in->height != out_h)) {
+        fprintf(stderr, "ERROR: Letterboxed input is %dx%d, network input is %dx%d\n",
+                in->width, in->height, out_w, out_h);
+        return -1;
+    }
+    return 0;
+}
+
+// Source row y as 3 float planes of width in->width, values in [0, 1]
+static void load_row(row_cache_t *rc, int y)
+{
+    const yolo2_input_t *in = rc->in;
+    const int w = in->width;
+    const uint8_t *base = (const uint8_t *)in->data;
+    float *r = rc->src;
+    float *g = rc->src + w;
+    float *b = rc->src + 2 * w;
+
+    if (in->format == YOLO2_INPUT_F32_CHW) {
+        for (int k = 0; k < 3; ++k) {
+            memcpy(rc->src + (size_t)k * w, base + ((size_t)k * in->height + y) * rc->stride, (size_t)w * sizeof(float));
+        }
+        return;
+    }
+
+    const uint8_t *row = base + (size_t)y * rc->stride;
+    int bpp = input_bpp(in->format);
+    int ri = 0, bi = 2;
+    if (in->format == YOLO2_INPUT_YUYV) {
+        for (int x = 0; x < w; x += 2) {
+            yolo2_yuyv_pair_to_rgb24(row + (size_t)x * 2, rc->rgb + (size_t)x * 3);
+        }
+        row = rc->rgb;
+        bpp = 3;
+    } else if (in->format == YOLO2_INPUT_BGR24 || in->format == YOLO2_INPUT_BGRX32) {
+        ri = 2;
+        bi = 0;
+    }
+    for (int x = 0; x < w; ++x) {
+        const uint8_t *px = row + (size_t)x * bpp;
+        r[x] = (float)px[ri] / 255.0f;
+        g[x] = (float)px[1] / 255.0f;
+        b[x] = (float)px[bi] / 255.0f;
+    }
+}
+
+// Source row y resampled to new_w (yolo2_resize_image's first pass), cached
+static const float *mid_row(row_cache_t *rc, int y)
+{
+    for (int s = 0; s < 2; ++s) {
+        if (rc->mid_y[s] == y) {
+            return rc->mid[s];
+        }
+    }
+    // The rows are walked top to bottom: replace the older one
+    const int s = (rc->mid_y[0] < rc->mid_y[1]) ? 0 : 1;
+    const int in_w = rc->in->width;
+    const int new_w = rc->new_w;
+    load_row(rc, y);
+    for (int k = 0; k < 3; ++k) {
+        const float *in = rc->src + (size_t)k * in_w;
+        float *mid = rc->mid[s] + (size_t)k * new_w;
+        for (int c = 0; c < new_w; ++c) {
+            if (c == new_w - 1 || in_w == 1) {
+                mid[c] = in[in_w - 1];
+            } else {
+                const float sx = (float)c * rc->w_scale;
+                const int ix = (int)sx;
+                const float dx = sx - (float)ix;
+                mid[c] = (1.0f - dx) * in[ix] + dx * in[ix + 1];
+            }
+        }
+    }
+    rc->mid_y[s] = y;
+    return rc->mid[s];
+}
+
+static int letterbox_rows(const yolo2_input_t *in, int out_w, int out_h, emit_row_fn emit, void *user)
+{
+    if (input_check(in, out_w, out_h) != 0) {
+        return -1;
+    }
+    const int in_w = in->width;
+    const int in_h = in->height;
+    int new_w = in_w;
+    int new_h = in_h;
+    if (((float)out_w / (float)in_w) < ((float)out_h / (float)in_h)) {
+        new_w = out_w;
+        new_h = (in_h * out_w) / in_w;
+    } else {
+        new_h = out_h;
+        new_w = (in_w * out_h) / in_h;
+    }
+    const int dx = (out_w - new_w) / 2;
+    const int dy = (out_h - new_h) / 2;
+    const int identity = (new_w == in_w && new_h == in_h);
+
+    row_cache_t rc;
+    memset(&rc, 0, sizeof(rc));
+    rc.in = in;
+    rc.stride = yolo2_input_row_bytes(in);
+    rc.new_w = new_w;
+    rc.new_h = new_h;
+    rc.w_scale = (new_w > 1) ? (float)(in_w - 1) / (float)(new_w - 1) : 0.0f;
+    rc.mid_y[0] = rc.mid_y[1] = -1;
+    rc.src = (float *)malloc((size_t)in_w * 3 * sizeof(float));
+    rc.rgb = (uint8_t *)malloc((size_t)in_w * 3);
+    rc.mid[0] = (float *)malloc((size_t)new_w * 3 * sizeof(float));
+    rc.mid[1] = (float *)malloc((size_t)new_w * 3 * sizeof(float));
+    float *row = (float *)malloc((size_t)new_w * 3 * sizeof(float));
+    int rc_result = 0;
+    if (!rc.src || !rc.rgb || !rc.mid[0] || !rc.mid[1] || !row) {
+        fprintf(stderr, "ERROR: Failed to allocate input row buffers\n");
+        rc_result = -1;
+        goto done;
+    }
+
+    for (int y = 0; y < out_h; ++y) {
+        const int r = y - dy;
+        if (r < 0 || r >= new_h) {
+            emit(user, y, NULL, new_w, dx, out_w);
+            continue;
+        }
+        if (identity) {
+            load_row(&rc, r);
+            emit(user, y, rc.src, new_w, dx, out_w);
+            continue;
+        }
+        if (new_w == 1 || new_h == 1) {
+            // yolo2_resize_image(): degenerate sizes take the top-left pixel
+            load_row(&rc, 0);
+            for (int k = 0; k < 3; ++k) {
+                for (int c = 0; c < new_w; ++c) {
+                    row[(size_t)k * new_w + c] = rc.src[(size_t)k * in_w];
+                }
+            }
+            emit(user, y, row, new_w, dx, out_w);
+            continue;
+        }
+        const float h_scale = (float)(in_h - 1) / (float)(new_h - 1);
+        const float sy = (float)r * h_scale;
+        const int iy = (int)sy;
+        const float fy = sy - (float)iy;
+        const int last = (r == new_h - 1 || in_h == 1);
+        const float *m1 = last ? NULL : mid_row(&rc, iy + 1);
+        const float *m0 = mid_row(&rc, iy);
+        for (int c = 0; c < new_w * 3; ++c) {
+            float val = (1.0f - fy) * m0[c];
+            if (!last) {
+                val += fy * m1[c];
+            }
+            row[c] = val;
+        }
+        emit(user, y, row, new_w, dx, out_w);
+    }
+
+done:
+    free(row);
+    free(rc.mid[1]);
+    free(rc.mid[0]);
+    free(rc.rgb);
+    free(rc.src);
+    return rc_result;
+}
+
+typedef struct {
+    float *output;
+    int out_h;
+} float_sink_t;
+
+static void emit_float_row(void *user, int y, const float *row, int new_w, int dx, int out_w)
+{
+    const float_sink_t *sink = (const float_sink_t *)user;
+    for (int k = 0; k < 3; ++k) {
+        float *dst = sink->output + ((size_t)k * sink->out_h + y) * out_w;
+        for (int x = 0; x < out_w; ++x) {
+            const int c = x - dx;
+            dst[x] = (row && c >= 0 && c < new_w) ? row[(size_t)k * new_w + c] : 0.5f;
+        }
+    }
+}
+
+int yolo2_input_letterbox(const yolo2_input_t *in, float *output, int out_w, int out_h)
+{
+    if (!output || out_w <= 0 || out_h <= 0 || (in && in->format == YOLO2_INPUT_ACT_Q16)) {
+        fprintf(stderr, "ERROR: Invalid letterbox output\n");
+        return -1;
+    }
+    float_sink_t sink = {output, out_h};
+    return letterbox_rows(in, out_w, out_h, emit_float_row, &sink);
+}
+
+typedef struct {
+    int16_t *output;
+    double scale;
+} q16_sink_t;
+
+// yolo2_process_input_image() rounding
+static int16_t quantize_input(float value, double scale)
+{
+    double v = value * scale;
+    if (v > 32767.0) v = 32767.0;
+    if (v < -32768.0) v = -32768.0;
+    int64_t q = (int64_t)(v < 0 ? v - 0.5 : v + 0.5);
+    if (q > 32767) q = 32767;
+    if (q < -32768) q = -32768;
+    return (int16_t)q;
+}
+
+static void emit_q16_row(void *user, int y, const float *row, int new_w, int dx, int out_w)
+{
+    const q16_sink_t *sink = (const q16_sink_t *)user;
+    const int16_t pad = quantize_input(0.5f, sink->scale);
+    for (int k = 0; k < 3; ++k) {
+        for (int x = 0; x < out_w; ++x) {
+            const int c = x - dx;
+            sink->output[yolo2_act_index(k, y, x, INPUT_HEIGHT, INPUT_WIDTH)] =
+                (row && c >= 0 && c < new_w) ? quantize_input(row[(size_t)k * new_w + c], sink->scale) : pad;
+        }
+    }
+}
+
+int yolo2_input_quantize(const yolo2_input_t *in, int16_t *output, int32_t q_in)
+{
+    if (!output) {
+        fprintf(stderr, "ERROR: Invalid input buffer\n");
+        return -1;
+    }
+    if (in && in->format == YOLO2_INPUT_ACT_Q16) {
+        if (input_check(in, INPUT_WIDTH, INPUT_HEIGHT) != 0) {
+            return -1;
+        }
+        if (in->data != output) {
+            memcpy(output, in->data, yolo2_act_words(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH) * sizeof(int16_t));
+        }
+        return 0;
+    }
+
+    q16_sink_t sink;
+    if (q_in >= 0 && q_in <= 31) {
+        sink.scale = (double)(1ULL << (unsigned int)q_in);
+    } else if (q_in < 0 && q_in >= -31) {
+        sink.scale = 1.0 / (double)(1ULL << (unsigned int)(-q_in));
+    } else {
+        sink.scale = 1.0;
+    }
+    sink.output = output;
+    return letterbox_rows(in, INPUT_WIDTH, INPUT_HEIGHT, emit_q16_row, &sink);
+}
@@ -0,0 +1,407 @@
+/**
+ * YOLOv2 two-engine layer pipeline
+ */
+
+#include "yolo2_pipeline.h"
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "file_loader.h"
+#include "yolo2_act_layout.h"
+#include "yolo2_config.h"
+#include "yolo2_log.h"
+
+typedef struct {
+    yolo2_inference_context_t *ctx;
+    int first;
+    int last;
+    int result;
+} stage_job_t;
+
+static void *stage_b_thread(void *arg)
+{
+    stage_job_t *job = (stage_job_t *)arg;
+    job->result = yolo2_run_inference_layers(job->ctx, NULL, job->first, job->last);
+    return NULL;
+}
+
+// YOLO2_TWO_ENGINE="tm,tn,tr,tc"; any other value keeps the compiled tiling.
+// Only used when engine B has no capability block.
+static int parse_engine_b_tile(int tile[4])
+{
+    const char *env = getenv("YOLO2_TWO_ENGINE");
+    tile[0] = Tm;
+    tile[1] = Tn;
+    tile[2] = Tr;
+    tile[3] = Tc;
+    if (!env || !strchr(env, ',')) {
+        return 0;
+    }
+    if (sscanf(env, "%d,%d,%d,%d", &tile[0], &tile[1], &tile[2], &tile[3]) != 4 ||
+        tile[0] <= 0 || tile[1] <= 0 || tile[2] <= 0 || tile[3] <= 0) {
+        fprintf(stderr, "ERROR: YOLO2_TWO_ENGINE must be 1 or tm,tn,tr,tc (got '%s')\n", env);
+        return -1;
+    }
+    return 0;
+}
+
+// Slot shares the primary's weights, bias, Q tables and network.
+static void init_slot(yolo2_inference_context_t *slot, const yolo2_inference_context_t *primary)
+{
+    yolo2_inference_init(slot);
+    slot->weights_buf = primary->weights_buf;
+    slot->bias_buf = primary->bias_buf;
+    slot->weight_q = primary->weight_q;
+    slot->bias_q = primary->bias_q;
+    slot->act_q = primary->act_q;
+    slot->weight_q_size = primary->weight_q_size;
+    slot->bias_q_size = primary->bias_q_size;
+    slot->act_q_size = primary->act_q_size;
+    slot->weight_bits = primary->weight_bits;
+    slot->weight_bits_size = primary->weight_bits_size;
+    slot->net = primary->net;
+}
+
+// Point a slot at engine A, or at engine B and the weight stream it reads.
+static void use_engine(yolo2_pipeline_t *p, yolo2_inference_context_t *slot, int engine_b)
+{
+    slot->accel = engine_b ? &p->engine_b : NULL;
+    if (engine_b && p->weights_b.ptr) {
+        slot->weights_buf = p->weights_b;
+        slot->weights_word_base = p->weights_b_base;
+    } else {
+        slot->weights_buf = p->primary->weights_buf;
+        slot->weights_word_base = 0;
+    }
+}
+
+// Engine B with another Tm/Tn reads the stage-B stream that yolov2_weight_gen
+// --engine-b reorganized for it: weights_reorg_int16_b.bin, described by
+// engine_b_tiling.bin {tm, tn, first conv}. It starts at that conv, so engine
+// B cannot run the layers before it (b_first).
+static int load_engine_b_weights(yolo2_pipeline_t *p, const char *weights_dir)
+{
+    char path[PATH_MAX];
+    int32_t *tiling = NULL;
+    size_t count = 0;
+    snprintf(path, sizeof(path), "%s/engine_b_tiling.bin", weights_dir);
+    if (load_q_values(path, &tiling, &count) != 0 || count < 3 ||
+        tiling[0] != p->engine_b.tm || tiling[1] != p->engine_b.tn) {
+        fprintf(stderr, "ERROR: Engine B has Tm=%d Tn=%d and needs its own weight stream; regenerate the weights "
+                "with yolov2_weight_gen --engine-b %d,%d[,split]\n",
+                p->engine_b.tm, p->engine_b.tn, p->engine_b.tm, p->engine_b.tn);
+        free(tiling);
+        return -1;
+    }
+    const int first_conv = tiling[2];
+    free(tiling);
+
+    // Engine B's plan gives the stream's first word.
+    yolo2_inference_context_t *slot = &p->slot[0];
+    if (yolo2_inference_plan(slot, &p->engine_b) != 0) {
+        return -1;
+    }
+    long base = -1;
+    p->b_first = 0;
+    for (int i = 0; i < slot->plan->n && base < 0; ++i) {
+        const yolo2_plan_layer_t *l = &slot->plan->layers[i];
+        if (l->type != YOLO2_PLAN_CONV) {
+            continue;
+        }
+        if (l->conv_index < first_conv) {
+            p->b_first = i + 1;
+        } else {
+            base = l->weight_word_offset;
+        }
+    }
+    if (base < 0) {
+        fprintf(stderr, "ERROR: engine_b_tiling.bin starts at conv %d, past the last conv layer\n", first_conv);
+        return -1;
+    }
+
+    void *data = NULL;
+    size_t size = 0;
+    snprintf(path, sizeof(path), "%s/weights_reorg_int16_b.bin", weights_dir);
+    if (load_weights(path, &data, &size) != 0) {
+        fprintf(stderr, "ERROR: Failed to load engine B weights from %s\n", path);
+        return -1;
+    }
+    if (memory_allocate_weights(size, &p->weights_b) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate engine B weights buffer\n");
+        free(data);
+        return -1;
+    }
+    // Bytewise, as main.c copies the primary weights into the uncached buffer
+    volatile char *dst = (volatile char *)p->weights_b.ptr;
+    const char *src = (const char *)data;
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = src[i];
+    }
+    __sync_synchronize();
+    memory_flush_cache(p->weights_b.ptr, size);
+    free(data);
+    p->weights_b_base = base;
+    YOLO2_LOG_INFO("Two-engine pipeline: engine B weights %s (%zu bytes, conv %d.. from layer %d)\n",
+                   path, size, first_conv, p->b_first);
+    return 0;
+}
+
+static int publish_region(yolo2_pipeline_t *p, const yolo2_inference_context_t *slot)
+{
+    yolo2_inference_context_t *dst = p->primary;
+    if (!slot->region_output || slot->region_layer_idx < 0) {
+        dst->region_layer_idx = -1;
+        return 0;
+    }
+    if (dst->region_output_size != slot->region_output_size) {
+        free(dst->region_output);
+        dst->region_output = (float *)malloc(slot->region_output_size * sizeof(float));
+        if (!dst->region_output) {
+            fprintf(stderr, "ERROR: Failed to allocate region output\n");
+            dst->region_output_size = 0;
+            dst->region_layer_idx = -1;
+            return -1;
+        }
+        dst->region_output_size = slot->region_output_size;
+    }
+    memcpy(dst->region_output, slot->region_output, slot->region_output_size * sizeof(float));
+    dst->region_layer_idx = slot->region_layer_idx;
+    return 0;
+}
+
+// Split that minimizes the slower stage, from per-layer times on A and B.
+// Engine B runs layers from b_first on, so the split is at least b_first - 1.
+static int choose_split(const uint64_t *a_us, const uint64_t *b_us, int n, int b_first)
+{
+    const int min_split = b_first > 0 ? b_first - 1 : 0;
+    const char *env = getenv("YOLO2_ENGINE_SPLIT");
+    if (env && env[0]) {
+        const int forced = atoi(env);
+        if (forced >= min_split && forced < n - 1) {
+            return forced;
+        }
+        fprintf(stderr, "WARNING: YOLO2_ENGINE_SPLIT=%s out of range %d..%d, choosing automatically\n", env,
+                min_split, n - 2);
+    }
+
+    uint64_t total_b = 0;
+    for (int i = 0; i < n; ++i) {
+        total_b += b_us[i];
+    }
+    int best = -1;
+    uint64_t best_interval = 0;
+    uint64_t prefix_a = 0, suffix_b = total_b;
+    for (int k = 0; k + 1 < n; ++k) {
+        prefix_a += a_us[k];
+        suffix_b -= b_us[k];
+        const uint64_t interval = prefix_a > suffix_b ? prefix_a : suffix_b;
+        if (k >= min_split && (best < 0 || interval < best_interval)) {
+            best = k;
+            best_interval = interval;
+        }
+    }
+    return best;
+}
+
+/**
+ * Open engine B, allocate the second frame slot and load engine B's weights
+ */
+int yolo2_pipeline_init(yolo2_pipeline_t *p, yolo2_inference_context_t *primary, const char *weights_dir)
+{
+    memset(p, 0, sizeof(*p));
+    p->split = -1;
+    if (!primary || !primary->net || !primary->inference_buf.ptr) {
+        fprintf(stderr, "ERROR: Pipeline needs an initialized inference context\n");
+        return -1;
+    }
+    if (primary->net->n > 32) {
+        fprintf(stderr, "ERROR: Pipeline supports at most 32 layers\n");
+        return -1;
+    }
+    p->primary = primary;
+
+    int tile[4];
+    if (parse_engine_b_tile(tile) != 0) {
+        return -1;
+    }
+    if (yolo2_accel_open_instance(&p->engine_b, 1, tile[0], tile[1], tile[2], tile[3]) != YOLO2_SUCCESS) {
+        fprintf(stderr, "ERROR: Failed to open engine B (instance 1)\n");
+        return -1;
+    }
+
+    // Slot 0 reuses the primary activation buffer; slot 1 gets its own.
+    init_slot(&p->slot[0], primary);
+    p->slot[0].inference_buf = primary->inference_buf;
+    init_slot(&p->slot[1], primary);
+    if (memory_allocate_inference_buffer(&p->slot[1].inference_buf) != 0) {
+        fprintf(stderr, "ERROR: Failed to allocate second inference buffer\n");
+        yolo2_pipeline_cleanup(p);
+        return -1;
+    }
+
+    // The primary weights are reorganized for engine A's Tm/Tn
+    const yolo2_accel_t *def = yolo2_accel_default();
+    if ((p->engine_b.tm != def->tm || p->engine_b.tn != def->tn) && load_engine_b_weights(p, weights_dir) != 0) {
+        yolo2_pipeline_cleanup(p);
+        return -1;
+    }
+
+    const yolo2_accel_t *a = yolo2_accel_default();
+    const yolo2_accel_t *b = &p->engine_b;
+    YOLO2_LOG_INFO("Two-engine pipeline: engine A Tm=%d Tn=%d Tr=%d Tc=%d, engine B Tm=%d Tn=%d Tr=%d Tc=%d\n",
+                   a->tm, a->tn, a->tr, a->tc, b->tm, b->tn, b->tr, b->tc);
+    return 0;
+}
+
+// First frame: whole network on A, then on B (from b_first), to time every
+// layer on both. With a NULL input the frame was loaded; the second pass
+// re-reads its measure_input copy.
+static int measure_and_split(yolo2_pipeline_t *p, const yolo2_input_t *input)
+{
+    yolo2_inference_context_t *slot = &p->slot[0];
+    const int n = p->primary->net->n;
+    uint64_t a_us[32], b_us[32] = {0};
+    const yolo2_input_t loaded = {p->measure_input, INPUT_WIDTH, INPUT_HEIGHT, 0, YOLO2_INPUT_ACT_Q16, 1};
+    const yolo2_input_t *frame = input ? input : &loaded;
+
+    use_engine(p, slot, 0);
+    if (yolo2_run_inference_input_layers(slot, input, 0, n - 1) != 0) {
+        return -1;
+    }
+    memcpy(a_us, slot->layer_time_us, sizeof(a_us));
+
+    // Engine B lacks the weights before b_first: A runs those layers again.
+    int result_b = 0;
+    if (p->b_first > 0) {
+        result_b = yolo2_run_inference_input_layers(slot, frame, 0, p->b_first - 1);
+    }
+    if (result_b == 0) {
+        use_engine(p, slot, 1);
+        result_b = yolo2_run_inference_input_layers(slot, p->b_first > 0 ? NULL : frame, p->b_first, n - 1);
+    }
+    free(p->measure_input);
+    p->measure_input = NULL;
+    if (result_b != 0) {
+        return -1;
+    }
+    for (int i = p->b_first; i < n; ++i) {
+        b_us[i] = slot->layer_time_us[i];
+    }
+
+    p->split = choose_split(a_us, b_us, n, p->b_first);
+    uint64_t stage_a = 0, stage_b = 0;
+    for (int i = 0; i < n; ++i) {
+        if (i <= p->split) {
+            stage_a += a_us[i];
+        } else {
+            stage_b += b_us[i];
+        }
+    }
+    YOLO2_LOG_INFO("Two-engine pipeline: split after layer %d, stage A %.2f ms, stage B %.2f ms\n",
+                   p->split, (double)stage_a / 1000.0, (double)stage_b / 1000.0);
+    return publish_region(p, slot);
+}
+
+/**
+ * Quantize a frame into the slot of the next step
+ */
+int yolo2_pipeline_load_input(yolo2_pipeline_t *p, const yolo2_input_t *input)
+{
+    if (!p || !p->primary || !input) {
+        fprintf(stderr, "ERROR: Invalid pipeline or input image\n");
+        return -1;
+    }
+    yolo2_inference_context_t *slot = &p->slot[p->split < 0 ? 0 : p->next_slot];
+    use_engine(p, slot, 0);
+    if (yolo2_inference_load_input(slot, input) != 0) {
+        return -1;
+    }
+    if (p->split < 0) {
+        // Engine A's run overwrites the input buffer before B measures it
+        const size_t in_bytes = yolo2_act_words(INPUT_CHANNELS, INPUT_HEIGHT, INPUT_WIDTH) * sizeof(int16_t);
+        free(p->measure_input);
+        p->measure_input = (int16_t *)malloc(in_bytes);
+        if (!p->measure_input) {
+            fprintf(stderr, "ERROR: Failed to allocate the measurement input\n");
+            slot->input_loaded = 0;
+            return -1;
+        }
+        memcpy(p->measure_input, slot->in_ptr[0], in_bytes);
+    }
+    return 0;
+}
+
+/**
+ * Feed one frame
+ */
+int yolo2_pipeline_step(yolo2_pipeline_t *p, const yolo2_input_t *input)
+{
+    if (!p || !p->primary || (!input && !p->slot[p->split < 0 ? 0 : p->next_slot].input_loaded)) {
+        fprintf(stderr, "ERROR: Invalid pipeline or input image\n");
+        return -1;
+    }
+    if (p->split < 0) {
+        return measure_and_split(p, input) == 0 ? 1 : -1;
+    }
+
+    const int n = p->primary->net->n;
+    yolo2_inference_context_t *cur = &p->slot[p->next_slot];
+    yolo2_inference_context_t *prev = &p->slot[p->next_slot ^ 1];
+    stage_job_t job = {prev, p->split + 1, n - 1, 0};
+    pthread_t thread;
+    int started = 0;
+
+    if (p->pending) {
+        use_engine(p, prev, 1);
+        if (pthread_create(&thread, NULL, stage_b_thread, &job) != 0) {
+            fprintf(stderr, "ERROR: Failed to start stage B thread\n");
+            return -1;
+        }
+        started = 1;
+    }
+
+    use_engine(p, cur, 0);
+    const int result_a = yolo2_run_inference_input_layers(cur, input, 0, p->split);
+
+    if (started) {
+        pthread_join(thread, NULL);
+    }
+    if (result_a != 0 || (started && job.result != 0)) {
+        p->pending = 0;
+        return -1;
+    }
+
+    p->next_slot ^= 1;
+    p->pending = 1;
+    if (!started) {
+        return 0;
+    }
+    return publish_region(p, prev) == 0 ? 1 : -1;
+}
+
+/**
+ * Close engine B and free the frame slots
+ */
+void yolo2_pipeline_cleanup(yolo2_pipeline_t *p)
+{
+    if (!p) {
+        return;
+    }
+    if (p->slot[1].inference_buf.ptr) {
+        memory_free_ddr(&p->slot[1].inference_buf);
+    }
+    for (int s = 0; s < 2; ++s) {
+        free(p->slot[s].region_output);
+    }
+    free(p->measure_input);
+    if (p->weights_b.ptr) {
+        memory_free_ddr(&p->weights_b);
+    }
+    yolo2_accel_close(&p->engine_b);
+    memset(p, 0, sizeof(*p));
+    p->split = -1;
+}
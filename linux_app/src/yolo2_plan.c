@@ -0,0 +1,245 @@
+/**
+ * YOLOv2 layer plan
+ */
+
+#include "yolo2_plan.h"
+
+#include <stddef.h>
+
+#include "yolo2_act_layout.h"
+#include "yolo2_requant.h"
+
+#ifdef ACT_BLOCKED_LAYOUT
+#define PLAN_ACT_BLOCKED 1
+#else
+#define PLAN_ACT_BLOCKED 0
+#endif
+
+// Fixed tensors of the YOLOv2 memory layout (ModelConfig in model_config.cpp)
+#define ROUTE16_LEN ((long)yolo2_act_words(512, 26, 26))
+#define CONV27_LEN ((long)yolo2_act_words(256, 13, 13))
+#define CONV24_LEN ((long)yolo2_act_words(1024, 13, 13))
+#define DETECTION_WORKSPACE (3L * 13 * 425)
+
+// 16-bit words a conv layer occupies in weights_reorg_int16.bin (matches
+// yolo2_weight_words() in model_config.hpp)
+static long plan_weight_words(long count, int weight_bits_word)
+{
+    const int weight_bits = yolo2_wbits_precision(weight_bits_word);
+    const long words = (weight_bits == 8) ? (count + 1) / 2 : (weight_bits == 4) ? 16 + (count + 3) / 4 : count;
+    return words + (words & 0x1);
+}
+
+static int min_int(int a, int b)
+{
+    return a < b ? a : b;
+}
+
+// Spatial tile: as many output rows/columns as the on-chip input buffer holds
+static void plan_tile(const yolo2_plan_t *plan, yolo2_plan_layer_t *l)
+{
+    l->tr = min_int(min_int((plan->ib_height - l->ksize) / l->stride + 1, plan->tr), l->out_h);
+    l->tc = min_int(min_int((plan->ib_width - l->ksize) / l->stride + 1, plan->tc), l->out_w);
+}
+
+// Ping-pong activation layout; the route-16, conv-24 and conv-27 outputs stay
+// at the bottom of the buffer until the route layers read them.
+static void plan_buffers(yolo2_plan_t *plan)
+{
+    yolo2_plan_layer_t *L = plan->layers;
+    const long bottom = plan->mem_len;
+    const int n = plan->n;
+
+    for (int x = 0; x < n; ++x) {
+        L[x].in_offset = YOLO2_PLAN_NONE;
+        L[x].out_offset = YOLO2_PLAN_NONE;
+    }
+    for (int x = 0; x < 25 && x < n; ++x) {
+        if (x % 2 == 0) {
+            const long reserved = (x < 18) ? 0 : ROUTE16_LEN;
+            L[x].in_offset = 0;
+            L[x].out_offset = bottom - reserved - (long)yolo2_act_words(L[x].ofm, L[x].out_h, L[x].out_w);
+        } else {
+            L[x].in_offset = L[x - 1].out_offset;
+            L[x].out_offset = 0;
+        }
+    }
+    if (26 < n) {
+        L[26].in_offset = bottom - ROUTE16_LEN;
+        L[26].out_offset = 0;
+    }
+    if (27 < n) {
+        L[27].in_offset = 0;
+        L[27].out_offset = bottom - ROUTE16_LEN - CONV24_LEN - CONV27_LEN;
+    }
+    if (29 < n) {
+        L[29].in_offset = L[27].out_offset;
+        L[29].out_offset = 0;
+    }
+    if (30 < n) {
+        L[30].in_offset = 0;
+        L[30].out_offset = bottom - ((long)L[30].ofm * L[30].out_h * L[30].out_w + DETECTION_WORKSPACE);
+    }
+    if (31 < n) {
+        L[31].in_offset = L[30].out_offset;
+    }
+}
+
+int yolo2_plan_build(yolo2_plan_t *plan, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                     const int32_t *weight_bits, int weight_bits_count, long mem_len)
+{
+    if (plan->n < 1 || plan->n > YOLO2_PLAN_MAX_LAYERS) {
+        fprintf(stderr, "ERROR: Layer plan supports 1..%d layers (got %d)\n", YOLO2_PLAN_MAX_LAYERS, plan->n);
+        return -1;
+    }
+    plan->tm = tm;
+    plan->tn = tn;
+    plan->tr = tr;
+    plan->tc = tc;
+    plan->ib_height = ib_height;
+    plan->ib_width = ib_width;
+    plan->act_blocked = PLAN_ACT_BLOCKED;
+    plan->mem_len = mem_len;
+
+    int conv_index = 0;
+    long woffset = 0, wword_offset = 0, boffset = 0;
+    for (int i = 0; i < plan->n; ++i) {
+        yolo2_plan_layer_t *l = &plan->layers[i];
+        l->tm = l->tn = l->tr = l->tc = 0;
+        l->ofm_num_bound = l->mloopsxtm = l->mloops_a1xtm = 0;
+        l->conv_index = -1;
+        l->weight_bits = 0;
+        l->weight_offset = l->weight_word_offset = l->beta_offset = 0;
+        l->route_conv = -1;
+
+        switch (l->type) {
+            case YOLO2_PLAN_CONV: {
+                l->out_w = (l->in_w - l->ksize + 2 * l->pad) / l->stride + 1;
+                l->out_h = (l->in_h - l->ksize + 2 * l->pad) / l->stride + 1;
+                plan_tile(plan, l);
+                l->tm = min_int(l->ofm, tm);
+                l->tn = min_int(l->ifm, tn);
+                const int loops = (l->ofm + l->tm - 1) / l->tm;
+                l->ofm_num_bound = (loops + 1) * l->tm;
+                l->mloopsxtm = loops * l->tm;
+                l->mloops_a1xtm = (loops + 1) * l->tm;
+
+                const int bits = (weight_bits && conv_index < weight_bits_count) ? weight_bits[conv_index] : 16;
+                const int prec = yolo2_wbits_precision(bits);
+                if ((prec != 4 && prec != 8 && prec != 16) || (bits & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT))) {
+                    fprintf(stderr, "ERROR: Layer plan: invalid weight bits %d for conv %d\n", bits, conv_index);
+                    return -1;
+                }
+                const long count = (long)l->ifm * l->ofm * l->ksize * l->ksize;
+                l->conv_index = conv_index++;
+                l->weight_bits = bits;
+                l->weight_offset = woffset;
+                l->weight_word_offset = wword_offset;
+                l->beta_offset = boffset;
+                woffset += count;
+                wword_offset += plan_weight_words(count, bits);
+                boffset += (long)l->ofm * yolo2_beta_words(bits);
+                break;
+            }
+            case YOLO2_PLAN_MAXPOOL: {
+                plan_tile(plan, l);
+                l->ofm = l->ifm;
+                l->tm = min_int(min_int(tm, tn), l->ifm);
+                const int loops = (l->ifm + l->tm - 1) / l->tm;
+                l->ofm_num_bound = (loops + 2) * l->tm;
+                l->mloopsxtm = loops * l->tm;
+                l->mloops_a1xtm = (loops + 1) * l->tm;
+                break;
+            }
+            case YOLO2_PLAN_REORG:
+                // Runs on the CPU; the tile is only reported to the golden store
+                l->tm = tm;
+                l->tr = tr;
+                l->tc = tc;
+                break;
+            case YOLO2_PLAN_ROUTE:
+                if (l->route_layer >= 0) {
+                    for (int k = 0; k <= l->route_layer && k < i; ++k) {
+                        if (plan->layers[k].type == YOLO2_PLAN_CONV) {
+                            l->route_conv = plan->layers[k].conv_index;
+                        }
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    plan_buffers(plan);
+    return 0;
+}
+
+int yolo2_plan_check(const yolo2_plan_t *plan, int tm, int tn, int tr, int tc, int ib_height, int ib_width,
+                     const int32_t *weight_bits, int weight_bits_count)
+{
+    if (plan->tm != tm || plan->tn != tn || plan->tr != tr || plan->tc != tc ||
+        plan->ib_height != ib_height || plan->ib_width != ib_width) {
+        fprintf(stderr, "ERROR: Layer plan built for Tm=%d Tn=%d Tr=%d Tc=%d IB=%dx%d, "
+                "accelerator has Tm=%d Tn=%d Tr=%d Tc=%d IB=%dx%d\n",
+                plan->tm, plan->tn, plan->tr, plan->tc, plan->ib_height, plan->ib_width,
+                tm, tn, tr, tc, ib_height, ib_width);
+        return -1;
+    }
+    if (plan->act_blocked != PLAN_ACT_BLOCKED) {
+        fprintf(stderr, "ERROR: Layer plan built for the %s activation layout\n", plan->act_blocked ? "blocked" : "CHW");
+        return -1;
+    }
+    for (int i = 0; i < plan->n; ++i) {
+        const yolo2_plan_layer_t *l = &plan->layers[i];
+        if (l->type != YOLO2_PLAN_CONV) {
+            continue;
+        }
+        const int bits = (weight_bits && l->conv_index < weight_bits_count) ? weight_bits[l->conv_index] : 16;
+        if (bits != l->weight_bits) {
+            fprintf(stderr, "ERROR: Layer plan built for weight bits 0x%x in conv %d, weights are 0x%x\n",
+                    l->weight_bits, l->conv_index, bits);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void yolo2_plan_strip_requant(yolo2_plan_t *plan)
+{
+    long boffset = 0;
+    for (int i = 0; i < plan->n; ++i) {
+        yolo2_plan_layer_t *l = &plan->layers[i];
+        if (l->type != YOLO2_PLAN_CONV) {
+            continue;
+        }
+        l->weight_bits = yolo2_wbits_precision(l->weight_bits);
+        l->beta_offset = boffset;
+        boffset += l->ofm;
+    }
+}
+
+int yolo2_plan_write(FILE *fp, const yolo2_plan_t *plan, const char *source)
+{
+    static const char *const names[] = {"conv", "maxpool", "reorg", "route", "region", "other"};
+
+    fprintf(fp, "/* Auto-generated layer plan. Do not edit by hand.\n"
+                " * Generated by yolov2_plan_gen from %s; included by yolo2_plan.h\n"
+                " * with YOLO2_STATIC_PLAN. Field order: yolo2_plan_t and yolo2_plan_layer_t. */\n\n", source);
+    fprintf(fp, "YOLO2_PLAN_STORAGE yolo2_plan_t yolo2_static_plan = {\n");
+    fprintf(fp, "    %d,\n    %d, %d, %d, %d,\n    %d, %d,\n    %d,\n    %ld,\n    {\n",
+            plan->n, plan->tm, plan->tn, plan->tr, plan->tc, plan->ib_height, plan->ib_width,
+            plan->act_blocked, plan->mem_len);
+    for (int i = 0; i < plan->n; ++i) {
+        const yolo2_plan_layer_t *l = &plan->layers[i];
+        const int kind = (l->type >= 0 && l->type <= YOLO2_PLAN_OTHER) ? l->type : YOLO2_PLAN_OTHER;
+        fprintf(fp, "        /* %2d %-7s */ {%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, "
+                    "%d, %d, %d, %d, %d, %d, %d, %d, %d, %ldL, %ldL, %ldL, %d, %ldL, %ldL},\n",
+                i, names[kind], l->type, l->ifm, l->ofm, l->ksize, l->stride, l->pad,
+                l->in_w, l->in_h, l->out_w, l->out_h, l->is_nl, l->is_bn, l->route_layer,
+                l->tm, l->tn, l->tr, l->tc, l->ofm_num_bound, l->mloopsxtm, l->mloops_a1xtm,
+                l->conv_index, l->weight_bits, l->weight_offset, l->weight_word_offset, l->beta_offset,
+                l->route_conv, l->in_offset, l->out_offset);
+    }
+    fprintf(fp, "    }\n};\n");
+    return ferror(fp) ? -1 : 0;
+}
@@ -0,0 +1,238 @@
+/**
+ * YOLOv2 tensor dumps - binary tensors for per-layer host/cosim/board debugging
+ *
+ * Shared by linux_app, the host model and the cosim testbench; keep this
+ * file valid C99 and C++ (the host build compiles it with g++).
+ */
+
+#include "yolo2_tensor.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define TENSOR_MAGIC "Y2T"
+#define TAP_MAX_LAYERS 64
+
+typedef char tensor_header_size_check[(sizeof(yolo2_tensor_header_t) == YOLO2_TENSOR_HEADER_SIZE) ? 1 : -1];
+
+static size_t tensor_elem_size(int dtype)
+{
+    return dtype == YOLO2_TENSOR_I16 ? sizeof(int16_t) : sizeof(float);
+}
+
+int yolo2_tensor_write(const char *path, int layer, int type, int dtype, int q,
+                       const void *data, int c, int h, int w, int row_stride)
+{
+    if (!path || !path[0] || !data || c <= 0 || h <= 0 || w <= 0 || row_stride < w ||
+        (dtype != YOLO2_TENSOR_F32 && dtype != YOLO2_TENSOR_I16)) {
+        fprintf(stderr, "ERROR: Invalid tensor dump request for %s\n", path ? path : "(null)");
+        return -1;
+    }
+
+    const size_t elem = tensor_elem_size(dtype);
+    yolo2_tensor_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TENSOR_MAGIC, 4);
+    hdr.version = YOLO2_TENSOR_VERSION;
+    hdr.dtype = (uint32_t)dtype;
+    hdr.q = dtype == YOLO2_TENSOR_I16 ? q : 0;
+    hdr.layer = layer;
+    hdr.type = type;
+    hdr.c = (uint32_t)c;
+    hdr.h = (uint32_t)h;
+    hdr.w = (uint32_t)w;
+    hdr.data_offset = YOLO2_TENSOR_HEADER_SIZE;
+    hdr.data_bytes = (uint64_t)c * h * w * elem;
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot write tensor %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+    if (ok && row_stride == w) {
+        ok = fwrite(data, elem, (size_t)c * h * w, fp) == (size_t)c * h * w;
+    } else {
+        const uint8_t *row = (const uint8_t *)data;
+        for (int r = 0; ok && r < c * h; ++r, row += (size_t)row_stride * elem) {
+            ok = fwrite(row, elem, (size_t)w, fp) == (size_t)w;
+        }
+    }
+    if (fclose(fp) != 0) {
+        ok = 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to write tensor %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int yolo2_tensor_dump_floats(const char *path, const float *data, size_t count)
+{
+    if (!path || !path[0] || !data || count == 0) {
+        return -1;
+    }
+
+    const size_t len = strlen(path);
+    if (len < 4 || strcmp(path + len - 4, ".txt") != 0) {
+        return yolo2_tensor_write(path, -1, -1, YOLO2_TENSOR_F32, 0, data, (int)count, 1, 1, 1);
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "ERROR: Cannot open dump file %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        fprintf(fp, "%.9g\n", data[i]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* YOLO2_TAP_DIR / YOLO2_TAP_LAYERS, read on first use */
+static struct {
+    int init;
+    int enabled;
+    char dir[PATH_MAX];
+    unsigned char layers[TAP_MAX_LAYERS];
+} g_tap;
+
+static void tap_init(void)
+{
+    g_tap.init = 1;
+    const char *dir = getenv("YOLO2_TAP_DIR");
+    if (!dir || !dir[0]) {
+        return;
+    }
+    snprintf(g_tap.dir, sizeof(g_tap.dir), "%s", dir);
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        fprintf(stderr, "ERROR: Cannot create tap dir %s: %s\n", dir, strerror(errno));
+        return;
+    }
+
+    const char *list = getenv("YOLO2_TAP_LAYERS");
+    if (!list || !list[0]) {
+        memset(g_tap.layers, 1, sizeof(g_tap.layers));
+    } else {
+        // Comma-separated layers and ranges: "0-5,30"
+        const char *s = list;
+        while (*s) {
+            char *end;
+            long lo = strtol(s, &end, 10);
+            long hi = lo;
+            if (end == s) {
+                fprintf(stderr, "WARNING: Invalid YOLO2_TAP_LAYERS='%s', tapping all layers\n", list);
+                memset(g_tap.layers, 1, sizeof(g_tap.layers));
+                break;
+            }
+            if (*end == '-') {
+                s = end + 1;
+                hi = strtol(s, &end, 10);
+                if (end == s) {
+                    hi = TAP_MAX_LAYERS - 1;
+                }
+            }
+            for (long i = lo < 0 ? 0 : lo; i <= hi && i < TAP_MAX_LAYERS; ++i) {
+                g_tap.layers[i] = 1;
+            }
+            if (*end != ',') {
+                break;
+            }
+            s = end + 1;
+        }
+    }
+    g_tap.enabled = 1;
+    printf("Tensor taps: writing layer outputs to %s\n", g_tap.dir);
+}
+
+int yolo2_tensor_tap_enabled(int layer)
+{
+    if (!g_tap.init) {
+        tap_init();
+    }
+    return g_tap.enabled && layer >= 0 && layer < TAP_MAX_LAYERS && g_tap.layers[layer];
+}
+
+int yolo2_tensor_tap(int layer, int type, int dtype, int q,
+                     const void *data, int c, int h, int w, int row_stride)
+{
+    if (!yolo2_tensor_tap_enabled(layer)) {
+        return 0;
+    }
+    char path[PATH_MAX + 32];
+    snprintf(path, sizeof(path), "%s/layer_%02d.y2t", g_tap.dir, layer);
+    return yolo2_tensor_write(path, layer, type, dtype, q, data, c, h, w, row_stride);
+}
+
+int yolo2_tensor_map(const char *path, yolo2_tensor_file_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Cannot open tensor %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < YOLO2_TENSOR_HEADER_SIZE) {
+        fprintf(stderr, "ERROR: %s is not a tensor file\n", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Cannot map tensor %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    const yolo2_tensor_header_t *hdr = (const yolo2_tensor_header_t *)map;
+    const size_t count = (size_t)hdr->c * hdr->h * hdr->w;
+    if (memcmp(hdr->magic, TENSOR_MAGIC, 4) != 0 || hdr->version != YOLO2_TENSOR_VERSION ||
+        (hdr->dtype != YOLO2_TENSOR_F32 && hdr->dtype != YOLO2_TENSOR_I16)) {
+        fprintf(stderr, "ERROR: %s is not a v%d tensor file\n", path, YOLO2_TENSOR_VERSION);
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+    if (hdr->data_bytes != count * tensor_elem_size((int)hdr->dtype) ||
+        hdr->data_offset + hdr->data_bytes > (uint64_t)st.st_size) {
+        fprintf(stderr, "ERROR: Tensor file %s is truncated or corrupt\n", path);
+        munmap(map, (size_t)st.st_size);
+        return -1;
+    }
+
+    f->hdr = hdr;
+    f->data = (const uint8_t *)map + hdr->data_offset;
+    f->count = count;
+    f->map = map;
+    f->map_size = (size_t)st.st_size;
+    return 0;
+}
+
+void yolo2_tensor_unmap(yolo2_tensor_file_t *f)
+{
+    if (f && f->map) {
+        munmap(f->map, f->map_size);
+    }
+    if (f) {
+        memset(f, 0, sizeof(*f));
+    }
+}
+
+double yolo2_tensor_value(const yolo2_tensor_file_t *f, size_t i)
+{
+    if (f->hdr->dtype == YOLO2_TENSOR_I16) {
+        return ldexp((double)((const int16_t *)f->data)[i], -f->hdr->q);
+    }
+    return (double)((const float *)f->data)[i];
+}
@@ -3,10 +3,13 @@
  */
 
 #include "yolo2_v4l2.h"
+#include "yolo2_input.h"
 #include "yolo2_log.h"
 
 #include <errno.h>
 #include <fcntl.h>
+#include <linux/dma-buf.h>
+#include <linux/dma-heap.h>
 #include <linux/videodev2.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -17,6 +20,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#define YOLO2_V4L2_NUM_BUFFERS 4
+
 #define STBI_NO_THREAD_LOCALS
 #include "stb_image.h"
 
@@ -41,6 +46,32 @@ const char *yolo2_v4l2_pixfmt_name(uint32_t pixfmt)
     }
 }
 
+const char *yolo2_v4l2_memory_name(yolo2_v4l2_memory_t memory)
+{
+    switch (memory) {
+        case YOLO2_V4L2_MEM_MMAP:
+            return "mmap";
+        case YOLO2_V4L2_MEM_USERPTR:
+            return "userptr";
+        case YOLO2_V4L2_MEM_DMABUF:
+            return "dmabuf";
+    }
+    return "unknown";
+}
+
+static uint32_t v4l2_memory(yolo2_v4l2_memory_t memory)
+{
+    switch (memory) {
+        case YOLO2_V4L2_MEM_USERPTR:
+            return V4L2_MEMORY_USERPTR;
+        case YOLO2_V4L2_MEM_DMABUF:
+            return V4L2_MEMORY_DMABUF;
+        case YOLO2_V4L2_MEM_MMAP:
+            break;
+    }
+    return V4L2_MEMORY_MMAP;
+}
+
 static int yolo2_try_set_format(
     yolo2_v4l2_camera_t *cam,
     int width,
@@ -66,9 +97,201 @@ static int yolo2_try_set_format(
     cam->width = (int)fmt.fmt.pix.width;
     cam->height = (int)fmt.fmt.pix.height;
     cam->pixfmt = fmt.fmt.pix.pixelformat;
+    cam->stride = fmt.fmt.pix.bytesperline ? fmt.fmt.pix.bytesperline : (size_t)cam->width * 2u;
+    cam->sizeimage = fmt.fmt.pix.sizeimage;
     return 0;
 }
 
+// Release the driver's buffer queue and everything backing it
+static void release_buffers(yolo2_v4l2_camera_t *cam)
+{
+    if (cam->buffers) {
+        struct v4l2_requestbuffers req;
+        memset(&req, 0, sizeof(req));
+        req.count = 0;
+        req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        req.memory = v4l2_memory(cam->memory);
+        if (cam->fd >= 0) {
+            (void)xioctl(cam->fd, VIDIOC_REQBUFS, &req);
+        }
+        for (unsigned int i = 0; i < cam->num_buffers; ++i) {
+            yolo2_v4l2_buf_t *b = &cam->buffers[i];
+            if (cam->memory != YOLO2_V4L2_MEM_USERPTR && b->start && b->start != MAP_FAILED) {
+                munmap(b->start, b->length);
+            }
+            if (b->dmabuf_fd >= 0) {
+                close(b->dmabuf_fd);
+            }
+        }
+        free(cam->buffers);
+    }
+    cam->buffers = NULL;
+    cam->num_buffers = 0;
+    if (cam->region.ptr) {
+        memory_free_ddr(&cam->region);
+    }
+}
+
+static void fill_v4l2_buffer(const yolo2_v4l2_camera_t *cam, unsigned int index, struct v4l2_buffer *buf)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf->memory = v4l2_memory(cam->memory);
+    buf->index = index;
+    if (cam->memory == YOLO2_V4L2_MEM_USERPTR) {
+        buf->m.userptr = (unsigned long)cam->buffers[index].start;
+        buf->length = (uint32_t)cam->buffers[index].length;
+    } else if (cam->memory == YOLO2_V4L2_MEM_DMABUF) {
+        buf->m.fd = cam->buffers[index].dmabuf_fd;
+        buf->length = (uint32_t)cam->buffers[index].length;
+    }
+}
+
+// USERPTR: split one udmabuf region into page-aligned frame buffers
+static int alloc_userptr(yolo2_v4l2_camera_t *cam, size_t length)
+{
+    if (memory_allocate_ddr(length * cam->num_buffers, (size_t)sysconf(_SC_PAGESIZE), &cam->region) != 0) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < cam->num_buffers; ++i) {
+        cam->buffers[i].start = (uint8_t *)cam->region.ptr + (size_t)i * length;
+        cam->buffers[i].length = length;
+    }
+    return 0;
+}
+
+// DMABUF: one DMA heap allocation per buffer, mapped for the CPU
+static int alloc_dmabuf(yolo2_v4l2_camera_t *cam, size_t length)
+{
+    const char *heap_path = getenv("YOLO2_V4L2_DMA_HEAP");
+    if (!heap_path || !heap_path[0]) {
+        heap_path = "/dev/dma_heap/linux,cma";
+    }
+    const int heap = open(heap_path, O_RDWR | O_CLOEXEC);
+    if (heap < 0) {
+        YOLO2_LOG_INFO("DMA heap %s not available: %s\n", heap_path, strerror(errno));
+        return -1;
+    }
+    int rc = 0;
+    for (unsigned int i = 0; i < cam->num_buffers && rc == 0; ++i) {
+        struct dma_heap_allocation_data alloc;
+        memset(&alloc, 0, sizeof(alloc));
+        alloc.len = length;
+        alloc.fd_flags = O_RDWR | O_CLOEXEC;
+        if (xioctl(heap, DMA_HEAP_IOCTL_ALLOC, &alloc) == -1) {
+            YOLO2_LOG_INFO("DMA heap allocation failed: %s\n", strerror(errno));
+            rc = -1;
+            break;
+        }
+        cam->buffers[i].dmabuf_fd = (int)alloc.fd;
+        cam->buffers[i].length = length;
+        cam->buffers[i].start = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, (int)alloc.fd, 0);
+        if (cam->buffers[i].start == MAP_FAILED) {
+            YOLO2_LOG_INFO("mmap of dmabuf failed: %s\n", strerror(errno));
+            cam->buffers[i].start = NULL;
+            rc = -1;
+        }
+    }
+    close(heap);
+    return rc;
+}
+
+static int map_mmap(yolo2_v4l2_camera_t *cam)
+{
+    for (unsigned int i = 0; i < cam->num_buffers; ++i) {
+        struct v4l2_buffer buf;
+        fill_v4l2_buffer(cam, i, &buf);
+        if (xioctl(cam->fd, VIDIOC_QUERYBUF, &buf) == -1) {
+            fprintf(stderr, "ERROR: VIDIOC_QUERYBUF failed: %s\n", strerror(errno));
+            return -1;
+        }
+        cam->buffers[i].length = buf.length;
+        cam->buffers[i].start = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, cam->fd, buf.m.offset);
+        if (cam->buffers[i].start == MAP_FAILED) {
+            fprintf(stderr, "ERROR: mmap failed: %s\n", strerror(errno));
+            cam->buffers[i].start = NULL;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Request, back and queue the capture buffers. USERPTR/DMABUF failures are
+// reported at info level and undone, so the caller can fall back to MMAP.
+static int setup_buffers(yolo2_v4l2_camera_t *cam, yolo2_v4l2_memory_t memory)
+{
+    const int fallback = (memory != YOLO2_V4L2_MEM_MMAP);
+    cam->memory = memory;
+
+    struct v4l2_requestbuffers req;
+    memset(&req, 0, sizeof(req));
+    req.count = YOLO2_V4L2_NUM_BUFFERS;
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = v4l2_memory(memory);
+
+    if (xioctl(cam->fd, VIDIOC_REQBUFS, &req) == -1) {
+        if (fallback) {
+            YOLO2_LOG_INFO("Camera does not support %s buffers (%s), using mmap\n",
+                           yolo2_v4l2_memory_name(memory), strerror(errno));
+        } else {
+            fprintf(stderr, "ERROR: VIDIOC_REQBUFS failed: %s\n", strerror(errno));
+        }
+        return -1;
+    }
+    if (req.count < 2) {
+        fprintf(stderr, "ERROR: Insufficient V4L2 buffers (count=%u)\n", req.count);
+        req.count = 0;
+        (void)xioctl(cam->fd, VIDIOC_REQBUFS, &req);
+        return -1;
+    }
+
+    cam->buffers = (yolo2_v4l2_buf_t *)calloc(req.count, sizeof(*cam->buffers));
+    if (!cam->buffers) {
+        fprintf(stderr, "ERROR: Out of memory allocating V4L2 buffers\n");
+        return -1;
+    }
+    cam->num_buffers = req.count;
+    for (unsigned int i = 0; i < cam->num_buffers; ++i) {
+        cam->buffers[i].dmabuf_fd = -1;
+    }
+
+    const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t length = (cam->sizeimage + page - 1) / page * page;
+    int rc;
+    switch (memory) {
+        case YOLO2_V4L2_MEM_USERPTR:
+            rc = alloc_userptr(cam, length);
+            break;
+        case YOLO2_V4L2_MEM_DMABUF:
+            rc = alloc_dmabuf(cam, length);
+            break;
+        default:
+            rc = map_mmap(cam);
+            break;
+    }
+
+    for (unsigned int i = 0; i < cam->num_buffers && rc == 0; ++i) {
+        struct v4l2_buffer buf;
+        fill_v4l2_buffer(cam, i, &buf);
+        if (xioctl(cam->fd, VIDIOC_QBUF, &buf) == -1) {
+            if (fallback) {
+                YOLO2_LOG_INFO("Camera rejected %s buffer (%s)\n", yolo2_v4l2_memory_name(memory), strerror(errno));
+            } else {
+                fprintf(stderr, "ERROR: VIDIOC_QBUF failed: %s\n", strerror(errno));
+            }
+            rc = -1;
+        }
+    }
+    if (rc != 0) {
+        if (fallback) {
+            YOLO2_LOG_INFO("Falling back to mmap capture buffers\n");
+        }
+        release_buffers(cam);
+        cam->memory = YOLO2_V4L2_MEM_MMAP;
+    }
+    return rc;
+}
+
 int yolo2_v4l2_open(
     yolo2_v4l2_camera_t *cam,
     const char *device,
@@ -138,68 +361,29 @@ int yolo2_v4l2_open(
         YOLO2_LOG_INFO("WARNING: Failed to set FPS to %d: %s\n", fps, strerror(errno));
     }
 
-    struct v4l2_requestbuffers req;
-    memset(&req, 0, sizeof(req));
-    req.count = 4;
-    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    req.memory = V4L2_MEMORY_MMAP;
-
-    if (xioctl(cam->fd, VIDIOC_REQBUFS, &req) == -1) {
-        fprintf(stderr, "ERROR: VIDIOC_REQBUFS failed: %s\n", strerror(errno));
+    /* mmap stays the default: userptr captures into the uncached udmabuf
+     * region, which the CPU letterbox then reads byte by byte. */
+    const char *mode = getenv("YOLO2_V4L2_MEMORY");
+    int rc = -1;
+    if (!mode || !mode[0] || strcmp(mode, "mmap") == 0) {
+        rc = -1;
+    } else if (strcmp(mode, "dmabuf") == 0) {
+        rc = setup_buffers(cam, YOLO2_V4L2_MEM_DMABUF);
+    } else if (strcmp(mode, "userptr") == 0) {
+        rc = setup_buffers(cam, YOLO2_V4L2_MEM_USERPTR);
+    } else {
+        fprintf(stderr, "ERROR: YOLO2_V4L2_MEMORY must be mmap, userptr or dmabuf (got '%s')\n", mode);
         yolo2_v4l2_close(cam);
         return -1;
     }
-    if (req.count < 2) {
-        fprintf(stderr, "ERROR: Insufficient V4L2 buffers (count=%u)\n", req.count);
-        yolo2_v4l2_close(cam);
-        return -1;
-    }
-
-    cam->buffers = (yolo2_v4l2_mmap_buf_t *)calloc(req.count, sizeof(*cam->buffers));
-    if (!cam->buffers) {
-        fprintf(stderr, "ERROR: Out of memory allocating V4L2 buffers\n");
+    if (rc != 0 && setup_buffers(cam, YOLO2_V4L2_MEM_MMAP) != 0) {
         yolo2_v4l2_close(cam);
         return -1;
     }
-    cam->num_buffers = req.count;
-
-    for (unsigned int i = 0; i < cam->num_buffers; ++i) {
-        struct v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-
-        if (xioctl(cam->fd, VIDIOC_QUERYBUF, &buf) == -1) {
-            fprintf(stderr, "ERROR: VIDIOC_QUERYBUF failed: %s\n", strerror(errno));
-            yolo2_v4l2_close(cam);
-            return -1;
-        }
 
-        cam->buffers[i].length = buf.length;
-        cam->buffers[i].start = mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, cam->fd, buf.m.offset);
-        if (cam->buffers[i].start == MAP_FAILED) {
-            fprintf(stderr, "ERROR: mmap failed: %s\n", strerror(errno));
-            yolo2_v4l2_close(cam);
-            return -1;
-        }
-    }
-
-    for (unsigned int i = 0; i < cam->num_buffers; ++i) {
-        struct v4l2_buffer buf;
-        memset(&buf, 0, sizeof(buf));
-        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-        buf.memory = V4L2_MEMORY_MMAP;
-        buf.index = i;
-        if (xioctl(cam->fd, VIDIOC_QBUF, &buf) == -1) {
-            fprintf(stderr, "ERROR: VIDIOC_QBUF failed: %s\n", strerror(errno));
-            yolo2_v4l2_close(cam);
-            return -1;
-        }
-    }
-
-    YOLO2_LOG_INFO("Camera opened: %s (%dx%d @ ~%dfps, fmt=%s)\n",
-                   device, cam->width, cam->height, cam->fps, yolo2_v4l2_pixfmt_name(cam->pixfmt));
+    YOLO2_LOG_INFO("Camera opened: %s (%dx%d @ ~%dfps, fmt=%s, %u %s buffers)\n",
+                   device, cam->width, cam->height, cam->fps, yolo2_v4l2_pixfmt_name(cam->pixfmt),
+                   cam->num_buffers, yolo2_v4l2_memory_name(cam->memory));
     return 0;
 }
 
@@ -228,22 +412,28 @@ int yolo2_v4l2_stop(yolo2_v4l2_camera_t *cam)
 void yolo2_v4l2_close(yolo2_v4l2_camera_t *cam)
 {
     if (!cam) return;
-    if (cam->buffers) {
-        for (unsigned int i = 0; i < cam->num_buffers; ++i) {
-            if (cam->buffers[i].start && cam->buffers[i].start != MAP_FAILED) {
-                munmap(cam->buffers[i].start, cam->buffers[i].length);
-            }
-        }
-        free(cam->buffers);
-    }
-    cam->buffers = NULL;
-    cam->num_buffers = 0;
+    release_buffers(cam);
     if (cam->fd >= 0) {
         close(cam->fd);
     }
     cam->fd = -1;
 }
 
+/* DMA-heap buffers are mapped cached: bracket the CPU reads of a dequeued
+ * frame with DMA_BUF_IOCTL_SYNC so no stale lines are seen. */
+static int dmabuf_sync(yolo2_v4l2_camera_t *cam, uint32_t index, uint64_t flags)
+{
+    if (cam->memory != YOLO2_V4L2_MEM_DMABUF) return 0;
+    struct dma_buf_sync sync;
+    memset(&sync, 0, sizeof(sync));
+    sync.flags = flags | DMA_BUF_SYNC_READ;
+    if (xioctl(cam->buffers[index].dmabuf_fd, DMA_BUF_IOCTL_SYNC, &sync) == -1) {
+        fprintf(stderr, "ERROR: DMA_BUF_IOCTL_SYNC failed: %s\n", strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
 int yolo2_v4l2_dequeue(yolo2_v4l2_camera_t *cam, yolo2_v4l2_frame_t *frame)
 {
     if (!cam || cam->fd < 0 || !frame) return -1;
@@ -251,7 +441,7 @@ int yolo2_v4l2_dequeue(yolo2_v4l2_camera_t *cam, yolo2_v4l2_frame_t *frame)
     struct v4l2_buffer buf;
     memset(&buf, 0, sizeof(buf));
     buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
+    buf.memory = v4l2_memory(cam->memory);
 
     if (xioctl(cam->fd, VIDIOC_DQBUF, &buf) == -1) {
         if (errno == EAGAIN) {
@@ -266,6 +456,11 @@ int yolo2_v4l2_dequeue(yolo2_v4l2_camera_t *cam, yolo2_v4l2_frame_t *frame)
         return -1;
     }
 
+    if (dmabuf_sync(cam, buf.index, DMA_BUF_SYNC_START) != 0) {
+        xioctl(cam->fd, VIDIOC_QBUF, &buf);
+        return -1;
+    }
+
     frame->data = (const uint8_t *)cam->buffers[buf.index].start;
     frame->size = (size_t)buf.bytesused;
     frame->index = buf.index;
@@ -276,11 +471,12 @@ int yolo2_v4l2_enqueue(yolo2_v4l2_camera_t *cam, const yolo2_v4l2_frame_t *frame
 {
     if (!cam || cam->fd < 0 || !frame) return -1;
 
+    if (frame->index >= cam->num_buffers) return -1;
+
+    dmabuf_sync(cam, frame->index, DMA_BUF_SYNC_END);
+
     struct v4l2_buffer buf;
-    memset(&buf, 0, sizeof(buf));
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
-    buf.index = frame->index;
+    fill_v4l2_buffer(cam, frame->index, &buf);
 
     if (xioctl(cam->fd, VIDIOC_QBUF, &buf) == -1) {
         fprintf(stderr, "ERROR: VIDIOC_QBUF failed: %s\n", strerror(errno));
@@ -318,13 +514,6 @@ int yolo2_decode_mjpeg_to_rgb24(const uint8_t *mjpeg, size_t mjpeg_size, uint8_t
     return 0;
 }
 
-static uint8_t clamp_u8(int v)
-{
-    if (v < 0) return 0;
-    if (v > 255) return 255;
-    return (uint8_t)v;
-}
-
 void yolo2_yuyv_to_rgb24(const uint8_t *yuyv, uint8_t *rgb, int width, int height)
 {
     if (!yuyv || !rgb || width <= 0 || height <= 0) {
@@ -338,32 +527,8 @@ void yolo2_yuyv_to_rgb24(const uint8_t *yuyv, uint8_t *rgb, int width, int heigh
     uint8_t *dst = rgb;
 
     for (int i = 0; i < num_pairs; ++i) {
-        const int y0 = (int)src[0];
-        const int u = (int)src[1];
-        const int y1 = (int)src[2];
-        const int v = (int)src[3];
+        yolo2_yuyv_pair_to_rgb24(src, dst);
         src += 4;
-
-        const int c0 = y0 - 16;
-        const int c1 = y1 - 16;
-        const int d = u - 128;
-        const int e = v - 128;
-
-        // Integer approximation (BT.601)
-        const int r0 = (298 * c0 + 409 * e + 128) >> 8;
-        const int g0 = (298 * c0 - 100 * d - 208 * e + 128) >> 8;
-        const int b0 = (298 * c0 + 516 * d + 128) >> 8;
-
-        const int r1 = (298 * c1 + 409 * e + 128) >> 8;
-        const int g1 = (298 * c1 - 100 * d - 208 * e + 128) >> 8;
-        const int b1 = (298 * c1 + 516 * d + 128) >> 8;
-
-        dst[0] = clamp_u8(r0);
-        dst[1] = clamp_u8(g0);
-        dst[2] = clamp_u8(b0);
-        dst[3] = clamp_u8(r1);
-        dst[4] = clamp_u8(g1);
-        dst[5] = clamp_u8(b1);
         dst += 6;
     }
 }
@@ -7,19 +7,40 @@ sudo xmutil loadapp yolov2_accel
 
 echo "Loading udmabuf..."
 sudo rmmod u-dma-buf 2>/dev/null
-sudo insmod /lib/modules/$(uname -r)/extra/u-dma-buf.ko udmabuf0=134217728 udmabuf1=1048576 udmabuf2=33554432
+# The two-engine pipeline needs a second inference buffer (udmabuf3), and
+# udmabuf5 for engine B's own weight stream when the weights have one.
+WEIGHTS_DIR=/home/ubuntu/weights
+ARGS=("$@")
+for ((i = 0; i + 1 < ${#ARGS[@]}; i++)); do
+  [[ "${ARGS[i]}" == "-w" ]] && WEIGHTS_DIR="${ARGS[i+1]}"
+done
+UDMABUF_EXTRA=()
+if [[ -n "$YOLO2_TWO_ENGINE" && "$YOLO2_TWO_ENGINE" != "0" ]]; then
+  UDMABUF_EXTRA+=(udmabuf3=33554432)
+  if [[ -f "$WEIGHTS_DIR/weights_reorg_int16_b.bin" ]]; then
+    UDMABUF_EXTRA+=(udmabuf5=134217728)
+  fi
+fi
+# Camera capture buffers with YOLO2_V4L2_MEMORY=userptr come from udmabuf4.
+if [[ " $* " == *" --camera "* && "$YOLO2_V4L2_MEMORY" == "userptr" ]]; then
+  UDMABUF_EXTRA+=(udmabuf4=33554432)
+fi
+sudo insmod /lib/modules/$(uname -r)/extra/u-dma-buf.ko udmabuf0=134217728 udmabuf1=1048576 udmabuf2=33554432 "${UDMABUF_EXTRA[@]}"
 
 echo "Setting sync mode..."
 echo 1 | sudo tee /sys/class/u-dma-buf/udmabuf0/sync_mode > /dev/null
 echo 1 | sudo tee /sys/class/u-dma-buf/udmabuf1/sync_mode > /dev/null
 echo 1 | sudo tee /sys/class/u-dma-buf/udmabuf2/sync_mode > /dev/null
+for extra in "${UDMABUF_EXTRA[@]}"; do
+  echo 1 | sudo tee /sys/class/u-dma-buf/${extra%%=*}/sync_mode > /dev/null
+done
 
 echo "Ready! Running YOLOv2..."
 cd ~/linux_app
 
 # Pass through YOLO2_* env vars even under sudo (sudo often resets the environment).
 YOLO_ENV=()
-for v in YOLO2_LAYER_TIMEOUT_MS YOLO2_NO_DUMP YOLO2_DUMP_REGION_RAW YOLO2_DUMP_REGION YOLO2_VERBOSE; do
+for v in YOLO2_LAYER_TIMEOUT_MS YOLO2_NO_DUMP YOLO2_DUMP_REGION_RAW YOLO2_DUMP_REGION YOLO2_VERBOSE YOLO2_TWO_ENGINE YOLO2_ENGINE_SPLIT YOLO2_ACCEL_INSTANCES YOLO2_CPU_OFFLOAD YOLO2_CPU_THREADS YOLO2_AUTOTUNE_REPEATS YOLO2_BITSTREAM YOLO2_V4L2_MEMORY YOLO2_V4L2_DMA_HEAP; do
   if [[ -n "${!v}" ]]; then
     YOLO_ENV+=("$v=${!v}")
   fi
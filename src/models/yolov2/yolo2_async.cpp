@@ -0,0 +1,183 @@
+/*
+ * YOLOv2 AsyncSession - queued inference on a dedicated executor thread
+ *
+ * Submitters push jobs into a bounded FIFO under one mutex; the executor
+ * pops them one at a time and runs them on its Session, which no other
+ * thread touches. See include/models/yolov2/yolo2_async.hpp.
+ */
+
+#include "yolo2_async.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace yolo2 {
+
+namespace {
+
+// Future variant: complete a shared promise (std::function needs a copyable target)
+AsyncSession::Callback promise_callback(const std::shared_ptr<std::promise<Detections>> &promise) {
+    return [promise](std::exception_ptr error, Detections &&dets) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(dets));
+        }
+    };
+}
+
+// Callbacks belong to the caller; an exception escaping one must not take the executor down.
+void deliver(const AsyncSession::Callback &done, std::exception_ptr error, Detections &&dets) {
+    try {
+        done(error, std::move(dets));
+    } catch (...) {
+    }
+}
+
+void deliver_cancelled(const AsyncSession::Callback &done) {
+    deliver(done, std::make_exception_ptr(Cancelled()), Detections());
+}
+
+} // namespace
+
+AsyncSession::AsyncSession(Session session, size_t queue_depth)
+    : session_(std::move(session)), depth_(queue_depth ? queue_depth : 1) {
+    executor_ = std::thread(&AsyncSession::run, this);
+}
+
+AsyncSession::AsyncSession(const SessionOptions &options, size_t queue_depth)
+    : AsyncSession(Session(options), queue_depth) {}
+
+AsyncSession::~AsyncSession() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        dropped.swap(queue_);
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    idle_.notify_all();
+    for (const Job &job : dropped) deliver_cancelled(job.done);
+    executor_.join();
+}
+
+AsyncSession::Ticket AsyncSession::submit(const Frame &frame) {
+    auto promise = std::make_shared<std::promise<Detections>>();
+    Ticket ticket;
+    ticket.result = promise->get_future();
+    enqueue(frame, promise_callback(promise), true, &ticket.id);
+    return ticket;
+}
+
+uint64_t AsyncSession::submit(const Frame &frame, Callback done) {
+    uint64_t id = 0;
+    enqueue(frame, std::move(done), true, &id);
+    return id;
+}
+
+bool AsyncSession::try_submit(const Frame &frame, Ticket &ticket) {
+    auto promise = std::make_shared<std::promise<Detections>>();
+    Ticket t;
+    t.result = promise->get_future();
+    if (!enqueue(frame, promise_callback(promise), false, &t.id)) return false;
+    ticket = std::move(t);
+    return true;
+}
+
+bool AsyncSession::try_submit(const Frame &frame, Callback done, uint64_t *id) {
+    return enqueue(frame, std::move(done), false, id);
+}
+
+bool AsyncSession::enqueue(const Frame &frame, Callback done, bool block, uint64_t *id) {
+    if (!done) throw std::runtime_error("AsyncSession: empty callback");
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (block && queue_.size() >= depth_ && on_executor()) {
+        // Only the executor frees queue slots, so it would wait for itself.
+        throw std::runtime_error("AsyncSession: submit() from a callback with a full queue; use try_submit()");
+    }
+    if (block) {
+        not_full_.wait(lock, [this] { return stop_ || queue_.size() < depth_; });
+    }
+    if (stop_) throw std::runtime_error("AsyncSession is shutting down");
+    if (queue_.size() >= depth_) return false;
+    const uint64_t job_id = next_id_++;
+    queue_.push_back(Job{job_id, frame, std::move(done)});
+    if (id) *id = job_id;
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+bool AsyncSession::cancel(uint64_t id) {
+    Callback done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = queue_.begin();
+        while (it != queue_.end() && it->id != id) ++it;
+        if (it == queue_.end()) return false;
+        done = std::move(it->done);
+        queue_.erase(it);
+    }
+    not_full_.notify_one();
+    idle_.notify_all();
+    deliver_cancelled(done);
+    return true;
+}
+
+size_t AsyncSession::cancel_all() {
+    std::deque<Job> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dropped.swap(queue_);
+    }
+    not_full_.notify_all();
+    idle_.notify_all();
+    for (const Job &job : dropped) deliver_cancelled(job.done);
+    return dropped.size();
+}
+
+void AsyncSession::drain() {
+    if (on_executor()) throw std::runtime_error("AsyncSession: drain() from a callback would wait for itself");
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return stop_ || (queue_.empty() && !busy_); });
+}
+
+bool AsyncSession::on_executor() const {
+    return std::this_thread::get_id() == executor_.get_id();
+}
+
+size_t AsyncSession::queued() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+void AsyncSession::run() {
+    Detections dets;
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            busy_ = false;
+            if (queue_.empty()) idle_.notify_all();
+            not_empty_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (stop_) return;
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            busy_ = true;
+        }
+        not_full_.notify_one();
+
+        std::exception_ptr error;
+        try {
+            session_.detect(job.frame, dets);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        deliver(job.done, error, error ? Detections() : std::move(dets));
+        dets.clear();
+    }
+}
+
+} // namespace yolo2
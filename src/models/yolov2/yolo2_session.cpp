@@ -0,0 +1,178 @@
+/*
+ * YOLOv2 Session - embeddable detector behind libyolo2
+ *
+ * Owns the parsed network and the weights of the selected backend, so the
+ * per-frame cost is preprocessing, the backend run and box decoding. See
+ * include/models/yolov2/yolo2_session.hpp.
+ */
+
+#include "yolo2_session.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include <core/yolo.h>
+#include <api.hpp>
+
+#include "yolo2_input.h"
+
+namespace yolo2 {
+
+namespace {
+
+void free_network_deep(network *net) {
+    if (!net) return;
+    for (int i = 0; i < net->n; ++i) {
+        free_layer(net->layers[i]);
+    }
+    free(net->layers);
+    free(net->seen);
+    free(net->t);
+    free(net->cost);
+    free(net);
+}
+
+struct DetectionGuard {
+    detection *dets = nullptr;
+    int n = 0;
+    ~DetectionGuard() {
+        if (dets) free_detections(dets, n);
+    }
+};
+
+// Frame -> yolo2_input.h descriptor
+yolo2_input_t to_input(const Frame &frame) {
+    yolo2_input_t in{};
+    in.data = frame.data;
+    in.width = frame.width;
+    in.height = frame.height;
+    in.stride = frame.stride;
+    in.letterboxed = frame.letterboxed ? 1 : 0;
+    switch (frame.format) {
+        case PixelFormat::RGB8: in.format = YOLO2_INPUT_RGB24; break;
+        case PixelFormat::BGR8: in.format = YOLO2_INPUT_BGR24; break;
+        case PixelFormat::RGBX8: in.format = YOLO2_INPUT_RGBX32; break;
+        case PixelFormat::BGRX8: in.format = YOLO2_INPUT_BGRX32; break;
+        case PixelFormat::YUYV: in.format = YOLO2_INPUT_YUYV; break;
+        case PixelFormat::F32_PLANAR: in.format = YOLO2_INPUT_F32_CHW; break;
+    }
+    return in;
+}
+
+// The network input itself: used in place, no letterbox copy
+bool is_network_input(const Frame &frame, const network *net) {
+    return frame.format == PixelFormat::F32_PLANAR && frame.letterboxed && frame.width == net->w &&
+           frame.height == net->h && (frame.stride == 0 || frame.stride == net->w * sizeof(float));
+}
+
+} // namespace
+
+void Detections::clear() {
+    x.clear();
+    y.clear();
+    w.clear();
+    h.clear();
+    cls.clear();
+    score.clear();
+    box.clear();
+}
+
+const char *to_string(Backend b) {
+    switch (b) {
+        case Backend::Hls: return "hls";
+    }
+    return "unknown";
+}
+
+Backend parse_backend(const std::string &v) {
+    if (v.empty() || v == "hls") return Backend::Hls;
+    throw std::runtime_error("Unsupported backend: " + v);
+}
+
+struct Session::Impl {
+    SessionOptions options;
+    network *net = nullptr;
+    std::unique_ptr<Yolo2Weights> weights;
+    std::vector<float> input;   // letterboxed network input, reused across frames
+
+    ~Impl() { free_network_deep(net); }
+};
+
+Session::Session(const SessionOptions &options) : impl_(new Impl) {
+    impl_->options = options;
+    impl_->net = load_network(const_cast<char *>(options.cfg_path.c_str()));
+    if (!impl_->net) {
+        throw std::runtime_error("Failed to load network " + options.cfg_path);
+    }
+    set_batch_network(impl_->net, 1);
+    impl_->weights = yolov2_hls_load(impl_->net, options.precision, options.weights_dir.c_str());
+}
+
+Session::~Session() = default;
+Session::Session(Session &&other) noexcept = default;
+Session &Session::operator=(Session &&other) noexcept = default;
+
+Detections Session::detect(const Frame &frame) {
+    Detections out;
+    detect(frame, out);
+    return out;
+}
+
+void Session::detect(const Frame &frame, Detections &out) {
+    if (!impl_) throw std::runtime_error("Session was moved from");
+    network *net = impl_->net;
+    const SessionOptions &opt = impl_->options;
+
+    const float *input = static_cast<const float *>(frame.data);
+    if (!is_network_input(frame, net)) {
+        const yolo2_input_t in = to_input(frame);
+        impl_->input.resize(static_cast<size_t>(net->w) * net->h * 3);
+        if (yolo2_input_letterbox(&in, impl_->input.data(), net->w, net->h) != 0) {
+            throw std::runtime_error("Invalid frame");
+        }
+        input = impl_->input.data();
+    }
+    yolov2_hls_ps(net, input, *impl_->weights);
+
+    const layer &last = net->layers[net->n - 1];
+    DetectionGuard dets;
+    dets.dets = get_network_boxes(net, frame.width, frame.height, opt.thresh, opt.hier_thresh, 0, 1, &dets.n);
+    if (!dets.dets) {
+        throw std::runtime_error("get_network_boxes returned null");
+    }
+    if (opt.nms > 0.0f) {
+        do_nms_sort(dets.dets, dets.n, last.classes, opt.nms);
+    }
+
+    out.clear();
+    for (int i = 0; i < dets.n; ++i) {
+        const detection &d = dets.dets[i];
+        for (int j = 0; j < last.classes; ++j) {
+            if (d.prob[j] > opt.thresh) {
+                out.x.push_back(d.bbox.x);
+                out.y.push_back(d.bbox.y);
+                out.w.push_back(d.bbox.w);
+                out.h.push_back(d.bbox.h);
+                out.cls.push_back(j);
+                out.score.push_back(d.prob[j]);
+                out.box.push_back(i);
+            }
+        }
+    }
+}
+
+const SessionOptions &Session::options() const { return impl_->options; }
+int Session::input_width() const { return impl_->net->w; }
+int Session::input_height() const { return impl_->net->h; }
+int Session::classes() const { return impl_->net->layers[impl_->net->n - 1].classes; }
+
+const float *Session::region_output() const {
+    return impl_->net->layers[impl_->net->n - 1].output;
+}
+
+size_t Session::region_outputs() const {
+    return static_cast<size_t>(impl_->net->layers[impl_->net->n - 1].outputs);
+}
+
+} // namespace yolo2
@@ -0,0 +1,129 @@
+/*
+ * Calibration image set and forked worker pool of the host-model tools.
+ * See yolo2_tool_workers.hpp.
+ */
+
+#include "yolo2_tool_workers.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace yolo2_tools {
+
+NetworkGuard::NetworkGuard(const std::string &cfg_path) {
+    ptr = load_network(const_cast<char *>(cfg_path.c_str()));
+    if (!ptr) throw std::runtime_error("Failed to load network: " + cfg_path);
+    set_batch_network(ptr, 1);
+}
+
+NetworkGuard::~NetworkGuard() {
+    if (!ptr) return;
+    for (int i = 0; i < ptr->n; ++i) free_layer(ptr->layers[i]);
+    free(ptr->layers);
+    free(ptr->seen);
+    free(ptr->t);
+    free(ptr->cost);
+    free(ptr);
+}
+
+std::vector<std::string> list_images(const std::string &path, int max_images) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    if (fs::is_regular_file(path)) {
+        files.push_back(path);
+    } else if (fs::is_directory(path)) {
+        for (const auto &entry : fs::directory_iterator(path)) {
+            if (!entry.is_regular_file()) continue;
+            std::string ext = entry.path().extension().string();
+            std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp") {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+    } else {
+        throw std::runtime_error("Calibration image path not found: " + path);
+    }
+    if (max_images > 0 && files.size() > static_cast<size_t>(max_images)) files.resize(max_images);
+    if (files.empty()) throw std::runtime_error("No calibration images in " + path);
+    return files;
+}
+
+int worker_count(int requested, size_t images) {
+    const int jobs = requested > 0 ? requested : static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(1, std::min(jobs, static_cast<int>(images)));
+}
+
+bool write_all(int fd, const void *data, size_t len) {
+    const char *p = static_cast<const char *>(data);
+    while (len > 0) {
+        const ssize_t n = ::write(fd, p, len);
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool read_all(int fd, void *data, size_t len) {
+    char *p = static_cast<char *>(data);
+    while (len > 0) {
+        const ssize_t n = ::read(fd, p, len);
+        if (n <= 0) return false;
+        p += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void run_forked_workers(int jobs, const std::function<bool(int worker, int fd)> &work,
+                        const std::function<bool(int worker, int fd)> &collect, const char *failure) {
+    std::fflush(stdout);
+    std::fflush(stderr);
+    std::vector<pid_t> pids;
+    std::vector<int> fds;
+    for (int w = 0; w < jobs; ++w) {
+        int pipefd[2];
+        if (::pipe(pipefd) != 0) throw std::runtime_error("pipe() failed");
+        const pid_t pid = ::fork();
+        if (pid < 0) throw std::runtime_error("fork() failed");
+        if (pid == 0) {
+            ::close(pipefd[0]);
+            for (int fd : fds) ::close(fd);
+            int rc = 0;
+            try {
+                if (!work(w, pipefd[1])) rc = 1;
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "Worker %d failed: %s\n", w, e.what());
+                rc = 1;
+            }
+            std::fflush(stdout);
+            std::fflush(stderr);
+            ::_exit(rc);
+        }
+        ::close(pipefd[1]);
+        pids.push_back(pid);
+        fds.push_back(pipefd[0]);
+    }
+
+    bool ok = true;
+    for (int w = 0; w < jobs; ++w) {
+        if (!collect(w, fds[w])) ok = false;
+        ::close(fds[w]);
+        int status = 0;
+        ::waitpid(pids[w], &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    if (!ok) throw std::runtime_error(failure);
+}
+
+} // namespace yolo2_tools
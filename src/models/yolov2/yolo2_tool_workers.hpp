@@ -0,0 +1,50 @@
+#pragma once
+
+// Shared by the host-model tools that run a calibration image set
+// (yolov2_calib, yolov2_precision_search).
+//
+// The host model keeps its on-chip buffers in function statics, so images
+// are spread over forked worker processes instead of threads. Worker w takes
+// images w, w + jobs, ... and streams its result back to the parent over a
+// pipe; the parent reads the workers in order.
+
+#include <core/yolo.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace yolo2_tools {
+
+// Network parsed from a cfg, freed with its layers.
+struct NetworkGuard {
+    network *ptr = nullptr;
+
+    NetworkGuard() = default;
+    // Loads cfg_path at batch 1; throws std::runtime_error on failure.
+    explicit NetworkGuard(const std::string &cfg_path);
+    ~NetworkGuard();
+    NetworkGuard(const NetworkGuard &) = delete;
+    NetworkGuard &operator=(const NetworkGuard &) = delete;
+};
+
+// path itself, or the jpg/png/bmp files in it (sorted), at most max_images
+// when > 0. Throws when the path is missing or holds no image.
+std::vector<std::string> list_images(const std::string &path, int max_images);
+
+// requested (all cores when <= 0), clamped to 1..images.
+int worker_count(int requested, size_t images);
+
+// Whole-buffer pipe I/O; false on a short read/write.
+bool write_all(int fd, const void *data, size_t len);
+bool read_all(int fd, void *data, size_t len);
+
+// Forks `jobs` workers. Each child runs work(w, fd) and exits with its
+// result (an exception counts as a failure and is printed). The parent then
+// calls collect(w, fd) for w = 0..jobs-1 and reaps the child. Throws
+// std::runtime_error(failure) when a worker or a collect() fails.
+void run_forked_workers(int jobs, const std::function<bool(int worker, int fd)> &work,
+                        const std::function<bool(int worker, int fd)> &collect, const char *failure);
+
+} // namespace yolo2_tools
@@ -0,0 +1,541 @@
+/*
+ * YOLOv2 Activation Calibration Tool
+ *
+ * Runs the FP32 host model over a set of calibration images and collects a
+ * |x| histogram of the network input and of every conv layer output. From
+ * those it picks one power-of-two activation Q per tensor (max, percentile
+ * or KL divergence) and writes the iofm Q table used by the fixed-point
+ * paths (iofm_Q.bin for int16, iofm_int8_Q.bin for int8).
+ *
+ * Images are spread over forked worker processes (yolo2_tool_workers.hpp);
+ * each worker streams its histograms back to the parent over a pipe.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+
+#include <core/yolo.h>
+#include <core/precision.hpp>
+#include <api.hpp>
+#include <models/yolov2/yolo2_host_ops.hpp>
+
+#include "yolo2_tool_workers.hpp"
+
+namespace {
+
+using namespace yolo2_tools;
+
+enum class Method {
+    Max,
+    Percentile,
+    KL
+};
+
+const char *to_string(Method m) {
+    switch (m) {
+        case Method::Max: return "max";
+        case Method::Percentile: return "percentile";
+        case Method::KL: return "kl";
+    }
+    return "unknown";
+}
+
+Method parse_method(const std::string &arg) {
+    if (arg == "max") return Method::Max;
+    if (arg == "percentile" || arg == "pct") return Method::Percentile;
+    if (arg == "kl" || arg == "entropy") return Method::KL;
+    throw std::runtime_error("Unknown calibration method: " + arg);
+}
+
+struct CalibConfig {
+    std::string cfg_path = "config/yolov2.cfg";
+    std::string images = "examples/test_images";
+    std::string out_dir = "weights";
+    Method method = Method::KL;
+    double percentile = 99.99;
+    bool int16 = true;
+    bool int8 = false;
+    bool write = true;
+    int max_images = 0;
+    int jobs = 0;
+};
+
+void print_usage(const char *argv0) {
+    std::printf("Usage: %s [--images <dir|file>] [--cfg <cfg>] [--out-dir <dir>] [--precision int16|int8|all]\n"
+                "          [--method max|percentile|kl] [--percentile P] [--max-images N] [--jobs N] [--no-write]\n"
+                "\n"
+                "  --images <path>    Calibration image directory (jpg/png/bmp) or a single image\n"
+                "                     (default: examples/test_images)\n"
+                "  --precision <p>    Q tables to write: int16 -> iofm_Q.bin, int8 -> iofm_int8_Q.bin\n"
+                "  --method <m>       Threshold selection (default: kl)\n"
+                "  --percentile P     Coverage for --method percentile (default: 99.99)\n"
+                "  --jobs N           Worker processes (default: all cores). Each worker holds its own\n"
+                "                     copy of the fp32 weights, so N also bounds peak memory.\n"
+                "  --no-write         Print the per-layer report only\n"
+                "\n"
+                "Requires weights/weights_reorg.bin and weights/bias.bin (fp32).\n",
+                argv0);
+}
+
+CalibConfig parse_args(int argc, char **argv) {
+    CalibConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if ((arg == "--images" || arg == "-i") && i + 1 < argc) {
+            cfg.images = argv[++i];
+        } else if ((arg == "--cfg" || arg == "-c") && i + 1 < argc) {
+            cfg.cfg_path = argv[++i];
+        } else if ((arg == "--out-dir" || arg == "-o") && i + 1 < argc) {
+            cfg.out_dir = argv[++i];
+        } else if ((arg == "--precision" || arg == "-p") && i + 1 < argc) {
+            const std::string p = argv[++i];
+            if (p == "int16" || p == "i16") {
+                cfg.int16 = true;
+                cfg.int8 = false;
+            } else if (p == "int8" || p == "i8") {
+                cfg.int16 = false;
+                cfg.int8 = true;
+            } else if (p == "all") {
+                cfg.int16 = cfg.int8 = true;
+            } else {
+                throw std::runtime_error("Unsupported calibration precision: " + p);
+            }
+        } else if ((arg == "--method" || arg == "-m") && i + 1 < argc) {
+            cfg.method = parse_method(argv[++i]);
+        } else if (arg == "--percentile" && i + 1 < argc) {
+            cfg.percentile = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--max-images" && i + 1 < argc) {
+            cfg.max_images = std::atoi(argv[++i]);
+        } else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+            cfg.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--no-write") {
+            cfg.write = false;
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            throw std::runtime_error("Unknown option: " + arg);
+        }
+    }
+    if (!(cfg.percentile > 0.0 && cfg.percentile <= 100.0)) {
+        throw std::runtime_error("--percentile must be in (0, 100]");
+    }
+    return cfg;
+}
+
+constexpr int kHistBins = 16384;
+constexpr int kHistBinsLog2 = 14;
+constexpr int kEmptyRange = INT_MIN;
+
+// Histogram of |x| over [0, 2^range_log2). The range only grows by powers of
+// two (folding bin pairs), so histograms from different workers merge exactly
+// and every power-of-two Q threshold lands on a bin edge.
+struct AbsHistogram {
+    int range_log2 = kEmptyRange;
+    float maxabs = 0.0f;
+    uint64_t count = 0;
+    std::vector<uint64_t> bins = std::vector<uint64_t>(kHistBins, 0);
+
+    void grow(int log2) {
+        if (range_log2 == kEmptyRange) {
+            range_log2 = log2;
+            return;
+        }
+        for (; range_log2 < log2; ++range_log2) {
+            for (int b = 0; b < kHistBins / 2; ++b) bins[b] = bins[2 * b] + bins[2 * b + 1];
+            std::fill(bins.begin() + kHistBins / 2, bins.end(), 0);
+        }
+    }
+
+    // Rows of w valid elements, row_stride apart (the DDR layout pads rows).
+    void add(const float *data, size_t rows, int w, int row_stride) {
+        float m = 0.0f;
+        for (size_t r = 0; r < rows; ++r) {
+            const float *row = data + r * row_stride;
+            for (int x = 0; x < w; ++x) m = std::max(m, std::fabs(row[x]));
+        }
+        if (m > 0.0f) {
+            int e = 0;
+            std::frexp(m, &e); // m < 2^e
+            if (range_log2 == kEmptyRange || e > range_log2) grow(e);
+        }
+        maxabs = std::max(maxabs, m);
+        count += rows * static_cast<size_t>(w);
+        if (range_log2 == kEmptyRange) {
+            bins[0] += rows * static_cast<size_t>(w);
+            return;
+        }
+        const float scale = std::ldexp(1.0f, kHistBinsLog2 - range_log2);
+        for (size_t r = 0; r < rows; ++r) {
+            const float *row = data + r * row_stride;
+            for (int x = 0; x < w; ++x) {
+                const int b = static_cast<int>(std::fabs(row[x]) * scale);
+                bins[std::min(b, kHistBins - 1)]++;
+            }
+        }
+    }
+
+    void merge(AbsHistogram other) {
+        if (other.range_log2 != kEmptyRange) {
+            if (range_log2 == kEmptyRange || other.range_log2 > range_log2) grow(other.range_log2);
+            other.grow(range_log2);
+        }
+        for (int b = 0; b < kHistBins; ++b) bins[b] += other.bins[b];
+        maxabs = std::max(maxabs, other.maxabs);
+        count += other.count;
+    }
+
+    // Upper edge of bin b.
+    double edge(int b) const { return std::ldexp(static_cast<double>(b + 1), range_log2 - kHistBinsLog2); }
+};
+
+// Threshold T(Q): the largest magnitude representable with `bits` at Q.
+double q_threshold(int q, int bits) {
+    return std::ldexp(static_cast<double>((1 << (bits - 1)) - 1), -q);
+}
+
+int select_q_percentile(const AbsHistogram &h, int bits, double percentile) {
+    const int q_max = select_q(h.maxabs, bits);
+    if (h.range_log2 == kEmptyRange) return q_max;
+    const double target = static_cast<double>(h.count) * percentile / 100.0;
+    double cum = 0.0;
+    for (int b = 0; b < kHistBins; ++b) {
+        cum += static_cast<double>(h.bins[b]);
+        if (cum >= target) {
+            const float thr = static_cast<float>(std::min<double>(h.edge(b), h.maxabs));
+            return std::max(q_max, select_q(thr, bits));
+        }
+    }
+    return q_max;
+}
+
+// KL(P || Q) between the clipped reference distribution and its quantized
+// version when saturating at T(q) with a step of 2^-q.
+double kl_divergence(const AbsHistogram &h, int q, int bits) {
+    const double bin_w = std::ldexp(1.0, h.range_log2 - kHistBinsLog2);
+    const double thr = q_threshold(q, bits);
+    const int nb = static_cast<int>(std::min<double>(kHistBins, std::ceil(thr / bin_w)));
+    if (nb <= 0) return INFINITY;
+    // Bins per quantization level (at least one: finer steps than the
+    // histogram resolves add no measurable error).
+    const int per_level = std::max(1, static_cast<int>(std::ldexp(1.0, -q) / bin_w));
+
+    std::vector<double> p(h.bins.begin(), h.bins.begin() + nb);
+    for (int b = nb; b < kHistBins; ++b) p[nb - 1] += static_cast<double>(h.bins[b]);
+
+    std::vector<double> qd(nb, 0.0);
+    for (int s = 0; s < nb; s += per_level) {
+        const int e = std::min(nb, s + per_level);
+        double total = 0.0;
+        int nonzero = 0;
+        for (int b = s; b < e; ++b) {
+            total += static_cast<double>(h.bins[b]);
+            nonzero += h.bins[b] != 0;
+        }
+        if (nonzero == 0) continue;
+        for (int b = s; b < e; ++b) {
+            if (h.bins[b] != 0) qd[b] = total / nonzero;
+        }
+    }
+
+    double psum = 0.0, qsum = 0.0;
+    for (int b = 0; b < nb; ++b) {
+        psum += p[b];
+        qsum += qd[b];
+    }
+    if (psum <= 0.0 || qsum <= 0.0) return INFINITY;
+    constexpr double kEps = 1e-12;
+    double kl = 0.0;
+    for (int b = 0; b < nb; ++b) {
+        if (p[b] <= 0.0) continue;
+        const double pi = p[b] / psum;
+        const double qi = std::max(qd[b] / qsum, kEps);
+        kl += pi * std::log(pi / qi);
+    }
+    return kl;
+}
+
+int select_q_kl(const AbsHistogram &h, int bits) {
+    const int q_max = select_q(h.maxabs, bits);
+    if (h.range_log2 == kEmptyRange) return q_max;
+    // Candidates trade range for resolution, one bit at a time.
+    constexpr int kMaxExtraBits = 8;
+    int best_q = q_max;
+    double best_kl = kl_divergence(h, q_max, bits);
+    for (int q = q_max + 1; q <= q_max + kMaxExtraBits; ++q) {
+        const double kl = kl_divergence(h, q, bits);
+        if (kl < best_kl) {
+            best_kl = kl;
+            best_q = q;
+        }
+    }
+    return best_q;
+}
+
+int select_activation_q(const AbsHistogram &h, int bits, Method method, double percentile) {
+    switch (method) {
+        case Method::Max: return select_q(h.maxabs, bits);
+        case Method::Percentile: return select_q_percentile(h, bits, percentile);
+        case Method::KL: return select_q_kl(h, bits);
+    }
+    return select_q(h.maxabs, bits);
+}
+
+// Fraction of samples above T(q) (saturated by the datapath).
+double clipped_fraction(const AbsHistogram &h, int q, int bits) {
+    if (h.count == 0 || h.range_log2 == kEmptyRange) return 0.0;
+    const double thr = q_threshold(q, bits);
+    uint64_t above = 0;
+    for (int b = 0; b < kHistBins; ++b) {
+        if (h.edge(b) > thr) above += h.bins[b];
+    }
+    return static_cast<double>(above) / static_cast<double>(h.count);
+}
+
+// iofm entry k+1 is the output of the k-th conv layer; entry 0 is the input.
+std::vector<int> conv_slots(const network *net) {
+    std::vector<int> slot(net->n, -1);
+    int conv = 0;
+    for (int i = 0; i < net->n; ++i) {
+        if (net->layers[i].type == CONVOLUTIONAL) slot[i] = 1 + conv++;
+    }
+    return slot;
+}
+
+// Conv layer whose output feeds layer i unchanged in scale (maxpool, reorg
+// and single-input routes pass Q through), or -1.
+int producing_conv(const network *net, int i) {
+    while (i >= 0) {
+        const layer &l = net->layers[i];
+        if (l.type == CONVOLUTIONAL) return i;
+        if (l.type == ROUTE) {
+            if (l.n != 1) return -1;
+            i = l.input_layers[0];
+        } else {
+            --i;
+        }
+    }
+    return -1;
+}
+
+// Concatenated route inputs share one Q on the accelerator: force every
+// group to the smallest (widest range) member.
+void unify_route_q(const network *net, const std::vector<int> &slot, std::vector<int> &q) {
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        if (l.type != ROUTE || l.n < 2) continue;
+        std::vector<int> members;
+        for (int k = 0; k < l.n; ++k) {
+            const int src = producing_conv(net, l.input_layers[k]);
+            if (src >= 0) members.push_back(slot[src]);
+        }
+        if (members.size() < 2) continue;
+        int qmin = INT_MAX;
+        for (int s : members) qmin = std::min(qmin, q[s]);
+        for (int s : members) q[s] = qmin;
+    }
+}
+
+struct ObserverState {
+    const std::vector<int> *slot;
+    std::vector<AbsHistogram> *hists;
+};
+
+void observe_layer(const Yolo2LayerView &view, void *user) {
+    auto *st = static_cast<ObserverState *>(user);
+    const int s = (*st->slot)[view.layer];
+    if (s < 0 || !view.is_float) return;
+    (*st->hists)[s].add(static_cast<const float *>(view.data), static_cast<size_t>(view.c) * view.h, view.w, view.row_stride);
+}
+
+// Runs images worker, worker + jobs, ... and accumulates into hists.
+// Returns the number of images actually processed.
+uint32_t run_worker(const CalibConfig &cfg, const std::vector<std::string> &images, int worker, int jobs,
+                    std::vector<AbsHistogram> &hists) {
+    NetworkGuard net(cfg.cfg_path);
+
+    const std::vector<int> slot = conv_slots(net.ptr);
+    hists.assign(1 + std::count_if(slot.begin(), slot.end(), [](int s) { return s >= 0; }), AbsHistogram());
+    ObserverState state{&slot, &hists};
+
+    uint32_t done = 0;
+    for (size_t i = worker; i < images.size(); i += jobs) {
+        const auto start = std::chrono::steady_clock::now();
+        int w = 0, h = 0, c = 0;
+        // load_image_stb() exits on unreadable files; skip them here instead.
+        if (!stbi_info(images[i].c_str(), &w, &h, &c)) {
+            std::fprintf(stderr, "Warning: skipping unreadable image %s\n", images[i].c_str());
+            continue;
+        }
+        image im = load_image_stb(const_cast<char *>(images[i].c_str()), 3);
+        image sized = letterbox_image(im, net.ptr->w, net.ptr->h);
+        free_image(im);
+        hists[0].add(sized.data, static_cast<size_t>(sized.c) * sized.h, sized.w, sized.w);
+        try {
+            yolov2_hls_ps(net.ptr, sized.data, Precision::FP32, observe_layer, &state);
+        } catch (...) {
+            free_image(sized);
+            throw;
+        }
+        free_image(sized);
+        ++done;
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("  [%zu/%zu] %s (%.2f s)\n", i + 1, images.size(), images[i].c_str(), secs);
+    }
+    return done;
+}
+
+bool send_histograms(int fd, uint32_t done, const std::vector<AbsHistogram> &hists) {
+    const uint32_t n = static_cast<uint32_t>(hists.size());
+    if (!write_all(fd, &done, sizeof(done)) || !write_all(fd, &n, sizeof(n))) return false;
+    for (const AbsHistogram &h : hists) {
+        if (!write_all(fd, &h.range_log2, sizeof(h.range_log2)) ||
+            !write_all(fd, &h.maxabs, sizeof(h.maxabs)) ||
+            !write_all(fd, &h.count, sizeof(h.count)) ||
+            !write_all(fd, h.bins.data(), h.bins.size() * sizeof(uint64_t))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool receive_histograms(int fd, uint32_t &done, std::vector<AbsHistogram> &hists) {
+    uint32_t n = 0;
+    if (!read_all(fd, &done, sizeof(done)) || !read_all(fd, &n, sizeof(n))) return false;
+    hists.assign(n, AbsHistogram());
+    for (AbsHistogram &h : hists) {
+        if (!read_all(fd, &h.range_log2, sizeof(h.range_log2)) ||
+            !read_all(fd, &h.maxabs, sizeof(h.maxabs)) ||
+            !read_all(fd, &h.count, sizeof(h.count)) ||
+            !read_all(fd, h.bins.data(), h.bins.size() * sizeof(uint64_t))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Forks `jobs` workers and merges their histograms into merged.
+uint32_t collect_from_workers(const CalibConfig &cfg, const std::vector<std::string> &images, int jobs,
+                              std::vector<AbsHistogram> &merged) {
+    uint32_t done = 0;
+    run_forked_workers(
+        jobs,
+        [&](int w, int fd) {
+            std::vector<AbsHistogram> hists;
+            const uint32_t part_done = run_worker(cfg, images, w, jobs, hists);
+            return send_histograms(fd, part_done, hists);
+        },
+        [&](int, int fd) {
+            std::vector<AbsHistogram> part;
+            uint32_t part_done = 0;
+            if (!receive_histograms(fd, part_done, part)) return false;
+            if (merged.empty()) {
+                merged = std::move(part);
+            } else if (part.size() == merged.size()) {
+                for (size_t s = 0; s < merged.size(); ++s) merged[s].merge(std::move(part[s]));
+            } else {
+                return false;
+            }
+            done += part_done;
+            return true;
+        },
+        "Calibration worker failed");
+    return done;
+}
+
+// Histograms over all images (in-process for a single job).
+std::vector<AbsHistogram> collect_histograms(const CalibConfig &cfg, const std::vector<std::string> &images,
+                                             int jobs) {
+    std::vector<AbsHistogram> merged;
+    uint32_t done = 0;
+    if (jobs == 1) {
+        done = run_worker(cfg, images, 0, 1, merged);
+    } else {
+        done = collect_from_workers(cfg, images, jobs, merged);
+    }
+    if (done == 0) throw std::runtime_error("No calibration image could be processed");
+    std::printf("Processed %u of %zu image(s)\n", done, images.size());
+    return merged;
+}
+
+void write_q_table(const std::string &path, const std::vector<int> &q) {
+    std::vector<int32_t> out(q.begin(), q.end());
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (!fp) throw std::runtime_error("Couldn't open Q table for writing: " + path);
+    const size_t wr = std::fwrite(out.data(), sizeof(int32_t), out.size(), fp);
+    std::fclose(fp);
+    if (wr != out.size()) throw std::runtime_error("Short write: " + path);
+    std::printf("Wrote %zu activation Q values to %s\n", out.size(), path.c_str());
+}
+
+// Chooses, reports and (optionally) writes the Q table for one bit width.
+void emit_q_table(const CalibConfig &cfg, const network *net, const std::vector<AbsHistogram> &hists, int bits,
+                  const std::string &file_name) {
+    const std::vector<int> slot = conv_slots(net);
+    std::vector<int> q(hists.size());
+    for (size_t s = 0; s < hists.size(); ++s) {
+        q[s] = select_activation_q(hists[s], bits, cfg.method, cfg.percentile);
+    }
+    unify_route_q(net, slot, q);
+
+    std::printf("\nint%d activation Q (method: %s)\n", bits, to_string(cfg.method));
+    std::printf("  %-5s %-6s %12s %6s %6s %6s %6s %10s\n", "entry", "layer", "max|x|", "Q_max", "Q_pct", "Q_kl",
+                "Q", "clipped");
+    for (size_t s = 0; s < hists.size(); ++s) {
+        int layer_idx = -1;
+        for (int i = 0; i < net->n; ++i) {
+            if (slot[i] == static_cast<int>(s)) layer_idx = i;
+        }
+        const AbsHistogram &h = hists[s];
+        std::printf("  %-5zu %-6s %12.5g %6d %6d %6d %6d %9.5f%%\n", s,
+                    layer_idx < 0 ? "input" : std::to_string(layer_idx).c_str(), h.maxabs,
+                    select_q(h.maxabs, bits), select_q_percentile(h, bits, cfg.percentile), select_q_kl(h, bits), q[s],
+                    100.0 * clipped_fraction(h, q[s], bits));
+    }
+
+    if (cfg.write) {
+        std::filesystem::create_directories(cfg.out_dir);
+        write_q_table((std::filesystem::path(cfg.out_dir) / file_name).string(), q);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const CalibConfig cfg = parse_args(argc, argv);
+        const std::vector<std::string> images = list_images(cfg.images, cfg.max_images);
+
+        const int jobs = worker_count(cfg.jobs, images.size());
+
+        // Calibration runs must not write region dumps or consult the golden store.
+        setenv("YOLO2_NO_DUMP", "1", 1);
+        unsetenv("YOLO2_GOLDEN_DIR");
+
+        std::printf("Calibrating on %zu image(s) from %s with %d worker(s)\n", images.size(), cfg.images.c_str(),
+                    jobs);
+        const auto start = std::chrono::steady_clock::now();
+        const std::vector<AbsHistogram> hists = collect_histograms(cfg, images, jobs);
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("Collected %zu activation histograms in %.1f s\n", hists.size(), secs);
+
+        NetworkGuard net(cfg.cfg_path);
+
+        if (cfg.int16) emit_q_table(cfg, net.ptr, hists, 16, "iofm_Q.bin");
+        if (cfg.int8) emit_q_table(cfg, net.ptr, hists, 8, "iofm_int8_Q.bin");
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
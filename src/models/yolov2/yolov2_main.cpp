@@ -1,13 +1,12 @@
 /*
  * YOLOv2 Object Detection - CLI entry point
  *
- * Single-translation-unit driver for the float32 CPU/HLS pipeline.
+ * Command-line front end of the libyolo2 Session (yolo2_session.hpp).
  * Responsibilities:
  *  - Parse CLI arguments (cfg, names, input image, output prefix, thresholds)
- *  - Load network/alphabet
- *  - Preprocess image to network size (letterbox)
- *  - Run inference via selected backend (default: HLS path)
- *  - Postprocess detections, draw labels, and save outputs
+ *  - Open a Session (network + weights of the selected backend) and the alphabet
+ *  - Run the input image through the Session (letterbox, inference, boxes, NMS)
+ *  - Draw labels and save outputs
  *
  */
 
@@ -20,11 +19,12 @@
 #include <chrono>
 #include <fstream>
 #include <filesystem>
-#include <iomanip>
 
 #include <core/yolo.h>
 #include <core/precision.hpp>
-#include <api.hpp>
+
+#include "yolo2_session.hpp"
+#include "yolo2_tensor.h"
 
 namespace {
 
@@ -36,29 +36,10 @@ struct AppConfig {
     float thresh = 0.25f;
     float nms = 0.45f;
     float hier_thresh = 0.5f;
-    enum class Backend { Hls, Cpu } backend = Backend::Hls;
+    yolo2::Backend backend = yolo2::Backend::Hls;
     Precision precision = Precision::FP32;
 };
 
-void dump_float_array_text(const char *path, const float *data, size_t count) {
-    if (!path || !path[0] || !data || count == 0) {
-        return;
-    }
-
-    std::ofstream out(path);
-    if (!out) {
-        std::fprintf(stderr, "Warning: cannot open dump file %s\n", path);
-        return;
-    }
-
-    out << std::setprecision(9);
-    for (size_t i = 0; i < count; ++i) {
-        out << data[i] << '\n';
-    }
-
-    std::printf("Dumped %zu floats to %s\n", count, path);
-}
-
 void print_usage(const char *prog) {
     std::printf(
         "Usage: %s [options]\n"
@@ -70,7 +51,7 @@ void print_usage(const char *prog) {
         "  --thresh <float>      Confidence threshold (default: 0.5)\n"
         "  --nms <float>         NMS IoU threshold (default: 0.45)\n"
         "  --hier <float>        Hierarchical threshold (default: 0.5)\n"
-        "  --backend <hls|cpu>   Backend selector (default: hls; cpu stub)\n"
+        "  --backend <hls>       Backend selector (default: hls)\n"
         "  --precision <fp32|int16> Precision selector (default: fp32)\n"
         "  --help                Show this help message\n",
         prog);
@@ -103,12 +84,10 @@ AppConfig parse_args(int argc, char **argv) {
             cfg.hier_thresh = std::strtof(argv[++i], nullptr);
         } else if (arg == "--backend" && i + 1 < argc) {
             std::string backend_val = argv[++i];
-            if (backend_val == "hls") {
-                cfg.backend = AppConfig::Backend::Hls;
-            } else if (backend_val == "cpu") {
-                cfg.backend = AppConfig::Backend::Cpu;
-            } else {
-                std::fprintf(stderr, "Unsupported backend '%s'. Use 'hls' (available) or 'cpu' (stub).\n",
+            try {
+                cfg.backend = yolo2::parse_backend(backend_val);
+            } catch (const std::exception &) {
+                std::fprintf(stderr, "Unsupported backend '%s'. Use 'hls'.\n",
                              backend_val.c_str());
                 std::exit(1);
             }
@@ -156,28 +135,11 @@ void free_alphabet(image **alphabet) {
     free(alphabet);
 }
 
-void free_network_deep(network *net) {
-    if (!net) return;
-    for (int i = 0; i < net->n; ++i) {
-        free_layer(net->layers[i]);
-    }
-    free(net->layers);
-    free(net->seen);
-    free(net->t);
-    free(net->cost);
-    free(net);
-}
-
 struct AlphabetGuard {
     image **ptr = nullptr;
     ~AlphabetGuard() { free_alphabet(ptr); }
 };
 
-struct NetworkGuard {
-    network *ptr = nullptr;
-    ~NetworkGuard() { free_network_deep(ptr); }
-};
-
 struct ImageGuard {
     image img{};
     bool owns = false;
@@ -254,12 +216,14 @@ void run_detector(AppConfig cfg) {
     std::printf("  precision: %s\n", to_string(cfg.precision));
     std::printf("  output: %s[.png]\n", cfg.output_prefix.c_str());
 
-    NetworkGuard net_guard;
-    net_guard.ptr = load_network(const_cast<char *>(cfg.cfg_path.c_str()));
-    if (!net_guard.ptr) {
-        throw std::runtime_error("Failed to load network");
-    }
-    set_batch_network(net_guard.ptr, 1);
+    yolo2::SessionOptions options;
+    options.cfg_path = cfg.cfg_path;
+    options.backend = cfg.backend;
+    options.precision = cfg.precision;
+    options.thresh = cfg.thresh;
+    options.hier_thresh = cfg.hier_thresh;
+    options.nms = cfg.nms;
+    yolo2::Session session(options);
 
     const std::vector<std::string> label_strings = load_label_lines(cfg.names_path);
     std::vector<const char *> label_ptrs;
@@ -275,21 +239,9 @@ void run_detector(AppConfig cfg) {
     std::printf("Input img: %s (w=%d, h=%d, c=%d)\n",
                 cfg.input_path.c_str(), input_img.img.w, input_img.img.h, input_img.img.c);
 
-    const int net_w = net_guard.ptr->w;
-    const int net_h = net_guard.ptr->h;
-    ImageGuard sized(letterbox_image(input_img.img, net_w, net_h), true);
-
+    const yolo2::Frame frame(input_img.img.data, input_img.img.w, input_img.img.h, yolo2::PixelFormat::F32_PLANAR);
     const auto start = std::chrono::high_resolution_clock::now();
-    switch (cfg.backend) {
-        case AppConfig::Backend::Hls:
-            yolov2_hls_ps(net_guard.ptr, sized.img.data, cfg.precision);
-            break;
-        case AppConfig::Backend::Cpu:
-            // CPU path placeholder: the current codebase does not load float weights
-            // into network layers. This hook will be wired once weights loading is
-            // refactored out of the HLS path.
-            throw std::runtime_error("CPU backend is not wired yet (weights not loaded in this build).");
-    }
+    const yolo2::Detections found = session.detect(frame);
     const auto end = std::chrono::high_resolution_clock::now();
     const double elapsed = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
     std::printf("%s: Predicted in %.3f seconds.\n", cfg.input_path.c_str(), elapsed);
@@ -298,36 +250,39 @@ void run_detector(AppConfig cfg) {
     const bool do_dump = !(disable_dumps && disable_dumps[0] && disable_dumps[0] != '0');
     const char *dump_path = std::getenv("YOLO2_DUMP_REGION");
     if (!dump_path || !dump_path[0]) {
-        dump_path = "yolov2_region_proc_cpu.txt";
-    }
-    if (do_dump) {
-        layer last = net_guard.ptr->layers[net_guard.ptr->n - 1];
-        dump_float_array_text(dump_path, last.output, static_cast<size_t>(last.outputs));
+        dump_path = "yolov2_region_proc_cpu.y2t";
     }
-
-    int nboxes = 0;
-    layer last = net_guard.ptr->layers[net_guard.ptr->n - 1];
-    detection *dets = get_network_boxes(net_guard.ptr, input_img.img.w, input_img.img.h,
-                                        cfg.thresh, cfg.hier_thresh, 0, 1, &nboxes);
-    if (!dets) {
-        throw std::runtime_error("get_network_boxes returned null");
-    }
-
-    if (cfg.nms > 0.0f) {
-        do_nms_sort(dets, nboxes, last.classes, cfg.nms);
+    if (do_dump && yolo2_tensor_dump_floats(dump_path, session.region_output(), session.region_outputs()) == 0) {
+        std::printf("Dumped %zu floats to %s\n", session.region_outputs(), dump_path);
     }
 
+    const int classes = session.classes();
     const int available_labels = static_cast<int>(label_ptrs.size());
-    if (available_labels < last.classes) {
+    if (available_labels < classes) {
         std::fprintf(stderr,
                      "Warning: names file provides %d labels, but network expects %d classes.\n",
-                     available_labels, last.classes);
+                     available_labels, classes);
     }
 
-    draw_detections(input_img.img, dets, nboxes, cfg.thresh,
-                    const_cast<char **>(label_ptrs.data()), alphabet_guard.ptr, last.classes);
-
-    free_detections(dets, nboxes);
+    // draw_detections() takes darknet boxes: one per Detections box index,
+    // with the scores of its classes.
+    std::vector<detection> dets;
+    std::vector<std::vector<float>> probs;
+    for (size_t i = 0; i < found.size(); ++i) {
+        if (i == 0 || found.box[i] != found.box[i - 1]) {
+            probs.emplace_back(classes, 0.0f);
+            detection d{};
+            d.bbox = box{found.x[i], found.y[i], found.w[i], found.h[i]};
+            d.classes = classes;
+            dets.push_back(d);
+        }
+        probs.back()[found.cls[i]] = found.score[i];
+    }
+    for (size_t i = 0; i < dets.size(); ++i) {
+        dets[i].prob = probs[i].data();
+    }
+    draw_detections(input_img.img, dets.data(), static_cast<int>(dets.size()), cfg.thresh,
+                    const_cast<char **>(label_ptrs.data()), alphabet_guard.ptr, classes);
 
     save_image_png(input_img.img, cfg.output_prefix.c_str());
     std::printf("Output written to %s.png\n", cfg.output_prefix.c_str());
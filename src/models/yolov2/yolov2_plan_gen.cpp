@@ -0,0 +1,85 @@
+/*
+ * YOLOv2 Layer Plan Generator
+ *
+ * Parses the network cfg and writes the layer plan (linux_app/include/
+ * yolo2_plan.h) as a compiled-in table for YOLO2_STATIC_PLAN builds of the
+ * host model and linux_app. The plan is fixed to the tiling in params.hpp,
+ * the activation layout of this build (LAYOUT=) and the per-conv weight
+ * precision in <weights-dir>/weight_bits.bin, and the executors refuse to
+ * run it against anything else.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <core/yolo.h>
+#include <core/params.hpp>
+#include <models/yolov2/model_config.hpp>
+
+namespace {
+
+struct PlanGenConfig {
+    std::string cfg_path = "config/yolov2.cfg";
+    std::string weights_dir = "weights";
+    std::string out_path = "build/plan/yolo2_plan_table.h";
+};
+
+void print_usage(const char *prog) {
+    std::printf("Usage: %s [--cfg config/yolov2.cfg] [--weights-dir weights] [--out build/plan/yolo2_plan_table.h]\n",
+                prog);
+}
+
+PlanGenConfig parse_args(int argc, char **argv) {
+    PlanGenConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if ((arg == "--cfg" || arg == "-c") && i + 1 < argc) {
+            cfg.cfg_path = argv[++i];
+        } else if (arg == "--weights-dir" && i + 1 < argc) {
+            cfg.weights_dir = argv[++i];
+        } else if ((arg == "--out" || arg == "-o") && i + 1 < argc) {
+            cfg.out_path = argv[++i];
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+    return cfg;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const PlanGenConfig cfg = parse_args(argc, argv);
+
+        network *net = load_network(const_cast<char *>(cfg.cfg_path.c_str()));
+        if (!net) throw std::runtime_error("Failed to load cfg: " + cfg.cfg_path);
+        int conv_layers = 0;
+        for (int i = 0; i < net->n; ++i) if (net->layers[i].type == CONVOLUTIONAL) conv_layers++;
+
+        const std::vector<int> bits = yolo2_weight_bits(cfg.weights_dir, conv_layers);
+        const yolo2_plan_t plan = yolo2_make_plan(net, Tm, Tn, Tr, Tc, OnChipIB_Height, OnChipIB_Width, bits);
+
+        const std::filesystem::path out(cfg.out_path);
+        if (out.has_parent_path()) std::filesystem::create_directories(out.parent_path());
+        FILE *fp = std::fopen(cfg.out_path.c_str(), "w");
+        if (!fp) throw std::runtime_error("Failed to open " + cfg.out_path);
+        const int rc = yolo2_plan_write(fp, &plan, cfg.cfg_path.c_str());
+        if (std::fclose(fp) != 0 || rc != 0) throw std::runtime_error("Failed to write " + cfg.out_path);
+
+        std::printf("Layer plan     : %s (%d layers, Tm=%d Tn=%d Tr=%d Tc=%d, %s layout)\n", cfg.out_path.c_str(),
+                    plan.n, plan.tm, plan.tn, plan.tr, plan.tc, plan.act_blocked ? "blocked" : "CHW");
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "Fatal error: %s\n", ex.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,448 @@
+/*
+ * YOLOv2 Per-Layer Weight Precision Search
+ *
+ * Chooses which conv layers can store their weights as int8 (packed two per
+ * 16-bit word, see weight_load_reorg), or with --levels 8,4 as 4-bit codebook
+ * indices, while the detections stay close to the FP32 model on a
+ * calibration set.
+ *
+ *  1. FP32 reference detections for every image.
+ *  2. Sensitivity: each conv layer alone at each level, scored by detection
+ *     agreement with the reference (F1 over same-class matches at IoU >= 0.5).
+ *  3. Greedy, one level after the other (8, then 4): lower layers in order of
+ *     decreasing agreement (ties: larger weight savings first) and keep each
+ *     one only while the mean agreement stays >= --min-agreement.
+ *
+ * 8-bit layers are emulated in the FP32 host model by rounding their weights
+ * onto the int8 grid the INT16 datapath uses, 4-bit layers by snapping them to
+ * the layer codebook yolov2_weight_gen would fit. With --per-channel, reduced
+ * layers are requantized per output channel (yolo2_requant.h) and emulated
+ * on the per-channel grids. The result is written as
+ * weights/weight_bits.bin (input to yolov2_weight_gen --weight-bits) and
+ * reported with the DDR traffic and latency estimate of yolo2_cost_model.hpp.
+ *
+ * Like yolov2_calib, images are spread over forked worker processes
+ * (yolo2_tool_workers.hpp) because the host model keeps its buffers in
+ * function statics.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+
+#include <core/yolo.h>
+#include <core/precision.hpp>
+#include <api.hpp>
+#include <models/yolov2/model_config.hpp>
+#include <models/yolov2/yolo2_cost_model.hpp>
+
+#include "yolo2_tool_workers.hpp"
+
+namespace {
+
+using namespace yolo2_tools;
+
+struct SearchConfig {
+    std::string cfg_path = "config/yolov2.cfg";
+    std::string images = "examples/test_images";
+    std::string out_dir = "weights";
+    double min_agreement = 0.95;
+    std::vector<int> levels = {8};  // descending
+    float thresh = 0.25f;
+    float nms = 0.45f;
+    float iou = 0.5f;
+    bool write = true;
+    int max_images = 0;
+    int jobs = 0;
+    bool per_channel = false;
+};
+
+void print_usage(const char *argv0) {
+    std::printf("Usage: %s [--images <dir|file>] [--cfg <cfg>] [--out-dir <dir>] [--min-agreement A]\n"
+                "          [--levels 8[,4]] [--per-channel] [--thresh T] [--nms N] [--iou I] [--max-images N] [--jobs N]\n"
+                "          [--no-write]\n"
+                "\n"
+                "  --images <path>      Calibration image directory (jpg/png/bmp) or a single image\n"
+                "                       (default: examples/test_images)\n"
+                "  --min-agreement A    Lowest accepted mean detection agreement with FP32, in [0, 1]\n"
+                "                       (default: 0.95)\n"
+                "  --levels L[,L]       Reduced weight precisions to try: 8 (int8) and/or 4 (16-entry\n"
+                "                       codebook) (default: 8)\n"
+                "  --per-channel        Requantize reduced layers per output channel (multiplier + shift\n"
+                "                       at write-back) instead of one power-of-two scale per layer\n"
+                "  --thresh/--nms       Detection threshold and NMS IoU (default: 0.25 / 0.45)\n"
+                "  --iou I              IoU for a detection to count as matched (default: 0.5)\n"
+                "  --jobs N             Worker processes (default: all cores)\n"
+                "  --no-write           Print the report only\n"
+                "\n"
+                "Requires weights/weights_reorg.bin and weights/bias.bin (fp32). Writes\n"
+                "<out-dir>/weight_bits.bin; regenerate the int16 weights with\n"
+                "yolov2_weight_gen --precision int16 --quantize --weight-bits <out-dir>/weight_bits.bin.\n",
+                argv0);
+}
+
+SearchConfig parse_args(int argc, char **argv) {
+    SearchConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if ((arg == "--images" || arg == "-i") && i + 1 < argc) {
+            cfg.images = argv[++i];
+        } else if ((arg == "--cfg" || arg == "-c") && i + 1 < argc) {
+            cfg.cfg_path = argv[++i];
+        } else if ((arg == "--out-dir" || arg == "-o") && i + 1 < argc) {
+            cfg.out_dir = argv[++i];
+        } else if (arg == "--min-agreement" && i + 1 < argc) {
+            cfg.min_agreement = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--levels" && i + 1 < argc) {
+            cfg.levels.clear();
+            std::string list(argv[++i]);
+            for (size_t pos = 0; pos <= list.size();) {
+                const size_t end = std::min(list.find(',', pos), list.size());
+                cfg.levels.push_back(std::atoi(list.substr(pos, end - pos).c_str()));
+                pos = end + 1;
+            }
+        } else if (arg == "--thresh" && i + 1 < argc) {
+            cfg.thresh = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--nms" && i + 1 < argc) {
+            cfg.nms = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--iou" && i + 1 < argc) {
+            cfg.iou = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--max-images" && i + 1 < argc) {
+            cfg.max_images = std::atoi(argv[++i]);
+        } else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+            cfg.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--per-channel") {
+            cfg.per_channel = true;
+        } else if (arg == "--no-write") {
+            cfg.write = false;
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            throw std::runtime_error("Unknown option: " + arg);
+        }
+    }
+    if (!(cfg.min_agreement >= 0.0 && cfg.min_agreement <= 1.0)) {
+        throw std::runtime_error("--min-agreement must be in [0, 1]");
+    }
+    for (int l : cfg.levels) {
+        if (l != 8 && l != 4) throw std::runtime_error("--levels entries must be 8 or 4");
+    }
+    std::sort(cfg.levels.begin(), cfg.levels.end(), std::greater<int>());
+    cfg.levels.erase(std::unique(cfg.levels.begin(), cfg.levels.end()), cfg.levels.end());
+    return cfg;
+}
+
+// One thresholded (box, class) pair after NMS, in image-relative coordinates.
+struct Det {
+    int cls;
+    float prob;
+    float x, y, w, h;
+};
+
+// Detections of one image; ok is false when the image could not be read.
+struct ImageDets {
+    bool ok = false;
+    std::vector<Det> dets;
+};
+
+float iou(const Det &a, const Det &b) {
+    const float ow = std::min(a.x + a.w / 2, b.x + b.w / 2) - std::max(a.x - a.w / 2, b.x - b.w / 2);
+    const float oh = std::min(a.y + a.h / 2, b.y + b.h / 2) - std::max(a.y - a.h / 2, b.y - b.h / 2);
+    if (ow <= 0.0f || oh <= 0.0f) return 0.0f;
+    const float inter = ow * oh;
+    return inter / (a.w * a.h + b.w * b.h - inter);
+}
+
+// F1 of greedy same-class matches (highest probability first); 1 when both are empty.
+double agreement(const std::vector<Det> &ref, std::vector<Det> cand, float min_iou) {
+    if (ref.empty() && cand.empty()) return 1.0;
+    std::sort(cand.begin(), cand.end(), [](const Det &a, const Det &b) { return a.prob > b.prob; });
+    std::vector<bool> used(ref.size(), false);
+    int matched = 0;
+    for (const Det &d : cand) {
+        int best = -1;
+        float best_iou = min_iou;
+        for (size_t k = 0; k < ref.size(); ++k) {
+            if (used[k] || ref[k].cls != d.cls) continue;
+            const float v = iou(ref[k], d);
+            if (v >= best_iou) {
+                best = static_cast<int>(k);
+                best_iou = v;
+            }
+        }
+        if (best >= 0) {
+            used[best] = true;
+            ++matched;
+        }
+    }
+    return 2.0 * matched / static_cast<double>(ref.size() + cand.size());
+}
+
+ImageDets detect(network *net, const SearchConfig &cfg, const std::string &path, const std::vector<int> &bits) {
+    ImageDets out;
+    int w = 0, h = 0, c = 0;
+    // load_image_stb() exits on unreadable files; skip them here instead.
+    if (!stbi_info(path.c_str(), &w, &h, &c)) return out;
+    image im = load_image_stb(const_cast<char *>(path.c_str()), 3);
+    image sized = letterbox_image(im, net->w, net->h);
+    try {
+        yolov2_hls_ps(net, sized.data, Precision::FP32, nullptr, nullptr, bits.data());
+    } catch (...) {
+        free_image(sized);
+        free_image(im);
+        throw;
+    }
+    free_image(sized);
+
+    int nboxes = 0;
+    const layer &last = net->layers[net->n - 1];
+    detection *dets = get_network_boxes(net, im.w, im.h, cfg.thresh, 0.5f, 0, 1, &nboxes);
+    free_image(im);
+    if (!dets) throw std::runtime_error("get_network_boxes returned null");
+    if (cfg.nms > 0.0f) do_nms_sort(dets, nboxes, last.classes, cfg.nms);
+    for (int i = 0; i < nboxes; ++i) {
+        for (int k = 0; k < last.classes; ++k) {
+            if (dets[i].prob[k] > cfg.thresh) {
+                const box &b = dets[i].bbox;
+                out.dets.push_back({k, dets[i].prob[k], b.x, b.y, b.w, b.h});
+            }
+        }
+    }
+    free_detections(dets, nboxes);
+    out.ok = true;
+    return out;
+}
+
+// Runs images worker, worker + jobs, ... with the given per-conv bits.
+std::vector<std::pair<uint32_t, ImageDets>> run_worker(const SearchConfig &cfg, const std::vector<std::string> &images,
+                                                       const std::vector<int> &bits, int worker, int jobs) {
+    NetworkGuard net(cfg.cfg_path);
+
+    std::vector<std::pair<uint32_t, ImageDets>> results;
+    for (size_t i = worker; i < images.size(); i += jobs) {
+        results.emplace_back(static_cast<uint32_t>(i), detect(net.ptr, cfg, images[i], bits));
+    }
+    return results;
+}
+
+bool send_results(int fd, const std::vector<std::pair<uint32_t, ImageDets>> &results) {
+    const uint32_t n = static_cast<uint32_t>(results.size());
+    if (!write_all(fd, &n, sizeof(n))) return false;
+    for (const auto &r : results) {
+        const uint32_t hdr[3] = {r.first, r.second.ok ? 1u : 0u, static_cast<uint32_t>(r.second.dets.size())};
+        if (!write_all(fd, hdr, sizeof(hdr)) ||
+            !write_all(fd, r.second.dets.data(), r.second.dets.size() * sizeof(Det))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool receive_results(int fd, std::vector<ImageDets> &out) {
+    uint32_t n = 0;
+    if (!read_all(fd, &n, sizeof(n))) return false;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t hdr[3];
+        if (!read_all(fd, hdr, sizeof(hdr)) || hdr[0] >= out.size()) return false;
+        ImageDets &d = out[hdr[0]];
+        d.ok = hdr[1] != 0;
+        d.dets.resize(hdr[2]);
+        if (!read_all(fd, d.dets.data(), d.dets.size() * sizeof(Det))) return false;
+    }
+    return true;
+}
+
+// Detections for every image under one precision assignment.
+std::vector<ImageDets> run_config(const SearchConfig &cfg, const std::vector<std::string> &images,
+                                  const std::vector<int> &bits, int jobs) {
+    std::vector<ImageDets> out(images.size());
+    if (jobs == 1) {
+        for (auto &r : run_worker(cfg, images, bits, 0, 1)) out[r.first] = std::move(r.second);
+        return out;
+    }
+
+    run_forked_workers(
+        jobs, [&](int w, int fd) { return send_results(fd, run_worker(cfg, images, bits, w, jobs)); },
+        [&](int, int fd) { return receive_results(fd, out); }, "Search worker failed");
+    return out;
+}
+
+double mean_agreement(const std::vector<ImageDets> &ref, const std::vector<ImageDets> &cand, float min_iou) {
+    double sum = 0.0;
+    int n = 0;
+    for (size_t i = 0; i < ref.size(); ++i) {
+        if (!ref[i].ok) continue;
+        if (!cand[i].ok) throw std::runtime_error("Image became unreadable during the search");
+        sum += agreement(ref[i].dets, cand[i].dets, min_iou);
+        ++n;
+    }
+    return n ? sum / n : 1.0;
+}
+
+struct ConvInfo {
+    int layer;
+    Yolo2ConvShape shape;
+    int count;
+};
+
+std::vector<ConvInfo> conv_layers(const network *net) {
+    std::vector<ConvInfo> convs;
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        if (l.type != CONVOLUTIONAL) continue;
+        convs.push_back({i, {l.c, l.n, l.size, l.stride, l.pad, l.w, l.h}, l.n * l.c * l.size * l.size});
+    }
+    return convs;
+}
+
+// sensitivity[l][k]: agreement with conv k alone at levels[l].
+void report(const std::vector<ConvInfo> &convs, const std::vector<int> &bits, const std::vector<int> &levels,
+            const std::vector<std::vector<double>> &sensitivity) {
+    std::printf("\n  %-5s %-6s %-16s %4s", "conv", "layer", "shape", "bits");
+    for (int l : levels) std::printf(" %8s%d", "agree@", l);
+    std::printf(" %10s %10s %9s %9s\n", "w MB", "DDR MB", "est ms", "16b ms");
+    Yolo2LayerCost total, total16;
+    int64_t wbytes = 0, wbytes16 = 0;
+    for (size_t k = 0; k < convs.size(); ++k) {
+        const ConvInfo &c = convs[k];
+        const Yolo2LayerCost cost = yolo2_conv_cost(c.shape, bits[k]);
+        const Yolo2LayerCost cost16 = yolo2_conv_cost(c.shape, 16);
+        const int prec = yolo2_wbits_precision(bits[k]);
+        const int64_t stored = static_cast<int64_t>(yolo2_weight_words(c.count, bits[k])) * kYolo2WordBytes;
+        wbytes += stored;
+        wbytes16 += static_cast<int64_t>(yolo2_weight_words(c.count, 16)) * kYolo2WordBytes;
+        char shape[32];
+        std::snprintf(shape, sizeof(shape), "%dx%dx%d->%d", c.shape.in_w, c.shape.ifm, c.shape.ksize, c.shape.ofm);
+        std::printf("  %-5zu %-6d %-16s %4d", k, c.layer, shape, prec);
+        for (const std::vector<double> &sens : sensitivity) std::printf(" %9.4f", sens[k]);
+        std::printf(" %10.2f %10.2f %9.3f %9.3f\n", stored / 1e6, cost.ddr_bytes() / 1e6, cost.seconds() * 1e3,
+                    cost16.seconds() * 1e3);
+        total.weight_bytes += cost.weight_bytes;
+        total.input_bytes += cost.input_bytes;
+        total.output_bytes += cost.output_bytes;
+        total.cycles += cost.cycles;
+        total16.weight_bytes += cost16.weight_bytes;
+        total16.input_bytes += cost16.input_bytes;
+        total16.output_bytes += cost16.output_bytes;
+        total16.cycles += cost16.cycles;
+    }
+    std::printf("\nWeight storage : %.2f MB (all 16-bit: %.2f MB)\n", wbytes / 1e6, wbytes16 / 1e6);
+    std::printf("Weight traffic : %.2f MB per frame (all 16-bit: %.2f MB)\n", total.weight_bytes / 1e6,
+                total16.weight_bytes / 1e6);
+    std::printf("DDR traffic    : %.2f MB per frame (all 16-bit: %.2f MB)\n", total.ddr_bytes() / 1e6,
+                total16.ddr_bytes() / 1e6);
+    std::printf("Est. conv time : %.2f ms (all 16-bit: %.2f ms, %.2fx)\n", total.seconds() * 1e3,
+                total16.seconds() * 1e3, total16.seconds() / total.seconds());
+}
+
+// weight_bits.bin entry of a reduced layer
+int level_word(const SearchConfig &cfg, int level) {
+    return level | (cfg.per_channel ? YOLO2_WBITS_REQUANT : 0);
+}
+
+void write_bits(const std::string &path, const std::vector<int> &bits) {
+    std::vector<int32_t> out(bits.begin(), bits.end());
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (!fp) throw std::runtime_error("Couldn't open for writing: " + path);
+    const size_t wr = std::fwrite(out.data(), sizeof(int32_t), out.size(), fp);
+    std::fclose(fp);
+    if (wr != out.size()) throw std::runtime_error("Short write: " + path);
+    std::printf("Wrote %zu per-layer weight precisions to %s\n", out.size(), path.c_str());
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const SearchConfig cfg = parse_args(argc, argv);
+        const std::vector<std::string> images = list_images(cfg.images, cfg.max_images);
+
+        const int jobs = worker_count(cfg.jobs, images.size());
+
+        // Search runs must not write region dumps or consult the golden store.
+        setenv("YOLO2_NO_DUMP", "1", 1);
+        unsetenv("YOLO2_GOLDEN_DIR");
+
+        NetworkGuard net(cfg.cfg_path);
+        const std::vector<ConvInfo> convs = conv_layers(net.ptr);
+        const size_t n = convs.size();
+
+        std::printf("Searching weight precision for %zu conv layers on %zu image(s) with %d worker(s), "
+                    "min agreement %.4f\n", n, images.size(), jobs, cfg.min_agreement);
+        const auto start = std::chrono::steady_clock::now();
+
+        const std::vector<int> all16(n, 16);
+        const std::vector<ImageDets> ref = run_config(cfg, images, all16, jobs);
+        const size_t usable = std::count_if(ref.begin(), ref.end(), [](const ImageDets &d) { return d.ok; });
+        if (usable == 0) throw std::runtime_error("No calibration image could be processed");
+        size_t ref_dets = 0;
+        for (const ImageDets &d : ref) ref_dets += d.dets.size();
+        std::printf("Reference: %zu detection(s) on %zu of %zu image(s)\n", ref_dets, usable, images.size());
+
+        std::vector<std::vector<double>> sensitivity(cfg.levels.size(), std::vector<double>(n, 1.0));
+        for (size_t l = 0; l < cfg.levels.size(); ++l) {
+            for (size_t k = 0; k < n; ++k) {
+                std::vector<int> bits = all16;
+                bits[k] = level_word(cfg, cfg.levels[l]);
+                sensitivity[l][k] = mean_agreement(ref, run_config(cfg, images, bits, jobs), cfg.iou);
+                std::printf("  conv %2zu (layer %2d) alone at %d bits: agreement %.4f\n", k, convs[k].layer,
+                            cfg.levels[l], sensitivity[l][k]);
+            }
+        }
+
+        std::vector<int> bits = all16;
+        double current = 1.0;
+        for (size_t l = 0; l < cfg.levels.size(); ++l) {
+            const int level = cfg.levels[l];
+            const std::vector<double> &sens = sensitivity[l];
+            std::vector<size_t> order(n);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                if (sens[a] != sens[b]) return sens[a] > sens[b];
+                return convs[a].count > convs[b].count;
+            });
+
+            for (size_t k : order) {
+                if (sens[k] < cfg.min_agreement) continue;
+                const int prev = bits[k];
+                bits[k] = level_word(cfg, level);
+                const double a = mean_agreement(ref, run_config(cfg, images, bits, jobs), cfg.iou);
+                const bool keep = a >= cfg.min_agreement;
+                std::printf("  + conv %2zu (layer %2d) at %d bits: agreement %.4f -> %s\n", k, convs[k].layer, level,
+                            a, keep ? "keep" : "revert");
+                if (keep) {
+                    current = a;
+                } else {
+                    bits[k] = prev;
+                }
+            }
+        }
+
+        const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const int w8 = static_cast<int>(std::count(bits.begin(), bits.end(), level_word(cfg, 8)));
+        const int w4 = static_cast<int>(std::count(bits.begin(), bits.end(), level_word(cfg, 4)));
+        std::printf("\n%d of %zu conv layers at 8 bits and %d at 4 bits%s, agreement %.4f (search took %.1f s)\n", w8,
+                    n, w4, cfg.per_channel ? " (per-channel)" : "", current, secs);
+        report(convs, bits, cfg.levels, sensitivity);
+
+        if (cfg.write) {
+            std::filesystem::create_directories(cfg.out_dir);
+            write_bits((std::filesystem::path(cfg.out_dir) / "weight_bits.bin").string(), bits);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+/*
+ * YOLOv2 Tensor Compare
+ *
+ * Compares two .y2t tensors (linux_app/include/yolo2_tensor.h), or two
+ * YOLO2_TAP_DIR directories layer by layer, and reports the max abs and ULP
+ * error and the first mismatching element per tensor. Older "%.9g" text
+ * dumps (.txt) are read as flat float tensors, so they can be compared too.
+ *
+ * ULP error is measured on the grid of the tensors: raw int16 steps when
+ * both are int16 at the same Q, float ULPs when both are fp32, otherwise
+ * steps of the coarser int16 grid.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "yolo2_golden.h"
+#include "yolo2_tensor.h"
+
+namespace {
+
+struct CmpConfig {
+    std::vector<std::string> paths;
+    double tol = 0.0;
+    double max_ulp = 0.0;
+    bool info = false;
+};
+
+void print_usage(const char *prog) {
+    std::printf("Usage: %s [--tol abs] [--ulp n] <a.y2t|a.txt|dir> <b.y2t|b.txt|dir>\n"
+                "       %s --info <file.y2t>...\n\n"
+                "  --tol   Accept elements whose abs error is <= abs (default 0)\n"
+                "  --ulp   Accept elements whose ULP error is <= n (default 0)\n"
+                "          An element mismatches when it exceeds both.\n"
+                "  --info  Print the header and value range of each file\n\n"
+                "Directories are compared file by file (layer_NN.y2t from YOLO2_TAP_DIR).\n"
+                "Exit code: 0 all match, 1 mismatch or missing tensor, 2 error.\n",
+                prog, prog);
+}
+
+CmpConfig parse_args(int argc, char **argv) {
+    CmpConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--tol" && i + 1 < argc) {
+            cfg.tol = std::atof(argv[++i]);
+        } else if (arg == "--ulp" && i + 1 < argc) {
+            cfg.max_ulp = std::atof(argv[++i]);
+        } else if (arg == "--info") {
+            cfg.info = true;
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::runtime_error("Unknown argument: " + arg);
+        } else {
+            cfg.paths.push_back(arg);
+        }
+    }
+    if (cfg.info ? cfg.paths.empty() : cfg.paths.size() != 2) {
+        print_usage(argv[0]);
+        std::exit(2);
+    }
+    return cfg;
+}
+
+// A mapped .y2t file, or a text dump read into memory as a flat fp32 tensor.
+class Tensor {
+public:
+    explicit Tensor(const std::string &path) {
+        if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".txt") == 0) {
+            std::ifstream in(path);
+            if (!in) throw std::runtime_error("Cannot open " + path);
+            float v;
+            while (in >> v) text_.push_back(v);
+            std::memset(&hdr_, 0, sizeof(hdr_));
+            hdr_.dtype = YOLO2_TENSOR_F32;
+            hdr_.layer = -1;
+            hdr_.type = -1;
+            hdr_.c = static_cast<uint32_t>(text_.size());
+            hdr_.h = hdr_.w = 1;
+            file_.hdr = &hdr_;
+            file_.data = text_.data();
+            file_.count = text_.size();
+        } else if (yolo2_tensor_map(path.c_str(), &file_) != 0) {
+            throw std::runtime_error("Cannot read tensor " + path);
+        }
+    }
+    ~Tensor() { yolo2_tensor_unmap(&file_); }
+    Tensor(const Tensor &) = delete;
+    Tensor &operator=(const Tensor &) = delete;
+
+    const yolo2_tensor_header_t &hdr() const { return *file_.hdr; }
+    size_t count() const { return file_.count; }
+    bool is_i16() const { return file_.hdr->dtype == YOLO2_TENSOR_I16; }
+    double value(size_t i) const { return yolo2_tensor_value(&file_, i); }
+    int16_t raw16(size_t i) const { return static_cast<const int16_t *>(file_.data)[i]; }
+    float raw32(size_t i) const { return static_cast<const float *>(file_.data)[i]; }
+
+    std::string dtype_str() const {
+        return is_i16() ? "i16 q" + std::to_string(hdr().q) : "f32";
+    }
+    std::string shape_str() const {
+        return std::to_string(hdr().c) + "x" + std::to_string(hdr().h) + "x" + std::to_string(hdr().w);
+    }
+
+private:
+    yolo2_tensor_file_t file_{};
+    yolo2_tensor_header_t hdr_{};
+    std::vector<float> text_;
+};
+
+const char *type_str(int type) {
+    switch (type) {
+        case YOLO2_GOLDEN_CONV: return "conv";
+        case YOLO2_GOLDEN_MAXPOOL: return "max";
+        case YOLO2_GOLDEN_REORG: return "reorg";
+        default: return "-";
+    }
+}
+
+// Distance in representable floats (0 for equal values, including +0/-0)
+double float_ulp(float a, float b) {
+    if (std::isnan(a) || std::isnan(b)) return (std::isnan(a) && std::isnan(b)) ? 0.0 : HUGE_VAL;
+    auto ordered = [](float f) {
+        int32_t i;
+        std::memcpy(&i, &f, sizeof(i));
+        return i < 0 ? static_cast<int64_t>(INT32_MIN) - i : static_cast<int64_t>(i);
+    };
+    return static_cast<double>(std::llabs(ordered(a) - ordered(b)));
+}
+
+struct CmpResult {
+    size_t mismatches = 0;
+    size_t first = 0;
+    double max_abs = 0.0;
+    double max_ulp = 0.0;
+};
+
+CmpResult compare(const Tensor &a, const Tensor &b, const CmpConfig &cfg) {
+    CmpResult r;
+    const size_t n = a.count();
+    const bool same_i16 = a.is_i16() && b.is_i16() && a.hdr().q == b.hdr().q;
+    const bool both_f32 = !a.is_i16() && !b.is_i16();
+    // Coarser int16 grid for mixed comparisons
+    int q = 0;
+    if (a.is_i16() && b.is_i16()) q = std::min(a.hdr().q, b.hdr().q);
+    else if (a.is_i16()) q = a.hdr().q;
+    else if (b.is_i16()) q = b.hdr().q;
+    const double lsb = std::ldexp(1.0, -q);
+
+    for (size_t i = 0; i < n; ++i) {
+        double err, ulp;
+        if (same_i16) {
+            const int16_t ra = a.raw16(i), rb = b.raw16(i);
+            if (ra == rb) continue;
+            ulp = std::abs(static_cast<int>(ra) - static_cast<int>(rb));
+            err = ulp * lsb;
+        } else if (both_f32) {
+            const float fa = a.raw32(i), fb = b.raw32(i);
+            if (fa == fb) continue;
+            err = std::fabs(static_cast<double>(fa) - fb);
+            ulp = float_ulp(fa, fb);
+        } else {
+            err = std::fabs(a.value(i) - b.value(i));
+            if (err == 0.0) continue;
+            ulp = err / lsb;
+        }
+        if (!(err <= r.max_abs)) r.max_abs = err;
+        if (!(ulp <= r.max_ulp)) r.max_ulp = ulp;
+        if (err > cfg.tol && ulp > cfg.max_ulp) {
+            if (r.mismatches++ == 0) r.first = i;
+        }
+    }
+    return r;
+}
+
+// Prints one result line; returns 0 on match, 1 on mismatch.
+int compare_files(const std::string &name, const std::string &pa, const std::string &pb, const CmpConfig &cfg) {
+    const Tensor a(pa);
+    const Tensor b(pb);
+    const int layer = a.hdr().layer >= 0 ? a.hdr().layer : b.hdr().layer;
+    std::printf("%-20s %5s %-6s %-14s %-8s %-8s ", name.c_str(), layer >= 0 ? std::to_string(layer).c_str() : "-",
+                type_str(a.hdr().type), a.shape_str().c_str(), a.dtype_str().c_str(), b.dtype_str().c_str());
+    if (a.count() != b.count()) {
+        std::printf("SHAPE MISMATCH (%s vs %s)\n", a.shape_str().c_str(), b.shape_str().c_str());
+        return 1;
+    }
+    if (a.hdr().c != b.hdr().c || a.hdr().h != b.hdr().h || a.hdr().w != b.hdr().w) {
+        std::printf("(b is %s) ", b.shape_str().c_str());
+    }
+
+    const CmpResult r = compare(a, b, cfg);
+    std::printf("%12.6g %10.6g %10zu/%-10zu", r.max_abs, r.max_ulp, r.mismatches, a.count());
+    if (r.mismatches > 0) {
+        const size_t hw = static_cast<size_t>(a.hdr().h) * a.hdr().w;
+        if (hw == 1) {
+            std::printf("  first at [%zu]", r.first);
+        } else {
+            std::printf("  first at [c=%zu y=%zu x=%zu]", r.first / hw, (r.first % hw) / a.hdr().w,
+                        r.first % a.hdr().w);
+        }
+        std::printf(" %.9g vs %.9g", a.value(r.first), b.value(r.first));
+    }
+    std::printf("\n");
+    return r.mismatches > 0 ? 1 : 0;
+}
+
+void print_header() {
+    std::printf("%-20s %5s %-6s %-14s %-8s %-8s %12s %10s %21s\n", "tensor", "layer", "type", "shape (CxHxW)", "a", "b",
+                "max |err|", "max ulp", "mismatches");
+}
+
+int compare_dirs(const std::string &da, const std::string &db, const CmpConfig &cfg) {
+    std::map<std::string, int> names;  // bit 0: in a, bit 1: in b
+    for (int side = 0; side < 2; ++side) {
+        for (const auto &e : std::filesystem::directory_iterator(side == 0 ? da : db)) {
+            if (e.is_regular_file() && e.path().extension() == ".y2t") {
+                names[e.path().filename().string()] |= 1 << side;
+            }
+        }
+    }
+    if (names.empty()) throw std::runtime_error("No .y2t tensors in " + da + " or " + db);
+
+    print_header();
+    int failed = 0, missing = 0;
+    for (const auto &kv : names) {
+        if (kv.second != 3) {
+            std::printf("%-20s missing in %s\n", kv.first.c_str(), kv.second == 1 ? db.c_str() : da.c_str());
+            missing++;
+            continue;
+        }
+        failed += compare_files(kv.first, da + "/" + kv.first, db + "/" + kv.first, cfg);
+    }
+    std::printf("\n%zu tensors, %d mismatching, %d missing\n", names.size(), failed, missing);
+    return (failed || missing) ? 1 : 0;
+}
+
+void print_info(const std::string &path) {
+    const Tensor t(path);
+    double lo = HUGE_VAL, hi = -HUGE_VAL, sum = 0.0;
+    for (size_t i = 0; i < t.count(); ++i) {
+        const double v = t.value(i);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+        sum += v;
+    }
+    std::printf("%s: layer %d %s %s %s, %zu values, min %.9g max %.9g mean %.9g\n", path.c_str(), t.hdr().layer,
+                type_str(t.hdr().type), t.shape_str().c_str(), t.dtype_str().c_str(), t.count(), lo, hi,
+                t.count() ? sum / static_cast<double>(t.count()) : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        const CmpConfig cfg = parse_args(argc, argv);
+        if (cfg.info) {
+            for (const std::string &p : cfg.paths) print_info(p);
+            return 0;
+        }
+        const std::string &a = cfg.paths[0];
+        const std::string &b = cfg.paths[1];
+        if (std::filesystem::is_directory(a) && std::filesystem::is_directory(b)) {
+            return compare_dirs(a, b, cfg);
+        }
+        if (std::filesystem::is_directory(a) || std::filesystem::is_directory(b)) {
+            throw std::runtime_error("Compare two files or two directories");
+        }
+        for (const std::string &p : cfg.paths) {
+            if (!std::filesystem::is_regular_file(p)) throw std::runtime_error("No such file: " + p);
+        }
+        print_header();
+        return compare_files(std::filesystem::path(a).filename().string(), a, b, cfg);
+    } catch (const std::exception &ex) {
+        std::fprintf(stderr, "Fatal error: %s\n", ex.what());
+        return 2;
+    }
+}
@@ -2,7 +2,23 @@
  * YOLOv2 Weight Reorganization Tool
  *
  * Reads YOLOv2 weights and writes them in the tiled order expected by the HLS
- * accelerator (TM x TN chunks, KxK major). Supports fp32 and int16 inputs.
+ * accelerator (TM x TN chunks, KxK major). Supports fp32 and int16 inputs, and
+ * can start from a raw Darknet .weights file, folding batch norm and
+ * quantizing (int16/int8) in the same pass. Int16 outputs can mix in 8-bit
+ * layers (--weight-bits), stored two weights per 16-bit word, and 4-bit
+ * layers, stored as a 16-entry codebook plus four indices per word. With
+ * --per-channel, or YOLO2_WBITS_REQUANT entries in the --weight-bits table,
+ * every output channel is scaled to the full weight grid and write-back
+ * undoes the scale with a per-channel multiplier and shift (yolo2_requant.h).
+ *
+ * Inputs are mmapped; every (layer, Tm block) is an independent task whose
+ * output offset is known up front, so blocks are reorganized in parallel and
+ * written straight into the mmapped output file.
+ *
+ * --engine-b also writes the layers of the two-engine pipeline's stage B
+ * reorganized for a second accelerator build with another Tm/Tn
+ * (linux_app/include/yolo2_pipeline.h). Biases and Q tables do not depend on
+ * the tiling, so both engines read the one copy.
  */
 
 #include <cstdio>
@@ -13,73 +29,98 @@
 #include <filesystem>
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <cstdint>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <core/yolo.h>
 #include <core/yolo_cfg.hpp>
 #include <models/yolov2/model_config.hpp>
 #include <core/params.hpp>
+#include <models/yolov2/yolo2_host_ops.hpp>
 
 namespace {
 
 enum class Precision {
     FP32,
-    INT16
+    INT16,
+    INT8
 };
 
 const char *to_string(Precision p) {
-    return p == Precision::FP32 ? "fp32" : "int16";
-}
-
-template <typename T>
-void WeightReorg(const T *weight, T *weight_reorg, int IFM_NUM, int OFM_NUM, int Ksize) {
-    const int KxK = Ksize * Ksize;
-    const int IFM_NUMxKxK = IFM_NUM * KxK;
-
-    std::vector<T> weight_buffer(Tm * Tn * K * K);
-    std::vector<T> weight_buffer2(Tm * Tn * K * K);
-    int offset = 0;
-
-    for (int m = 0; m < OFM_NUM; m += Tm) {
-        int TM_MIN = std::min(Tm, OFM_NUM - m);
-        for (int n = 0; n < IFM_NUM; n += Tn) {
-            int TN_MIN = std::min(Tn, IFM_NUM - n);
-            int Woffset = m * IFM_NUMxKxK + n * KxK;
-
-            for (int tm = 0; tm < TM_MIN; tm++) {
-                std::memcpy(weight_buffer.data() + tm * TN_MIN * KxK,
-                            weight + tm * IFM_NUMxKxK + Woffset,
-                            TN_MIN * KxK * sizeof(T));
-            }
-
-            int TN_MINxTM_MIN = TN_MIN * TM_MIN;
-            for (int tk = 0; tk < KxK; tk++)
-                for (int tm = 0; tm < TM_MIN; tm++)
-                    for (int tn = 0; tn < TN_MIN; tn++) {
-                        weight_buffer2[tk * TN_MINxTM_MIN + tm * TN_MIN + tn] =
-                            weight_buffer[tm * TN_MIN * KxK + tn * KxK + tk];
-                    }
-
-            std::memcpy(weight_reorg + offset, weight_buffer2.data(),
-                        TM_MIN * TN_MIN * KxK * sizeof(T));
-            offset += TM_MIN * TN_MIN * KxK;
-        }
+    switch (p) {
+        case Precision::FP32: return "fp32";
+        case Precision::INT16: return "int16";
+        case Precision::INT8: return "int8";
     }
+    return "unknown";
 }
 
+// Tm x Tn of the engine a weight stream is reorganized for.
+struct Tiling {
+    int tm = Tm, tn = Tn;
+};
+
 struct GenConfig {
     std::string cfg_path = "config/yolov2.cfg";
     std::string weights_in;
+    std::string bias_in;
+    std::string darknet_in;
     std::string weights_out;
+    std::string weight_bits_in;
     Precision precision = Precision::FP32;
+    bool quantize = false;
+    bool per_channel = false;
+    int jobs = 0;
+    bool engine_b = false;
+    Tiling engine_b_tile;
+    int engine_b_split = -1;  // last layer of stage A; -1: every layer
 };
 
 Precision parse_precision(const std::string &arg) {
     if (arg == "fp32" || arg == "float" || arg == "f32") return Precision::FP32;
     if (arg == "int16" || arg == "i16" || arg == "fixed") return Precision::INT16;
+    if (arg == "int8" || arg == "i8") return Precision::INT8;
     throw std::runtime_error("Unknown precision: " + arg);
 }
 
+void print_usage(const char *argv0) {
+    std::printf("Usage: %s [--cfg <cfg>] [--weights <weights.bin>] [--out <weights_reorg.bin>] [--precision fp32|int16|int8]\n"
+                "          [--darknet <yolov2.weights>] [--quantize] [--bias <bias.bin>] [--weight-bits <file>]\n"
+                "          [--per-channel] [--engine-b tm,tn[,split]] [--jobs N]\n"
+                "\n"
+                "  --darknet <file>  Start from a raw Darknet .weights file: fold batch norm, then\n"
+                "                    reorganize (fp32) or quantize + reorganize (int16/int8). Biases and\n"
+                "                    Q tables are written next to --out.\n"
+                "  --quantize        Quantize folded fp32 weights.bin/bias.bin to --precision int16|int8\n"
+                "                    (without it, int16 expects an already quantized weight_int16.bin).\n"
+                "  --weight-bits <f> Per-conv weight precision (int32 4, 8 or 16 per layer, e.g. from\n"
+                "                    yolov2_precision_search). 8-bit layers are packed two per word in the\n"
+                "                    int16 output; 4-bit layers store a 16-entry codebook (1-D k-means)\n"
+                "                    and four indices per word. Entries with 0x100 set are requantized\n"
+                "                    per channel. The table is copied next to --out as weight_bits.bin.\n"
+                "  --per-channel     Requantize every conv layer per output channel (int16): weights and\n"
+                "                    bias of each channel are scaled to the full grid and bias_int16.bin\n"
+                "                    holds {bias, multiplier, shift} per channel.\n"
+                "  --engine-b <t>    Also write the conv layers after network layer `split` (default: all)\n"
+                "                    reorganized for an engine B with Tm=tm, Tn=tn, as <out>_b.bin, and\n"
+                "                    {tm, tn, first conv} as engine_b_tiling.bin next to --out. The\n"
+                "                    two-engine pipeline then never splits before that layer.\n"
+                "  --jobs N          Worker threads (default: all cores)\n",
+                argv0);
+}
+
 GenConfig parse_args(int argc, char **argv) {
     GenConfig cfg;
     for (int i = 1; i < argc; ++i) {
@@ -88,48 +129,607 @@ GenConfig parse_args(int argc, char **argv) {
             cfg.cfg_path = argv[++i];
         } else if ((arg == "--weights" || arg == "-w") && i + 1 < argc) {
             cfg.weights_in = argv[++i];
+        } else if ((arg == "--bias" || arg == "-b") && i + 1 < argc) {
+            cfg.bias_in = argv[++i];
+        } else if ((arg == "--darknet" || arg == "-d") && i + 1 < argc) {
+            cfg.darknet_in = argv[++i];
         } else if ((arg == "--out" || arg == "-o") && i + 1 < argc) {
             cfg.weights_out = argv[++i];
         } else if ((arg == "--precision" || arg == "-p") && i + 1 < argc) {
             cfg.precision = parse_precision(argv[++i]);
+        } else if (arg == "--weight-bits" && i + 1 < argc) {
+            cfg.weight_bits_in = argv[++i];
+        } else if (arg == "--engine-b" && i + 1 < argc) {
+            const char *v = argv[++i];
+            const int fields = std::sscanf(v, "%d,%d,%d", &cfg.engine_b_tile.tm, &cfg.engine_b_tile.tn,
+                                           &cfg.engine_b_split);
+            if (fields < 2 || cfg.engine_b_tile.tm <= 0 || cfg.engine_b_tile.tn <= 0 || cfg.engine_b_split < -1) {
+                throw std::runtime_error(std::string("--engine-b: expected tm,tn[,split], got '") + v + "'");
+            }
+            cfg.engine_b = true;
+        } else if ((arg == "--jobs" || arg == "-j") && i + 1 < argc) {
+            cfg.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--quantize") {
+            cfg.quantize = true;
+        } else if (arg == "--per-channel") {
+            cfg.per_channel = true;
         } else if (arg == "--int16") {
             cfg.precision = Precision::INT16;
+        } else if (arg == "--int8") {
+            cfg.precision = Precision::INT8;
         } else if (arg == "--fp32") {
             cfg.precision = Precision::FP32;
         } else if (arg == "--help" || arg == "-h") {
-            std::printf("Usage: %s [--cfg <cfg>] [--weights <weights.bin>] [--out <weights_reorg.bin>] [--precision fp32|int16]\n", argv[0]);
+            print_usage(argv[0]);
             std::exit(0);
         }
     }
     return cfg;
 }
 
-template <typename T>
-std::vector<T> read_weights(const std::string &path) {
-    FILE *fp = std::fopen(path.c_str(), "rb");
-    if (!fp) throw std::runtime_error("Couldn't open file: " + path);
-    std::fseek(fp, 0, SEEK_END);
-    long sz = std::ftell(fp);
-    std::fseek(fp, 0, SEEK_SET);
-    if (sz <= 0 || sz % sizeof(T) != 0) {
-        std::fclose(fp);
-        throw std::runtime_error("Invalid weight file size: " + path);
+// Read-only mmap of an input file.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::runtime_error("Couldn't open file: " + path);
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || st.st_size <= 0) {
+            ::close(fd_);
+            throw std::runtime_error("Invalid weight file size: " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to mmap: " + path);
+        }
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t *>(p);
     }
-    std::vector<T> buf(sz / sizeof(T));
-    size_t rd = std::fread(buf.data(), sizeof(T), buf.size(), fp);
-    std::fclose(fp);
-    if (rd != buf.size()) throw std::runtime_error("Failed to read weights: " + path);
-    return buf;
-}
+    ~MappedFile() {
+        ::munmap(const_cast<uint8_t *>(data_), size_);
+        ::close(fd_);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+    template <typename T>
+    const T *as(size_t byte_off = 0) const { return reinterpret_cast<const T *>(data_ + byte_off); }
+
+private:
+    int fd_ = -1;
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Output file sized up front and mmapped shared; workers write their blocks in place.
+class OutputMap {
+public:
+    OutputMap(const std::string &path, size_t bytes) : path_(path), size_(bytes) {
+        auto parent = std::filesystem::path(path).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent);
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) throw std::runtime_error("Couldn't open file for write: " + path);
+        if (::ftruncate(fd_, static_cast<off_t>(bytes)) != 0) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to size output: " + path);
+        }
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd_);
+            throw std::runtime_error("Failed to mmap output: " + path);
+        }
+        data_ = static_cast<uint8_t *>(p);
+    }
+    ~OutputMap() {
+        if (data_) ::munmap(data_, size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+    OutputMap(const OutputMap &) = delete;
+    OutputMap &operator=(const OutputMap &) = delete;
+
+    template <typename T>
+    T *as() { return reinterpret_cast<T *>(data_); }
+
+    void finish() {
+        if (::msync(data_, size_, MS_SYNC) != 0) throw std::runtime_error("Failed to write weights: " + path_);
+    }
+
+private:
+    std::string path_;
+    int fd_ = -1;
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
 
 template <typename T>
-void write_weights(const std::string &path, const std::vector<T> &buf) {
-    std::filesystem::create_directories(std::filesystem::path(path).parent_path());
+void write_vector(const std::string &path, const std::vector<T> &buf) {
+    auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
     FILE *fp = std::fopen(path.c_str(), "wb");
     if (!fp) throw std::runtime_error("Couldn't open file for write: " + path);
     size_t wr = std::fwrite(buf.data(), sizeof(T), buf.size(), fp);
     std::fclose(fp);
-    if (wr != buf.size()) throw std::runtime_error("Failed to write weights: " + path);
+    if (wr != buf.size()) throw std::runtime_error("Failed to write: " + path);
+}
+
+// Integer outputs pad each layer to a 32-bit boundary (the int16 loaders skip
+// one element after odd-sized layers).
+size_t padded_count(size_t count, size_t elem_size) {
+    const size_t per_word = 4 / elem_size;
+    return (count + per_word - 1) / per_word * per_word;
+}
+
+template <typename T>
+T quantize(float v, float scale) {
+    const float lo = static_cast<float>(std::numeric_limits<T>::min());
+    const float hi = static_cast<float>(std::numeric_limits<T>::max());
+    float q = std::nearbyint(v * scale);
+    if (q > hi) q = hi;
+    if (q < lo) q = lo;
+    return static_cast<T>(q);
+}
+
+// One conv layer as seen by the generator.
+struct ConvLayer {
+    int index = 0;       // network layer index
+    int ifm = 0, ofm = 0, ksize = 0;
+    size_t count = 0;    // ofm*ifm*k*k
+    size_t in_off = 0;   // element offset of the weights in the input
+    size_t out_off = 0;  // element offset in the reorganized output
+    const float *biases = nullptr;     // Darknet / bias.bin
+    const float *scales = nullptr;     // Darknet batch norm (null when folded)
+    const float *mean = nullptr;
+    const float *variance = nullptr;
+    std::vector<float> fold;           // per-ofm weight multiplier after BN folding
+    int q_w = 0;
+    int q_b = 0;
+    int bits = 16;       // weight precision in the int16 output (16, 8 or 4)
+    bool requant = false;    // per-channel requantization (YOLO2_WBITS_REQUANT)
+    std::vector<Yolo2ChannelRequant> rq;
+    Yolo2Codebook codebook;  // 4-bit layers
+};
+
+std::vector<ConvLayer> collect_conv_layers(const network *net) {
+    std::vector<ConvLayer> layers;
+    for (int i = 0; i < net->n; ++i) {
+        const layer &l = net->layers[i];
+        if (l.type != CONVOLUTIONAL) continue;
+        ConvLayer c;
+        c.index = i;
+        c.ifm = l.c;
+        c.ofm = l.n;
+        c.ksize = l.size;
+        c.count = static_cast<size_t>(l.n) * l.c * l.size * l.size;
+        layers.push_back(std::move(c));
+    }
+
+    // The runtime executors still carry the per-layer sizes as static tables.
+    const ModelConfig &mc = yolo2_model_config();
+    for (size_t i = 0; i < layers.size() && i < mc.weight_offsets.size(); ++i) {
+        if (static_cast<size_t>(mc.weight_offsets[i]) != layers[i].count ||
+            mc.beta_offsets[i] != layers[i].ofm) {
+            std::fprintf(stderr,
+                         "Warning: conv %zu (layer %d) has %zu weights / %d biases but model_config expects %d / %d; "
+                         "update model_config.cpp and linux_app before running this model\n",
+                         i, layers[i].index, layers[i].count, layers[i].ofm,
+                         mc.weight_offsets[i], mc.beta_offsets[i]);
+        }
+    }
+    return layers;
+}
+
+// Walks a Darknet .weights file: header, then per conv layer
+// biases[n], (scales[n], mean[n], variance[n] if BN), weights[n*c*k*k].
+void map_darknet(const MappedFile &file, const network *net, std::vector<ConvLayer> &layers) {
+    if (file.size() < 3 * sizeof(int32_t)) throw std::runtime_error("Darknet weights file too small");
+    const int32_t *hdr = file.as<int32_t>();
+    const int major = hdr[0], minor = hdr[1];
+    size_t off = 3 * sizeof(int32_t);
+    off += ((major * 10 + minor) >= 2 && major < 1000 && minor < 1000) ? sizeof(uint64_t) : sizeof(int32_t);
+
+    for (ConvLayer &c : layers) {
+        const bool bn = net->layers[c.index].batch_normalize != 0;
+        const size_t n = static_cast<size_t>(c.ofm);
+        const size_t need = (n * (bn ? 4 : 1) + c.count) * sizeof(float);
+        if (off + need > file.size()) {
+            throw std::runtime_error("Darknet weights truncated at layer " + std::to_string(c.index));
+        }
+        c.biases = file.as<float>(off);
+        off += n * sizeof(float);
+        if (bn) {
+            c.scales = file.as<float>(off);
+            c.mean = file.as<float>(off + n * sizeof(float));
+            c.variance = file.as<float>(off + 2 * n * sizeof(float));
+            off += 3 * n * sizeof(float);
+        }
+        c.in_off = off / sizeof(float);
+        off += c.count * sizeof(float);
+    }
+    if (off != file.size()) {
+        std::fprintf(stderr, "Warning: %zu trailing bytes in Darknet weights file\n", file.size() - off);
+    }
+}
+
+// Batch-norm folding as in Darknet's forward pass: y = scale*(x-mean)/(sqrt(var)+eps) + bias.
+void fold_batchnorm(ConvLayer &c, std::vector<float> &bias_out) {
+    c.fold.assign(c.ofm, 1.0f);
+    for (int o = 0; o < c.ofm; ++o) {
+        float b = c.biases ? c.biases[o] : 0.0f;
+        if (c.scales) {
+            const float k = c.scales[o] / (std::sqrt(c.variance[o]) + .000001f);
+            c.fold[o] = k;
+            b -= c.mean[o] * k;
+        }
+        bias_out.push_back(b);
+    }
+}
+
+// Runs fn(task) for task in [0, count) on `jobs` threads.
+template <typename Fn>
+void parallel_for(size_t count, int jobs, Fn fn) {
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> errors(jobs);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < jobs; ++t) {
+        pool.emplace_back([&, t] {
+            try {
+                for (size_t i = next++; i < count; i = next++) fn(i);
+            } catch (...) {
+                errors[t] = std::current_exception();
+                next = count;
+            }
+        });
+    }
+    for (auto &th : pool) th.join();
+    for (auto &e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+struct BlockTask {
+    size_t layer;
+    int m;
+};
+
+// Tasks are (layer, Tm block) pairs, largest layers first for better balance.
+std::vector<BlockTask> make_tasks(const std::vector<ConvLayer> &layers, int tile_m) {
+    std::vector<size_t> order(layers.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return layers[a].count > layers[b].count; });
+    std::vector<BlockTask> tasks;
+    for (size_t li : order) {
+        for (int m = 0; m < layers[li].ofm; m += tile_m) tasks.push_back({li, m});
+    }
+    return tasks;
+}
+
+// Reorganizes every layer from `in` into the mmapped output with convert(v, layer, ofm).
+template <typename Tin, typename Tout, typename Convert>
+void reorg_all(const Tin *in, Tout *out, const std::vector<ConvLayer> &layers, int jobs, Convert convert,
+               Tiling tile = Tiling()) {
+    const std::vector<BlockTask> tasks = make_tasks(layers, tile.tm);
+    parallel_for(tasks.size(), jobs, [&](size_t t) {
+        const ConvLayer &c = layers[tasks[t].layer];
+        WeightReorgBlock(in + c.in_off, out + c.out_off, c.ifm, c.ofm, c.ksize, tasks[t].m,
+                         [&](Tin v, int o) { return convert(v, c, o); }, tile.tm, tile.tn);
+    });
+}
+
+// Stage-B layers of --engine-b (network index > split), with out_off relative
+// to the first of them. *base gets that layer's offset in the full stream.
+std::vector<ConvLayer> engine_b_layers(const std::vector<ConvLayer> &layers, int split, size_t *base) {
+    std::vector<ConvLayer> stage_b;
+    for (const ConvLayer &c : layers) {
+        if (c.index > split) stage_b.push_back(c);
+    }
+    if (stage_b.empty()) throw std::runtime_error("--engine-b: no conv layer after layer " + std::to_string(split));
+    *base = stage_b.front().out_off;
+    for (ConvLayer &c : stage_b) c.out_off -= *base;
+    return stage_b;
+}
+
+// Per-layer max |w * fold| for Q selection (parallel over layers).
+std::vector<float> layer_maxabs(const float *in, const std::vector<ConvLayer> &layers, int jobs) {
+    std::vector<float> maxabs(layers.size(), 0.0f);
+    parallel_for(layers.size(), jobs, [&](size_t li) {
+        const ConvLayer &c = layers[li];
+        const size_t per_ofm = c.count / c.ofm;
+        float mx = 0.0f;
+        for (int o = 0; o < c.ofm; ++o) {
+            const float k = c.fold.empty() ? 1.0f : std::fabs(c.fold[o]);
+            const float *w = in + c.in_off + static_cast<size_t>(o) * per_ofm;
+            float m = 0.0f;
+            for (size_t i = 0; i < per_ofm; ++i) m = std::max(m, std::fabs(w[i]));
+            mx = std::max(mx, m * k);
+        }
+        maxabs[li] = mx;
+    });
+    return maxabs;
+}
+
+// Per-channel requantization: divides each channel's fold and bias by its
+// scale, so the weight Q and bias Q selected afterwards see the scaled layer.
+void scale_channels(const float *in, std::vector<ConvLayer> &layers, std::vector<float> &biases, int jobs) {
+    std::vector<size_t> boffs;
+    size_t boff = 0;
+    for (const ConvLayer &c : layers) {
+        boffs.push_back(boff);
+        boff += c.ofm;
+    }
+    parallel_for(layers.size(), jobs, [&](size_t li) {
+        ConvLayer &c = layers[li];
+        if (!c.requant) return;
+        const size_t per_ofm = c.count / c.ofm;
+        std::vector<float> chan_max(c.ofm, 0.0f);
+        for (int o = 0; o < c.ofm; ++o) {
+            const float *w = in + c.in_off + static_cast<size_t>(o) * per_ofm;
+            float m = 0.0f;
+            for (size_t i = 0; i < per_ofm; ++i) m = std::max(m, std::fabs(w[i]));
+            chan_max[o] = m * std::fabs(c.fold[o]);
+        }
+        float *b = biases.data() + boffs[li];
+        c.rq = yolo2_channel_requant(chan_max.data(), b, c.ofm);
+        for (int o = 0; o < c.ofm; ++o) {
+            c.fold[o] /= c.rq[o].scale;
+            b[o] /= c.rq[o].scale;
+        }
+    });
+}
+
+std::string sibling(const std::string &out_path, const std::string &name) {
+    return (std::filesystem::path(out_path).parent_path() / name).string();
+}
+
+// <out>_b.bin of --engine-b
+std::string engine_b_path(const std::string &out_path) {
+    const std::filesystem::path p(out_path);
+    return (p.parent_path() / (p.stem().string() + "_b" + p.extension().string())).string();
+}
+
+// engine_b_tiling.bin: int32 {tm, tn, conv index of the first stage-B layer}
+void write_engine_b_tiling(const GenConfig &cfg, const std::vector<ConvLayer> &layers, const ConvLayer &first) {
+    int32_t conv = 0;
+    while (layers[conv].index != first.index) ++conv;
+    write_vector(sibling(cfg.weights_out, "engine_b_tiling.bin"),
+                 std::vector<int32_t>{cfg.engine_b_tile.tm, cfg.engine_b_tile.tn, conv});
+    std::printf("Engine B       : %s (Tm=%d Tn=%d, conv %d.. from layer %d)\n", engine_b_path(cfg.weights_out).c_str(),
+                cfg.engine_b_tile.tm, cfg.engine_b_tile.tn, conv, first.index);
+}
+
+// fp32 / int16 pass-through reorganization of an already folded (and for int16,
+// already quantized) weight blob. Output keeps the input length.
+template <typename T>
+void reorg_prepared(const GenConfig &cfg, std::vector<ConvLayer> &layers, int jobs) {
+    MappedFile in(cfg.weights_in);
+    if (in.size() % sizeof(T) != 0) throw std::runtime_error("Invalid weight file size: " + cfg.weights_in);
+    const size_t elems = in.size() / sizeof(T);
+
+    size_t expected = 0;
+    for (const ConvLayer &c : layers) expected += c.count;
+
+    // Some legacy int16 blobs are already quantized and reorganized.
+    if (!std::is_floating_point<T>::value && elems < expected) {
+        if (cfg.engine_b) throw std::runtime_error("--engine-b needs weights that are not reorganized yet");
+        std::fprintf(stderr,
+                     "Warning: int16 weight file smaller than expected (%zu < %zu); assuming it is already reorganized. Copying through.\n",
+                     elems, expected);
+        OutputMap out(cfg.weights_out, in.size());
+        std::memcpy(out.as<uint8_t>(), in.data(), in.size());
+        out.finish();
+        return;
+    }
+
+    size_t off = 0;
+    for (ConvLayer &c : layers) {
+        c.in_off = off;
+        c.out_off = off;
+        off += std::is_floating_point<T>::value ? c.count : padded_count(c.count, sizeof(T));
+        if (off > elems) throw std::runtime_error("Weight file too small for layer " + std::to_string(c.index));
+    }
+
+    if (!std::is_floating_point<T>::value && std::filesystem::exists(sibling(cfg.weights_out, "weight_bits.bin"))) {
+        std::fprintf(stderr, "Warning: %s is left as is; pre-quantized inputs are all 16-bit, so remove it if it lists 8-bit layers\n",
+                     sibling(cfg.weights_out, "weight_bits.bin").c_str());
+    }
+
+    // Output is zero-filled by ftruncate, which also covers any trailing tail.
+    OutputMap out(cfg.weights_out, in.size());
+    reorg_all(in.as<T>(), out.as<T>(), layers, jobs, [](T v, const ConvLayer &, int) { return v; });
+    out.finish();
+
+    if (cfg.engine_b) {
+        size_t base = 0;
+        const std::vector<ConvLayer> stage_b = engine_b_layers(layers, cfg.engine_b_split, &base);
+        OutputMap out_b(engine_b_path(cfg.weights_out), (off - base) * sizeof(T));
+        reorg_all(in.as<T>(), out_b.as<T>(), stage_b, jobs, [](T v, const ConvLayer &, int) { return v; },
+                  cfg.engine_b_tile);
+        out_b.finish();
+        write_engine_b_tiling(cfg, layers, stage_b.front());
+    }
+}
+
+// Darknet (fold) or folded fp32 (quantize) input -> fp32/int16/int8 output + biases + Q tables.
+template <typename Tq>
+void quantize_and_reorg(const GenConfig &cfg, const network *net, std::vector<ConvLayer> &layers, int jobs) {
+    const bool from_darknet = !cfg.darknet_in.empty();
+    MappedFile in(from_darknet ? cfg.darknet_in : cfg.weights_in);
+    std::unique_ptr<MappedFile> bias_file;
+    std::vector<float> biases;
+
+    if (from_darknet) {
+        map_darknet(in, net, layers);
+    } else {
+        bias_file.reset(new MappedFile(cfg.bias_in));
+        size_t woff = 0, boff = 0;
+        for (ConvLayer &c : layers) {
+            c.in_off = woff;
+            c.biases = bias_file->as<float>(boff * sizeof(float));
+            woff += c.count;
+            boff += c.ofm;
+        }
+        if (woff * sizeof(float) > in.size()) throw std::runtime_error("Weight file too small: " + cfg.weights_in);
+        if (boff * sizeof(float) > bias_file->size()) throw std::runtime_error("Bias file too small: " + cfg.bias_in);
+    }
+    for (ConvLayer &c : layers) fold_batchnorm(c, biases);
+
+    const float *w = in.as<float>();
+    constexpr bool is_fp32 = std::is_floating_point<Tq>::value;
+    const int bits = static_cast<int>(sizeof(Tq) * 8);
+
+    size_t out_elems = 0;
+    for (ConvLayer &c : layers) {
+        c.out_off = out_elems;
+        if (is_fp32) {
+            out_elems += c.count;
+        } else if ((c.bits == 8 || c.bits == 4) && sizeof(Tq) == 2) {
+            out_elems += yolo2_weight_words(static_cast<int>(c.count), c.bits);
+        } else {
+            out_elems += padded_count(c.count, sizeof(Tq));
+        }
+    }
+
+    std::vector<int32_t> q_w, q_b;
+    if constexpr (!is_fp32) {
+        scale_channels(w, layers, biases, jobs);
+        const std::vector<float> maxabs = layer_maxabs(w, layers, jobs);
+        size_t boff = 0;
+        for (size_t li = 0; li < layers.size(); ++li) {
+            ConvLayer &c = layers[li];
+            c.q_w = select_q(maxabs[li], std::min(bits, c.bits));
+            float bmax = 0.0f;
+            for (int o = 0; o < c.ofm; ++o) bmax = std::max(bmax, std::fabs(biases[boff + o]));
+            c.q_b = select_q(bmax, 16);
+            boff += c.ofm;
+            q_b.push_back(c.q_b);
+        }
+        // 4-bit layers take Q from their codebook, fitted on the folded weights.
+        std::vector<size_t> coded_idx;
+        for (size_t li = 0; li < layers.size(); ++li) {
+            if (layers[li].bits == 4 && sizeof(Tq) == 2) coded_idx.push_back(li);
+        }
+        parallel_for(coded_idx.size(), jobs, [&](size_t t) {
+            ConvLayer &c = layers[coded_idx[t]];
+            const size_t per_ofm = c.count / c.ofm;
+            std::vector<float> folded(c.count);
+            for (size_t i = 0; i < c.count; ++i) folded[i] = w[c.in_off + i] * c.fold[i / per_ofm];
+            c.codebook = yolo2_fit_codebook(folded.data(), c.count);
+            c.q_w = c.codebook.q;
+        });
+        for (const ConvLayer &c : layers) q_w.push_back(c.q_w);
+    }
+
+    // Writes `stream` (out_off relative to `out`) reorganized for `tile`.
+    auto write_stream = [&](OutputMap &out, const std::vector<ConvLayer> &stream, Tiling tile) {
+        if constexpr (is_fp32) {
+            reorg_all(w, out.as<Tq>(), stream, jobs, [](float v, const ConvLayer &c, int o) {
+                return static_cast<Tq>(v * c.fold[o]);
+            }, tile);
+        } else {
+            // 8-bit layers of an int16 output are written bytewise into their packed
+            // words (little endian, so the low byte holds the even weight). 4-bit
+            // layers are reorganized as one index byte per weight, then packed.
+            std::vector<ConvLayer> full, packed, coded;
+            std::vector<size_t> coded_off;
+            size_t index_elems = 0;
+            for (const ConvLayer &c : stream) {
+                if (c.bits == 8 && sizeof(Tq) == 2) {
+                    packed.push_back(c);
+                    packed.back().out_off = c.out_off * sizeof(Tq);
+                } else if (c.bits == 4 && sizeof(Tq) == 2) {
+                    coded.push_back(c);
+                    coded_off.push_back(c.out_off);
+                    coded.back().out_off = index_elems;
+                    index_elems += c.count;
+                } else {
+                    full.push_back(c);
+                }
+            }
+            reorg_all(w, out.as<Tq>(), full, jobs, [](float v, const ConvLayer &c, int o) {
+                return quantize<Tq>(v * c.fold[o], std::ldexp(1.0f, c.q_w));
+            }, tile);
+            reorg_all(w, out.as<int8_t>(), packed, jobs, [](float v, const ConvLayer &c, int o) {
+                return quantize<int8_t>(v * c.fold[o], std::ldexp(1.0f, c.q_w));
+            }, tile);
+            if (!coded.empty()) {
+                std::vector<uint8_t> indices(index_elems);
+                reorg_all(w, indices.data(), coded, jobs, [](float v, const ConvLayer &c, int o) {
+                    return static_cast<uint8_t>(c.codebook.index(v * c.fold[o]));
+                }, tile);
+                parallel_for(coded.size(), jobs, [&](size_t k) {
+                    const ConvLayer &c = coded[k];
+                    Tq *dst = out.as<Tq>() + coded_off[k];
+                    std::copy(c.codebook.code, c.codebook.code + kYolo2CodebookSize, dst);
+                    const uint8_t *idx = indices.data() + c.out_off;
+                    for (size_t i = 0; i < c.count; i += 4) {
+                        uint16_t word = 0;
+                        for (size_t j = 0; j < 4 && i + j < c.count; ++j) word |= static_cast<uint16_t>(idx[i + j] << (4 * j));
+                        dst[kYolo2CodebookSize + i / 4] = static_cast<Tq>(word);
+                    }
+                });
+            }
+        }
+    };
+
+    OutputMap out(cfg.weights_out, out_elems * sizeof(Tq));
+    write_stream(out, layers, Tiling());
+    out.finish();
+    if (cfg.engine_b) {
+        size_t base = 0;
+        const std::vector<ConvLayer> stage_b = engine_b_layers(layers, cfg.engine_b_split, &base);
+        OutputMap out_b(engine_b_path(cfg.weights_out), (out_elems - base) * sizeof(Tq));
+        write_stream(out_b, stage_b, cfg.engine_b_tile);
+        out_b.finish();
+        write_engine_b_tiling(cfg, layers, stage_b.front());
+    }
+
+    // Biases: fp32 as folded, otherwise int16 with per-layer Q (int8 keeps 16-bit
+    // biases; they are added in the 32-bit accumulator).
+    const std::string suffix = (cfg.precision == Precision::INT8) ? "int8" : "int16";
+    if constexpr (is_fp32) {
+        write_vector(sibling(cfg.weights_out, "bias.bin"), biases);
+    } else {
+        std::vector<int16_t> bias_q;
+        size_t boff = 0;
+        for (const ConvLayer &c : layers) {
+            const float scale = std::ldexp(1.0f, c.q_b);
+            for (int o = 0; o < c.ofm; ++o) {
+                bias_q.push_back(quantize<int16_t>(biases[boff + o], scale));
+                if (c.requant) {
+                    bias_q.push_back(static_cast<int16_t>(static_cast<uint16_t>(c.rq[o].mult)));
+                    bias_q.push_back(static_cast<int16_t>(c.rq[o].shift));
+                }
+            }
+            if ((c.ofm * yolo2_beta_words(c.requant ? YOLO2_WBITS_REQUANT : 0)) & 0x1) bias_q.push_back(0);
+            boff += c.ofm;
+        }
+        write_vector(sibling(cfg.weights_out, "bias_" + suffix + ".bin"), bias_q);
+        write_vector(sibling(cfg.weights_out, "weight_" + suffix + "_Q.bin"), q_w);
+        write_vector(sibling(cfg.weights_out, "bias_" + suffix + "_Q.bin"), q_b);
+        // Always written for int16 so a stale table never pairs with a new blob.
+        if (cfg.precision == Precision::INT16) {
+            std::vector<int32_t> wbits;
+            int w8 = 0, w4 = 0, requant = 0;
+            for (const ConvLayer &c : layers) {
+                wbits.push_back(c.bits | (c.requant ? YOLO2_WBITS_REQUANT : 0));
+                w8 += (c.bits == 8);
+                w4 += (c.bits == 4);
+                requant += c.requant;
+            }
+            write_vector(sibling(cfg.weights_out, "weight_bits.bin"), wbits);
+            std::printf("Weight bits    : %s (%d 8-bit and %d 4-bit of %zu conv layers, %d requantized per channel)\n",
+                        sibling(cfg.weights_out, "weight_bits.bin").c_str(), w8, w4, layers.size(), requant);
+        }
+        std::printf("Q tables       : %s, %s\n",
+                    sibling(cfg.weights_out, "weight_" + suffix + "_Q.bin").c_str(),
+                    sibling(cfg.weights_out, "bias_" + suffix + "_Q.bin").c_str());
+    }
+    std::printf("Biases         : %s\n",
+                sibling(cfg.weights_out, is_fp32 ? "bias.bin" : "bias_" + suffix + ".bin").c_str());
 }
 
 } // namespace
@@ -138,24 +738,38 @@ int main(int argc, char **argv) {
     try {
         GenConfig cfg = parse_args(argc, argv);
         const std::string default_in_fp32 = "weights/weights.bin";
+        const std::string default_bias_fp32 = "weights/bias.bin";
         const std::string default_out_fp32 = "weights/weights_reorg.bin";
         const std::string default_in_int16 = "weights/weight_int16.bin";
         const std::string default_out_int16 = "weights/weights_reorg_int16.bin";
+        const std::string default_out_int8 = "weights/weights_reorg_int8.bin";
+
+        const bool from_darknet = !cfg.darknet_in.empty();
+        // int8 has no pre-quantized input format; it is always produced from floats.
+        const bool quantize_floats = cfg.precision != Precision::FP32 &&
+                                     (from_darknet || cfg.quantize || cfg.precision == Precision::INT8);
+        const bool float_input = cfg.precision == Precision::FP32 || quantize_floats;
 
         if (cfg.weights_in.empty()) {
-            cfg.weights_in = (cfg.precision == Precision::FP32) ? default_in_fp32 : default_in_int16;
+            cfg.weights_in = float_input ? default_in_fp32 : default_in_int16;
+        }
+        if (cfg.bias_in.empty()) {
+            cfg.bias_in = default_bias_fp32;
         }
         if (cfg.weights_out.empty()) {
-            cfg.weights_out = (cfg.precision == Precision::FP32) ? default_out_fp32 : default_out_int16;
+            cfg.weights_out = (cfg.precision == Precision::FP32) ? default_out_fp32
+                            : (cfg.precision == Precision::INT16) ? default_out_int16
+                            : default_out_int8;
         }
 
-        std::filesystem::path in_path(cfg.weights_in);
+        std::filesystem::path in_path(from_darknet ? cfg.darknet_in : cfg.weights_in);
         std::filesystem::path out_path(cfg.weights_out);
+        const std::string default_in_str = float_input ? default_in_fp32 : default_in_int16;
 
         // Prevent accidental in-place overwrite if a user points --weights to the output path.
         if (in_path.lexically_normal() == out_path.lexically_normal()) {
-            auto default_in = std::filesystem::path(cfg.precision == Precision::FP32 ? default_in_fp32 : default_in_int16);
-            if (std::filesystem::exists(default_in)) {
+            auto default_in = std::filesystem::path(default_in_str);
+            if (!from_darknet && std::filesystem::exists(default_in)) {
                 std::fprintf(stderr,
                              "Warning: input and output paths are the same (%s); falling back to %s\n",
                              cfg.weights_in.c_str(), default_in.string().c_str());
@@ -167,8 +781,8 @@ int main(int argc, char **argv) {
         }
 
         // If a custom path is missing but the default exists, automatically fall back.
-        if (!std::filesystem::exists(in_path)) {
-            auto default_in = std::filesystem::path(cfg.precision == Precision::FP32 ? default_in_fp32 : default_in_int16);
+        if (!from_darknet && !std::filesystem::exists(in_path)) {
+            auto default_in = std::filesystem::path(default_in_str);
             if (in_path.lexically_normal() != default_in.lexically_normal() &&
                 std::filesystem::exists(default_in)) {
                 std::fprintf(stderr,
@@ -179,94 +793,67 @@ int main(int argc, char **argv) {
             }
         }
 
+        int jobs = cfg.jobs > 0 ? cfg.jobs : static_cast<int>(std::thread::hardware_concurrency());
+        if (jobs <= 0) jobs = 1;
+
         std::printf("Precision      : %s\n", to_string(cfg.precision));
-        std::printf("Input weights : %s\n", cfg.weights_in.c_str());
+        std::printf("Input weights : %s%s\n", in_path.string().c_str(),
+                    from_darknet ? " (Darknet, BN folded here)" : "");
         std::printf("Output weights: %s\n", cfg.weights_out.c_str());
+        std::printf("Threads        : %d\n", jobs);
 
         network *net = load_network(const_cast<char *>(cfg.cfg_path.c_str()));
         if (!net) throw std::runtime_error("Failed to load cfg: " + cfg.cfg_path);
 
-        const ModelConfig &mc = yolo2_model_config();
-
-        if (cfg.precision == Precision::FP32) {
-            auto weights = read_weights<float>(cfg.weights_in);
-            std::vector<float> weights_reorg(weights.size(), 0.0f);
-            size_t woffset = 0;
-            int offset_index = 0;
-
-            for (int i = 0; i < net->n; ++i) {
-                layer l = net->layers[i];
-                if (l.type == CONVOLUTIONAL) {
-                    if (offset_index >= static_cast<int>(mc.weight_offsets.size()))
-                        throw std::runtime_error("Weight offset table too small");
-                    if (woffset + mc.weight_offsets[offset_index] > weights.size())
-                        throw std::runtime_error("Weight file too small for layer " + std::to_string(i));
-
-                    WeightReorg(weights.data() + woffset,
-                                weights_reorg.data() + woffset,
-                                l.c, l.n, l.size);
-
-                    woffset += mc.weight_offsets[offset_index];
-                    offset_index++;
-                }
+        std::vector<ConvLayer> layers = collect_conv_layers(net);
+        if (!cfg.weight_bits_in.empty()) {
+            if (!quantize_floats || cfg.precision != Precision::INT16) {
+                throw std::runtime_error("--weight-bits needs int16 quantization (--precision int16 with --darknet or --quantize)");
             }
-
-            if (woffset != weights.size()) {
-                // Allow some trailing zeros if offsets table shorter?
-                if (woffset < weights.size()) {
-                    std::fill(weights_reorg.begin() + woffset, weights_reorg.end(), 0.0f);
-                } else {
-                    throw std::runtime_error("Processed weights exceed input size");
+            MappedFile bits_file(cfg.weight_bits_in);
+            if (bits_file.size() < layers.size() * sizeof(int32_t)) {
+                throw std::runtime_error("Weight bits table too small: " + cfg.weight_bits_in);
+            }
+            for (size_t li = 0; li < layers.size(); ++li) {
+                const int32_t b = bits_file.as<int32_t>()[li];
+                const int prec = yolo2_wbits_precision(b);
+                if ((prec != 4 && prec != 8 && prec != 16) || (b & ~(YOLO2_WBITS_MASK | YOLO2_WBITS_REQUANT))) {
+                    throw std::runtime_error("Invalid weight bits " + std::to_string(b) + " for conv " + std::to_string(li));
                 }
+                layers[li].bits = prec;
+                layers[li].requant = yolo2_wbits_requant(b) != 0;
             }
+        }
+        if (cfg.per_channel) {
+            if (!quantize_floats || cfg.precision != Precision::INT16) {
+                throw std::runtime_error("--per-channel needs int16 quantization (--precision int16 with --darknet or --quantize)");
+            }
+            for (ConvLayer &c : layers) c.requant = true;
+        }
+        const auto start = std::chrono::steady_clock::now();
 
-            write_weights(cfg.weights_out, weights_reorg);
+        if (from_darknet || quantize_floats) {
+            switch (cfg.precision) {
+                case Precision::FP32: quantize_and_reorg<float>(cfg, net, layers, jobs); break;
+                case Precision::INT16: quantize_and_reorg<int16_t>(cfg, net, layers, jobs); break;
+                case Precision::INT8: quantize_and_reorg<int8_t>(cfg, net, layers, jobs); break;
+            }
+        } else if (cfg.precision == Precision::FP32) {
+            reorg_prepared<float>(cfg, layers, jobs);
         } else {
-            auto weights = read_weights<int16_t>(cfg.weights_in);
-            size_t expected = 0;
-            for (int off : mc.weight_offsets) expected += off;
-
-            // Some legacy int16 blobs are already quantized and reorganized.
-            if (weights.size() < expected) {
-                std::fprintf(stderr,
-                             "Warning: int16 weight file smaller than expected (%zu < %zu); assuming it is already reorganized. Copying through.\n",
-                             weights.size(), expected);
-                write_weights(cfg.weights_out, weights);
-            } else {
-                std::vector<int16_t> weights_reorg(weights.size(), 0);
-                size_t woffset = 0;
-                int offset_index = 0;
-
-                for (int i = 0; i < net->n; ++i) {
-                    layer l = net->layers[i];
-                    if (l.type == CONVOLUTIONAL) {
-                        if (offset_index >= static_cast<int>(mc.weight_offsets.size()))
-                            throw std::runtime_error("Weight offset table too small");
-                        if (woffset + mc.weight_offsets[offset_index] > weights.size())
-                            throw std::runtime_error("Weight file too small for layer " + std::to_string(i));
-
-                        WeightReorg(weights.data() + woffset,
-                                    weights_reorg.data() + woffset,
-                                    l.c, l.n, l.size);
-
-                        woffset += mc.weight_offsets[offset_index];
-                        offset_index++;
-                    }
-                }
-
-                if (woffset != weights.size()) {
-                    if (woffset < weights.size()) {
-                        std::fill(weights_reorg.begin() + woffset, weights_reorg.end(), 0);
-                    } else {
-                        throw std::runtime_error("Processed weights exceed input size");
-                    }
-                }
+            reorg_prepared<int16_t>(cfg, layers, jobs);
+        }
 
-                write_weights(cfg.weights_out, weights_reorg);
+        // A stage-B stream of older weights must not pair with the new blob.
+        if (!cfg.engine_b) {
+            for (const std::string &stale : {engine_b_path(cfg.weights_out), sibling(cfg.weights_out, "engine_b_tiling.bin")}) {
+                if (std::filesystem::remove(stale)) std::printf("Removed stale  : %s\n", stale.c_str());
             }
         }
 
-        std::printf("Reorganized weights written to %s\n", cfg.weights_out.c_str());
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::printf("Reorganized weights written to %s (%zu conv layers, %.1f ms)\n",
+                    cfg.weights_out.c_str(), layers.size(), elapsed_ms);
 
     } catch (const std::exception &ex) {
         std::fprintf(stderr, "Fatal error: %s\n", ex.what());
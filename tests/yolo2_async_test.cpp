@@ -0,0 +1,298 @@
+/*
+ * AsyncSession queue test
+ *
+ * Links yolo2_async.cpp against a stub yolo2::Session (defined below) whose
+ * detect() blocks until the test releases it, so every queue state can be
+ * reached deterministically without weights or the host model:
+ *
+ *   - submit() back-pressure and try_submit() on a full queue
+ *   - cancel() of queued and running requests, cancel_all()
+ *   - drain(), detect() errors, destructor cancellation
+ *   - calls from a callback that would wait for the executor itself
+ *
+ * Each result frame's width comes back as its single score, so results can
+ * be matched to frames. A width < 0 makes the stub detect() throw.
+ */
+
+#include "yolo2_async.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Frames the stub has started and the permits it may still complete
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable cv;
+    int started = 0;
+    int permits = 0;
+};
+Gate gate;
+
+const std::chrono::seconds kTimeout(5);
+
+bool wait_started(int n) {
+    std::unique_lock<std::mutex> lock(gate.mutex);
+    return gate.cv.wait_for(lock, kTimeout, [n] { return gate.started >= n; });
+}
+
+void release(int n) {
+    {
+        std::lock_guard<std::mutex> lock(gate.mutex);
+        gate.permits += n;
+    }
+    gate.cv.notify_all();
+}
+
+void reset_gate() {
+    std::lock_guard<std::mutex> lock(gate.mutex);
+    gate.started = 0;
+    gate.permits = 0;
+}
+
+int failures = 0;
+
+void check(bool ok, const char *test, const char *what) {
+    if (!ok) {
+        printf("FAIL %s: %s\n", test, what);
+        ++failures;
+    }
+}
+
+yolo2::Frame frame(int tag) { return yolo2::Frame(nullptr, tag, 1, yolo2::PixelFormat::RGB8); }
+
+template <typename T>
+bool ready(std::future<T> &f, std::chrono::milliseconds wait = std::chrono::milliseconds(0)) {
+    return f.wait_for(wait) == std::future_status::ready;
+}
+
+bool is_cancelled(std::future<yolo2::Detections> &f) {
+    try {
+        f.get();
+    } catch (const yolo2::Cancelled &) {
+        return true;
+    } catch (...) {
+    }
+    return false;
+}
+
+int score(std::future<yolo2::Detections> &f) {
+    const yolo2::Detections d = f.get();
+    return d.size() == 1 ? static_cast<int>(d.score[0]) : -1;
+}
+
+} // namespace
+
+// Stub Session: only what AsyncSession uses
+namespace yolo2 {
+
+struct Session::Impl {
+    SessionOptions options;
+};
+
+Session::Session(const SessionOptions &options) : impl_(new Impl) { impl_->options = options; }
+Session::~Session() = default;
+Session::Session(Session &&other) noexcept = default;
+Session &Session::operator=(Session &&other) noexcept = default;
+
+void Session::detect(const Frame &frame, Detections &out) {
+    std::unique_lock<std::mutex> lock(gate.mutex);
+    ++gate.started;
+    gate.cv.notify_all();
+    gate.cv.wait(lock, [] { return gate.permits > 0; });
+    --gate.permits;
+    if (frame.width < 0) throw std::runtime_error("stub detect failure");
+    out.clear();
+    out.score.push_back(static_cast<float>(frame.width));
+}
+
+void Detections::clear() {
+    x.clear();
+    y.clear();
+    w.clear();
+    h.clear();
+    cls.clear();
+    score.clear();
+    box.clear();
+}
+
+} // namespace yolo2
+
+namespace {
+
+void test_order_and_back_pressure() {
+    const char *name = "back_pressure";
+    reset_gate();
+    yolo2::AsyncSession async(yolo2::SessionOptions{}, 2);
+    auto t1 = async.submit(frame(1));
+    check(wait_started(1), name, "first request did not start");
+    auto t2 = async.submit(frame(2));
+    auto t3 = async.submit(frame(3));
+    check(async.queued() == 2, name, "queue should hold two requests");
+
+    yolo2::AsyncSession::Ticket t4;
+    check(!async.try_submit(frame(4), t4), name, "try_submit succeeded on a full queue");
+    check(!async.try_submit(frame(4), [](std::exception_ptr, yolo2::Detections &&) {}), name,
+          "callback try_submit succeeded on a full queue");
+
+    // A blocking submit waits until the executor takes the next request
+    auto blocked = std::async(std::launch::async, [&async] { return async.submit(frame(5)); });
+    check(!ready(blocked, std::chrono::milliseconds(100)), name, "submit did not block on a full queue");
+    release(1);
+    check(ready(blocked, kTimeout), name, "submit stayed blocked after a slot freed");
+    auto t5 = blocked.get();
+
+    release(4);
+    check(score(t1.result) == 1 && score(t2.result) == 2 && score(t3.result) == 3 && score(t5.result) == 5, name,
+          "results out of order or wrong");
+    check(t1.id < t2.id && t2.id < t3.id && t3.id < t5.id, name, "ids not increasing");
+}
+
+void test_cancel() {
+    const char *name = "cancel";
+    reset_gate();
+    yolo2::AsyncSession async(yolo2::SessionOptions{}, 4);
+    auto running = async.submit(frame(1));
+    check(wait_started(1), name, "first request did not start");
+    auto a = async.submit(frame(2));
+    auto b = async.submit(frame(3));
+    std::atomic<int> cb_cancelled(0);
+    async.submit(frame(4), [&cb_cancelled](std::exception_ptr e, yolo2::Detections &&) {
+        try {
+            if (e) std::rethrow_exception(e);
+        } catch (const yolo2::Cancelled &) {
+            ++cb_cancelled;
+        } catch (...) {
+        }
+    });
+
+    check(!async.cancel(running.id), name, "cancel succeeded on the running request");
+    check(async.cancel(a.id), name, "cancel of a queued request failed");
+    check(!async.cancel(a.id), name, "second cancel of the same request succeeded");
+    check(is_cancelled(a.result), name, "cancelled future did not fail with Cancelled");
+    check(async.queued() == 2, name, "cancel did not remove the request");
+
+    check(async.cancel_all() == 2, name, "cancel_all did not drop both queued requests");
+    check(is_cancelled(b.result), name, "cancel_all future did not fail with Cancelled");
+    check(cb_cancelled == 1, name, "cancel_all callback did not get Cancelled");
+
+    release(1);
+    check(score(running.result) == 1, name, "running request was disturbed by cancel");
+}
+
+void test_drain_and_errors() {
+    const char *name = "drain";
+    reset_gate();
+    yolo2::AsyncSession async(yolo2::SessionOptions{}, 4);
+    std::atomic<int> done(0);
+    auto count = [&done](std::exception_ptr, yolo2::Detections &&) { ++done; };
+    async.submit(frame(1), count);
+    async.submit(frame(2), count);
+    auto failing = async.submit(frame(-1));
+
+    auto drained = std::async(std::launch::async, [&async] { async.drain(); });
+    check(!ready(drained, std::chrono::milliseconds(100)), name, "drain returned with requests pending");
+    release(3);
+    check(ready(drained, kTimeout), name, "drain did not return after the queue emptied");
+    check(done == 2, name, "callbacks not delivered before drain returned");
+
+    bool threw = false;
+    try {
+        failing.result.get();
+    } catch (const std::runtime_error &e) {
+        threw = std::string(e.what()) == "stub detect failure";
+    }
+    check(threw, name, "detect() error not delivered through the future");
+
+    // The executor keeps running after a failed request
+    auto after = async.submit(frame(7));
+    release(1);
+    check(score(after.result) == 7, name, "request after a failure did not run");
+}
+
+void test_destructor() {
+    const char *name = "destructor";
+    reset_gate();
+    std::future<yolo2::Detections> running, queued;
+    auto async = std::unique_ptr<yolo2::AsyncSession>(new yolo2::AsyncSession(yolo2::SessionOptions{}, 4));
+    running = async->submit(frame(1)).result;
+    check(wait_started(1), name, "first request did not start");
+    queued = async->submit(frame(2)).result;
+
+    auto destroyed = std::async(std::launch::async, [&async] { async.reset(); });
+    check(ready(queued, kTimeout), name, "destructor did not cancel the queued request");
+    check(is_cancelled(queued), name, "queued request not failed with Cancelled");
+    check(!ready(destroyed, std::chrono::milliseconds(100)), name, "destructor did not wait for the running request");
+    release(1);
+    check(ready(destroyed, kTimeout), name, "destructor did not return");
+    check(score(running) == 1, name, "running request lost on destruction");
+}
+
+void test_callback_reentry() {
+    const char *name = "callback_reentry";
+    reset_gate();
+    yolo2::AsyncSession async(yolo2::SessionOptions{}, 1);
+    std::promise<void> in_callback;
+    std::promise<std::string> outcome;
+    std::promise<void> proceed;
+    std::shared_future<void> proceed_f = proceed.get_future().share();
+
+    async.submit(frame(1), [&](std::exception_ptr, yolo2::Detections &&) {
+        in_callback.set_value();
+        proceed_f.wait();   // the test fills the queue meanwhile
+        std::string r;
+        try {
+            async.submit(frame(9));
+            r += "submit-ok ";
+        } catch (const std::runtime_error &) {
+            r += "submit-threw ";
+        }
+        try {
+            async.drain();
+            r += "drain-ok ";
+        } catch (const std::runtime_error &) {
+            r += "drain-threw ";
+        }
+        yolo2::AsyncSession::Ticket t;
+        r += async.try_submit(frame(9), t) ? "try-ok" : "try-full";
+        outcome.set_value(r);
+    });
+    release(1);
+    in_callback.get_future().wait();
+    auto filler = async.submit(frame(2));
+    proceed.set_value();
+
+    auto r = outcome.get_future();
+    check(ready(r, kTimeout), name, "callback deadlocked");
+    if (ready(r)) {
+        check(r.get() == "submit-threw drain-threw try-full", name, "reentrant calls were not rejected");
+    }
+    release(1);
+    check(score(filler.result) == 2, name, "queued request did not run after the callback");
+}
+
+} // namespace
+
+int main() {
+    test_order_and_back_pressure();
+    test_cancel();
+    test_drain_and_errors();
+    test_destructor();
+    test_callback_reentry();
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("AsyncSession tests passed\n");
+    return 0;
+}
@@ -0,0 +1,319 @@
+#!/usr/bin/env python3
+"""
+Run the single-layer testbench (vitis/yolo2_layer_tb.cpp) one case per process.
+
+  csim:  builds the testbench natively (make layer-tb / layer-tb-int16) and runs
+         every case in its own process, in parallel.
+  cosim: synthesizes the accelerator once with HLS_TB=layer and m_axi depths
+         sized for the selected cases, then co-simulates each case in its own
+         copy of the synthesized project, in parallel, and reads the latency
+         from each cosim report.
+
+Examples (from the repo root):
+  python3 vitis/run_layer_cases.py
+  python3 vitis/run_layer_cases.py --mode cosim --precision int16 -j 4
+  python3 vitis/run_layer_cases.py --mode cosim --case conv3x3_s1,pool2x2_s2
+  python3 vitis/run_layer_cases.py --layers 0,1,2,29,30 --weight-bits 0x108
+
+The HLS_* variables of vitis/yolo2_cli.tcl (HLS_BLOCKED_LAYOUT, HLS_SPLIT_K,
+HLS_GENERIC_KERNELS, HLS_PART) are passed through to the cosim build; pass the
+matching LAYOUT=/SPLIT_K= with --make-args so the native build agrees.
+Exits nonzero if any case fails.
+"""
+
+from __future__ import annotations
+
+import argparse
+import concurrent.futures
+import json
+import os
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+import time
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Optional
+
+
+REPO_ROOT = Path(__file__).resolve().parent.parent
+TB_BINARY = REPO_ROOT / "yolov2_layer_tb"
+CASE_RE = re.compile(r"^(\w+)\s+(conv|max|reorg)\b(.*)$")
+RESULT_RE = re.compile(r"^(PASS|FAIL|SKIP) (\w+)\s")
+PROJ_NAME = "yolo2_layer"
+
+
+@dataclass
+class CaseRun:
+    name: str
+    desc: str
+    status: str = "NOT RUN"
+    wall_s: float = 0.0
+    latency: Optional[dict] = None
+    detail: str = ""
+    log: str = ""
+    tb_args: list = field(default_factory=list)
+
+
+def _selection_args(args: argparse.Namespace) -> list:
+    out = []
+    if args.case:
+        out += ["--case", args.case]
+    if args.layers:
+        out += ["--layers", args.layers, "--cfg", _cfg_path(args)]
+    if args.weight_bits:
+        out += ["--weight-bits", args.weight_bits]
+    if args.seed is not None:
+        out += ["--seed", str(args.seed)]
+    return out
+
+
+def _cfg_path(args: argparse.Namespace) -> str:
+    # Absolute, since cosim runs the testbench from deep inside the project.
+    return str(Path(args.cfg).resolve() if args.cfg else REPO_ROOT / "config" / "yolov2.cfg")
+
+
+def _case_args(args: argparse.Namespace, name: str) -> list:
+    # --layers cases are named layerNN; everything else is a synthetic case.
+    m = re.fullmatch(r"layer(\d+)", name)
+    out = ["--layers", str(int(m.group(1)))] if m else ["--case", name]
+    if m:
+        out += ["--cfg", _cfg_path(args)]
+    if m and args.weight_bits:
+        out += ["--weight-bits", args.weight_bits]
+    if args.seed is not None:
+        out += ["--seed", str(args.seed)]
+    return out
+
+
+def build_native(args: argparse.Namespace) -> None:
+    target = "layer-tb-int16" if args.precision == "int16" else "layer-tb"
+    cmd = ["make", target, "LAYER_TB_ARGS=--list"] + shlex.split(args.make_args)
+    print(f"[build] {' '.join(cmd)}", flush=True)
+    proc = subprocess.run(cmd, cwd=REPO_ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if proc.returncode != 0:
+        sys.stdout.write(proc.stdout)
+        raise SystemExit(f"ERROR: {target} build failed")
+
+
+def list_cases(args: argparse.Namespace) -> list:
+    proc = subprocess.run([str(TB_BINARY), "--list"] + _selection_args(args), cwd=REPO_ROOT,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if proc.returncode != 0:
+        sys.stdout.write(proc.stdout)
+        raise SystemExit("ERROR: yolov2_layer_tb --list failed")
+    cases = []
+    for line in proc.stdout.splitlines():
+        m = CASE_RE.match(line)
+        if not m:
+            continue
+        run = CaseRun(name=m.group(1), desc=(m.group(2) + m.group(3)).strip())
+        if "  skip: " in run.desc:
+            run.desc, run.detail = run.desc.split("  skip: ", 1)
+            run.status = "SKIP"
+        cases.append(run)
+    return cases
+
+
+def case_depths(args: argparse.Namespace) -> list:
+    proc = subprocess.run([str(TB_BINARY), "--depths"] + _selection_args(args), cwd=REPO_ROOT,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    m = re.search(r"input=(\d+) output=(\d+) weight=(\d+) beta=(\d+)", proc.stdout)
+    if proc.returncode != 0 or not m:
+        sys.stdout.write(proc.stdout)
+        raise SystemExit("ERROR: yolov2_layer_tb --depths failed")
+    return [max(int(v), 1) for v in m.groups()]
+
+
+def _tb_result(run: CaseRun, output: str) -> None:
+    for line in output.splitlines():
+        m = RESULT_RE.match(line.strip())
+        if m and m.group(2) == run.name:
+            run.status = m.group(1)
+            tail = line.split(run.desc, 1)
+            run.detail = tail[1].strip() if len(tail) == 2 else ""
+            return
+    run.status = "FAIL"
+    run.detail = "no result line from the testbench"
+
+
+def run_csim_case(args: argparse.Namespace, run: CaseRun, log_dir: Path) -> CaseRun:
+    run.tb_args = _case_args(args, run.name)
+    t0 = time.monotonic()
+    proc = subprocess.run([str(TB_BINARY)] + run.tb_args, cwd=REPO_ROOT,
+                          stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    run.wall_s = time.monotonic() - t0
+    log = log_dir / f"{run.name}.log"
+    log.write_text(proc.stdout)
+    run.log = str(log)
+    _tb_result(run, proc.stdout)
+    if proc.returncode != 0 and run.status == "PASS":
+        run.status = "FAIL"
+        run.detail = f"exit code {proc.returncode}"
+    return run
+
+
+def _vitis_env(extra: dict) -> dict:
+    env = dict(os.environ)
+    env.update(extra)
+    return env
+
+
+def _vitis_run(args: argparse.Namespace, tcl: Path, cwd: Path, env: dict, log: Path) -> int:
+    cmd = shlex.split(args.vitis_run) + ["--mode", "hls", "--tcl", str(tcl)]
+    with open(log, "w") as f:
+        proc = subprocess.run(cmd, cwd=cwd, env=env, stdout=f, stderr=subprocess.STDOUT)
+    return proc.returncode
+
+
+def synthesize(args: argparse.Namespace, work: Path, depths: list) -> Path:
+    tcl = REPO_ROOT / "vitis" / ("yolo2_int16_cli.tcl" if args.precision == "int16" else "yolo2_cli.tcl")
+    env = _vitis_env({
+        "HLS_TB": "layer",
+        "HLS_PROJ_NAME": PROJ_NAME,
+        "HLS_RUN_CSIM": "0",
+        "HLS_RUN_COSIM": "0",
+        "HLS_RUN_IMPL": "0",
+        "HLS_RUN_EXPORT": "0",
+        "HLS_DEPTH_INPUT": str(depths[0]),
+        "HLS_DEPTH_OUTPUT": str(depths[1]),
+        "HLS_DEPTH_WEIGHT": str(depths[2]),
+        "HLS_DEPTH_BETA": str(depths[3]),
+    })
+    base = work / "synth"
+    if base.exists():
+        shutil.rmtree(base)
+    base.mkdir(parents=True)
+    log = base / "csynth.log"
+    print(f"[synth] {tcl.name} with depths {','.join(map(str, depths))} (log: {log})", flush=True)
+    t0 = time.monotonic()
+    rc = _vitis_run(args, tcl, base, env, log)
+    if rc != 0 or not (base / PROJ_NAME / "solution1" / "syn").is_dir():
+        raise SystemExit(f"ERROR: synthesis failed (exit code {rc}), see {log}")
+    print(f"[synth] done in {time.monotonic() - t0:.0f} s", flush=True)
+    return base / PROJ_NAME
+
+
+def parse_cosim_report(report: Path) -> Optional[dict]:
+    """Latency (cycles) from the Verilog row of <top>_cosim.rpt."""
+    if not report.exists():
+        return None
+    for line in report.read_text(errors="replace").splitlines():
+        cols = [c.strip() for c in line.strip().strip("|").split("|")]
+        if len(cols) >= 5 and cols[0].lower() == "verilog":
+            def num(s: str) -> Optional[int]:
+                return int(s) if s.isdigit() else None
+            return {"status": cols[1], "min": num(cols[2]), "avg": num(cols[3]), "max": num(cols[4])}
+    return None
+
+
+def run_cosim_case(args: argparse.Namespace, run: CaseRun, synth_proj: Path, work: Path,
+                   depths: list) -> CaseRun:
+    case_dir = work / "cases" / run.name
+    if case_dir.exists():
+        shutil.rmtree(case_dir)
+    case_dir.mkdir(parents=True)
+    shutil.copytree(synth_proj, case_dir / PROJ_NAME, symlinks=True)
+    # --alloc keeps every run's buffers at the synthesized depths, whatever the case.
+    run.tb_args = _case_args(args, run.name) + ["--alloc", ",".join(map(str, depths))]
+    env = _vitis_env({
+        "HLS_PROJ_NAME": PROJ_NAME,
+        "HLS_TB_ARGV": " ".join(run.tb_args),
+        "HLS_COSIM_TRACE": args.trace,
+    })
+    log = case_dir / "cosim.log"
+    t0 = time.monotonic()
+    rc = _vitis_run(args, REPO_ROOT / "vitis" / "yolo2_layer_cosim.tcl", case_dir, env, log)
+    run.wall_s = time.monotonic() - t0
+    run.log = str(log)
+    _tb_result(run, log.read_text(errors="replace"))
+    report = case_dir / PROJ_NAME / "solution1" / "sim" / "report" / "YOLO2_FPGA_cosim.rpt"
+    run.latency = parse_cosim_report(report)
+    if run.status == "PASS" and (rc != 0 or run.latency is None or run.latency["status"].lower() != "pass"):
+        run.status = "FAIL"
+        run.detail = f"cosim exit code {rc}" if rc != 0 else "no passing Verilog row in the cosim report"
+    if not args.keep and run.status == "PASS":
+        shutil.rmtree(case_dir / PROJ_NAME, ignore_errors=True)
+    return run
+
+
+def print_summary(runs: list, mode: str) -> None:
+    print()
+    width = max([len(r.name) for r in runs] + [4])
+    header = f"{'case':<{width}}  {'status':<6}  {'wall':>9}"
+    if mode == "cosim":
+        header += f"  {'latency min/avg/max (cycles)':>30}"
+    print(header)
+    print("-" * len(header))
+    for r in runs:
+        line = f"{r.name:<{width}}  {r.status:<6}  {r.wall_s:>8.3f}s"
+        if mode == "cosim":
+            lat = r.latency
+            text = f"{lat['min']}/{lat['avg']}/{lat['max']}" if lat else "-"
+            line += f"  {text:>30}"
+        if r.status in ("FAIL", "SKIP") and r.detail:
+            line += f"  ({r.detail})"
+        print(line)
+    counts = {s: sum(1 for r in runs if r.status == s) for s in ("PASS", "FAIL", "SKIP")}
+    print(f"\n{counts['PASS']} passed, {counts['FAIL']} failed, {counts['SKIP']} skipped")
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--mode", choices=("csim", "cosim"), default="csim")
+    ap.add_argument("--precision", choices=("fp32", "int16"), default="int16")
+    ap.add_argument("--case", help="comma-separated synthetic cases (default: all)")
+    ap.add_argument("--layers", help="comma-separated conv/maxpool layers of --cfg")
+    ap.add_argument("--cfg", help="network cfg for --layers (default: config/yolov2.cfg)")
+    ap.add_argument("--weight-bits", help="WeightBits word for --layers convs, e.g. 8 or 0x108")
+    ap.add_argument("--seed", type=int)
+    ap.add_argument("-j", "--jobs", type=int, default=0,
+                    help="parallel cases (default: all cores for csim, 4 for cosim)")
+    ap.add_argument("--make-args", default="", help="extra make variables for the native build, e.g. 'LAYOUT=blocked'")
+    ap.add_argument("--vitis-run", default="vitis-run", help="vitis-run command (cosim)")
+    ap.add_argument("--work-dir", default="layer_cases", help="cosim projects and logs (default: ./layer_cases)")
+    ap.add_argument("--trace", default="none", help="cosim trace level (none, port, all)")
+    ap.add_argument("--keep", action="store_true", help="keep the per-case cosim projects of passing cases")
+    ap.add_argument("--json", help="write the per-case results to this file")
+    args = ap.parse_args()
+
+    if args.mode == "cosim" and shutil.which(shlex.split(args.vitis_run)[0]) is None:
+        print(f"ERROR: {args.vitis_run} not found; source the Vitis settings64.sh first", file=sys.stderr)
+        return 2
+
+    build_native(args)
+    runs = list_cases(args)
+    todo = [r for r in runs if r.status != "SKIP"]
+    if not todo:
+        print("ERROR: no runnable cases selected", file=sys.stderr)
+        return 2
+
+    work = Path(args.work_dir).resolve()
+    log_dir = work / "csim" if args.mode == "csim" else work
+    log_dir.mkdir(parents=True, exist_ok=True)
+    jobs = args.jobs or ((os.cpu_count() or 1) if args.mode == "csim" else 4)
+
+    t0 = time.monotonic()
+    if args.mode == "csim":
+        fn = lambda r: run_csim_case(args, r, log_dir)
+    else:
+        depths = case_depths(args)
+        synth_proj = synthesize(args, work, depths)
+        fn = lambda r: run_cosim_case(args, r, synth_proj, work, depths)
+
+    print(f"[{args.mode}] {len(todo)} cases, {jobs} at a time", flush=True)
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        for r in pool.map(fn, todo):
+            print(f"[{args.mode}] {r.status} {r.name} ({r.wall_s:.1f} s)", flush=True)
+
+    print_summary(runs, args.mode)
+    print(f"total wall time {time.monotonic() - t0:.1f} s")
+    if args.json:
+        Path(args.json).write_text(json.dumps([asdict(r) for r in runs], indent=2) + "\n")
+    return 1 if any(r.status == "FAIL" for r in runs) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
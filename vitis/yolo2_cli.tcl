@@ -2,6 +2,10 @@
 # Run from repo root:
 #   vitis-run --mode hls --tcl vitis/yolo2_cli.tcl
 # To skip stages: HLS_RUN_CSIM=0, HLS_RUN_COSIM=0, HLS_RUN_IMPL=0, or HLS_RUN_EXPORT=0 in env.
+# HLS_BLOCKED_LAYOUT=1 selects the channel-blocked activation layout.
+# HLS_SPLIT_K=2 splits each conv input-channel loop over two partial-sum buffers.
+# HLS_GENERIC_KERNELS=0 builds only the YOLOv2 kernel shapes (conv 3x3/s1, 1x1/s1, pool 2x2/s2).
+# HLS_TB=layer uses the reduced single-layer testbench (vitis/run_layer_cases.py).
 # For INT16 version, use: vitis/yolo2_int16_cli.tcl
 
 proc norm {p} { file normalize $p }
@@ -29,7 +33,19 @@ set clk_period 5.0
 # Use the full co-simulation testbench
 set tb_file [norm [file join $proj_root vitis yolo2_cosim_tb.cpp]]
 
-set include_flags "-std=c++14 -I$proj_root/include -I$proj_root/include/core -I$proj_root/include/models/yolov2 -I$proj_root/hls -I$proj_root/hls/core -I$proj_root/hls/models/yolov2"
+set include_flags "-std=c++14 -I$proj_root/include -I$proj_root/include/core -I$proj_root/include/models/yolov2 -I$proj_root/hls -I$proj_root/hls/core -I$proj_root/hls/models/yolov2 -I$proj_root/linux_app/include"
+# HLS_BLOCKED_LAYOUT=1 builds the channel-blocked activation layout (linux_app/include/yolo2_act_layout.h).
+if {[info exists ::env(HLS_BLOCKED_LAYOUT)] && $::env(HLS_BLOCKED_LAYOUT) != 0} {
+  append include_flags " -DACT_BLOCKED_LAYOUT"
+}
+# HLS_SPLIT_K=2 gives the second ping-pong input buffer its own partial-sum buffer (hls/core/core_scheduler.hpp).
+if {[info exists ::env(HLS_SPLIT_K)] && $::env(HLS_SPLIT_K) ne ""} {
+  append include_flags " -DSPLIT_K=$::env(HLS_SPLIT_K)"
+}
+# HLS_GENERIC_KERNELS=0 drops the runtime-shape conv/pool datapaths (hls/core/core_compute.hpp).
+if {[info exists ::env(HLS_GENERIC_KERNELS)] && $::env(HLS_GENERIC_KERNELS) ne ""} {
+  append include_flags " -DGENERIC_KERNELS=$::env(HLS_GENERIC_KERNELS)"
+}
 
 set design_files [list                            \
   [norm [file join $proj_root hls core core_io.cpp]]        \
@@ -48,10 +64,53 @@ set tb_support_files [list                               \
   [norm [file join $proj_root src core yolo_region.cpp]] \
   [norm [file join $proj_root src core yolo_utils.cpp]]  \
   [norm [file join $proj_root hls models yolov2 model_config.cpp]] \
-  [norm [file join $proj_root hls models yolov2 yolo2_model.cpp]]]
+  [norm [file join $proj_root hls models yolov2 yolo2_model.cpp]] \
+  [norm [file join $proj_root linux_app src yolo2_golden.c]] \
+  [norm [file join $proj_root linux_app src yolo2_tensor.c]] \
+  [norm [file join $proj_root linux_app src yolo2_cpu_conv.c]] \
+  [norm [file join $proj_root linux_app src yolo2_plan.c]]]
+
+# HLS_TB=layer swaps in the reduced testbench: random single-layer cases
+# checked against a host reference (vitis/yolo2_layer_tb.cpp). HLS_TB_ARGV is
+# passed to it in csim and cosim, and HLS_DEPTH_INPUT/OUTPUT/WEIGHT/BETA
+# shrink the m_axi depths to its cases (yolo2_layer_tb --depths).
+set tb_argv ""
+if {[info exists ::env(HLS_TB)] && $::env(HLS_TB) eq "layer"} {
+  set tb_file [norm [file join $proj_root vitis yolo2_layer_tb.cpp]]
+  set tb_support_files [list                               \
+    [norm [file join $proj_root src core yolo_cfg.cpp]]    \
+    [norm [file join $proj_root src core yolo_image.cpp]]  \
+    [norm [file join $proj_root src core yolo_layers.cpp]] \
+    [norm [file join $proj_root src core yolo_math.cpp]]   \
+    [norm [file join $proj_root src core yolo_net.cpp]]    \
+    [norm [file join $proj_root src core yolo_post.cpp]]   \
+    [norm [file join $proj_root src core yolo_region.cpp]] \
+    [norm [file join $proj_root src core yolo_utils.cpp]]  \
+    [norm [file join $proj_root hls models yolov2 model_config.cpp]] \
+    [norm [file join $proj_root linux_app src yolo2_cpu_conv.c]] \
+    [norm [file join $proj_root linux_app src yolo2_plan.c]]]
+}
+if {[info exists ::env(HLS_TB_ARGV)]} {
+  set tb_argv $::env(HLS_TB_ARGV)
+}
+set depth_input  6922240
+set depth_output 5537792
+set depth_weight 50941792
+set depth_beta   32283
+# HLS_COSIM_TRACE=none skips the waveform dump (all by default)
+set cosim_trace all
+if {[info exists ::env(HLS_COSIM_TRACE)] && $::env(HLS_COSIM_TRACE) ne ""} {
+  set cosim_trace $::env(HLS_COSIM_TRACE)
+}
+foreach {port var} {INPUT depth_input OUTPUT depth_output WEIGHT depth_weight BETA depth_beta} {
+  if {[info exists ::env(HLS_DEPTH_$port)] && $::env(HLS_DEPTH_$port) ne ""} {
+    set $var $::env(HLS_DEPTH_$port)
+  }
+}
 
 proc build_project {proj_name} {
   global top part clk_period design_files include_flags tb_file tb_support_files part_fallback
+  global tb_argv cosim_trace depth_input depth_output depth_weight depth_beta
 
   open_project -reset $proj_name
   set_top $top
@@ -81,21 +140,22 @@ proc build_project {proj_name} {
   # Input: 416*416*32 + 208*208*32 = 6,922,240 words = 27,688,960 bytes
   # Output: 416*416*32 = 5,537,792 words = 22,151,168 bytes
   # Weight: weights_reorg.bin = 50,941,792 words = 203,767,168 bytes
-  # Beta: bias.bin = 10,761 words = 43,044 bytes
+  # Beta: bias.bin = 10,761 words; 32,283 with per-channel requant triplets
   # Note: TCL directive overrides pragma, so these values take precedence
-  set_directive_interface -mode m_axi   -depth 6922240   -bundle DATA_BUS_IN  $top Input
-  set_directive_interface -mode m_axi   -depth 5537792   -bundle DATA_BUS_OUT $top Output
-  set_directive_interface -mode m_axi   -depth 50941792  -bundle DATA_BUS1    $top Weight
-  set_directive_interface -mode m_axi   -depth 10761     -bundle DATA_BUS1    $top Beta
+  # (HLS_DEPTH_* override them for the layer testbench)
+  set_directive_interface -mode m_axi   -depth $depth_input  -bundle DATA_BUS_IN  $top Input
+  set_directive_interface -mode m_axi   -depth $depth_output -bundle DATA_BUS_OUT $top Output
+  set_directive_interface -mode m_axi   -depth $depth_weight -bundle DATA_BUS1    $top Weight
+  set_directive_interface -mode m_axi   -depth $depth_beta   -bundle DATA_BUS1    $top Beta
 
   if {![info exists ::env(HLS_RUN_CSIM)] || $::env(HLS_RUN_CSIM) != 0} {
-    csim_design
+    csim_design -argv $tb_argv
   }
 
   csynth_design
 
   if {![info exists ::env(HLS_RUN_COSIM)] || $::env(HLS_RUN_COSIM) != 0} {
-    cosim_design -rtl verilog -trace_level all
+    cosim_design -rtl verilog -trace_level $cosim_trace -argv $tb_argv
   }
 
   # C Implementation (RTL synthesis and place & route)
@@ -110,10 +170,21 @@ proc build_project {proj_name} {
   if {![info exists ::env(HLS_RUN_EXPORT)] || $::env(HLS_RUN_EXPORT) != 0} {
     puts "Exporting IP catalog..."
     set export_dir [file join [pwd] "${proj_name}_ip"]
-    export_design -format ip_catalog -rtl verilog -output $export_dir
+    # A renamed project also gets its own IP name so both engines fit in one Vivado design
+    set ip_flags {}
+    if {[info exists ::env(HLS_PROJ_NAME)] && $::env(HLS_PROJ_NAME) ne ""} {
+      set ip_flags [list -ipname $proj_name]
+    }
+    export_design -format ip_catalog -rtl verilog {*}$ip_flags -output $export_dir
     puts "IP exported to: $export_dir"
     puts "To use in Vivado: Add IP Repository -> $export_dir"
   }
 }
 
-build_project yolo2_fp32
+# HLS_PROJ_NAME renames the project and the exported IP, e.g. for a second,
+# differently-tiled engine of the two-engine pipeline (linux_app/include/yolo2_pipeline.h).
+set proj_name yolo2_fp32
+if {[info exists ::env(HLS_PROJ_NAME)] && $::env(HLS_PROJ_NAME) ne ""} {
+  set proj_name $::env(HLS_PROJ_NAME)
+}
+build_project $proj_name
@@ -4,9 +4,13 @@
 #include "../hls/core/types.hpp"
 #include "../include/core/yolo.h"
 #include "../include/core/precision.hpp"
+#include "../linux_app/include/yolo2_golden.h"
+#include "../linux_app/include/yolo2_tensor.h"
+#include "../linux_app/include/yolo2_act_layout.h"
 
 // Constants are already defined in params.hpp, no need to redefine
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -15,6 +19,7 @@
 #include <stdexcept>
 #include <chrono>
 #include <cmath>
+#include <memory>
 #include <unistd.h>
 #include <limits.h>
 #include <sys/stat.h>
@@ -85,14 +90,10 @@ void generate_iofm_offset(IO_Dtype* in_ptr[32], IO_Dtype* out_ptr[32],
     IO_Dtype *Memory_bottom = Memory_top + cfg.mem_len;
     
     for(int x = 0; x < 18; x++) {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if(out_w & 0x7)
-            out_w_align_256b += 8;
-
+        const layer &l = net->layers[x];
         if(x % 2 == 0) {
             in_ptr[x] = Memory_top;
-            out_ptr[x] = Memory_bottom - net->layers[x].out_c * net->layers[x].out_h * out_w_align_256b;
+            out_ptr[x] = Memory_bottom - yolo2_act_words(l.out_c, l.out_h, l.out_w);
         } else {
             in_ptr[x] = out_ptr[x-1];
             out_ptr[x] = Memory_top;
@@ -100,14 +101,10 @@ void generate_iofm_offset(IO_Dtype* in_ptr[32], IO_Dtype* out_ptr[32],
     }
 
     for(int x = 18; x < 25; x++) {
-        int out_w = net->layers[x].out_w;
-        int out_w_align_256b = (out_w >> 3) << 3;
-        if(out_w & 0x7)
-            out_w_align_256b += 8;
-
+        const layer &l = net->layers[x];
         if(x % 2 == 0) {
             in_ptr[x] = Memory_top;
-            out_ptr[x] = Memory_bottom - cfg.route16_len - net->layers[x].out_c * net->layers[x].out_h * out_w_align_256b;
+            out_ptr[x] = Memory_bottom - cfg.route16_len - yolo2_act_words(l.out_c, l.out_h, l.out_w);
         } else {
             in_ptr[x] = out_ptr[x-1];
             out_ptr[x] = Memory_top;
@@ -129,6 +126,22 @@ void generate_iofm_offset(IO_Dtype* in_ptr[32], IO_Dtype* out_ptr[32],
     in_ptr[31] = out_ptr[30];
 }
 
+// Compact CHW <-> accelerator activation layout (from yolo2_model.cpp)
+void chw_to_act(const IO_Dtype *src, IO_Dtype *dst, int c, int h, int w) {
+    std::fill(dst, dst + yolo2_act_words(c, h, w), static_cast<IO_Dtype>(0));
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[yolo2_act_index(ch, y, x, h, w)] = src[(static_cast<size_t>(ch) * h + y) * w + x];
+}
+
+void act_to_chw(const IO_Dtype *src, IO_Dtype *dst, int c, int h, int w) {
+    for (int ch = 0; ch < c; ++ch)
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                dst[(static_cast<size_t>(ch) * h + y) * w + x] = src[yolo2_act_index(ch, y, x, h, w)];
+}
+
 // Reorg CPU implementation (from yolo2_model.cpp)
 void reorg_cpu(IO_Dtype *x, int w, int h, int c, int stride, IO_Dtype *out) {
     int out_c = c / (stride * stride);
@@ -302,7 +315,7 @@ int main(int argc, char *argv[]) {
     // The extractor writes ALL convolutional layers, which may exceed weight_offsets
     // We'll update expected_w/b to match actual file sizes after reading them
     const size_t axi_weight_depth = 50941792; // words, from pragma depth (minimum)
-    const size_t axi_beta_depth   = 10761;    // words, from pragma depth (minimum)
+    const size_t axi_beta_depth   = 32283;    // words, from pragma depth (minimum)
     if (expected_w < axi_weight_depth) expected_w = axi_weight_depth;
     if (expected_b < axi_beta_depth)   expected_b = axi_beta_depth;
 
@@ -412,7 +425,14 @@ int main(int argc, char *argv[]) {
 
     // Load Q values for INT16 mode
     std::vector<int32_t> weight_q, bias_q, act_q;
+    std::vector<int> weight_bits(conv_layers, 16);
 #ifdef INT16_MODE
+    try {
+        weight_bits = yolo2_weight_bits(weights_dir, conv_layers);
+    } catch (const std::exception &e) {
+        fprintf(stderr, "ERROR: %s\n", e.what());
+        return 1;
+    }
     printf("Loading INT16 quantization Q values...\n");
     try {
         std::string weight_q_path = join_path(weights_dir, "weight_int16_Q.bin");
@@ -469,6 +489,8 @@ int main(int argc, char *argv[]) {
         free(Beta_buf);
         return 1;
     }
+    // Released on every exit path below
+    std::unique_ptr<IO_Dtype, void (*)(void *)> memory_guard(Memory_buf, free);
     // Zero-initialize and touch all memory to ensure it's accessible
     memset(Memory_buf, 0, mem_bytes);
     // Touch memory pages to ensure they're mapped (helps with co-simulation)
@@ -549,6 +571,7 @@ int main(int argc, char *argv[]) {
     // Copy input image to first layer input buffer
     const int input_elems = 416 * 416 * 3;
     printf("  Copying input image (%d elements)...\n", input_elems);
+    std::vector<IO_Dtype> input_chw(input_elems);
     
 #ifdef INT16_MODE
     // For INT16 mode, quantize the input image using first layer input Q value
@@ -568,12 +591,14 @@ int main(int argc, char *argv[]) {
         int64_t q = static_cast<int64_t>(std::llround(v));
         if (q > 32767) q = 32767;
         if (q < -32768) q = -32768;
-        in_ptr[0][idx] = static_cast<IO_Dtype>(q);
+        input_chw[idx] = static_cast<IO_Dtype>(q);
     }
 #else
     // For FP32 mode, copy directly
-    memcpy(in_ptr[0], sized.data, input_elems * sizeof(IO_Dtype));
+    memcpy(input_chw.data(), sized.data, input_elems * sizeof(IO_Dtype));
 #endif
+    chw_to_act(input_chw.data(), in_ptr[0], 3, 416, 416);
+    const size_t input_words = yolo2_act_words(3, 416, 416);
     
     // CRITICAL: Ensure the entire Input buffer range is accessible and zero-initialized
     // The hardware stub will copy the full depth (6,922,240 words) from in_ptr[0]
@@ -585,17 +610,50 @@ int main(int argc, char *argv[]) {
     }
     // Touch the entire Input range to ensure all pages are mapped
     volatile IO_Dtype dummy2 = 0;
-    for (size_t i = input_elems; i < input_depth_words; i += 1024) {
+    for (size_t i = input_words; i < input_depth_words; i += 1024) {
         dummy2 += in_ptr[0][i];
         in_ptr[0][i] = 0;  // Ensure zeros and page mapping
     }
     (void)dummy2;
     printf("Input image copied to buffer (entire Input range %zu words is accessible)\n", input_depth_words);
 
+    // Create output directory if it doesn't exist
+    struct stat info;
+    if (stat(output_dir.c_str(), &info) != 0) {
+        // Directory doesn't exist, try to create it
+        char cmd[512];
+        snprintf(cmd, sizeof(cmd), "mkdir -p %s", output_dir.c_str());
+        system(cmd);
+    }
+    
+    // Per-layer tensor taps (YOLO2_TAP_DIR / YOLO2_TAP_LAYERS), shared with the host model and linux_app.
+    // Without YOLO2_TAP_DIR the first five layers are written to the output directory.
+    setenv("YOLO2_TAP_DIR", output_dir.c_str(), 0);
+    setenv("YOLO2_TAP_LAYERS", "0-4", 0);
+
+    // Per-layer golden record/verify (YOLO2_GOLDEN_DIR / YOLO2_GOLDEN_MODE), shared with the host model and linux_app.
+    std::unique_ptr<yolo2_golden_t, void (*)(yolo2_golden_t *)> golden_store(nullptr, yolo2_golden_discard);
+    if (yolo2_golden_env_enabled()) {
+#ifdef INT16_MODE
+        const int golden_int16 = 1;
+#else
+        const int golden_int16 = 0;
+#endif
+        golden_store.reset(yolo2_golden_open_env(yolo2_golden_model_key(weights_dir.c_str(), golden_int16),
+                                                 yolo2_hash64(0, input_chw.data(), input_elems * sizeof(IO_Dtype)),
+                                                 (int)sizeof(IO_Dtype), golden_int16 ? 0 : 1));
+        if (!golden_store) {
+            fprintf(stderr, "ERROR: Golden store could not be opened (YOLO2_GOLDEN_DIR)\n");
+            return 1;
+        }
+    }
+    yolo2_golden_t *const golden = golden_store.get();
+
     // Region buffers for reorg/route operations
     const int region_len = 13 * 16 * 425;
     std::vector<IO_Dtype> region_buf(region_len, 0);
     std::vector<IO_Dtype> region_buf2(region_len, 0);
+    std::vector<IO_Dtype> golden_buf;
     
     // Track Q values for route layer alignment (INT16 mode)
 #ifdef INT16_MODE
@@ -604,6 +662,20 @@ int main(int argc, char *argv[]) {
     int pending_route_q = -1;  // Q value to use for next layer after route
 #endif
 
+    // Tiling limits from the IP's capability block (yolo2_caps.h). The RTL
+    // copies Caps in and out on every call, so all calls pass caps_words.
+    uint32_t caps_words[YOLO2_CAPS_WORDS] = {};
+    YOLO2_FPGA(in_ptr[0], out_ptr[0], NULL, NULL, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+               0, 0, 0, 0, 0, 0, 0, YOLO2_LAYER_CAPS, 0, 0, 0, 0, 16, caps_words);
+    yolo2_caps_t caps;
+    if (yolo2_caps_decode(caps_words, &caps) != 0) {
+        fprintf(stderr, "ERROR: YOLO2_FPGA returned no capability block\n");
+        return 1;
+    }
+    printf("Accelerator caps v%d.%d: Tm=%d Tn=%d Tr=%d Tc=%d IB=%dx%d SPLIT_K=%d features=0x%x\n",
+           caps.version_major, caps.version_minor, caps.tm, caps.tn, caps.tr, caps.tc,
+           caps.ib_height, caps.ib_width, caps.split_k, caps.features);
+
     // Run inference
     printf("\nStarting inference...\n");
     printf("Running through %d layers...\n", net->n);
@@ -626,12 +698,12 @@ int main(int argc, char *argv[]) {
                 output_w = (l.w - l.size + 2*l.pad) / l.stride + 1;
                 output_h = (l.h - l.size + 2*l.pad) / l.stride + 1;
 
-                TR = std::min(((OnChipIB_Height - l.size) / l.stride + 1), Tr);
+                TR = std::min(((caps.ib_height - l.size) / l.stride + 1), caps.tr);
                 TR = std::min(output_h, TR);
-                TC = std::min(((OnChipIB_Width - l.size) / l.stride + 1), Tc);
+                TC = std::min(((caps.ib_width - l.size) / l.stride + 1), caps.tc);
                 TC = std::min(output_w, TC);
-                TM = std::min(l.n, Tm);
-                TN = std::min(l.c, Tn);
+                TM = std::min(l.n, caps.tm);
+                TN = std::min(l.c, caps.tn);
                 mLoops = (int)ceil(((float)l.n) / TM);
 
                 printf("  Layer %2d: CONV  IFM=%3d OFM=%3d K=%d S=%d P=%d -> %dx%d (TM=%d TN=%d TR=%d TC=%d)\n",
@@ -709,20 +781,25 @@ int main(int argc, char *argv[]) {
                 // Update current Q for next layer
                 current_Qa = Qa_out;
                 
-                printf("    Q values: Qw=%d, Qb=%d, Qa_in=%d, Qa_out=%d\n", Qw, Qb, Qa_in, Qa_out);
+                printf("    Q values: Qw=%d, Qb=%d, Qa_in=%d, Qa_out=%d, weight bits=0x%x\n",
+                       Qw, Qb, Qa_in, Qa_out, weight_bits[offset_index]);
 #endif
 
                 YOLO2_FPGA(in_ptr[i], out_ptr[i], Weight_buf + woffset, Beta_buf + boffset,
                           l.c, l.n, l.size, l.stride, l.w, l.h, output_w, output_h, l.pad,
                           (l.activation == LEAKY) ? 1 : 0, l.batch_normalize ? 1 : 0,
                           TM, TN, TR, TC, (mLoops + 1) * TM, mLoops * TM, (mLoops + 1) * TM, 0,
-                          Qw, Qa_in, Qa_out, Qb);
+                          Qw, Qa_in, Qa_out, Qb, weight_bits[offset_index], caps_words);
                 
                 printf("    Layer %d completed\n", i);
                 fflush(stdout);
 
+#ifdef INT16_MODE
+                woffset += yolo2_weight_words(cfg.weight_offsets[offset_index], weight_bits[offset_index]);
+#else
                 woffset += cfg.weight_offsets[offset_index];
-                boffset += cfg.beta_offsets[offset_index];
+#endif
+                boffset += cfg.beta_offsets[offset_index] * yolo2_beta_words(weight_bits[offset_index]);
                 offset_index++;
                 break;
             }
@@ -730,11 +807,11 @@ int main(int argc, char *argv[]) {
                 output_w = l.out_h;
                 output_h = l.out_w;
 
-                TR = std::min(((OnChipIB_Height - l.size) / l.stride + 1), Tr);
-                TC = std::min(((OnChipIB_Width - l.size) / l.stride + 1), Tc);
+                TR = std::min(((caps.ib_height - l.size) / l.stride + 1), caps.tr);
+                TC = std::min(((caps.ib_width - l.size) / l.stride + 1), caps.tc);
                 TR = std::min(output_h, TR);
                 TC = std::min(output_w, TC);
-                TM = std::min(Tm, Tn);
+                TM = std::min(caps.tm, caps.tn);
                 TM = std::min(l.c, TM);
                 mLoops = (int)ceil(((float)l.c) / TM);
 
@@ -744,35 +821,26 @@ int main(int argc, char *argv[]) {
                 YOLO2_FPGA(in_ptr[i], out_ptr[i], NULL, NULL, l.c, l.c,
                           l.size, l.stride, l.w, l.h, output_w, output_h, l.pad, 0, 0,
                           TM, 0, TR, TC, (mLoops + 2) * TM, mLoops * TM, (mLoops + 1) * TM, 1,
-                          0, 0, 0, 0);
+                          0, 0, 0, 0, 16, caps_words);
                 break;
             }
             case REORG: {
                 output_w = 26;
                 output_h = 32 * 13;
 
-                TR = std::min(((OnChipIB_Height - l.stride) / l.stride + 1), Tr);
+                TR = std::min(((caps.ib_height - l.stride) / l.stride + 1), caps.tr);
                 TR = std::min(output_h, TR);
-                TC = std::min(((OnChipIB_Width - l.stride) / l.stride + 1), Tc);
+                TC = std::min(((caps.ib_width - l.stride) / l.stride + 1), caps.tc);
                 TC = std::min(output_w, TC);
-                TM = std::min(Tm, Tn);
+                TM = std::min(caps.tm, caps.tn);
                 TM = std::min(4, TM);
                 mLoops = (int)ceil(((float)4) / TM);
 
                 printf("  Layer %2d: REORG stride=%d\n", i, l.stride);
 
-                tmp_ptr_f0 = in_ptr[i];
-                for(int k = 0; k < 26*64; k++) {
-                    memcpy((IO_Dtype *)(region_buf.data() + k*26), 
-                           (IO_Dtype *)(tmp_ptr_f0 + k*32), 26*sizeof(IO_Dtype));
-                }
+                act_to_chw(in_ptr[i], region_buf.data(), 64, 26, 26);
                 reorg_cpu(region_buf.data(), output_w, output_h, 4, 2, region_buf2.data());
-                tmp_ptr_f0 = region_buf.data();
-                memset(region_buf.data(), 0, 13*16*256*sizeof(IO_Dtype));
-                for(int k = 0; k < 13*256; k++) {
-                    memcpy((IO_Dtype *)(tmp_ptr_f0 + k*16), 
-                           (IO_Dtype *)(region_buf2.data() + k*13), 13*sizeof(IO_Dtype));
-                }
+                tmp_ptr_f0 = region_buf2.data();
                 
 #ifdef INT16_MODE
                 // Align quantization scales for route layer concatenation (layer 24)
@@ -781,7 +849,7 @@ int main(int argc, char *argv[]) {
                     const int target_q = std::min(route24_q, current_Qa);
                     const int shift = current_Qa - target_q;
                     if (shift != 0) {
-                        const int total = 13 * 16 * 256;
+                        const int total = 13 * 13 * 256;
                         printf("    Aligning Q scales: current_Qa=%d, route24_q=%d, target=%d, shift=%d\n",
                                current_Qa, route24_q, target_q, shift);
                         for (int idx = 0; idx < total; ++idx) {
@@ -802,7 +870,7 @@ int main(int argc, char *argv[]) {
                 }
 #endif
                 
-                memcpy(out_ptr[i], tmp_ptr_f0, 13*16*256*sizeof(IO_Dtype));
+                chw_to_act(tmp_ptr_f0, out_ptr[i], 256, 13, 13);
                 break;
             }
             case ROUTE: {
@@ -821,14 +889,7 @@ int main(int argc, char *argv[]) {
             }
             case REGION: {
                 printf("  Layer %2d: REGION (post-processing)\n", i);
-                tmp_ptr_f0 = in_ptr[i];
-                for(int k = 0; k < 13*425; k++) {
-                    for(int j = 0; j < 16; j++) {
-                        if(j < 13) {
-                            region_buf[k*13 + j] = tmp_ptr_f0[k*16 + j];
-                        }
-                    }
-                }
+                act_to_chw(in_ptr[i], region_buf.data(), 425, 13, 13);
                 // Convert to float for region layer processing
                 std::vector<float> region_f(region_buf.size());
 #ifdef INT16_MODE
@@ -862,6 +923,49 @@ int main(int argc, char *argv[]) {
                 printf("  Layer %2d: UNKNOWN type %d (skipping)\n", i, l.type);
                 break;
         }
+
+        const bool tap = yolo2_tensor_tap_enabled(i) != 0;
+        if (golden || tap) {
+            // The golden store and the taps see compact CHW regardless of the DDR layout.
+            int out_c = 0, out_h = 0, out_w = 0, type = -1;
+            int tile_c = TM, tile_h = TR, tile_w = TC;
+            if (l.type == CONVOLUTIONAL || l.type == MAXPOOL) {
+                out_c = (l.type == CONVOLUTIONAL) ? l.n : l.c;
+                out_h = output_h;
+                out_w = output_w;
+                type = (l.type == CONVOLUTIONAL) ? YOLO2_GOLDEN_CONV : YOLO2_GOLDEN_MAXPOOL;
+            } else if (l.type == REORG) {
+                out_c = 256;
+                out_h = out_w = 13;
+                type = YOLO2_GOLDEN_REORG;
+                tile_c = caps.tm;
+                tile_h = caps.tr;
+                tile_w = caps.tc;
+            }
+            if (type >= 0) {
+                golden_buf.resize(static_cast<size_t>(out_c) * out_h * out_w);
+                act_to_chw(out_ptr[i], golden_buf.data(), out_c, out_h, out_w);
+                if (golden) {
+                    yolo2_golden_layer(golden, i, type, golden_buf.data(), out_c, out_h, out_w, out_w,
+                                       tile_c, tile_h, tile_w);
+                }
+                if (tap) {
+#ifdef INT16_MODE
+                    yolo2_tensor_tap(i, type, YOLO2_TENSOR_I16, current_Qa, golden_buf.data(), out_c, out_h, out_w, out_w);
+#else
+                    yolo2_tensor_tap(i, type, YOLO2_TENSOR_F32, 0, golden_buf.data(), out_c, out_h, out_w, out_w);
+#endif
+                }
+            }
+        }
+    }
+
+    if (golden) {
+        const int golden_rc = yolo2_golden_close(golden_store.release());
+        if (golden_rc != -1) {
+            fprintf(stderr, "ERROR: Golden verification failed (first diverging layer %d)\n", golden_rc);
+            return 1;
+        }
     }
 
     auto end_time = std::chrono::high_resolution_clock::now();
@@ -950,15 +1054,6 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Create output directory if it doesn't exist
-    struct stat info;
-    if (stat(output_dir.c_str(), &info) != 0) {
-        // Directory doesn't exist, try to create it
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd), "mkdir -p %s", output_dir.c_str());
-        system(cmd);
-    }
-    
     if (final_output) {
         std::string output_path = join_path(output_dir, "cosim_output.bin");
         write_binary<IO_Dtype>(output_path, final_output, final_output_size);
@@ -967,19 +1062,7 @@ int main(int argc, char *argv[]) {
         printf("WARNING: Could not determine final output location\n");
     }
 
-    // Save intermediate outputs for debugging (first few layers)
-    printf("Saving intermediate layer outputs...\n");
-    for (int i = 0; i < std::min(5, net->n); ++i) {
-        if (net->layers[i].type == CONVOLUTIONAL || net->layers[i].type == MAXPOOL) {
-            int out_size = net->layers[i].out_w * net->layers[i].out_h * net->layers[i].out_c;
-            char fname[512];
-            snprintf(fname, sizeof(fname), "%s/layer_%02d_output.bin", output_dir.c_str(), i);
-            write_binary<IO_Dtype>(fname, out_ptr[i], out_size);
-        }
-    }
-
     // Cleanup
-    free(Memory_buf);
     free(Weight_buf);
     free(Beta_buf);
     free_image(im);
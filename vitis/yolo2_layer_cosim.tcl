@@ -0,0 +1,26 @@
+# Co-simulate the single-layer testbench on an already synthesized project
+# (no csim/csynth). vitis/run_layer_cases.py synthesizes once with
+# HLS_TB=layer, copies the project per case and runs this in each copy:
+#   HLS_PROJ_NAME=yolo2_layer HLS_TB_ARGV="--case conv3x3_s1 --alloc 13312,38528,4320,120" \
+#     vitis-run --mode hls --tcl vitis/yolo2_layer_cosim.tcl
+# HLS_COSIM_TRACE selects the cosim trace level (none by default).
+
+set proj_name [expr {[info exists ::env(HLS_PROJ_NAME)] ? $::env(HLS_PROJ_NAME) : "yolo2_layer"}]
+set tb_argv ""
+if {[info exists ::env(HLS_TB_ARGV)]} {
+  set tb_argv $::env(HLS_TB_ARGV)
+}
+set cosim_trace none
+if {[info exists ::env(HLS_COSIM_TRACE)] && $::env(HLS_COSIM_TRACE) ne ""} {
+  set cosim_trace $::env(HLS_COSIM_TRACE)
+}
+
+puts "Opening project: $proj_name"
+open_project $proj_name
+open_solution "solution1"
+
+puts "Running cosim_design with: $tb_argv"
+cosim_design -rtl verilog -trace_level $cosim_trace -argv $tb_argv
+
+close_solution
+close_project
@@ -0,0 +1,629 @@
+/*
+ * YOLO2_FPGA Reduced-Workload Testbench
+ *
+ * Runs single YOLO2_FPGA calls on random weights and inputs and compares each
+ * output with a reference on the host, so an HLS change can be checked in
+ * C simulation or co-simulation without the full network on dog.jpg:
+ *
+ *   - conv (INT16): yolo2_cpu_conv(), the bit-exact CPU kernel shared with
+ *     linux_app; the output must match exactly
+ *   - conv (FP32), maxpool, reorg: direct loops over the same windows the
+ *     accelerator reads; fp32 conv allows float reassociation error
+ *
+ * Cases come from a built-in list of synthetic shapes (every LayerType, the
+ * Ksize/Kstride pairs the IP accepts, partial Tm/Tn/Tr/Tc tiles, 8-/4-bit and
+ * per-channel requantized weights) or from single layers of a cfg
+ * (--layers). Each case is seeded from its name, so it gets the same data
+ * whether it runs alone or in a list, and vitis/run_layer_cases.py can run
+ * one case per process. The words around the output tensor are checked too,
+ * so a write past the tensor fails the case.
+ *
+ * Co-simulation allocates the full m_axi depth of every port. The depths
+ * must cover the largest case; --depths prints them for a case list and
+ * --alloc makes the buffers at least that large (see run_layer_cases.py).
+ */
+
+#include "../hls/models/yolov2/yolo2_accel.hpp"
+#include "../hls/models/yolov2/model_config.hpp"
+#include "../hls/core/params.hpp"
+#include "../hls/core/types.hpp"
+#include "../hls/core/core_compute.hpp"
+#include "../hls/core/core_scheduler.hpp"
+#include "../include/core/yolo.h"
+#include "../linux_app/include/yolo2_act_layout.h"
+#include "../linux_app/include/yolo2_cpu_conv.h"
+#include "../linux_app/include/yolo2_plan.h"
+#include "../linux_app/include/yolo2_requant.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+enum LayerKind { KIND_CONV = 0, KIND_MAXPOOL = 1, KIND_REORG = 2 };
+
+struct LayerCase {
+    std::string name;
+    int kind = KIND_CONV;
+    int ifm = 0, ofm = 0, ksize = 1, stride = 1, pad = 0;
+    int in_w = 0, in_h = 0;
+    bool is_nl = false;
+    int weight_bits = 16;   // WeightBits word, maybe | YOLO2_WBITS_REQUANT
+};
+
+struct TbConfig {
+    std::vector<std::string> cases;     // empty: all synthetic cases
+    std::vector<int> layers;            // cfg layer indices
+    std::string cfg_path = "config/yolov2.cfg";
+    int weight_bits = 16;               // for --layers convs
+    unsigned seed = 1;
+    bool list = false;
+    bool depths = false;
+    size_t alloc[4] = {0, 0, 0, 0};     // minimum Input, Output, Weight, Beta words
+};
+
+// Words written outside the output tensor are caught in these guards.
+constexpr size_t kGuardWords = 64;
+
+LayerCase conv(const std::string &name, int ifm, int ofm, int ksize, int stride, int pad, int w, int h,
+               bool is_nl, int weight_bits = 16) {
+    LayerCase c;
+    c.name = name;
+    c.kind = KIND_CONV;
+    c.ifm = ifm; c.ofm = ofm; c.ksize = ksize; c.stride = stride; c.pad = pad;
+    c.in_w = w; c.in_h = h;
+    c.is_nl = is_nl;
+    c.weight_bits = weight_bits;
+    return c;
+}
+
+LayerCase maxpool(const std::string &name, int channels, int ksize, int stride, int w, int h) {
+    LayerCase c;
+    c.name = name;
+    c.kind = KIND_MAXPOOL;
+    c.ifm = c.ofm = channels; c.ksize = ksize; c.stride = stride; c.pad = ksize - 1;
+    c.in_w = w; c.in_h = h;
+    return c;
+}
+
+// Synthetic shapes. Tm = 32, Tn = 4, Tr = Tc = 13 make 40 output channels,
+// 6 input channels and 30x30 maps partial tiles on every axis.
+std::vector<LayerCase> synthetic_cases() {
+    std::vector<LayerCase> v;
+    v.push_back(conv("conv3x3_s1", 8, 32, 3, 1, 1, 13, 13, true));
+    v.push_back(conv("conv3x3_s1_edge", 6, 40, 3, 1, 1, 30, 30, true));
+    v.push_back(conv("conv3x3_s1_rgb", 3, 16, 3, 1, 1, 28, 27, true));
+    v.push_back(conv("conv3x3_s1_nopad", 8, 36, 3, 1, 0, 17, 15, true));
+    v.push_back(conv("conv1x1_s1", 64, 40, 1, 1, 0, 13, 13, true));
+    v.push_back(conv("conv1x1_s1_linear", 36, 33, 1, 1, 0, 15, 14, false));
+    v.push_back(conv("conv3x3_s2", 8, 40, 3, 2, 1, 30, 30, true));
+    v.push_back(conv("conv1x1_s2", 12, 16, 1, 2, 0, 27, 27, false));
+    v.push_back(conv("conv2x2_s1", 8, 20, 2, 1, 0, 14, 14, true));
+    v.push_back(conv("conv3x3_w8", 12, 40, 3, 1, 1, 26, 26, true, 8));
+    v.push_back(conv("conv3x3_w4", 12, 40, 3, 1, 1, 26, 26, true, 4));
+    v.push_back(conv("conv3x3_rq16", 12, 40, 3, 1, 1, 26, 26, true, 16 | YOLO2_WBITS_REQUANT));
+    v.push_back(conv("conv3x3_rq8", 12, 40, 3, 1, 1, 26, 26, true, 8 | YOLO2_WBITS_REQUANT));
+    v.push_back(conv("conv1x1_rq4", 20, 40, 1, 1, 0, 13, 13, false, 4 | YOLO2_WBITS_REQUANT));
+    v.push_back(maxpool("pool2x2_s2", 8, 2, 2, 26, 26));
+    v.push_back(maxpool("pool2x2_s2_edge", 6, 2, 2, 31, 29));
+    v.push_back(maxpool("pool2x2_s1", 8, 2, 1, 13, 13));
+    v.push_back(maxpool("pool3x3_s2", 5, 3, 2, 27, 27));
+    LayerCase reorg;
+    reorg.name = "reorg_s2";
+    reorg.kind = KIND_REORG;
+    reorg.ifm = 1; reorg.ofm = 4; reorg.ksize = 2; reorg.stride = 2;
+    reorg.in_w = 52; reorg.in_h = 30;
+    v.push_back(reorg);
+    return v;
+}
+
+// Why a case cannot run on this build, or empty
+std::string unsupported(const LayerCase &c) {
+#ifndef INT16_MODE
+    if (c.weight_bits != 16) return "fp32 builds load 16-bit weights only";
+#endif
+#ifdef ACT_BLOCKED_LAYOUT
+    if (c.kind == KIND_REORG) return "reorg is CHW-only";
+#endif
+#if !GENERIC_KERNELS
+    if (c.kind == KIND_CONV && !((c.ksize == 3 || c.ksize == 1) && c.stride == 1))
+        return "conv shape not built (GENERIC_KERNELS=0)";
+    if (c.kind == KIND_MAXPOOL && !(c.ksize == 2 && c.stride == 2))
+        return "pool shape not built (GENERIC_KERNELS=0)";
+#endif
+    if (c.kind == KIND_REORG && Tm < 4) return "reorg writes 4 channels per tile (Tm < 4)";
+    if (c.ofm > MAX_BETA_LENGTH) return "OFM exceeds MAX_BETA_LENGTH";
+    return std::string();
+}
+
+// Tiling registers of one call (yolo2_plan.h, as the executors derive them)
+struct CallShape {
+    int out_w = 0, out_h = 0;
+    int tm = 0, tn = 0, tr = 0, tc = 0;
+    int ofm_num_bound = 0, mloopsxtm = 0, mloops_a1xtm = 0;
+};
+
+CallShape call_shape(const LayerCase &c) {
+    CallShape s;
+    if (c.kind == KIND_REORG) {
+        // As the cosim TB's reorg layer: 4 output channels per input channel.
+        s.out_w = c.in_w / c.stride;
+        s.out_h = c.in_h / c.stride;
+        s.tr = std::min(std::min((OnChipIB_Height - c.ksize) / c.stride + 1, Tr), s.out_h);
+        s.tc = std::min(std::min((OnChipIB_Width - c.ksize) / c.stride + 1, Tc), s.out_w);
+        s.tm = 4;
+        const int loops = (c.ofm + s.tm - 1) / s.tm;
+        s.ofm_num_bound = (loops + 2) * s.tm;
+        s.mloopsxtm = loops * s.tm;
+        s.mloops_a1xtm = (loops + 1) * s.tm;
+        return s;
+    }
+
+    yolo2_plan_t plan;
+    std::memset(&plan, 0, sizeof(plan));
+    plan.n = 1;
+    yolo2_plan_layer_t &l = plan.layers[0];
+    l.type = (c.kind == KIND_CONV) ? YOLO2_PLAN_CONV : YOLO2_PLAN_MAXPOOL;
+    l.ifm = c.ifm; l.ofm = c.ofm; l.ksize = c.ksize; l.stride = c.stride; l.pad = c.pad;
+    l.in_w = c.in_w; l.in_h = c.in_h;
+    // Darknet maxpool output; conv outputs are recomputed by the plan
+    l.out_w = (c.in_w + c.pad - c.ksize) / c.stride + 1;
+    l.out_h = (c.in_h + c.pad - c.ksize) / c.stride + 1;
+    l.is_nl = c.is_nl;
+    l.route_layer = -1;
+    const int32_t bits = c.weight_bits;
+    if (yolo2_plan_build(&plan, Tm, Tn, Tr, Tc, OnChipIB_Height, OnChipIB_Width, &bits, 1, 0) != 0)
+        throw std::runtime_error("layer plan failed for case " + c.name);
+    s.out_w = l.out_w; s.out_h = l.out_h;
+    s.tm = l.tm; s.tn = l.tn; s.tr = l.tr; s.tc = l.tc;
+    s.ofm_num_bound = l.ofm_num_bound; s.mloopsxtm = l.mloopsxtm; s.mloops_a1xtm = l.mloops_a1xtm;
+    return s;
+}
+
+size_t weight_words(const LayerCase &c) {
+    if (c.kind != KIND_CONV) return 0;
+    const int count = c.ifm * c.ofm * c.ksize * c.ksize;
+#ifdef INT16_MODE
+    return static_cast<size_t>(yolo2_weight_words(count, c.weight_bits));
+#else
+    return static_cast<size_t>(count);
+#endif
+}
+
+size_t beta_words(const LayerCase &c) {
+    return (c.kind == KIND_CONV) ? static_cast<size_t>(c.ofm) * yolo2_beta_words(c.weight_bits) : 0;
+}
+
+// m_axi words a case touches: Input, Output (with guards), Weight, Beta
+void case_depths(const LayerCase &c, size_t depth[4]) {
+    const CallShape s = call_shape(c);
+    depth[0] = yolo2_act_words(c.ifm, c.in_h, c.in_w);
+    depth[1] = yolo2_act_words(c.ofm, s.out_h, s.out_w) + 2 * kGuardWords;
+    depth[2] = std::max<size_t>(weight_words(c), 1);
+    depth[3] = std::max<size_t>(beta_words(c), 1);
+}
+
+// Stable per-case seed (FNV-1a of the name)
+unsigned case_seed(const std::string &name, unsigned seed) {
+    uint32_t h = 2166136261u;
+    for (char ch : name) {
+        h ^= static_cast<uint8_t>(ch);
+        h *= 16777619u;
+    }
+    return h ^ (seed * 0x9e3779b9u);
+}
+
+#ifdef INT16_MODE
+// Q formats that keep random data mostly inside int16 at every layer size
+constexpr int kQaIn = 9;     // inputs in [-4, 4)
+constexpr int kQaOut = 10;
+constexpr int kQb = 10;      // bias in [-1, 1)
+int weight_q(int weight_bits) {
+    return (yolo2_wbits_precision(weight_bits) == 8) ? 10 : 12;   // weights in [-1/8, 1/8)
+}
+#endif
+
+#ifndef INT16_MODE
+// Index of weight (o, i, ky, kx) in the reorganized stream (weight_load_reorg())
+size_t stream_index(const LayerCase &c, int tm, int tn, int o, int i, int kk) {
+    const int kk_count = c.ksize * c.ksize;
+    const int mb = o / tm, o_in = o % tm;
+    const int tm_min = std::min(tm, c.ofm - mb * tm);
+    const int n = (i / tn) * tn, t = i % tn;
+    const int tn_min = std::min(tn, c.ifm - n);
+    return static_cast<size_t>(mb) * tm * c.ifm * kk_count + static_cast<size_t>(n) * tm_min * kk_count +
+           (static_cast<size_t>(kk) * tm_min + o_in) * tn_min + t;
+}
+#endif
+
+void fill_case(const LayerCase &c, std::mt19937 &rng, IO_Dtype *input, IO_Dtype *weight, IO_Dtype *beta) {
+    std::fill(input, input + yolo2_act_words(c.ifm, c.in_h, c.in_w), static_cast<IO_Dtype>(0));
+#ifdef INT16_MODE
+    std::uniform_int_distribution<int> act(-(4 << kQaIn), (4 << kQaIn) - 1);
+#else
+    std::uniform_real_distribution<float> act(-4.0f, 4.0f);
+#endif
+    for (int ch = 0; ch < c.ifm; ++ch)
+        for (int y = 0; y < c.in_h; ++y)
+            for (int x = 0; x < c.in_w; ++x)
+                input[yolo2_act_index(ch, y, x, c.in_h, c.in_w)] = static_cast<IO_Dtype>(act(rng));
+    if (c.kind != KIND_CONV) return;
+
+    const size_t words = weight_words(c);
+#ifdef INT16_MODE
+    const int bits = yolo2_wbits_precision(c.weight_bits);
+    std::uniform_int_distribution<int> word(-32768, 32767);
+    std::uniform_int_distribution<int> w16(-512, 511);
+    size_t first = 0;
+    if (bits == 4) {
+        for (int k = 0; k < 16; ++k) weight[k] = static_cast<IO_Dtype>(w16(rng));   // codebook
+        first = 16;
+    }
+    for (size_t k = first; k < words; ++k)
+        weight[k] = static_cast<IO_Dtype>((bits == 16) ? w16(rng) : word(rng));   // packed bytes / nibbles
+
+    std::uniform_int_distribution<int> bias(-(1 << kQb), (1 << kQb) - 1);
+    std::uniform_int_distribution<int> mult(1 << 15, 65535);
+    std::uniform_int_distribution<int> shift(16, 22);
+    const int per = yolo2_beta_words(c.weight_bits);
+    for (int o = 0; o < c.ofm; ++o) {
+        beta[o * per] = static_cast<IO_Dtype>(bias(rng));
+        if (yolo2_wbits_requant(c.weight_bits)) {
+            beta[o * per + 1] = static_cast<IO_Dtype>(static_cast<uint16_t>(mult(rng)));
+            beta[o * per + 2] = static_cast<IO_Dtype>(shift(rng));
+        }
+    }
+#else
+    std::uniform_real_distribution<float> w(-0.125f, 0.125f);
+    std::uniform_real_distribution<float> bias(-1.0f, 1.0f);
+    for (size_t k = 0; k < words; ++k) weight[k] = w(rng);
+    for (int o = 0; o < c.ofm; ++o) beta[o] = bias(rng);
+#endif
+}
+
+void reference(const LayerCase &c, const CallShape &s, const IO_Dtype *input, const IO_Dtype *weight,
+               const IO_Dtype *beta, IO_Dtype *out) {
+    if (c.kind == KIND_CONV) {
+#ifdef INT16_MODE
+        yolo2_cpu_conv_t l;
+        l.ifm = c.ifm; l.ofm = c.ofm; l.ksize = c.ksize; l.stride = c.stride; l.pad = c.pad;
+        l.in_w = c.in_w; l.in_h = c.in_h; l.out_w = s.out_w; l.out_h = s.out_h;
+        l.tm = s.tm; l.tn = s.tn; l.weight_bits = c.weight_bits;
+        l.qw = weight_q(c.weight_bits); l.qa_in = kQaIn; l.qa_out = kQaOut; l.qb = kQb;
+        l.is_nl = c.is_nl;
+        l.split_k = SPLIT_K;
+        std::vector<int16_t> decoded(static_cast<size_t>(c.ofm) * c.ifm * c.ksize * c.ksize);
+        yolo2_cpu_conv_decode(&l, weight, 0, c.ofm, decoded.data());
+        if (yolo2_cpu_conv(&l, input, decoded.data(), beta, out, 0, c.ofm, 1) != 0)
+            throw std::runtime_error("reference conv failed for case " + c.name);
+#else
+        for (int o = 0; o < c.ofm; ++o)
+            for (int y = 0; y < s.out_h; ++y)
+                for (int x = 0; x < s.out_w; ++x) {
+                    double acc = beta[o];
+                    for (int i = 0; i < c.ifm; ++i)
+                        for (int ky = 0; ky < c.ksize; ++ky)
+                            for (int kx = 0; kx < c.ksize; ++kx) {
+                                const int iy = y * c.stride + ky - c.pad, ix = x * c.stride + kx - c.pad;
+                                if (iy < 0 || iy >= c.in_h || ix < 0 || ix >= c.in_w) continue;
+                                acc += static_cast<double>(weight[stream_index(c, s.tm, s.tn, o, i, ky * c.ksize + kx)]) *
+                                       input[yolo2_act_index(i, iy, ix, c.in_h, c.in_w)];
+                            }
+                    const float v = static_cast<float>(acc);
+                    out[yolo2_act_index(o, y, x, s.out_h, s.out_w)] = (c.is_nl && v < 0.0f) ? v * 0.1f : v;
+                }
+#endif
+        return;
+    }
+    if (c.kind == KIND_MAXPOOL) {
+        // Windows start at (y, x) * stride; taps past the map are skipped
+        // (the accelerator pads them with the most negative value).
+        for (int ch = 0; ch < c.ifm; ++ch)
+            for (int y = 0; y < s.out_h; ++y)
+                for (int x = 0; x < s.out_w; ++x) {
+                    bool any = false;
+                    IO_Dtype m = 0;
+                    for (int ky = 0; ky < c.ksize; ++ky)
+                        for (int kx = 0; kx < c.ksize; ++kx) {
+                            const int iy = y * c.stride + ky, ix = x * c.stride + kx;
+                            if (iy >= c.in_h || ix >= c.in_w) continue;
+                            const IO_Dtype v = input[yolo2_act_index(ch, iy, ix, c.in_h, c.in_w)];
+                            if (!any || v > m) m = v;
+                            any = true;
+                        }
+                    out[yolo2_act_index(ch, y, x, s.out_h, s.out_w)] = m;
+                }
+        return;
+    }
+    // Reorg: output channel (ky * 2 + kx) of input channel i is 4 * i + ky * 2 + kx
+    for (int i = 0; i < c.ifm; ++i)
+        for (int k = 0; k < 4; ++k)
+            for (int y = 0; y < s.out_h; ++y)
+                for (int x = 0; x < s.out_w; ++x)
+                    out[yolo2_act_index(4 * i + k, y, x, s.out_h, s.out_w)] =
+                        input[yolo2_act_index(i, y * 2 + k / 2, x * 2 + k % 2, c.in_h, c.in_w)];
+}
+
+struct CaseResult {
+    size_t checked = 0;
+    size_t mismatches = 0;
+    size_t guard_errors = 0;
+    double max_err = 0.0;
+    double ms = 0.0;
+};
+
+bool values_match(IO_Dtype got, IO_Dtype want, double &err) {
+    err = std::fabs(static_cast<double>(got) - static_cast<double>(want));
+#ifdef INT16_MODE
+    return got == want;
+#else
+    return err <= 1e-3 + 1e-4 * std::fabs(static_cast<double>(want));
+#endif
+}
+
+// Buffers shared by all cases, sized to the largest case (and --alloc)
+struct TbBuffers {
+    std::vector<IO_Dtype> input, output, weight, beta, ref;
+};
+
+CaseResult run_case(const LayerCase &c, unsigned seed, TbBuffers &buf) {
+    const CallShape s = call_shape(c);
+    std::mt19937 rng(case_seed(c.name, seed));
+    fill_case(c, rng, buf.input.data(), buf.weight.data(), buf.beta.data());
+
+    const size_t out_words = yolo2_act_words(c.ofm, s.out_h, s.out_w);
+    const IO_Dtype sentinel = static_cast<IO_Dtype>(-12345);
+    std::fill(buf.output.begin(), buf.output.end(), sentinel);
+    IO_Dtype *out = buf.output.data() + kGuardWords;
+
+    int qw = 0, qa_in = 0, qa_out = 0, qb = 0;
+#ifdef INT16_MODE
+    if (c.kind == KIND_CONV) {
+        qw = weight_q(c.weight_bits); qa_in = kQaIn; qa_out = kQaOut; qb = kQb;
+    }
+#endif
+    const bool conv_layer = (c.kind == KIND_CONV);
+    const auto t0 = std::chrono::steady_clock::now();
+    YOLO2_FPGA(buf.input.data(), out, conv_layer ? buf.weight.data() : NULL, conv_layer ? buf.beta.data() : NULL,
+               c.ifm, c.ofm, c.ksize, c.stride, c.in_w, c.in_h, s.out_w, s.out_h,
+               conv_layer ? c.pad : 0, c.is_nl, false,
+               s.tm, conv_layer ? s.tn : 0, s.tr, s.tc, s.ofm_num_bound, s.mloopsxtm, s.mloops_a1xtm, c.kind,
+               qw, qa_in, qa_out, qb, conv_layer ? c.weight_bits : 16, NULL);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    CaseResult r;
+    r.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    std::fill(buf.ref.begin(), buf.ref.begin() + out_words, static_cast<IO_Dtype>(0));
+    reference(c, s, buf.input.data(), buf.weight.data(), buf.beta.data(), buf.ref.data());
+
+    int shown = 0;
+    for (int ch = 0; ch < c.ofm; ++ch)
+        for (int y = 0; y < s.out_h; ++y)
+            for (int x = 0; x < s.out_w; ++x) {
+                const size_t idx = yolo2_act_index(ch, y, x, s.out_h, s.out_w);
+                double err = 0.0;
+                r.checked++;
+                if (!values_match(out[idx], buf.ref[idx], err)) {
+                    if (shown++ < 5)
+                        printf("    mismatch c=%d y=%d x=%d: got %.6g, expected %.6g\n", ch, y, x,
+                               static_cast<double>(out[idx]), static_cast<double>(buf.ref[idx]));
+                    r.mismatches++;
+                }
+                r.max_err = std::max(r.max_err, err);
+            }
+    for (size_t k = 0; k < kGuardWords; ++k) {
+        if (buf.output[k] != sentinel) r.guard_errors++;
+        if (buf.output[kGuardWords + out_words + k] != sentinel) r.guard_errors++;
+    }
+    return r;
+}
+
+std::string describe(const LayerCase &c) {
+    char line[160];
+    if (c.kind == KIND_CONV)
+        snprintf(line, sizeof(line), "conv %dx%d/%d pad %d %4d -> %4d %3dx%-3d %s w%d%s", c.ksize, c.ksize, c.stride,
+                 c.pad, c.ifm, c.ofm, c.in_w, c.in_h, c.is_nl ? "leaky " : "linear", yolo2_wbits_precision(c.weight_bits),
+                 yolo2_wbits_requant(c.weight_bits) ? "+rq" : "");
+    else if (c.kind == KIND_MAXPOOL)
+        snprintf(line, sizeof(line), "max  %dx%d/%d        %4d         %3dx%-3d", c.ksize, c.ksize, c.stride, c.ifm,
+                 c.in_w, c.in_h);
+    else
+        snprintf(line, sizeof(line), "reorg   /%d        %4d -> %4d %3dx%-3d", c.stride, c.ifm, c.ofm, c.in_w, c.in_h);
+    return line;
+}
+
+std::vector<std::string> split_list(const std::string &s) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        const size_t comma = s.find(',', start);
+        const std::string item = s.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        if (!item.empty()) out.push_back(item);
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return out;
+}
+
+void print_usage(const char *prog) {
+    printf("Usage: %s [--case name[,name...]] [--layers i[,j...]] [--cfg config/yolov2.cfg]\n"
+           "          [--weight-bits n] [--seed n] [--list] [--depths] [--alloc in,out,weight,beta]\n"
+           "\n"
+           "  --case        Synthetic cases to run (default: all; see --list)\n"
+           "  --layers      Conv/maxpool layers of --cfg to run with random data\n"
+           "  --weight-bits WeightBits word for --layers convs (16, 8, 4, | 0x100)\n"
+           "  --depths      Print the m_axi depths the selected cases need and exit\n"
+           "  --alloc       Allocate at least these words per port (co-simulation depths)\n",
+           prog);
+}
+
+TbConfig parse_args(int argc, char **argv) {
+    TbConfig cfg;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg(argv[i]);
+        if (arg == "--case" && i + 1 < argc) {
+            for (const std::string &n : split_list(argv[++i])) cfg.cases.push_back(n);
+        } else if (arg == "--layers" && i + 1 < argc) {
+            for (const std::string &n : split_list(argv[++i])) cfg.layers.push_back(std::atoi(n.c_str()));
+        } else if (arg == "--cfg" && i + 1 < argc) {
+            cfg.cfg_path = argv[++i];
+        } else if (arg == "--weight-bits" && i + 1 < argc) {
+            cfg.weight_bits = static_cast<int>(std::strtol(argv[++i], NULL, 0));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            cfg.seed = static_cast<unsigned>(std::strtoul(argv[++i], NULL, 0));
+        } else if (arg == "--list") {
+            cfg.list = true;
+        } else if (arg == "--depths") {
+            cfg.depths = true;
+        } else if (arg == "--alloc" && i + 1 < argc) {
+            const std::vector<std::string> v = split_list(argv[++i]);
+            if (v.size() != 4) throw std::runtime_error("--alloc expects four word counts");
+            for (int k = 0; k < 4; ++k) cfg.alloc[k] = std::strtoull(v[k].c_str(), NULL, 0);
+        } else if (arg == "--help" || arg == "-h") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else {
+            throw std::runtime_error("Unknown argument: " + arg);
+        }
+    }
+    return cfg;
+}
+
+// The cfg is resolved from the project root (co-simulation runs in the
+// solution's sim directory).
+std::string resolve_cfg(const std::string &path) {
+    struct stat st;
+    if (path.empty() || path[0] == '/' || stat(path.c_str(), &st) == 0) return path;
+    char cwd[PATH_MAX];
+    if (getcwd(cwd, sizeof(cwd)) == nullptr) return path;
+    std::string dir = cwd;
+    for (int i = 0; i < 10; ++i) {
+        const std::string candidate = dir + "/" + path;
+        if (stat(candidate.c_str(), &st) == 0) return candidate;
+        const size_t slash = dir.find_last_of('/');
+        if (slash == std::string::npos || slash == 0) break;
+        dir = dir.substr(0, slash);
+    }
+    return path;
+}
+
+std::vector<LayerCase> cfg_cases(const TbConfig &cfg) {
+    std::vector<LayerCase> v;
+    const std::string cfg_path = resolve_cfg(cfg.cfg_path);
+    network *net = load_network(const_cast<char *>(cfg_path.c_str()));
+    if (!net) throw std::runtime_error("Failed to load cfg: " + cfg_path);
+    for (int idx : cfg.layers) {
+        if (idx < 0 || idx >= net->n) throw std::runtime_error("--layers: no layer " + std::to_string(idx));
+        const layer &l = net->layers[idx];
+        char name[32];
+        snprintf(name, sizeof(name), "layer%02d", idx);
+        if (l.type == CONVOLUTIONAL) {
+            v.push_back(conv(name, l.c, l.n, l.size, l.stride, l.pad, l.w, l.h, l.activation == LEAKY, cfg.weight_bits));
+        } else if (l.type == MAXPOOL) {
+            LayerCase c = maxpool(name, l.c, l.size, l.stride, l.w, l.h);
+            c.pad = l.pad;
+            v.push_back(c);
+        } else {
+            throw std::runtime_error("--layers: layer " + std::to_string(idx) + " is not a conv or maxpool");
+        }
+    }
+    return v;
+}
+
+std::vector<LayerCase> select_cases(const TbConfig &cfg) {
+    std::vector<LayerCase> all = synthetic_cases();
+    std::vector<LayerCase> v;
+    if (cfg.cases.empty() && cfg.layers.empty()) return all;
+    for (const std::string &name : cfg.cases) {
+        auto it = std::find_if(all.begin(), all.end(), [&](const LayerCase &c) { return c.name == name; });
+        if (it == all.end()) throw std::runtime_error("Unknown case: " + name + " (see --list)");
+        v.push_back(*it);
+    }
+    if (!cfg.layers.empty()) {
+        const std::vector<LayerCase> layers = cfg_cases(cfg);
+        v.insert(v.end(), layers.begin(), layers.end());
+    }
+    return v;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    try {
+        const TbConfig cfg = parse_args(argc, argv);
+        const std::vector<LayerCase> cases = select_cases(cfg);
+
+        if (cfg.list) {
+            for (const LayerCase &c : cases) {
+                const std::string why = unsupported(c);
+                printf("%-20s %s%s%s\n", c.name.c_str(), describe(c).c_str(), why.empty() ? "" : "  skip: ",
+                       why.c_str());
+            }
+            return 0;
+        }
+
+        size_t depth[4] = {cfg.alloc[0], cfg.alloc[1], cfg.alloc[2], cfg.alloc[3]};
+        for (const LayerCase &c : cases) {
+            if (!unsupported(c).empty()) continue;
+            size_t d[4];
+            case_depths(c, d);
+            for (int k = 0; k < 4; ++k) depth[k] = std::max(depth[k], d[k]);
+        }
+        if (cfg.depths) {
+            printf("input=%zu output=%zu weight=%zu beta=%zu\n", depth[0], depth[1], depth[2], depth[3]);
+            return 0;
+        }
+
+        printf("YOLO2_FPGA Layer Testbench (%s, %s layout, Tm=%d Tn=%d Tr=%d Tc=%d)\n",
+#ifdef INT16_MODE
+               "INT16",
+#else
+               "FP32",
+#endif
+#ifdef ACT_BLOCKED_LAYOUT
+               "blocked",
+#else
+               "CHW",
+#endif
+               Tm, Tn, Tr, Tc);
+
+        TbBuffers buf;
+        buf.input.assign(std::max<size_t>(depth[0], 1), 0);
+        buf.output.assign(std::max<size_t>(depth[1], 1), 0);
+        buf.weight.assign(std::max<size_t>(depth[2], 1), 0);
+        buf.beta.assign(std::max<size_t>(depth[3], 1), 0);
+        buf.ref.assign(buf.output.size(), 0);
+
+        int failed = 0, passed = 0, skipped = 0;
+        for (const LayerCase &c : cases) {
+            const std::string why = unsupported(c);
+            if (!why.empty()) {
+                printf("SKIP %-20s %s (%s)\n", c.name.c_str(), describe(c).c_str(), why.c_str());
+                skipped++;
+                continue;
+            }
+            const CaseResult r = run_case(c, cfg.seed, buf);
+            const bool ok = (r.mismatches == 0 && r.guard_errors == 0);
+            printf("%s %-20s %s  %zu/%zu mismatches, max err %.3g, %zu guard words, %.1f ms\n", ok ? "PASS" : "FAIL",
+                   c.name.c_str(), describe(c).c_str(), r.mismatches, r.checked, r.max_err, r.guard_errors, r.ms);
+            ok ? passed++ : failed++;
+        }
+        printf("\n%d passed, %d failed, %d skipped\n", passed, failed, skipped);
+        return failed ? 1 : 0;
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "Fatal error: %s\n", ex.what());
+        return 1;
+    }
+}